@@ -0,0 +1,158 @@
+// Portable; also builds outside Windows: g++ -std=c++20 -O2 -I.. Test_AnimationLock.cpp
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <format>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <XivAlexanderCommon/Utils/AnimationLock.h>
+
+using Utils::AnimationLock::MitigationMode;
+
+// What NetworkTimingHandler used to do for every action response: copy the samples to get statistics,
+// and describe every step, whether it would be logged or not.
+// Missing socket latency falls back to ping latency; it used to be offset by 20ms first, so that ping latency never got used.
+static int64_t ResolveByDescribing(MitigationMode mode, const std::deque<int64_t>& samples, int64_t socketLatencyUs, int64_t pingLatencyUs,
+	int64_t nowUs, int64_t originalWaitUs, int64_t rttUs, int64_t expectedDelayUs, std::string& log) {
+	std::stringstream description;
+	description << std::format(" mode={}", static_cast<int>(mode) + 1);
+
+	const auto socketLatencyOffsetUs = socketLatencyUs == INT64_MAX ? INT64_MAX : std::max<int64_t>(socketLatencyUs - 20000, 1);
+	auto latencyUs = socketLatencyOffsetUs != INT64_MAX ? socketLatencyOffsetUs : pingLatencyUs;
+
+	const auto minCopy = samples;
+	int64_t rttMinUs = minCopy.front();
+	for (const auto v : minCopy)
+		rttMinUs = std::min(rttMinUs, v);
+
+	const auto meanCopy = samples;
+	int64_t acc = 0;
+	for (const auto v : meanCopy)
+		acc += v;
+	const auto rttMeanUs = acc / static_cast<int64_t>(meanCopy.size());
+	int64_t diffSquaredSum = 0;
+	for (const auto v : meanCopy)
+		diffSquaredSum += (v - rttMeanUs) * (v - rttMeanUs);
+	const auto rttDeviationUs = meanCopy.size() == 1 ? 0 : static_cast<int64_t>(std::sqrt(diffSquaredSum / static_cast<int64_t>(meanCopy.size())));
+	const auto latencyEstimateUs = ((rttMinUs + rttMeanUs) / 2) - ((rttDeviationUs + 25000) / 2);
+
+	if (latencyUs == INT64_MAX || rttUs < latencyUs) {
+		latencyUs = latencyEstimateUs;
+		description << std::format(" latency={}us*", latencyUs);
+	} else {
+		description << std::format(" latency={}us", latencyUs);
+	}
+
+	int64_t delay = 0;
+	switch (mode) {
+		case MitigationMode::SubtractLatency:
+			delay = rttUs - latencyUs;
+			break;
+
+		case MitigationMode::SimulateRtt:
+			delay = expectedDelayUs;
+			break;
+
+		case MitigationMode::SimulateNormalizedRttAndLatency: {
+			const auto bestLatencyUs = std::max(latencyUs, latencyEstimateUs);
+			if (bestLatencyUs != latencyUs)
+				description << std::format("->{}us", bestLatencyUs);
+			delay = bestLatencyUs > 0 ? ((rttUs % bestLatencyUs) + (rttUs - bestLatencyUs)) / 2 : rttUs;
+			break;
+		}
+	}
+	delay = std::max<int64_t>(delay, 0);
+	description << std::format(" delay={}us", delay);
+	log = description.str();
+	return nowUs + (originalWaitUs - rttUs) + delay;
+}
+
+struct Case {
+	MitigationMode Mode;
+	std::deque<int64_t> Samples;
+	Utils::AnimationLock::LatencySnapshot Snapshot;
+	int64_t NowUs;
+	int64_t OriginalWaitUs;
+	int64_t RttUs;
+};
+
+static Case MakeCase(std::mt19937_64& rng) {
+	Case c{};
+	c.Mode = static_cast<MitigationMode>(rng() % 3);
+
+	// Latency from LAN to intercontinental, with jitter, and the occasional missing measurement.
+	const auto baseUs = static_cast<int64_t>(1000 + rng() % 300000);
+	const auto jitterUs = static_cast<int64_t>(1 + rng() % 40000);
+	c.RttUs = baseUs + static_cast<int64_t>(rng() % jitterUs) + static_cast<int64_t>(rng() % 50000);
+	for (auto i = 1 + rng() % 9; i > 0; --i)
+		c.Samples.push_back(baseUs + static_cast<int64_t>(rng() % jitterUs) + static_cast<int64_t>(rng() % 50000));
+	c.Samples.push_back(c.RttUs);
+
+	c.Snapshot.SocketLatencyUs = rng() % 8 ? baseUs + static_cast<int64_t>(rng() % 40000) : INT64_MAX;
+	c.Snapshot.PingLatencyUs = rng() % 4 ? baseUs + static_cast<int64_t>(rng() % jitterUs) : INT64_MAX;
+
+	int64_t minUs = c.Samples.front(), acc = 0;
+	for (const auto v : c.Samples) {
+		minUs = std::min(minUs, v);
+		acc += v;
+	}
+	const auto count = static_cast<int64_t>(c.Samples.size());
+	int64_t diffSquaredSum = 0;
+	for (const auto v : c.Samples)
+		diffSquaredSum += (v - acc / count) * (v - acc / count);
+	c.Snapshot.RttMinUs = minUs;
+	c.Snapshot.RttMeanUs = acc / count;
+	c.Snapshot.RttDeviationUs = static_cast<int64_t>(std::sqrt(diffSquaredSum / count));
+
+	c.NowUs = static_cast<int64_t>(1000000 + rng() % (1ULL << 42));
+	c.OriginalWaitUs = rng() % 2 ? 600000 : static_cast<int64_t>(100000 + rng() % 1000000);
+	return c;
+}
+
+int main() {
+	static constexpr int64_t ExpectedDelayUs = 75000;
+	std::mt19937_64 rng(0x5EED);
+	std::vector<Case> cases;
+	for (auto i = 0; i < 100000; ++i)
+		cases.emplace_back(MakeCase(rng));
+
+	// Step. Same decision as before, for every mode and with or without measurements.
+	uint64_t failures = 0;
+	std::string log;
+	for (const auto& c : cases) {
+		const auto expected = ResolveByDescribing(c.Mode, c.Samples, c.Snapshot.SocketLatencyUs, c.Snapshot.PingLatencyUs, c.NowUs, c.OriginalWaitUs, c.RttUs, ExpectedDelayUs, log);
+		const auto actual = Utils::AnimationLock::Resolve(c.Mode, c.Snapshot, c.NowUs, c.OriginalWaitUs, c.RttUs, ExpectedDelayUs);
+		if (expected != actual.AnimationLockEndsAtUs && failures++ < 10) {
+			std::printf("Mismatch: mode=%d rtt=%lld socket=%lld ping=%lld: before=%lld after=%lld\n",
+				static_cast<int>(c.Mode), static_cast<long long>(c.RttUs),
+				static_cast<long long>(c.Snapshot.SocketLatencyUs), static_cast<long long>(c.Snapshot.PingLatencyUs),
+				static_cast<long long>(expected), static_cast<long long>(actual.AnimationLockEndsAtUs));
+		}
+	}
+	std::printf("%zu cases, %llu mismatches\n", cases.size(), static_cast<unsigned long long>(failures));
+
+	// Step. Per action response.
+	static constexpr auto Repeats = 10;
+	int64_t sink = 0;
+	const auto t0 = std::chrono::steady_clock::now();
+	for (auto r = 0; r < Repeats; ++r) {
+		for (const auto& c : cases)
+			sink += ResolveByDescribing(c.Mode, c.Samples, c.Snapshot.SocketLatencyUs, c.Snapshot.PingLatencyUs, c.NowUs, c.OriginalWaitUs, c.RttUs, ExpectedDelayUs, log);
+	}
+	const auto t1 = std::chrono::steady_clock::now();
+	for (auto r = 0; r < Repeats; ++r) {
+		for (const auto& c : cases)
+			sink += Utils::AnimationLock::Resolve(c.Mode, c.Snapshot, c.NowUs, c.OriginalWaitUs, c.RttUs, ExpectedDelayUs).AnimationLockEndsAtUs;
+	}
+	const auto t2 = std::chrono::steady_clock::now();
+	const auto ns = [&](auto d) { return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(d).count()) / static_cast<double>(cases.size() * Repeats); };
+	std::printf("Per response: describing %.1fns, resolving %.1fns (%lld)\n", ns(t1 - t0), ns(t2 - t1), static_cast<long long>(sink));
+
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,197 @@
+#include "pch.h"
+
+#include <chrono>
+#include <random>
+
+#include <XivAlexanderCommon/Sqex/Network/Structure.h>
+
+using namespace Sqex::Network::Structure;
+
+// What TunnelXivStream used to do: search for both magics across the whole buffer, and step over one byte whenever the header found was not usable.
+// A TotalLength shorter than the header could not be decoded either, so it is skipped the same way as zero.
+static size_t LegacyResync(std::span<const uint8_t> buf) {
+	size_t skipped = 0;
+	while (true) {
+		const auto searchLength = std::min(sizeof XivBundle::MagicConstant1, buf.size());
+		const auto trash = static_cast<size_t>(std::min(
+			std::search(buf.begin(), buf.end(), XivBundle::MagicConstant1, XivBundle::MagicConstant1 + searchLength),
+			std::search(buf.begin(), buf.end(), XivBundle::MagicConstant2, XivBundle::MagicConstant2 + searchLength)
+		) - buf.begin());
+		skipped += trash;
+		buf = buf.subspan(trash);
+		if (buf.size() < sizeof(XivBundleHeader) || reinterpret_cast<const XivBundleHeader*>(buf.data())->TotalLength >= sizeof(XivBundleHeader))
+			return skipped;
+		skipped++;
+		buf = buf.subspan(1);
+	}
+}
+
+static void AppendHeader(std::vector<uint8_t>& buf, const uint8_t* magic, uint32_t totalLength) {
+	const auto offset = buf.size();
+	buf.resize(offset + sizeof(XivBundleHeader), 0xcc);
+	auto& header = *reinterpret_cast<XivBundleHeader*>(&buf[offset]);
+	memcpy(header.Magic, magic, sizeof header.Magic);
+	header.TotalLength = totalLength;
+}
+
+enum class GarbageType {
+	Random,
+
+	// Runs of zeroes, parts of magics, and headers that are too short, which may happen to form a usable header.
+	Lookalike,
+
+	// Same as above, but with each piece followed by a byte that keeps it from forming a usable header.
+	SeparatedLookalike,
+};
+
+static void AppendGarbage(std::mt19937& rng, std::vector<uint8_t>& buf, size_t length, GarbageType type) {
+	const auto end = buf.size() + length;
+	while (buf.size() < end) {
+		switch (type == GarbageType::Random ? 3 : rng() % 8) {
+			case 0:
+				buf.resize(buf.size() + rng() % (type == GarbageType::SeparatedLookalike ? sizeof XivBundle::MagicConstant2 : 64));
+				break;
+			case 1: {
+				const auto magic = rng() % 2 ? XivBundle::MagicConstant1 : XivBundle::MagicConstant2;
+				buf.insert(buf.end(), magic, magic + rng() % sizeof XivBundle::MagicConstant1);
+				break;
+			}
+			case 2:
+				AppendHeader(buf, rng() % 2 ? XivBundle::MagicConstant1 : XivBundle::MagicConstant2, rng() % sizeof(XivBundleHeader));
+				break;
+			default:
+				for (auto i = rng() % 32; i--;)
+					buf.push_back(static_cast<uint8_t>(rng()));
+		}
+		if (type == GarbageType::SeparatedLookalike)
+			buf.push_back(0xcc);
+	}
+	buf.resize(end);
+}
+
+static size_t Fuzz(size_t iterations) {
+	std::mt19937 rng(0);
+	size_t failures = 0;
+	for (size_t i = 0; i < iterations; ++i) {
+		std::vector<uint8_t> buf;
+		const auto type = static_cast<GarbageType>(i % 3);
+		AppendGarbage(rng, buf, rng() % 512, type);
+		const auto expected = buf.size();
+		AppendHeader(buf, rng() % 2 ? XivBundle::MagicConstant1 : XivBundle::MagicConstant2, static_cast<uint32_t>(sizeof(XivBundleHeader) + rng() % 0x10000));
+		AppendGarbage(rng, buf, rng() % 64, type);
+
+		// Planted garbage may form a usable header by chance, so the old function is what decides where the bundle begins.
+		const auto legacy = LegacyResync(buf);
+		const auto found = XivBundle::ExtractFrontTrash(buf).size();
+		if (legacy != found || legacy > expected) {
+			if (failures++ < 10)
+				std::cout << std::format("  case {}: legacy {}, found {}, planted {}\n", i, legacy, found, expected);
+		}
+
+		// If the planted header has not fully arrived yet, it must be waited for in a stream known to carry bundles, rather than thrown away as trash.
+		const auto cut = expected + rng() % sizeof(XivBundleHeader);
+		const auto cutBuf = std::span(buf).subspan(0, cut);
+		if (const auto foundCut = XivBundle::ExtractFrontTrash(cutBuf, true).size(); foundCut > legacy) {
+			if (failures++ < 10)
+				std::cout << std::format("  case {}: cut at {}, found {}, legacy {}\n", i, cut, foundCut, legacy);
+		}
+
+		// Otherwise, the same goes through as before.
+		if (const auto foundCut = XivBundle::ExtractFrontTrash(cutBuf).size(), legacyCut = LegacyResync(cutBuf); foundCut != legacyCut) {
+			if (failures++ < 10)
+				std::cout << std::format("  case {}: cut at {} in an unknown stream, found {}, legacy {}\n", i, cut, foundCut, legacyCut);
+		}
+	}
+	return failures;
+}
+
+template<typename TFn>
+static double Measure(const TFn& fn) {
+	size_t repeats = 0;
+	const auto start = std::chrono::steady_clock::now();
+	double elapsed;
+	do {
+		fn();
+		repeats++;
+		elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	} while (elapsed < 0.2);
+	return elapsed / static_cast<double>(repeats);
+}
+
+static size_t Benchmark() {
+	size_t failures = 0;
+	for (const auto type : { GarbageType::Random, GarbageType::SeparatedLookalike }) {
+		std::cout << (type == GarbageType::Random ? "Random garbage:\n" : "Zero runs, parts of magics, and broken headers:\n");
+		for (const auto length : { 4096, 65536, 1048576, 16777216 }) {
+			std::mt19937 rng(1);
+			std::vector<uint8_t> buf;
+			AppendGarbage(rng, buf, length, type);
+			AppendHeader(buf, XivBundle::MagicConstant1, 0x1000);
+
+			size_t found = 0;
+			const auto scan = Measure([&] { found = XivBundle::ExtractFrontTrash(buf).size(); });
+			if (found != static_cast<size_t>(length)) {
+				std::cout << std::format("  found {}, planted {}\n", found, length);
+				failures++;
+			}
+
+			size_t legacy = 0;
+			const auto legacyScan = Measure([&] { legacy = LegacyResync(buf); });
+			if (legacy != found) {
+				std::cout << std::format("  legacy {}, found {}\n", legacy, found);
+				failures++;
+			}
+			std::cout << std::format("  {:>8} bytes: legacy {:7.1f} MiB/s, single pass {:7.1f} MiB/s\n",
+				length, static_cast<double>(length) / legacyScan / 1048576, static_cast<double>(length) / scan / 1048576);
+		}
+	}
+	return failures;
+}
+
+int main() {
+	size_t failures = 0;
+
+	// Step. Edge cases.
+	{
+		std::vector<uint8_t> buf;
+		std::cout << std::format("Empty: {} trash\n", XivBundle::ExtractFrontTrash(buf).size());
+		failures += !XivBundle::ExtractFrontTrash(buf).empty();
+
+		buf = { 1, 2, 3 };
+		buf.insert(buf.end(), XivBundle::MagicConstant1, XivBundle::MagicConstant1 + 5);
+		std::cout << std::format("Partial magic at the end of a bundle stream: {} trash\n", XivBundle::ExtractFrontTrash(buf, true).size());
+		failures += XivBundle::ExtractFrontTrash(buf, true).size() != 3;
+
+		// Traffic that is not made of bundles, such as a request ending with zeroes, must go through in full.
+		for (const auto last : { 0x00, 0x52 }) {
+			buf.assign(40, 0xcc);
+			buf.insert(buf.end(), 3, static_cast<uint8_t>(last));
+			std::cout << std::format("Bytes of {:02x} at the end of other traffic: {} of {} bytes trash\n", last, XivBundle::ExtractFrontTrash(buf).size(), buf.size());
+			failures += XivBundle::ExtractFrontTrash(buf).size() != buf.size();
+		}
+		buf.assign(3, 0);
+		std::cout << std::format("Nothing but a part of a magic: {} trash\n", XivBundle::ExtractFrontTrash(buf).size());
+		failures += !XivBundle::ExtractFrontTrash(buf).empty();
+
+		buf.assign(100, 0xcc);
+		std::cout << std::format("No magic at all: {} trash\n", XivBundle::ExtractFrontTrash(buf).size());
+		failures += XivBundle::ExtractFrontTrash(buf).size() != buf.size();
+
+		buf.clear();
+		AppendHeader(buf, XivBundle::MagicConstant1, 0);
+		AppendHeader(buf, XivBundle::MagicConstant2, 12);
+		AppendHeader(buf, XivBundle::MagicConstant1, sizeof(XivBundleHeader));
+		std::cout << std::format("Headers too short: {} trash\n", XivBundle::ExtractFrontTrash(buf).size());
+		failures += XivBundle::ExtractFrontTrash(buf).size() != 2 * sizeof(XivBundleHeader);
+	}
+
+	// Step. Compare against the old search on random buffers.
+	std::cout << "Fuzzing:\n";
+	failures += Fuzz(200000);
+
+	// Step. Time both on large garbage prefixes.
+	failures += Benchmark();
+
+	std::cout << std::format("{} failure(s)\n", failures);
+	return failures ? 1 : 0;
+}
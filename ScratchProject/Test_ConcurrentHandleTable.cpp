@@ -0,0 +1,158 @@
+#include "pch.h"
+
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <random>
+#include <thread>
+
+#include <XivAlexanderCommon/Utils/ConcurrentHandleTable.h>
+
+static constexpr auto ReaderThreads = 8;
+static constexpr auto LookupsPerThread = 2000000;
+static constexpr auto LiveHandles = 256;
+
+struct Value {
+	uintptr_t Key;
+	std::atomic<int> Alive = 1;
+
+	Value(uintptr_t key) : Key(key) {}
+	~Value() { Alive = 0; }
+};
+
+static uintptr_t MakeKey(uint32_t n) {
+	return 0x1000 + 4 * static_cast<uintptr_t>(n);
+}
+
+int main() {
+	// Step. Correctness under stress: readers never see a dead value or a value of another key, while a writer keeps replacing entries.
+	{
+		Utils::ConcurrentHandleTable<uintptr_t, Value> table(4096);
+		for (uint32_t i = 0; i < LiveHandles; ++i)
+			table.Insert(MakeKey(i), std::make_unique<Value>(MakeKey(i)));
+
+		std::atomic_bool stop = false;
+		std::atomic<uint64_t> hits = 0, misses = 0, errors = 0, churns = 0;
+		std::vector<std::thread> threads;
+		for (auto t = 0; t < ReaderThreads; ++t) {
+			threads.emplace_back([&, t]() {
+				std::mt19937 rng(t);
+				uint64_t h = 0, m = 0, e = 0;
+				for (auto i = 0; i < LookupsPerThread; ++i) {
+					const auto key = MakeKey(rng() % (LiveHandles * 2));
+					if (const auto lease = table.Find(key)) {
+						if (lease->Key != key || !lease->Alive)
+							e++;
+						h++;
+					} else
+						m++;
+				}
+				hits += h;
+				misses += m;
+				errors += e;
+			});
+		}
+		threads.emplace_back([&]() {
+			std::mt19937 rng(12345);
+			while (!stop) {
+				const auto n = static_cast<uint32_t>(rng() % LiveHandles);
+				if (table.Erase(MakeKey(n)))
+					table.Insert(MakeKey(n + LiveHandles), std::make_unique<Value>(MakeKey(n + LiveHandles)));
+				else if (table.Erase(MakeKey(n + LiveHandles)))
+					table.Insert(MakeKey(n), std::make_unique<Value>(MakeKey(n)));
+				churns++;
+			}
+		});
+		for (auto t = 0; t < ReaderThreads; ++t)
+			threads[t].join();
+		stop = true;
+		threads.back().join();
+
+		std::cout << std::format("Stress: {} hits, {} misses, {} replacements, {} errors\n",
+			hits.load(), misses.load(), churns.load(), errors.load());
+		if (errors)
+			return 1;
+	}
+
+	// Step. Heavy open/close churn leaves tombstones everywhere; misses, the common case on ReadFile, must still stop early.
+	{
+		// Scrambled keys and a quarter-full table, so that keys collide and tombstones pile up in between.
+		const auto scrambled = [](uint32_t n) { return MakeKey((n * 2654435761u) >> 4); };
+		Utils::ConcurrentHandleTable<uintptr_t, Value> table(LiveHandles * 4);
+		std::vector<uint32_t> live;
+		std::mt19937 rng(0);
+		uint32_t next = 0;
+		for (auto i = 0; i < 1000000; ++i) {
+			if (live.size() < 64 || (live.size() < LiveHandles && rng() % 2)) {
+				table.Insert(scrambled(next), std::make_unique<Value>(scrambled(next)));
+				live.push_back(next++);
+			} else {
+				const auto index = rng() % live.size();
+				if (!table.Erase(scrambled(live[index])))
+					return 1;
+				live[index] = live.back();
+				live.pop_back();
+			}
+		}
+
+		uint64_t errors = 0;
+		for (const auto n : live) {
+			if (const auto lease = table.Find(scrambled(n)); !lease || lease->Key != scrambled(n))
+				errors++;
+		}
+
+		const auto t0 = std::chrono::steady_clock::now();
+		uint64_t found = 0;
+		for (auto i = 0; i < LookupsPerThread; ++i)
+			found += !!table.Find(scrambled(next + static_cast<uint32_t>(rng() % 65536)));
+		const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - t0).count();
+
+		std::cout << std::format("Churn: {} handles opened, {} live, longest probe {} of {} slots, {} misses in {}ms, {} errors\n",
+			next, live.size(), table.LongestProbe(), table.Capacity(), LookupsPerThread - found, ms, errors + found);
+		if (errors || found || table.LongestProbe() >= table.Capacity() / 16)
+			return 1;
+	}
+
+	// Step. Lookup throughput against the previous std::map, guarded by a mutex as concurrent access requires.
+	const auto bench = [](const char* name, auto&& find) {
+		const auto t0 = std::chrono::steady_clock::now();
+		std::atomic<uint64_t> found = 0;
+		std::vector<std::thread> threads;
+		for (auto t = 0; t < ReaderThreads; ++t) {
+			threads.emplace_back([&, t]() {
+				std::mt19937 rng(t);
+				uint64_t f = 0;
+				for (auto i = 0; i < LookupsPerThread; ++i)
+					f += find(MakeKey(rng() % (LiveHandles * 8)));
+				found += f;
+			});
+		}
+		for (auto& thread : threads)
+			thread.join();
+		const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - t0).count();
+		std::cout << std::format("{}: {} lookups x {} threads, {} found, {}ms\n", name, LookupsPerThread, ReaderThreads, found.load(), ms);
+	};
+
+	{
+		std::map<uintptr_t, std::unique_ptr<Value>> map;
+		std::mutex mtx;
+		for (uint32_t i = 0; i < LiveHandles; ++i)
+			map.emplace(MakeKey(i), std::make_unique<Value>(MakeKey(i)));
+		bench("std::map + mutex", [&](uintptr_t key) {
+			const auto lock = std::lock_guard(mtx);
+			const auto it = map.find(key);
+			return it != map.end() && it->second->Key == key;
+		});
+	}
+
+	{
+		Utils::ConcurrentHandleTable<uintptr_t, Value> table(4096);
+		for (uint32_t i = 0; i < LiveHandles; ++i)
+			table.Insert(MakeKey(i), std::make_unique<Value>(MakeKey(i)));
+		bench("ConcurrentHandleTable", [&](uintptr_t key) {
+			const auto lease = table.Find(key);
+			return lease && lease->Key == key;
+		});
+	}
+	return 0;
+}
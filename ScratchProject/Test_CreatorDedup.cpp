@@ -0,0 +1,48 @@
+#include "pch.h"
+
+#include <chrono>
+
+#include <XivAlexanderCommon/Sqex/Sqpack/Creator.h>
+
+static uint64_t TotalDataSize(const Sqex::Sqpack::Creator::SqpackViews& views) {
+	uint64_t size = 0;
+	for (const auto& data : views.Data)
+		size += data->StreamSize();
+	return size;
+}
+
+int main(int argc, char** argv) {
+	// Extracted TTMP directory with TTMPL.mpl and TTMPD.mpd; mod collections with shared textures benefit the most.
+	const std::filesystem::path ttmpDir = argc > 1 ? argv[1] : R"(Z:\ttmp\extracted)";
+
+	const auto build = [&ttmpDir](bool deduplicate) {
+		auto creator = Sqex::Sqpack::Creator("ffxiv", "040000");
+		const auto logger = creator.Log([](const std::string& s) { std::cout << s << "\n"; });
+		void(creator.AddAllEntriesFromSimpleTTMP(ttmpDir));
+
+		const auto t0 = std::chrono::steady_clock::now();
+		auto views = creator.AsViews(false, nullptr, deduplicate);
+		const auto t1 = std::chrono::steady_clock::now();
+		return std::make_pair(std::move(views), std::chrono::duration_cast<std::chrono::milliseconds>(t1 - t0).count());
+	};
+
+	const auto [plain, plainMs] = build(false);
+	const auto [dedup, dedupMs] = build(true);
+
+	// Every entry must read back the same bytes through its locator.
+	std::vector<uint8_t> expected, actual;
+	size_t mismatches = 0;
+	for (const auto& entry : dedup.Entries) {
+		const auto& data = *dedup.Data[entry->Locator.DatFileIndex];
+		expected.resize(static_cast<size_t>(entry->Provider->StreamSize()));
+		actual.resize(expected.size());
+		entry->Provider->ReadStream(0, std::span(expected));
+		data.ReadStream(entry->Locator.DatFileOffset(), std::span(actual));
+		if (expected != actual)
+			mismatches++;
+	}
+
+	std::cout << std::format("{} entries: without dedup {} bytes in {}ms; with dedup {} bytes in {}ms; saved {} bytes; {} mismatches\n",
+		dedup.Entries.size(), TotalDataSize(plain), plainMs, TotalDataSize(dedup), dedupMs, dedup.DeduplicatedSize, mismatches);
+	return mismatches ? 1 : 0;
+}
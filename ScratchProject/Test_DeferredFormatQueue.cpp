@@ -0,0 +1,170 @@
+// Portable; also builds outside Windows: g++ -std=c++20 -O2 -pthread -I.. Test_DeferredFormatQueue.cpp
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <XivAlexanderCommon/Utils/DeferredFormatQueue.h>
+
+enum class TestLevel {
+	Unset = 0,
+	Debug = 10,
+	Info = 20,
+};
+
+struct Meta {
+	int Category;
+	TestLevel Level;
+	std::chrono::system_clock::time_point Timestamp;
+};
+
+// What Logger does per call: level check, then deferred push, or format and append under a lock.
+struct Sink {
+	std::array<std::atomic<TestLevel>, 16> MinimumLevels{};
+	Utils::DeferredFormatQueue<Meta> Queue{ 1 << 16 };
+	std::mutex Mutex;
+	std::deque<std::string> Items;
+
+	bool IsEnabled(int category, TestLevel level) const {
+		return level >= MinimumLevels[category].load(std::memory_order_relaxed);
+	}
+
+	template<typename...Args>
+	void Deferred(int category, TestLevel level, const char* format, Args&&...args) {
+		if (!IsEnabled(category, level))
+			return;
+		if (!Queue.TryPush(Meta{ category, level, std::chrono::system_clock::now() }, format, std::forward<Args>(args)...))
+			Eager(category, level, format, std::forward<Args>(args)...);
+	}
+
+	template<typename...Args>
+	void Eager(int category, TestLevel level, const char* format, Args&&...args) {
+		if (!IsEnabled(category, level))
+			return;
+		auto s = std::vformat(format, std::make_format_args(args...));
+		std::lock_guard lock(Mutex);
+		Items.emplace_back(std::move(s));
+	}
+};
+
+template<typename Fn>
+static double NanosecondsPerCall(size_t count, Fn&& fn) {
+	const auto start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < count; ++i)
+		fn(i);
+	return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / static_cast<double>(count);
+}
+
+int main() {
+	size_t failures = 0;
+
+	// Step. Formatting results must match what eager formatting would have produced.
+	{
+		Utils::DeferredFormatQueue<int> q(8);
+		std::string dynamic = "dyn";
+		const char* cstr = "cstr";
+		std::wstring_view wide = L"wide";
+		q.TryPush(1, "{} {} {:08x} {:.2f}", dynamic, cstr, 0xBEEFu, 1.5);
+		q.TryPush(2, L"{} {}", wide, 42);
+		q.TryPush(3, "{} {}", 1);
+		dynamic = "changed";
+		std::vector<std::string> got;
+		q.Drain([&](int, Utils::DeferredFormatQueue<int>::FormattedText& text) {
+			if (const auto s = std::get_if<std::string>(&text))
+				got.push_back(*s);
+			else
+				got.push_back(std::string(std::get<std::wstring>(text).begin(), std::get<std::wstring>(text).end()));
+		});
+		const std::vector<std::string> expected{ "dyn cstr 0000beef 1.50", "wide 42", "<format error: " };
+		for (size_t i = 0; i < expected.size(); ++i) {
+			if (i >= got.size() || !got[i].starts_with(expected[i])) {
+				std::printf("format mismatch at %zu: %s\n", i, i < got.size() ? got[i].c_str() : "(missing)");
+				failures++;
+			}
+		}
+
+		// Non-value arguments are refused, so that the caller formats them eagerly.
+		if (Utils::DeferredFormatQueue<int>::IsDeferrable<char, std::vector<int>&>)
+			failures++;
+	}
+
+	// Step. Full queue refuses pushes instead of blocking.
+	{
+		Utils::DeferredFormatQueue<int> q(4);
+		size_t accepted = 0;
+		for (int i = 0; i < 10; ++i)
+			accepted += q.TryPush(i, "{}", i);
+		if (accepted != 4) {
+			std::printf("full queue accepted %zu\n", accepted);
+			failures++;
+		}
+	}
+
+	// Step. Multiple producers, one consumer; every record arrives exactly once and in per-producer order.
+	{
+		constexpr size_t Producers = 4, PerProducer = 200000;
+		Utils::DeferredFormatQueue<int> q(1024);
+		std::atomic<size_t> done = 0;
+		std::vector<std::thread> threads;
+		for (size_t p = 0; p < Producers; ++p) {
+			threads.emplace_back([&, p]() {
+				for (size_t i = 0; i < PerProducer; ++i) {
+					while (!q.TryPush(static_cast<int>(p), "{} {}", p, i))
+						std::this_thread::yield();
+				}
+				++done;
+			});
+		}
+		std::vector<size_t> next(Producers);
+		size_t received = 0;
+		const auto consume = [&](int p, Utils::DeferredFormatQueue<int>::FormattedText& text) {
+			const auto expected = std::format("{} {}", p, next[p]++);
+			if (std::get<std::string>(text) != expected)
+				failures++;
+			received++;
+		};
+		while (done < Producers)
+			q.Drain(consume);
+		q.Drain(consume);
+		for (auto& t : threads)
+			t.join();
+		if (received != Producers * PerProducer) {
+			std::printf("received %zu of %zu\n", received, Producers * PerProducer);
+			failures++;
+		}
+	}
+
+	// Step. Cost per call at the producer side.
+	{
+		constexpr size_t Count = 50000;
+		Sink sink;
+		const std::string name = "TestObject";
+
+		sink.MinimumLevels[0] = TestLevel::Info;
+		const auto disabled = NanosecondsPerCall(Count * 100, [&](size_t i) {
+			sink.Deferred(0, TestLevel::Debug, "{}: Writing to 0x{:X} (0x{:X} bytes)", name, i, i * 2);
+		});
+
+		const auto deferred = NanosecondsPerCall(Count, [&](size_t i) {
+			sink.Deferred(0, TestLevel::Info, "{}: Writing to 0x{:X} (0x{:X} bytes)", name, i, i * 2);
+		});
+		sink.Queue.Drain([](Meta&, auto&) {});
+
+		const auto eager = NanosecondsPerCall(Count, [&](size_t i) {
+			sink.Eager(0, TestLevel::Info, "{}: Writing to 0x{:X} (0x{:X} bytes)", name, i, i * 2);
+		});
+
+		std::printf("disabled level:        %8.2f ns/call\n", disabled);
+		std::printf("enabled, deferred:     %8.2f ns/call\n", deferred);
+		std::printf("enabled, eager format: %8.2f ns/call\n", eager);
+	}
+
+	std::printf("%zu failure(s)\n", failures);
+	return failures ? 1 : 0;
+}
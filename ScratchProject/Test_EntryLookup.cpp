@@ -0,0 +1,103 @@
+#include "pch.h"
+
+#include <chrono>
+#include <random>
+
+#include <XivAlexanderCommon/Sqex/Sqpack/Creator.h>
+#include <XivAlexanderCommon/Sqex/Sqpack/EntryLookup.h>
+#include <XivAlexanderCommon/Sqex/ThirdParty/TexTools.h>
+
+// What VirtualSqPacks used to do.
+static const Sqex::Sqpack::Creator::Entry* FindByProbing(const std::map<std::filesystem::path, Sqex::Sqpack::Creator::SqpackViews>& allViews, const Sqex::Sqpack::EntryPathSpec& pathSpec) {
+	for (const auto& views : allViews | std::views::values) {
+		auto it = views.HashOnlyEntries.find(pathSpec);
+		if (it == views.HashOnlyEntries.end()) {
+			it = views.FullPathEntries.find(pathSpec);
+			if (it == views.FullPathEntries.end())
+				continue;
+		}
+		return it->second.get();
+	}
+	return nullptr;
+}
+
+int main(int argc, char** argv) {
+	const std::filesystem::path sqpackPath = argc > 1 ? argv[1] : R"(C:\Program Files (x86)\SquareEnix\FINAL FANTASY XIV - A Realm Reborn\game\sqpack)";
+	constexpr size_t LookupCount = 100000;
+
+	// Step. Load every index file, as VirtualSqPacks does.
+	std::map<std::filesystem::path, Sqex::Sqpack::Creator::SqpackViews> allViews;
+	for (const auto& expac : std::filesystem::directory_iterator(sqpackPath)) {
+		if (!expac.is_directory())
+			continue;
+		for (const auto& file : std::filesystem::directory_iterator(expac)) {
+			if (file.path().extension() != L".index")
+				continue;
+			auto creator = Sqex::Sqpack::Creator(expac.path().filename().string(), file.path().filename().replace_extension().replace_extension().string());
+			void(creator.AddEntriesFromSqPack(file.path(), true, true));
+			allViews.emplace(file.path(), creator.AsViews(false));
+		}
+	}
+
+	const auto t0 = std::chrono::steady_clock::now();
+	Sqex::Sqpack::EntryLookup lookup;
+	for (const auto& views : allViews | std::views::values)
+		lookup.Add(views);
+	const auto t1 = std::chrono::steady_clock::now();
+	std::cout << std::format("{} views, {} entries; built in {}ms\n",
+		allViews.size(), lookup.Size(), std::chrono::duration_cast<std::chrono::milliseconds>(t1 - t0).count());
+
+	// Step. Mostly existing entries, some full paths, and some misses.
+	std::vector<Sqex::Sqpack::EntryPathSpec> existing;
+	for (const auto& views : allViews | std::views::values) {
+		for (const auto& pathSpec : views.HashOnlyEntries | std::views::keys)
+			existing.emplace_back(pathSpec);
+	}
+	std::mt19937 rng(0);
+	std::vector<Sqex::Sqpack::EntryPathSpec> queries;
+	queries.reserve(LookupCount);
+	for (size_t i = 0; i < LookupCount; ++i) {
+		switch (i % 10) {
+			case 0:
+				queries.emplace_back(static_cast<uint32_t>(rng()), static_cast<uint32_t>(rng()), static_cast<uint32_t>(rng()));
+				break;
+			case 1:
+				queries.emplace_back(Sqex::ThirdParty::TexTools::ItemMetadata::EqdpPath(Sqex::ThirdParty::TexTools::ItemMetadata::TargetItemType::Equipment, 101 + 100 * static_cast<uint32_t>(i / 10 % 18)));
+				break;
+			default:
+				queries.emplace_back(existing[rng() % existing.size()]);
+		}
+	}
+
+	// Step. Time each way, and compare the results.
+	std::vector<const Sqex::Sqpack::Creator::Entry*> expected(queries.size()), single(queries.size()), batch(queries.size());
+	const auto measure = [](const char* name, const std::function<void()>& fn) {
+		const auto start = std::chrono::steady_clock::now();
+		fn();
+		const auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		std::cout << std::format("{:<12} {:8.2f}ms, {:6.1f}ns/lookup\n", name, seconds * 1000, seconds * 1e9 / LookupCount);
+	};
+	measure("probing", [&]() {
+		for (size_t i = 0; i < queries.size(); ++i)
+			expected[i] = FindByProbing(allViews, queries[i]);
+	});
+	measure("EntryLookup", [&]() {
+		for (size_t i = 0; i < queries.size(); ++i) {
+			const auto match = lookup.Find(queries[i]);
+			single[i] = match ? match->Entry : nullptr;
+		}
+	});
+	measure("batch", [&]() {
+		const auto matches = lookup.Find(std::span(queries));
+		for (size_t i = 0; i < queries.size(); ++i)
+			batch[i] = matches[i] ? matches[i]->Entry : nullptr;
+	});
+
+	size_t mismatches = 0;
+	for (size_t i = 0; i < queries.size(); ++i) {
+		if (expected[i] != single[i] || expected[i] != batch[i])
+			mismatches++;
+	}
+	std::cout << std::format("{} found, {} mismatches\n", std::ranges::count_if(expected, [](const auto* p) { return p != nullptr; }), mismatches);
+	return mismatches ? 1 : 0;
+}
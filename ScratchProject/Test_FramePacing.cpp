@@ -0,0 +1,88 @@
+// Portable; also builds outside Windows: g++ -std=c++20 -O2 -I.. Test_FramePacing.cpp
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+
+#include <XivAlexanderCommon/Utils/FramePacing.h>
+
+// The loop MainThreadTimingHandler used, with its two bugs fixed:
+// - minDiff started from UINT64_MAX, which became -1 and made the loop always pick 0.
+// - The target was floor(now / prevInterval) * prevInterval + prevDrift + interval, which is a whole previous interval late
+//   whenever now % prevInterval < prevDrift; the last render of the previous schedule is computed the way renders are scheduled instead.
+static int64_t CalculateRenderDriftUsByLoop(int64_t nowUs, int64_t prevIntervalUs, int64_t prevDriftUs, int64_t intervalUs) {
+	const auto prevRenderTimestamp = (nowUs - prevDriftUs) / prevIntervalUs * prevIntervalUs + prevDriftUs + intervalUs;
+	int64_t minDiff = INT64_MAX;
+	int64_t minDriftUs = 0;
+	for (int64_t i = 0; i < intervalUs; ++i) {
+		const auto nextRenderTimestamp = static_cast<int64_t>((1 + (nowUs - i) / intervalUs) * intervalUs + i);
+		if (nextRenderTimestamp < prevRenderTimestamp)
+			continue;
+		const auto diff = nextRenderTimestamp - prevRenderTimestamp;
+		if (diff < minDiff) {
+			minDiff = diff;
+			minDriftUs = i;
+		}
+	}
+	return minDriftUs;
+}
+
+int main() {
+	uint64_t cases = 0, failures = 0;
+	const auto check = [&](int64_t now, int64_t prevInterval, int64_t prevDrift, int64_t interval) {
+		cases++;
+		const auto expected = CalculateRenderDriftUsByLoop(now, prevInterval, prevDrift, interval);
+		const auto actual = Utils::FramePacing::CalculateRenderDriftUs(now, prevInterval, prevDrift, interval);
+		if (expected != actual && failures++ < 10) {
+			std::printf("Mismatch: now=%lld prevInterval=%lld prevDrift=%lld interval=%lld: loop=%lld closed=%lld\n",
+				static_cast<long long>(now), static_cast<long long>(prevInterval), static_cast<long long>(prevDrift), static_cast<long long>(interval),
+				static_cast<long long>(expected), static_cast<long long>(actual));
+		}
+
+		// The first render on the new schedule, computed the way MainThreadTimingHandler does,
+		// is the earliest one after now that is at least one new interval after the last render on the previous schedule.
+		const auto lastRender = (now - prevDrift) / prevInterval * prevInterval + prevDrift;
+		const auto nextRender = (1 + (now - actual) / interval) * interval + actual;
+		if ((nextRender < lastRender + interval || (nextRender > now + 1 && nextRender - 1 >= lastRender + interval)) && failures++ < 10) {
+			std::printf("Misaligned: now=%lld prevInterval=%lld prevDrift=%lld interval=%lld: last=%lld next=%lld\n",
+				static_cast<long long>(now), static_cast<long long>(prevInterval), static_cast<long long>(prevDrift), static_cast<long long>(interval),
+				static_cast<long long>(lastRender), static_cast<long long>(nextRender));
+		}
+	};
+
+	// Step. Exhaustive over small intervals, every previous phase, and timestamps spanning several periods of both.
+	for (int64_t interval = 1; interval <= 48; ++interval) {
+		for (int64_t prevInterval = 1; prevInterval <= 48; ++prevInterval) {
+			for (int64_t prevDrift = 0; prevDrift < prevInterval; ++prevDrift) {
+				for (int64_t now = std::max(interval, prevInterval); now < 5 * std::max(interval, prevInterval); ++now)
+					check(now, prevInterval, prevDrift, interval);
+			}
+		}
+	}
+
+	// Step. Randomized over realistic values: QPC-based microsecond timestamps and 10 to 240 fps.
+	std::mt19937_64 rng(0x5EED);
+	for (auto i = 0; i < 20000; ++i) {
+		const auto interval = static_cast<int64_t>(1000000 / 240 + rng() % (1000000 / 10 - 1000000 / 240));
+		const auto prevInterval = static_cast<int64_t>(1000000 / 240 + rng() % (1000000 / 10 - 1000000 / 240));
+		const auto prevDrift = static_cast<int64_t>(rng() % prevInterval);
+		const auto now = static_cast<int64_t>(1000000 + rng() % (1ULL << 42));
+		check(now, prevInterval, prevDrift, interval);
+	}
+	std::printf("%llu cases, %llu mismatches\n", static_cast<unsigned long long>(cases), static_cast<unsigned long long>(failures));
+
+	// Step. Per-frame cost at 60fps.
+	static constexpr auto Iterations = 10000;
+	int64_t sink = 0;
+	const auto t0 = std::chrono::steady_clock::now();
+	for (auto i = 0; i < Iterations; ++i)
+		sink += CalculateRenderDriftUsByLoop(1000000000 + i * 7, 16666 + (i & 1), i % 16666, 16667 - (i & 1));
+	const auto t1 = std::chrono::steady_clock::now();
+	for (auto i = 0; i < Iterations; ++i)
+		sink += Utils::FramePacing::CalculateRenderDriftUs(1000000000 + i * 7, 16666 + (i & 1), i % 16666, 16667 - (i & 1));
+	const auto t2 = std::chrono::steady_clock::now();
+	const auto ns = [](auto d) { return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(d).count()) / Iterations; };
+	std::printf("Per call at 60fps: loop %.1fns, closed form %.1fns (%lld)\n", ns(t1 - t0), ns(t2 - t1), static_cast<long long>(sink));
+
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,80 @@
+#include "pch.h"
+
+#include <chrono>
+#include <random>
+
+#include <XivAlexanderCommon/Sqex/Sqpack/Reader.h>
+
+static constexpr auto LookupCount = 100000;
+
+int main() {
+	const std::filesystem::path gamePath = LR"(C:\Program Files (x86)\SquareEnix\FINAL FANTASY XIV - A Realm Reborn\game)";
+
+	// Readers loaded one by one, tried in turn: how GameReader resolved hash-only paths before.
+	std::vector<Sqex::Sqpack::Reader> readers;
+	for (const auto& iter : std::filesystem::recursive_directory_iterator(gamePath / "sqpack")) {
+		if (!iter.is_directory() && iter.path().wstring().ends_with(L".win32.index"))
+			readers.emplace_back(Sqex::Sqpack::Reader::FromPath(iter.path()));
+	}
+
+	// Half of the lookups hit an existing entry, and the other half are random hashes that most likely miss.
+	std::mt19937 rng(0x5EED);
+	std::vector<Sqex::Sqpack::EntryPathSpec> pathSpecs;
+	pathSpecs.reserve(LookupCount);
+	while (pathSpecs.size() < LookupCount) {
+		if (rng() % 2) {
+			const auto& reader = readers[rng() % readers.size()];
+			if (reader.EntryInfo.empty())
+				continue;
+			const auto& spec = reader.EntryInfo[rng() % reader.EntryInfo.size()].second.PathSpec;
+			if (rng() % 2 && spec.HasFullPathHash())
+				pathSpecs.emplace_back(spec.FullPathHash);
+			else if (spec.HasComponentHash())
+				pathSpecs.emplace_back(spec.PathHash, spec.NameHash);
+		} else if (rng() % 2)
+			pathSpecs.emplace_back(static_cast<uint32_t>(rng()));
+		else
+			pathSpecs.emplace_back(static_cast<uint32_t>(rng()), static_cast<uint32_t>(rng()));
+	}
+
+	const auto t0 = std::chrono::steady_clock::now();
+	std::vector<uint64_t> sequentialResults;
+	for (const auto& pathSpec : pathSpecs) {
+		uint64_t size = UINT64_MAX;
+		for (const auto& reader : readers) {
+			try {
+				size = reader.GetEntryProvider(pathSpec)->StreamSize();
+				break;
+			} catch (const std::out_of_range&) {
+				// pass
+			}
+		}
+		sequentialResults.emplace_back(size);
+	}
+
+	const auto t1 = std::chrono::steady_clock::now();
+	const auto gameReader = Sqex::Sqpack::GameReader(gamePath);
+	try {
+		void(gameReader.GetEntryProvider(Sqex::Sqpack::EntryPathSpec(0U)));
+	} catch (const std::out_of_range&) {
+		// pass; only here to build the index
+	}
+
+	const auto t2 = std::chrono::steady_clock::now();
+	std::vector<uint64_t> indexedResults;
+	for (const auto& pathSpec : pathSpecs) {
+		try {
+			indexedResults.emplace_back(gameReader.GetEntryProvider(pathSpec)->StreamSize());
+		} catch (const std::out_of_range&) {
+			indexedResults.emplace_back(UINT64_MAX);
+		}
+	}
+	const auto t3 = std::chrono::steady_clock::now();
+
+	const auto ms = [](auto d) { return std::chrono::duration_cast<std::chrono::milliseconds>(d).count(); };
+	const auto found = std::ranges::count_if(indexedResults, [](const auto& r) { return r != UINT64_MAX; });
+	std::cout << std::format("{} lookups ({} found) across {} index files: sequential {}ms; index build {}ms, indexed {}ms; {}\n",
+		LookupCount, found, readers.size(), ms(t1 - t0), ms(t2 - t1), ms(t3 - t2),
+		sequentialResults == indexedResults ? "identical" : "MISMATCH");
+	return 0;
+}
@@ -0,0 +1,104 @@
+// Portable; also builds outside Windows: g++ -std=c++20 -O2 -I.. Test_HybridWaiter.cpp
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include <XivAlexanderCommon/Utils/FramePacing.h>
+
+static constexpr auto Frames = 20000;
+static constexpr int64_t FrameIntervalUs = 16667;
+static constexpr int64_t WorkUs = 6000;
+
+struct Summary {
+	std::vector<int64_t> Late;
+	int64_t SpunUs = 0;
+
+	void Print(const char* name) {
+		std::ranges::sort(Late);
+		std::printf("%-12s late p50 %5lldus, p99 %5lldus, max %5lldus; spinning %5.2f%% of a core\n", name,
+			static_cast<long long>(Late[Late.size() / 2]), static_cast<long long>(Late[Late.size() * 99 / 100]), static_cast<long long>(Late.back()),
+			100. * static_cast<double>(SpunUs) / static_cast<double>(Frames * FrameIntervalUs));
+	}
+};
+
+// Timer that wakes up 100-1000us late, and 1% of the time up to 3ms late.
+struct SimulatedClock {
+	int64_t NowUs = 1000000;
+	std::mt19937_64 Rng{ 0x5EED };
+
+	void Sleep(int64_t us) {
+		NowUs += us + 100 + static_cast<int64_t>(Rng() % 900);
+		if (Rng() % 100 == 0)
+			NowUs += static_cast<int64_t>(Rng() % 3000);
+	}
+
+	void Pause() {
+		NowUs += 1;
+	}
+};
+
+int main() {
+	// Step. Simulated clock: compare sleeping only, spinning only, and the hybrid waiter.
+	{
+		SimulatedClock clock;
+		Summary s;
+		for (auto i = 0; i < Frames; ++i) {
+			clock.NowUs += WorkUs;
+			const auto deadline = (clock.NowUs / FrameIntervalUs + 1) * FrameIntervalUs;
+			clock.Sleep(deadline - clock.NowUs);
+			s.Late.push_back(std::max<int64_t>(0, clock.NowUs - deadline));
+		}
+		s.Print("Sleep only");
+	}
+	{
+		SimulatedClock clock;
+		Summary s;
+		for (auto i = 0; i < Frames; ++i) {
+			clock.NowUs += WorkUs;
+			const auto deadline = (clock.NowUs / FrameIntervalUs + 1) * FrameIntervalUs;
+			s.SpunUs += deadline - clock.NowUs;
+			clock.NowUs = deadline;
+			s.Late.push_back(0);
+		}
+		s.Print("Spin only");
+	}
+	{
+		SimulatedClock clock;
+		Summary s;
+		Utils::FramePacing::HybridWaiter waiter(
+			[&clock]() { return clock.NowUs; },
+			[&clock](int64_t us) { clock.Sleep(us); },
+			[&clock]() { clock.Pause(); });
+		for (auto i = 0; i < Frames; ++i) {
+			clock.NowUs += WorkUs;
+			const auto res = waiter.WaitUntil((clock.NowUs / FrameIntervalUs + 1) * FrameIntervalUs);
+			s.SpunUs += res.SpunUs;
+			s.Late.push_back(res.LateUs);
+		}
+		s.Print("Hybrid");
+		std::printf("Hybrid learned margin: %lldus\n", static_cast<long long>(waiter.MarginUs()));
+	}
+
+	// Step. Real clock and sleep_for of this machine, 300 frames.
+	{
+		const auto nowUs = []() {
+			return static_cast<int64_t>(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+		};
+		Utils::FramePacing::HybridWaiter waiter(nowUs, [](int64_t us) { std::this_thread::sleep_for(std::chrono::microseconds(us)); });
+		std::vector<int64_t> late;
+		int64_t spun = 0;
+		for (auto i = 0; i < 300; ++i) {
+			const auto res = waiter.WaitUntil((nowUs() / FrameIntervalUs + 1) * FrameIntervalUs);
+			spun += res.SpunUs;
+			late.push_back(res.LateUs);
+		}
+		std::ranges::sort(late);
+		std::printf("Real clock: late p50 %lldus, max %lldus; margin %lldus; spinning %.2f%% of a core\n",
+			static_cast<long long>(late[late.size() / 2]), static_cast<long long>(late.back()), static_cast<long long>(waiter.MarginUs()),
+			100. * static_cast<double>(spun) / (300. * FrameIntervalUs));
+	}
+	return 0;
+}
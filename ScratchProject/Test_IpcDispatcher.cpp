@@ -0,0 +1,201 @@
+#include "pch.h"
+
+#include <chrono>
+#include <limits>
+#include <map>
+#include <random>
+
+#include <XivAlexanderCommon/Sqex/Network/IpcDispatcher.h>
+
+using namespace Sqex::Network::Structure;
+
+// Opcodes as they would be set in game config.
+static constexpr uint16_t ActionRequest[]{ 0x0123, 0x0124 };
+static constexpr uint16_t ActionEffects[]{ 0x0201, 0x0202, 0x0203, 0x0204, 0x0205 };
+static constexpr uint16_t ActorControl = 0x0301;
+static constexpr uint16_t ActorControlSelf = 0x0302;
+static constexpr uint16_t ActorCast = 0x0303;
+static constexpr uint32_t ActionEffectLengths[]{ 0x9c, 0x29c, 0x4dc, 0x71c, 0x95c };
+
+static constexpr uint32_t PlayerId = 0x10000001;
+
+static std::vector<std::vector<uint8_t>> MakeRaidStream(size_t count) {
+	std::mt19937 rng(0);
+	std::vector<std::vector<uint8_t>> messages;
+	messages.reserve(count);
+
+	const auto add = [&](uint32_t source, IpcType type, uint16_t subType, uint32_t length) {
+		auto& buf = messages.emplace_back(std::max<size_t>(length, sizeof(XivMessageHeader) + sizeof(XivIpcHeader) + sizeof(XivIpcs::S2C_ActorControlSelf)));
+		auto& message = *reinterpret_cast<XivMessage*>(buf.data());
+		message.Length = length;
+		message.SourceActor = source;
+		message.CurrentActor = PlayerId;
+		message.Type = MessageType::Ipc;
+		message.Data.Ipc.Type = type;
+		message.Data.Ipc.SubType = subType;
+	};
+
+	// 24 players and a boss: mostly movement, status and HP updates of others, with actions sprinkled in.
+	while (messages.size() < count) {
+		const auto source = rng() % 25 == 0 ? PlayerId : 0x10000100 + rng() % 24;
+		switch (const auto roll = rng() % 100) {
+			case 0: case 1: case 2: case 3: case 4: case 5:
+				add(source, IpcType::InterestedType, ActionEffects[roll % 5], ActionEffectLengths[roll % 5]);
+				break;
+			case 6: case 7: case 8:
+				add(source, IpcType::InterestedType, ActorControlSelf, sizeof(XivMessageHeader) + sizeof(XivIpcHeader) + sizeof(XivIpcs::S2C_ActorControlSelf));
+				break;
+			case 9: case 10: case 11: case 12:
+				add(source, IpcType::InterestedType, ActorControl, sizeof(XivMessageHeader) + sizeof(XivIpcHeader) + sizeof(XivIpcs::S2C_ActorControl));
+				break;
+			case 13:
+				add(source, IpcType::InterestedType, ActorCast, sizeof(XivMessageHeader) + sizeof(XivIpcHeader) + sizeof(XivIpcs::S2C_ActorCast));
+				break;
+			case 14:
+				add(PlayerId, IpcType::CustomType, 0, sizeof(XivMessageHeader) + sizeof(XivIpcHeader) + sizeof(XivIpcs::S2C_Custom_OriginalWaitTime));
+				break;
+			default:
+				add(source, IpcType::InterestedType, static_cast<uint16_t>(0x0400 + rng() % 0x200), 0x20 + 8 * (rng() % 64));
+		}
+	}
+	return messages;
+}
+
+struct Counters {
+	uint64_t TimingHandler = 0;
+	uint64_t TypeFinder = 0;
+	uint64_t Logger = 0;
+	uint64_t Dropped = 0;
+
+	bool operator==(const Counters&) const = default;
+};
+
+// Roughly what NetworkTimingHandler, IpcTypeFinder and AllIpcMessageLogger test, with the work itself replaced by counting.
+struct Handlers {
+	Counters& Count;
+	bool TypeFinder;
+	bool Logger;
+
+	// What the handlers used to do: look at every message, and decide whether it is of interest.
+	void RegisterBroadcast(std::map<size_t, std::vector<std::function<bool(XivMessage*)>>>& handlers) {
+		handlers[0].emplace_back([this](XivMessage* pMessage) {
+			if (pMessage->Type == MessageType::Ipc && pMessage->Data.Ipc.Type == IpcType::CustomType)
+				return false;
+			if (pMessage->Type == MessageType::Ipc && pMessage->Data.Ipc.Type == IpcType::InterestedType && pMessage->CurrentActor == pMessage->SourceActor) {
+				const auto subType = pMessage->Data.Ipc.SubType;
+				if (std::ranges::find(ActionEffects, subType) != std::end(ActionEffects)
+					|| subType == ActorControlSelf || subType == ActorControl || subType == ActorCast)
+					Count.TimingHandler++;
+			}
+			return true;
+			});
+		if (TypeFinder) {
+			handlers[1].emplace_back([this](XivMessage* pMessage) {
+				if (pMessage->Type == MessageType::Ipc && pMessage->Data.Ipc.Type == IpcType::InterestedType && pMessage->CurrentActor == pMessage->SourceActor) {
+					if (std::ranges::find(ActionEffectLengths, pMessage->Length) != std::end(ActionEffectLengths)
+						|| pMessage->Length == sizeof(XivMessageHeader) + sizeof(XivIpcHeader) + sizeof(XivIpcs::S2C_ActorControlSelf)
+						|| pMessage->Length == sizeof(XivMessageHeader) + sizeof(XivIpcHeader) + sizeof(XivIpcs::S2C_ActorCast)
+						|| pMessage->Length == 0x38)
+						Count.TypeFinder++;
+				}
+				return true;
+				});
+		}
+		if (Logger) {
+			handlers[2].emplace_back([this](XivMessage* pMessage) {
+				if (pMessage->Type == MessageType::Ipc && pMessage->Data.Ipc.Type == IpcType::InterestedType)
+					Count.Logger++;
+				return true;
+				});
+		}
+	}
+
+	void RegisterDispatched(Sqex::Network::IpcDispatcher& dispatcher) {
+		const auto timing = [this](XivMessage*) {
+			Count.TimingHandler++;
+			return true;
+		};
+		for (const auto subType : ActionEffects)
+			dispatcher.Add(this, { .SubType = subType, .CurrentActorOnly = true }, timing);
+		dispatcher.Add(this, { .SubType = ActorControlSelf, .CurrentActorOnly = true }, timing);
+		dispatcher.Add(this, { .SubType = ActorControl, .CurrentActorOnly = true }, timing);
+		dispatcher.Add(this, { .SubType = ActorCast, .CurrentActorOnly = true }, timing);
+		dispatcher.Add(this, { .Type = IpcType::CustomType }, [](XivMessage*) { return false; });
+
+		if (TypeFinder) {
+			const auto finder = [this](XivMessage*) {
+				Count.TypeFinder++;
+				return true;
+			};
+			for (const auto length : ActionEffectLengths)
+				dispatcher.Add(this, { .Length = length, .CurrentActorOnly = true }, finder);
+			dispatcher.Add(this, { .Length = static_cast<uint32_t>(sizeof(XivMessageHeader) + sizeof(XivIpcHeader) + sizeof(XivIpcs::S2C_ActorControlSelf)), .CurrentActorOnly = true }, finder);
+			dispatcher.Add(this, { .Length = static_cast<uint32_t>(sizeof(XivMessageHeader) + sizeof(XivIpcHeader) + sizeof(XivIpcs::S2C_ActorCast)), .CurrentActorOnly = true }, finder);
+			dispatcher.Add(this, { .Length = 0x38, .CurrentActorOnly = true }, finder);
+		}
+		if (Logger) {
+			dispatcher.Add(this, { .Type = IpcType::InterestedType }, [this](XivMessage*) {
+				Count.Logger++;
+				return true;
+				});
+		}
+	}
+};
+
+int main() {
+	constexpr size_t MessageCount = 20000;
+	constexpr auto Repeats = 100;
+	constexpr auto Rounds = 5;
+	const auto stream = MakeRaidStream(MessageCount);
+	std::cout << std::format("{} messages, replayed {} times, best of {} rounds\n", stream.size(), Repeats, Rounds);
+
+	size_t failures = 0;
+	for (const auto [typeFinder, logger] : { std::pair{ false, false }, { true, false }, { true, true } }) {
+		Counters before, after;
+
+		std::map<size_t, std::vector<std::function<bool(XivMessage*)>>> broadcast;
+		Handlers broadcastHandlers{ before, typeFinder, logger };
+		broadcastHandlers.RegisterBroadcast(broadcast);
+		Sqex::Network::IpcDispatcher dispatcher;
+		Handlers dispatchedHandlers{ after, typeFinder, logger };
+		dispatchedHandlers.RegisterDispatched(dispatcher);
+
+		// Take the best of a few rounds; a single pass is mostly noise at this scale.
+		auto broadcastNs = std::numeric_limits<double>::infinity(), dispatchNs = broadcastNs;
+		for (auto round = 0; round < Rounds; ++round) {
+			auto start = std::chrono::steady_clock::now();
+			for (auto i = 0; i < Repeats; ++i) {
+				for (const auto& buf : stream) {
+					const auto pMessage = reinterpret_cast<XivMessage*>(const_cast<uint8_t*>(buf.data()));
+					auto use = true;
+					for (const auto& cbs : broadcast) {
+						for (const auto& cb : cbs.second)
+							use &= cb(pMessage);
+					}
+					before.Dropped += !use;
+				}
+			}
+			broadcastNs = (std::min)(broadcastNs, std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / (MessageCount * Repeats));
+
+			start = std::chrono::steady_clock::now();
+			for (auto i = 0; i < Repeats; ++i) {
+				for (const auto& buf : stream)
+					after.Dropped += !dispatcher.Dispatch(reinterpret_cast<XivMessage*>(const_cast<uint8_t*>(buf.data())));
+			}
+			dispatchNs = (std::min)(dispatchNs, std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / (MessageCount * Repeats));
+		}
+
+		std::cout << std::format("timing handler{}{}: broadcast {:.1f}ns/message, dispatcher {:.1f}ns/message\n",
+			typeFinder ? " + type finder" : "", logger ? " + logger" : "", broadcastNs, dispatchNs);
+
+		if (before != after) {
+			std::cout << std::format("  counts differ: {}/{}/{}/{} != {}/{}/{}/{}\n",
+				before.TimingHandler, before.TypeFinder, before.Logger, before.Dropped,
+				after.TimingHandler, after.TypeFinder, after.Logger, after.Dropped);
+			failures++;
+		}
+	}
+
+	std::cout << std::format("{} failure(s)\n", failures);
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,177 @@
+#include "pch.h"
+
+#include <chrono>
+#include <deque>
+#include <random>
+
+#include <XivAlexanderCommon/Utils/LogStore.h>
+
+static std::string MakeText(uint64_t id) {
+	auto s = std::format("{:016x} ", id);
+	s.resize(s.size() + static_cast<size_t>(id * 2654435761ULL % 240), static_cast<char>('a' + id % 26));
+	return s;
+}
+
+static uint64_t IdAt(size_t i) {
+	// Ids may have gaps; Logger drops pending items when it falls behind.
+	return 1 + i * 2 + (i % 7 == 0 ? 1 : 0);
+}
+
+static size_t Verify(const Utils::LogStore& store, size_t firstIndex, size_t lastIndex, size_t pageSize) {
+	size_t failures = 0;
+	auto index = firstIndex;
+	auto nextId = IdAt(firstIndex);
+	while (true) {
+		const auto count = store.Read(nextId, pageSize, [&](const Utils::LogStore::RecordView& r) {
+			if (index >= lastIndex || r.Id != IdAt(index) || r.Text != MakeText(r.Id) || r.Timestamp != static_cast<int64_t>(r.Id) * 10 || r.Category != r.Id % 9 || r.Level != r.Id % 5 * 10)
+				failures++;
+			nextId = r.Id + 1;
+			index++;
+		});
+		if (!count)
+			break;
+	}
+	if (index != lastIndex) {
+		std::cout << std::format("visited up to {}, expected {}\n", index, lastIndex);
+		failures++;
+	}
+	return failures;
+}
+
+static void Append(Utils::LogStore& store, size_t i) {
+	const auto id = IdAt(i);
+	store.Append(id, static_cast<int64_t>(id) * 10, static_cast<uint8_t>(id % 9), static_cast<uint8_t>(id % 5 * 10), MakeText(id));
+}
+
+int main() {
+	constexpr size_t Records = 1000000;
+	constexpr size_t RingCapacity = 64 * 1024;
+	constexpr size_t ArenaSize = 8 * 1024 * 1024;
+	const auto spillPath = std::filesystem::temp_directory_path() / "Test_LogStore.bin";
+
+	size_t failures = 0;
+	std::vector<std::string> texts(Records);
+	for (size_t i = 0; i < Records; ++i)
+		texts[i] = MakeText(IdAt(i));
+
+	// Step. Ring only: the newest records survive intact, and nothing older is reported.
+	{
+		Utils::LogStore store(4096, 128 * 1024);
+		for (size_t i = 0; i < 100000; ++i)
+			Append(store, i);
+		const auto first = 100000 - store.InMemoryCount();
+		if (store.FirstId() != IdAt(first))
+			failures++;
+		failures += Verify(store, first, 100000, 333);
+		std::cout << std::format("ring only: {} records in memory\n", store.InMemoryCount());
+	}
+
+	// Step. Empty texts mixed into a wrapping arena: every record in memory reads back as appended.
+	{
+		const std::vector<std::string> fixed{ "aaaaaaaa", "bbbbbbbb", "cccc", "", "dddd", "eeeeeeee", "ffff", "gggg" };
+		std::vector<std::string> appended;
+		std::mt19937_64 rng(2);
+		for (const auto arenaSize : { 16, 17, 64 }) {
+			for (const auto ringCapacity : { 3, 8, 1024 }) {
+				Utils::LogStore store(ringCapacity, arenaSize);
+				appended.clear();
+				for (size_t i = 0; i < 20000; ++i) {
+					std::string text;
+					if (i < fixed.size())
+						text = fixed[i];
+					else if (rng() % 3)
+						text.assign(rng() % 12, static_cast<char>('a' + i % 26));
+					store.Append(i + 1, 0, 0, 0, text);
+					appended.emplace_back(std::move(text));
+
+					const auto first = appended.size() - store.InMemoryCount();
+					if (store.FirstInMemoryId() != first + 1 || !store.InMemoryCount())
+						failures++;
+					store.Read(0, SIZE_MAX, [&](const Utils::LogStore::RecordView& r) {
+						if (r.Id > appended.size() || r.Text != appended[r.Id - 1])
+							failures++;
+					});
+				}
+			}
+		}
+	}
+
+	// Step. What Logger did before: a deque of items owning their text, trimmed from the front.
+	{
+		struct Item {
+			uint64_t Id;
+			int64_t Timestamp;
+			uint8_t Category;
+			uint8_t Level;
+			std::string Text;
+		};
+		std::deque<Item> items;
+		const auto start = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < Records; ++i) {
+			const auto id = IdAt(i);
+			items.push_back(Item{ id, static_cast<int64_t>(id) * 10, static_cast<uint8_t>(id % 9), static_cast<uint8_t>(id % 5 * 10), texts[i] });
+			if (items.size() > 128 * 1024)
+				items.pop_front();
+		}
+		const auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		std::cout << std::format("append, std::deque: {:.1f} ns/record\n", seconds * 1e9 / Records);
+	}
+
+	// Step. Append throughput.
+	for (const auto spill : { false, true }) {
+		Utils::LogStore store(RingCapacity, ArenaSize, spill ? spillPath : std::filesystem::path());
+		uint64_t bytes = 0;
+		const auto start = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < Records; ++i) {
+			const auto id = IdAt(i);
+			store.Append(id, static_cast<int64_t>(id) * 10, static_cast<uint8_t>(id % 9), static_cast<uint8_t>(id % 5 * 10), texts[i]);
+			bytes += texts[i].size();
+		}
+		const auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		std::cout << std::format("append, spill {:>3}: {:.1f} ns/record, {:.0f} MB/s\n",
+			spill ? "on" : "off", seconds * 1e9 / Records, static_cast<double>(bytes) / seconds / 1048576);
+
+		if (!spill)
+			continue;
+
+		// Step. Everything can be paged through, from disk and then from memory.
+		if (store.Count() != Records)
+			failures++;
+		failures += Verify(store, 0, Records, 4096);
+
+		// Step. Random page reads.
+		std::mt19937_64 rng(1);
+		for (const auto inMemory : { false, true }) {
+			constexpr size_t Pages = 2000, PageSize = 100;
+			const auto lo = inMemory ? Records - store.InMemoryCount() : 0;
+			const auto hi = inMemory ? Records - PageSize : Records - store.InMemoryCount() - PageSize;
+			std::uniform_int_distribution<size_t> dist(lo, hi);
+			size_t visited = 0;
+			const auto readStart = std::chrono::steady_clock::now();
+			for (size_t p = 0; p < Pages; ++p) {
+				const auto i = dist(rng);
+				const auto expectedId = IdAt(i);
+				bool first = true;
+				visited += store.Read(expectedId, PageSize, [&](const Utils::LogStore::RecordView& r) {
+					if (first && r.Id != expectedId)
+						failures++;
+					first = false;
+				});
+			}
+			const auto readSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - readStart).count();
+			if (visited != Pages * PageSize)
+				failures++;
+			std::cout << std::format("random {}-record page from {}: {:.1f} us/page\n",
+				PageSize, inMemory ? "memory" : "spill file", readSeconds * 1e6 / Pages);
+		}
+
+		store.Clear();
+		if (store.Count() || store.Read(0, 1, [](const auto&) {}))
+			failures++;
+		Append(store, 0);
+		failures += Verify(store, 0, 1, 16);
+	}
+
+	std::cout << std::format("{} failure(s)\n", failures);
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,499 @@
+// Portable; also builds outside Windows: g++ -std=c++20 -O2 -I.. Test_NetworkConditionSimulator.cpp
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <map>
+#include <optional>
+#include <queue>
+#include <random>
+#include <vector>
+
+#include <XivAlexanderCommon/Utils/AnimationLock.h>
+
+using Utils::AnimationLock::MitigationMode;
+
+// Between the game and the server.
+struct Conditions {
+	const char* Name;
+
+	// Round trip time, without jitter.
+	int64_t RttUs;
+
+	// Mean of the exponentially distributed extra delay of every packet, each way.
+	int64_t JitterUs;
+
+	// Chance of a packet being held up for SpikeUs more.
+	double SpikeChance;
+	int64_t SpikeUs;
+
+	// The server takes up to this long to process an action.
+	int64_t ServerDelayUs;
+
+	// Round trip time that TCP and ICMP see; less than RttUs behind a VPN that answers those by itself.
+	int64_t MeasuredRttUs;
+};
+
+// How the game and the server are assumed to behave. None of this has been measured against the real server;
+// change these to see how much the results depend on them.
+struct Rules {
+	int64_t GcdUs = 2500000;
+	int64_t AnimationLockUs = 600000;
+	size_t WeavesPerGcd = 2;
+
+	// The game lets another action through if the server has not responded in this long.
+	int64_t ClientResponseTimeoutUs = 500000;
+
+	// The server accepts an action that arrives up to this early for the animation lock or the recast of the previous one.
+	int64_t ServerToleranceUs = 50000;
+
+	int64_t KeepAliveIntervalUs = 10000000;
+
+	// Same as SingleConnection::ApplicationLatencyUs.
+	size_t ApplicationLatencySamples = 10;
+
+	int64_t DurationUs = 3600000000;
+};
+
+struct Setting {
+	const char* Name;
+
+	// Empty if XivAlexander does not touch the animation lock.
+	std::optional<MitigationMode> Mode;
+
+	int64_t ExpectedDelayUs = 75000;
+};
+
+struct Report {
+	uint64_t Requests = 0;
+	uint64_t Rejected = 0;
+	uint64_t GcdsAccepted = 0;
+	uint64_t WeavesAccepted = 0;
+	int64_t FirstGcdAcceptedUs = -1;
+	int64_t LastGcdAcceptedUs = -1;
+
+	// Sum of how long each GCD was sent after it was ready.
+	int64_t ClipUs = 0;
+	uint64_t GcdsSent = 0;
+
+	// Sum of how long the game kept the player from doing anything after each action that went through.
+	int64_t LockUs = 0;
+	uint64_t Effects = 0;
+
+	size_t PendingActionsLeft = 0;
+
+	[[nodiscard]] double Uptime(const Rules& rules) const {
+		if (GcdsAccepted < 2)
+			return 0;
+		return static_cast<double>(rules.GcdUs * static_cast<int64_t>(GcdsAccepted - 1)) / static_cast<double>(LastGcdAcceptedUs - FirstGcdAcceptedUs);
+	}
+
+	[[nodiscard]] double ClipPerGcdUs() const {
+		return GcdsSent ? static_cast<double>(ClipUs) / static_cast<double>(GcdsSent) : 0;
+	}
+
+	[[nodiscard]] double LockPerActionUs() const {
+		return Effects ? static_cast<double>(LockUs) / static_cast<double>(Effects) : 0;
+	}
+
+	[[nodiscard]] double WeavesPerGcd() const {
+		return GcdsAccepted ? static_cast<double>(WeavesAccepted) / static_cast<double>(GcdsAccepted) : 0;
+	}
+
+	[[nodiscard]] double RollbackRate() const {
+		return Requests ? static_cast<double>(Rejected) / static_cast<double>(Requests) : 0;
+	}
+
+	bool operator==(const Report&) const = default;
+};
+
+// Only mt19937_64 itself, as distributions are free to differ between standard libraries.
+class Random {
+	std::mt19937_64 m_rng;
+
+public:
+	explicit Random(uint64_t seed)
+		: m_rng(seed) {
+	}
+
+	double Uniform() {
+		return static_cast<double>(m_rng() >> 11) * 0x1.0p-53;
+	}
+
+	int64_t UniformUs(int64_t maxUs) {
+		return maxUs > 0 ? static_cast<int64_t>(m_rng() % static_cast<uint64_t>(maxUs + 1)) : 0;
+	}
+
+	int64_t ExponentialUs(int64_t meanUs) {
+		return meanUs > 0 ? static_cast<int64_t>(-static_cast<double>(meanUs) * std::log(1 - Uniform())) : 0;
+	}
+};
+
+// A player who presses GCD and WeavesPerGcd instant abilities in turn, each as soon as the game allows it,
+// on one connection to a server, everything on a virtual clock.
+// Messages go through Utils::AnimationLock::Tracker and Resolve, as NetworkTimingHandler does for C2S_ActionRequest,
+// S2C_ActionEffect, and S2C_ActorControlSelf/ActionRejected. Casts and server-originated actions are not simulated.
+class Simulation {
+	static constexpr uint32_t GcdActionId = 1;
+	static constexpr uint32_t WeaveActionId = 2;
+
+	enum class MessageType {
+		ActionRequest,
+		ActionEffect,
+		ActionRejected,
+		ClientKeepAlive,
+		ServerKeepAlive,
+	};
+
+	struct Message {
+		MessageType Type;
+		uint32_t ActionId;
+		uint32_t Sequence;
+		int64_t WaitUs;
+		int64_t KeepAliveSentUs;
+	};
+
+	enum class EventType {
+		PlayerInput,
+		KeepAlive,
+		ServerReceive,
+		ClientReceive,
+	};
+
+	struct Event {
+		int64_t AtUs;
+		uint64_t Order;
+		EventType Type;
+		Message Msg;
+
+		bool operator>(const Event& r) const {
+			return AtUs != r.AtUs ? AtUs > r.AtUs : Order > r.Order;
+		}
+	};
+
+	struct SentAction {
+		bool Gcd;
+		int64_t SentUs;
+		int64_t PreviousGcdReadyUs;
+	};
+
+	const Conditions& m_conditions;
+	const Rules& m_rules;
+	const Setting& m_setting;
+	Random m_random;
+
+	std::priority_queue<Event, std::vector<Event>, std::greater<>> m_events;
+	uint64_t m_eventOrder = 0;
+
+	// TCP delivers in order.
+	int64_t m_lastUpstreamUs = 0;
+	int64_t m_lastDownstreamUs = 0;
+
+	// What the game knows.
+	int64_t m_clientLockEndsUs = 0;
+	int64_t m_clientGcdReadyUs = 0;
+	size_t m_weavesLeft = 0;
+	uint32_t m_nextSequence = 1;
+	std::map<uint32_t, SentAction> m_sentActions;
+
+	// What XivAlexander knows.
+	Utils::AnimationLock::Tracker m_tracker;
+	std::deque<int64_t> m_applicationLatencyUs;
+	Utils::AnimationLock::LatencySnapshot m_snapshot;
+
+	// What the server knows.
+	int64_t m_serverLastProcessedUs = 0;
+	int64_t m_serverLockEndsUs = 0;
+	int64_t m_serverGcdReadyUs = 0;
+
+	Report m_report;
+
+	void Push(int64_t atUs, EventType type, const Message& msg = {}) {
+		m_events.push(Event{ atUs, m_eventOrder++, type, msg });
+	}
+
+	int64_t OneWayUs() {
+		auto us = m_conditions.RttUs / 2 + m_random.ExponentialUs(m_conditions.JitterUs);
+		if (m_random.Uniform() < m_conditions.SpikeChance)
+			us += m_conditions.SpikeUs;
+		return us;
+	}
+
+	void SendToServer(int64_t nowUs, const Message& msg) {
+		m_lastUpstreamUs = (std::max)(m_lastUpstreamUs, nowUs + OneWayUs());
+		Push(m_lastUpstreamUs, EventType::ServerReceive, msg);
+	}
+
+	void SendToClient(int64_t nowUs, const Message& msg) {
+		m_lastDownstreamUs = (std::max)(m_lastDownstreamUs, nowUs + OneWayUs());
+		Push(m_lastDownstreamUs, EventType::ClientReceive, msg);
+	}
+
+	void MeasureLatency() {
+		// Socket latency can be any higher value up to 40ms, which is what Resolve assumes.
+		const auto measuredUs = m_conditions.MeasuredRttUs + m_random.ExponentialUs(m_conditions.JitterUs) + m_random.ExponentialUs(m_conditions.JitterUs);
+		m_snapshot.SocketLatencyUs = measuredUs + m_random.UniformUs(40000);
+		m_snapshot.PingLatencyUs = measuredUs;
+	}
+
+	void AddApplicationLatency(int64_t rttUs) {
+		m_applicationLatencyUs.push_back(rttUs);
+		if (m_applicationLatencyUs.size() > m_rules.ApplicationLatencySamples)
+			m_applicationLatencyUs.pop_front();
+
+		// Same as NumericStatisticsTracker::Summarize.
+		const auto count = static_cast<int64_t>(m_applicationLatencyUs.size());
+		int64_t minUs = m_applicationLatencyUs.front(), acc = 0;
+		for (const auto v : m_applicationLatencyUs) {
+			minUs = (std::min)(minUs, v);
+			acc += v;
+		}
+		const auto meanUs = acc / count;
+		int64_t diffSquaredSum = 0;
+		for (const auto v : m_applicationLatencyUs)
+			diffSquaredSum += (v - meanUs) * (v - meanUs);
+		m_snapshot.RttMinUs = minUs;
+		m_snapshot.RttMeanUs = meanUs;
+		m_snapshot.RttDeviationUs = static_cast<int64_t>(std::sqrt(diffSquaredSum / count));
+	}
+
+	void SchedulePlayerInput(int64_t nowUs) {
+		const auto atUs = m_weavesLeft ? m_clientLockEndsUs : (std::max)(m_clientLockEndsUs, m_clientGcdReadyUs);
+		Push((std::max)(nowUs, atUs), EventType::PlayerInput);
+	}
+
+	void OnPlayerInput(int64_t nowUs) {
+		const auto gcd = m_weavesLeft == 0;
+		if (nowUs < m_clientLockEndsUs || (gcd && nowUs < m_clientGcdReadyUs))
+			return;
+
+		const auto sequence = m_nextSequence++;
+		m_sentActions.emplace(sequence, SentAction{ gcd, nowUs, m_clientGcdReadyUs });
+		if (gcd) {
+			m_report.ClipUs += nowUs - m_clientGcdReadyUs;
+			m_report.GcdsSent++;
+			m_clientGcdReadyUs = nowUs + m_rules.GcdUs;
+			m_weavesLeft = m_rules.WeavesPerGcd;
+		} else {
+			m_weavesLeft--;
+		}
+		m_clientLockEndsUs = nowUs + m_rules.ClientResponseTimeoutUs;
+		m_report.Requests++;
+
+		const auto actionId = gcd ? GcdActionId : WeaveActionId;
+		if (m_setting.Mode) {
+			m_tracker.OnActionRequest(actionId, sequence, nowUs);
+			MeasureLatency();
+		}
+		SendToServer(nowUs, { .Type = MessageType::ActionRequest, .ActionId = actionId, .Sequence = sequence });
+		SchedulePlayerInput(nowUs);
+	}
+
+	void OnServerReceive(int64_t nowUs, const Message& msg) {
+		if (msg.Type == MessageType::ClientKeepAlive) {
+			SendToClient(nowUs, { .Type = MessageType::ServerKeepAlive, .KeepAliveSentUs = msg.KeepAliveSentUs });
+			return;
+		}
+
+		const auto processedUs = m_serverLastProcessedUs = (std::max)(m_serverLastProcessedUs, nowUs + m_random.UniformUs(m_conditions.ServerDelayUs));
+		const auto gcd = msg.ActionId == GcdActionId;
+		if (processedUs + m_rules.ServerToleranceUs < m_serverLockEndsUs || (gcd && processedUs + m_rules.ServerToleranceUs < m_serverGcdReadyUs)) {
+			m_report.Rejected++;
+			SendToClient(processedUs, { .Type = MessageType::ActionRejected, .ActionId = msg.ActionId, .Sequence = msg.Sequence });
+			return;
+		}
+
+		m_serverLockEndsUs = processedUs + m_rules.AnimationLockUs;
+		if (gcd) {
+			m_serverGcdReadyUs = processedUs + m_rules.GcdUs;
+			if (m_report.FirstGcdAcceptedUs == -1)
+				m_report.FirstGcdAcceptedUs = processedUs;
+			m_report.LastGcdAcceptedUs = processedUs;
+			m_report.GcdsAccepted++;
+		} else {
+			m_report.WeavesAccepted++;
+		}
+		SendToClient(processedUs, { .Type = MessageType::ActionEffect, .ActionId = msg.ActionId, .Sequence = msg.Sequence, .WaitUs = m_rules.AnimationLockUs });
+	}
+
+	void OnClientReceive(int64_t nowUs, const Message& msg) {
+		static constexpr auto ignore = [](const auto&) {};
+
+		switch (msg.Type) {
+			case MessageType::ServerKeepAlive:
+				if (m_setting.Mode) {
+					AddApplicationLatency(nowUs - msg.KeepAliveSentUs);
+					MeasureLatency();
+				}
+				return;
+
+			case MessageType::ActionEffect: {
+				auto waitUs = msg.WaitUs;
+				if (m_setting.Mode) {
+					const auto result = m_tracker.OnActionEffect(msg.ActionId, msg.Sequence, msg.WaitUs, nowUs, false, [&](int64_t rttUs) {
+						AddApplicationLatency(rttUs);
+						return Utils::AnimationLock::Resolve(*m_setting.Mode, m_snapshot, nowUs, msg.WaitUs, rttUs, m_setting.ExpectedDelayUs);
+					}, ignore);
+					if (result.Shortened)
+						waitUs = result.WaitUs;
+				}
+
+				// The game only goes by the latest animation lock it has been told.
+				m_clientLockEndsUs = nowUs + waitUs;
+				if (const auto it = m_sentActions.find(msg.Sequence); it != m_sentActions.end()) {
+					m_report.LockUs += m_clientLockEndsUs - it->second.SentUs;
+					m_report.Effects++;
+					m_sentActions.erase(it);
+				}
+				break;
+			}
+
+			case MessageType::ActionRejected: {
+				if (m_setting.Mode)
+					m_tracker.OnActionRejected(msg.ActionId, msg.Sequence, ignore);
+
+				// The game takes back the animation lock and the recast, and the player tries the GCD again; a rejected weave is given up.
+				m_clientLockEndsUs = nowUs;
+				if (const auto it = m_sentActions.find(msg.Sequence); it != m_sentActions.end()) {
+					if (it->second.Gcd) {
+						m_clientGcdReadyUs = it->second.PreviousGcdReadyUs;
+						m_weavesLeft = 0;
+					}
+					m_sentActions.erase(it);
+				}
+				break;
+			}
+
+			default:
+				return;
+		}
+		SchedulePlayerInput(nowUs);
+	}
+
+public:
+	Simulation(const Conditions& conditions, const Rules& rules, const Setting& setting, uint64_t seed)
+		: m_conditions(conditions)
+		, m_rules(rules)
+		, m_setting(setting)
+		, m_random(seed) {
+	}
+
+	Report Run() {
+		// Tracker treats a request at 0 as unset.
+		constexpr int64_t StartUs = 1000000;
+		m_clientGcdReadyUs = StartUs;
+		Push(StartUs, EventType::PlayerInput);
+		Push(StartUs, EventType::KeepAlive);
+
+		while (!m_events.empty() && m_events.top().AtUs < StartUs + m_rules.DurationUs) {
+			const auto event = m_events.top();
+			m_events.pop();
+			switch (event.Type) {
+				case EventType::PlayerInput:
+					OnPlayerInput(event.AtUs);
+					break;
+
+				case EventType::KeepAlive:
+					SendToServer(event.AtUs, { .Type = MessageType::ClientKeepAlive, .KeepAliveSentUs = event.AtUs });
+					Push(event.AtUs + m_rules.KeepAliveIntervalUs, EventType::KeepAlive);
+					break;
+
+				case EventType::ServerReceive:
+					OnServerReceive(event.AtUs, event.Msg);
+					break;
+
+				case EventType::ClientReceive:
+					OnClientReceive(event.AtUs, event.Msg);
+					break;
+			}
+		}
+
+		m_report.PendingActionsLeft = m_tracker.PendingActions.size();
+		return m_report;
+	}
+};
+
+static const Setting Settings[]{
+	{ "off", std::nullopt },
+	{ "1: subtract latency", MitigationMode::SubtractLatency },
+	{ "2: simulate rtt", MitigationMode::SimulateRtt },
+	{ "3: normalized rtt", MitigationMode::SimulateNormalizedRttAndLatency },
+};
+
+static void PrintHeader() {
+	std::printf("  %-24s %10s %12s %12s %11s %10s\n", "", "GCD uptime", "clip/GCD", "lock/action", "weaves/GCD", "rollbacks");
+}
+
+static void PrintReport(const char* name, const Rules& rules, const Report& report) {
+	std::printf("  %-24s %9.2f%% %10.1fms %10.1fms %11.2f %9.2f%%\n",
+		name, 100 * report.Uptime(rules), report.ClipPerGcdUs() / 1000, report.LockPerActionUs() / 1000, report.WeavesPerGcd(), 100 * report.RollbackRate());
+}
+
+int main() {
+	static constexpr uint64_t Seed = 0x5EED;
+	const Rules rules;
+	uint64_t failures = 0;
+
+	// Step. Sanity checks on a perfectly steady connection.
+	{
+		const Conditions steady{ "Steady, 300ms", 300000, 0, 0, 0, 0, 300000 };
+		std::printf("%s\n", steady.Name);
+		PrintHeader();
+		std::map<const Setting*, Report> reports;
+		for (const auto& setting : Settings) {
+			const auto& report = reports[&setting] = Simulation(steady, rules, setting, Seed).Run();
+			PrintReport(setting.Name, rules, report);
+			if (report.Rejected || report.PendingActionsLeft > rules.WeavesPerGcd + 1) {
+				std::printf("    Should have had no rollbacks, and no requests left without a response\n");
+				failures++;
+			}
+			if (report != Simulation(steady, rules, setting, Seed).Run()) {
+				std::printf("    Not reproducible\n");
+				failures++;
+			}
+		}
+
+		// Two weaves with 300ms of latency each push the GCD back, unless the latency is taken out of the animation lock.
+		const auto& off = reports[&Settings[0]];
+		for (const auto& setting : Settings) {
+			if (setting.Mode && reports[&setting].ClipPerGcdUs() >= off.ClipPerGcdUs()) {
+				std::printf("    %s should have clipped less than off\n", setting.Name);
+				failures++;
+			}
+		}
+		std::printf("\n");
+	}
+
+	// Step. Each mode under different conditions.
+	const Conditions conditions[]{
+		{ "Nearby, 30ms", 30000, 1000, 0, 0, 25000, 30000 },
+		{ "Overseas, 150ms", 150000, 3000, 0, 0, 25000, 150000 },
+		{ "Overseas on Wi-Fi, 150ms with spikes", 150000, 15000, 0.02, 150000, 25000, 150000 },
+		{ "Intercontinental, 250ms", 250000, 5000, 0.005, 100000, 25000, 250000 },
+		{ "VPN answering pings by itself, 150ms", 150000, 3000, 0, 0, 25000, 10000 },
+	};
+	for (const auto& c : conditions) {
+		std::printf("%s\n", c.Name);
+		PrintHeader();
+		for (const auto& setting : Settings)
+			PrintReport(setting.Name, rules, Simulation(c, rules, setting, Seed).Run());
+		std::printf("\n");
+	}
+
+	// Step. Tuning ExpectedAnimationLockDurationUs for mode 2.
+	{
+		const auto& c = conditions[2];
+		std::printf("%s, simulate rtt with different expected delays\n", c.Name);
+		PrintHeader();
+		for (const auto delayUs : { 0, 25000, 50000, 75000, 100000, 150000 }) {
+			const Setting setting{ "", MitigationMode::SimulateRtt, delayUs };
+			char name[32];
+			std::snprintf(name, sizeof name, "2: delay=%dms", delayUs / 1000);
+			PrintReport(name, rules, Simulation(c, rules, setting, Seed).Run());
+		}
+	}
+
+	std::printf("%llu failure(s)\n", static_cast<unsigned long long>(failures));
+	return failures ? 1 : 0;
+}
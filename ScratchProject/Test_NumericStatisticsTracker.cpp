@@ -0,0 +1,207 @@
+#include "pch.h"
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <random>
+#include <thread>
+
+#include <XivAlexanderCommon/Utils/NumericStatisticsTracker.h>
+
+// What NumericStatisticsTracker used to do: a deque behind a mutex, copied by every query.
+// It used to be copied after the lock was released, which could read freed memory while a writer was adding a sample; here it is copied while locked.
+class LegacyTracker {
+	const size_t m_trackCount;
+	mutable std::mutex m_mtx;
+	mutable std::deque<int64_t> m_values;
+
+	std::deque<int64_t> RemoveExpired() const {
+		const auto lock = std::lock_guard(m_mtx);
+		while (m_values.size() > m_trackCount)
+			m_values.pop_front();
+		return m_values;
+	}
+
+public:
+	explicit LegacyTracker(size_t trackCount)
+		: m_trackCount(trackCount) {
+	}
+
+	void AddValue(int64_t v) {
+		const auto lock = std::lock_guard(m_mtx);
+		m_values.emplace_back(v);
+		while (m_values.size() > m_trackCount)
+			m_values.pop_front();
+	}
+
+	int64_t Latest() const {
+		const auto vals = RemoveExpired();
+		return vals.empty() ? 0 : vals.back();
+	}
+
+	int64_t Min() const {
+		const auto vals = RemoveExpired();
+		return vals.empty() ? 0 : *std::ranges::min_element(vals);
+	}
+
+	int64_t Mean() const {
+		const auto vals = RemoveExpired();
+		return vals.empty() ? 0 : std::accumulate(vals.begin(), vals.end(), int64_t{}) / static_cast<int64_t>(vals.size());
+	}
+
+	int64_t Median() const {
+		const auto vals = RemoveExpired();
+		std::vector<int64_t> sorted(vals.begin(), vals.end());
+		if (sorted.empty())
+			return 0;
+		std::ranges::sort(sorted);
+		if (sorted.size() % 2 == 0)
+			return (sorted[sorted.size() / 2] + sorted[sorted.size() / 2 - 1]) / 2;
+		return sorted[sorted.size() / 2];
+	}
+};
+
+static size_t CompareWithLegacy() {
+	size_t failures = 0;
+	std::mt19937 rng(0);
+	for (const auto trackCount : { 1, 2, 10, 128, 1024 }) {
+		Utils::NumericStatisticsTracker tracker(trackCount, 0);
+		LegacyTracker legacy(trackCount);
+		for (auto i = 0; i < 3000; ++i) {
+			const auto v = static_cast<int64_t>(rng() % 100000);
+			tracker.AddValue(v);
+			legacy.AddValue(v);
+			if (i % 7 == 0 && (tracker.Latest() != legacy.Latest() || tracker.Min() != legacy.Min() || tracker.Mean() != legacy.Mean() || tracker.Median() != legacy.Median())) {
+				if (failures++ < 10)
+					std::cout << std::format("  trackCount {}, sample {}: differs\n", trackCount, i);
+			}
+		}
+		if (tracker.Count() != static_cast<size_t>(trackCount))
+			failures++;
+
+		tracker.Clear();
+		if (!tracker.Empty() || tracker.Latest() != 0 || tracker.Median() != 0)
+			failures++;
+		tracker.AddValue(5);
+		if (tracker.Count() != 1 || tracker.Latest() != 5 || tracker.MeanAndDeviation() != std::pair<int64_t, int64_t>{ 5, 0 })
+			failures++;
+		if (tracker.Count(INT64_MAX) != 0 || tracker.CountFractional(INT64_MAX) != 0.)
+			failures++;
+	}
+	std::cout << std::format("Compared with the old implementation: {} failure(s)\n", failures);
+	return failures;
+}
+
+// Writers add consecutive numbers, so any consistent view has Min == Latest - Count + 1, and Mean in the middle.
+// A reader that saw samples from two different moments would break that.
+static size_t Stress(size_t writerCount, size_t readerCount, std::chrono::milliseconds duration) {
+	constexpr size_t TrackCount = 64;
+	Utils::NumericStatisticsTracker tracker(TrackCount, -1);
+	std::mutex nextMtx;
+	int64_t next = 0;
+	std::atomic_bool stop = false;
+	std::atomic<uint64_t> reads = 0, inconsistent = 0;
+
+	std::vector<std::thread> threads;
+	for (size_t i = 0; i < writerCount; ++i) {
+		threads.emplace_back([&] {
+			while (!stop) {
+				// Keep values in the order they are added even with several writers.
+				std::lock_guard lock(nextMtx);
+				tracker.AddValue(next++);
+			}
+		});
+	}
+	for (size_t i = 0; i < readerCount; ++i) {
+		threads.emplace_back([&] {
+			uint64_t localReads = 0, localInconsistent = 0;
+			while (!stop) {
+				const auto s = tracker.Summarize();
+				localReads++;
+				if (s.Count == 0)
+					continue;
+				const auto count = static_cast<int64_t>(s.Count);
+				if (s.Min != s.Latest - count + 1 || s.Mean != (s.Min + s.Latest) / 2 || (s.Count < TrackCount && s.Min != 0))
+					localInconsistent++;
+			}
+			reads += localReads;
+			inconsistent += localInconsistent;
+		});
+	}
+
+	std::this_thread::sleep_for(duration);
+	stop = true;
+	for (auto& thread : threads)
+		thread.join();
+
+	std::cout << std::format("  {} writer(s), {} reader(s): {} samples added, {} reads, {} inconsistent\n", writerCount, readerCount, next, reads.load(), inconsistent.load());
+	return inconsistent ? 1 : 0;
+}
+
+template<typename TTracker>
+static void Benchmark(const char* name, size_t readerCount) {
+	constexpr size_t TrackCount = 1024;
+	constexpr auto Duration = std::chrono::milliseconds(500);
+
+	TTracker tracker = [] {
+		if constexpr (std::is_same_v<TTracker, LegacyTracker>)
+			return TTracker(TrackCount);
+		else
+			return TTracker(TrackCount, 0);
+	}();
+	for (size_t i = 0; i < TrackCount; ++i)
+		tracker.AddValue(static_cast<int64_t>(i));
+
+	std::atomic_bool stop = false;
+	std::atomic<uint64_t> reads = 0;
+	std::vector<std::thread> readers;
+	for (size_t i = 0; i < readerCount; ++i) {
+		readers.emplace_back([&] {
+			uint64_t localReads = 0;
+			while (!stop) {
+				static_cast<void>(tracker.Mean());
+				localReads++;
+			}
+			reads += localReads;
+		});
+	}
+
+	uint64_t writes = 0;
+	int64_t worstWriteNs = 0;
+	const auto start = std::chrono::steady_clock::now();
+	while (std::chrono::steady_clock::now() - start < Duration) {
+		const auto writeStart = std::chrono::steady_clock::now();
+		tracker.AddValue(static_cast<int64_t>(writes++ % 1000));
+		worstWriteNs = std::max<int64_t>(worstWriteNs, std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - writeStart).count());
+	}
+	const auto elapsedNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+	stop = true;
+	for (auto& reader : readers)
+		reader.join();
+
+	std::cout << std::format("  {:<7} {} reader(s): {:8.1f} ns/write including timing, worst {:7}ns, {:9.1f} reads/ms\n",
+		name, readerCount, elapsedNs / static_cast<double>(writes), worstWriteNs, static_cast<double>(reads) * 1000000. / elapsedNs);
+}
+
+int main() {
+	size_t failures = 0;
+
+	// Step. Same answers as before.
+	failures += CompareWithLegacy();
+
+	// Step. Readers never see a torn history.
+	std::cout << "Stress:\n";
+	failures += Stress(1, 3, std::chrono::milliseconds(2000));
+	failures += Stress(2, 3, std::chrono::milliseconds(2000));
+
+	// Step. A writer on the game thread, with readers asking for the mean of 1024 samples in a loop.
+	std::cout << "Benchmark:\n";
+	for (const auto readerCount : { 0, 1, 3 }) {
+		Benchmark<LegacyTracker>("legacy", readerCount);
+		Benchmark<Utils::NumericStatisticsTracker>("seqlock", readerCount);
+	}
+
+	std::cout << std::format("{} failure(s)\n", failures);
+	return failures ? 1 : 0;
+}
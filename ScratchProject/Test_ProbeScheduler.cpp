@@ -0,0 +1,178 @@
+#include "pch.h"
+
+#include <map>
+#include <random>
+
+#include <XivAlexanderCommon/Utils/ProbeScheduler.h>
+
+using Scheduler = Utils::ProbeScheduler<int>;
+
+// Stands in for ICMP: each target answers after its own latency, or never, in which case the request times out.
+class FakeProber {
+public:
+	static constexpr int64_t TimeoutUs = 5000000;
+
+	struct Reply {
+		int Key;
+		Scheduler::ProbeId Probe;
+		std::optional<int64_t> LatencyUs;
+	};
+
+	std::map<int, std::function<std::optional<int64_t>(int64_t nowUs)>> Latencies;
+	std::multimap<int64_t, Reply> Pending;
+
+	void Send(int key, Scheduler::ProbeId probe, int64_t nowUs) {
+		const auto latencyUs = Latencies.at(key)(nowUs);
+		Pending.emplace(nowUs + (latencyUs ? *latencyUs : TimeoutUs), Reply{ key, probe, latencyUs });
+	}
+};
+
+struct Stats {
+	std::vector<int64_t> SentUs;
+	size_t Replies = 0;
+	size_t Failures = 0;
+	std::optional<Scheduler::Outcome> LastOutcome;
+};
+
+// Runs the scheduler on a fake clock the way the tracker thread does: poll, sleep until something happens, take the replies.
+static size_t Simulate(Scheduler& scheduler, FakeProber& prober, std::map<int, Stats>& stats, size_t maxInFlight, int64_t untilUs, const std::function<void(int64_t)>& onWake = {}) {
+	size_t wakeups = 0;
+	for (int64_t nowUs = 0; nowUs < untilUs; wakeups++) {
+		const auto nextDueUs = scheduler.Poll(nowUs, maxInFlight, [&](int key, Scheduler::ProbeId probe) {
+			if (scheduler.InFlight() > maxInFlight)
+				throw std::runtime_error("too many in flight");
+			stats[key].SentUs.push_back(nowUs);
+			prober.Send(key, probe, nowUs);
+		});
+
+		nowUs = std::min(nextDueUs, prober.Pending.empty() ? INT64_MAX : prober.Pending.begin()->first);
+		if (nowUs == INT64_MAX)
+			break;
+		while (!prober.Pending.empty() && prober.Pending.begin()->first <= nowUs) {
+			const auto [key, probe, latencyUs] = prober.Pending.begin()->second;
+			prober.Pending.erase(prober.Pending.begin());
+			auto& s = stats[key];
+			if (const auto outcome = scheduler.Complete(probe, nowUs, latencyUs)) {
+				s.LastOutcome = outcome;
+				(latencyUs ? s.Replies : s.Failures)++;
+			}
+		}
+		if (onWake)
+			onWake(nowUs);
+	}
+	return wakeups;
+}
+
+int main() {
+	size_t failures = 0;
+	const auto check = [&failures](bool ok, const std::string& what) {
+		std::cout << std::format("  {}: {}\n", what, ok ? "ok" : "FAILED");
+		failures += !ok;
+	};
+
+	constexpr int64_t IntervalUs = 1000000;
+	constexpr int64_t JitterUs = 100000;
+	constexpr int64_t MinuteUs = 60000000;
+
+	// Step. A session's worth of connections: lobby, zone, chat, and a few more; one of them stops answering, and one gets slower halfway.
+	{
+		std::cout << "Connections of a session, for 10 minutes:\n";
+		Scheduler scheduler({ .IntervalUs = IntervalUs, .JitterUs = JitterUs }, 0);
+		FakeProber prober;
+		std::mt19937 rng(0);
+		for (auto key = 0; key < 6; ++key) {
+			const auto baseUs = 20000 + 30000 * key;
+			prober.Latencies[key] = [baseUs, &rng](int64_t) { return std::optional<int64_t>(baseUs + rng() % 1000); };
+			scheduler.Add(key, 0);
+		}
+		prober.Latencies[6] = [](int64_t) { return std::optional<int64_t>(); };
+		scheduler.Add(6, 0);
+		prober.Latencies[7] = [](int64_t nowUs) { return std::optional<int64_t>(nowUs < 5 * MinuteUs ? 50000 : 150000); };
+		scheduler.Add(7, 0);
+
+		std::map<int, Stats> stats;
+		const auto wakeups = Simulate(scheduler, prober, stats, SIZE_MAX, 10 * MinuteUs);
+
+		size_t probes = 0;
+		int64_t minGapUs = INT64_MAX, maxGapUs = 0, gapSumUs = 0, gapCount = 0;
+		for (auto key = 0; key < 6; ++key) {
+			const auto& sent = stats[key].SentUs;
+			probes += sent.size();
+			for (size_t i = 1; i < sent.size(); ++i) {
+				const auto gapUs = sent[i] - sent[i - 1];
+				minGapUs = std::min(minGapUs, gapUs);
+				maxGapUs = std::max(maxGapUs, gapUs);
+				gapSumUs += gapUs;
+				gapCount++;
+			}
+		}
+		std::cout << std::format("  probes to answering targets: {}, intervals {}~{}us, mean {}us\n", probes, minGapUs, maxGapUs, gapSumUs / gapCount);
+		check(minGapUs >= IntervalUs - JitterUs && maxGapUs <= IntervalUs + JitterUs, "intervals stay within jitter");
+		check(std::abs(gapSumUs / gapCount - IntervalUs) < JitterUs / 10, "jitter averages out");
+
+		// Targets added at the same time should not keep probing at the same time.
+		std::set<int64_t> lastSent;
+		for (auto key = 0; key < 6; ++key)
+			lastSent.insert(stats[key].SentUs.back());
+		check(lastSent.size() == 6, "targets added together drift apart");
+
+		check(stats[6].Failures == 10 && stats[6].LastOutcome == Scheduler::Outcome::GaveUp && !scheduler.Contains(6), "gives up after 10 timeouts in a row");
+
+		// One extra probe right after the latency changed, and then back to the usual interval.
+		const auto& sent7 = stats[7].SentUs;
+		const auto quickProbes = std::ranges::count_if(std::views::iota(size_t{ 1 }, sent7.size()), [&](size_t i) { return sent7[i] - sent7[i - 1] < IntervalUs / 2; });
+		check(quickProbes == 1, "confirms a latency change once");
+
+		std::cout << std::format("  1 thread, {} wakeups; a thread per target would have been 8 threads, with 2 wakeups per probe ({})\n",
+			wakeups, 2 * (probes + stats[6].SentUs.size() + sent7.size()));
+	}
+
+	// Step. Limited requests in flight, as with the number of handles a thread can wait on.
+	{
+		std::cout << "100 targets, at most 8 in flight, for 1 minute:\n";
+		Scheduler scheduler({ .IntervalUs = IntervalUs, .JitterUs = JitterUs }, 1);
+		FakeProber prober;
+		std::map<int, Stats> stats;
+		for (auto key = 0; key < 100; ++key) {
+			prober.Latencies[key] = [](int64_t) { return std::optional<int64_t>(200000); };
+			scheduler.Add(key, 0);
+		}
+
+		size_t maxObserved = 0;
+		Simulate(scheduler, prober, stats, 8, MinuteUs, [&](int64_t) { maxObserved = std::max(maxObserved, scheduler.InFlight()); });
+		const auto fewest = std::ranges::min(stats | std::views::values | std::views::transform([](const Stats& s) { return s.SentUs.size(); }));
+		std::cout << std::format("  at most {} in flight, every target probed at least {} times\n", maxObserved, fewest);
+		check(maxObserved <= 8, "never more than 8 in flight");
+		check(fewest >= 10, "no target starves");
+	}
+
+	// Step. Removing a target while a probe to it is in flight.
+	{
+		std::cout << "Removal while in flight:\n";
+		Scheduler scheduler({ .IntervalUs = IntervalUs }, 2);
+		std::vector<Scheduler::ProbeId> sent;
+		const auto send = [&sent](int, Scheduler::ProbeId probe) { sent.push_back(probe); };
+		scheduler.Add(1, 0);
+		scheduler.Poll(0, SIZE_MAX, send);
+		check(sent.size() == 1 && scheduler.InFlight() == 1, "probe sent");
+		check(scheduler.Remove(1) && scheduler.InFlight() == 1, "removed, but the probe is still out there");
+
+		// Tracked again before the first reply arrives.
+		scheduler.Add(1, 500);
+		scheduler.Poll(500, 1, send);
+		check(sent.size() == 1, "the probe still out there counts towards the limit");
+		scheduler.Poll(500, SIZE_MAX, send);
+		check(sent.size() == 2 && scheduler.InFlight() == 2, "second probe sent without a limit");
+
+		check(!scheduler.Complete(sent[0], 1000, 1000) && scheduler.InFlight() == 1, "late reply ignored, and no longer counted");
+		check(!scheduler.Complete(sent[0], 1000, 1000) && scheduler.InFlight() == 1, "duplicate reply ignored");
+		check(scheduler.Complete(sent[1], 1500, 1000) == Scheduler::Outcome::Recorded && scheduler.InFlight() == 0, "reply to the new probe recorded");
+
+		scheduler.Remove(1);
+		scheduler.Add(1, 2000);
+		check(scheduler.Poll(1999, SIZE_MAX, send) == 2000, "re-added target waits for its due time");
+	}
+
+	std::cout << std::format("{} failure(s)\n", failures);
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,168 @@
+#include "pch.h"
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+
+#include <XivAlexanderCommon/Utils/Deflater.h>
+#include <XivAlexanderCommon/Utils/ZlibWrapper.h>
+
+// Looks like a bundle body: messages of a 0x20-byte header with actor ids and an opcode, followed by mostly zeroes.
+static std::vector<uint8_t> MakeBody(std::mt19937& rng, size_t size) {
+	std::vector<uint8_t> body;
+	body.reserve(size + 0x400);
+	while (body.size() < size) {
+		const auto length = static_cast<uint32_t>(rng() % 16 == 0 ? 0x29c + 8 * (rng() % 64) : 0x20 + 8 * (rng() % 16));
+		const auto offset = body.size();
+		body.resize(offset + length);
+		for (auto i = offset + 0x20; i < body.size(); ++i)
+			body[i] = static_cast<uint8_t>(rng() % 4 ? 0 : rng());
+
+		const uint32_t header[]{ length, static_cast<uint32_t>(0x10000100 + rng() % 24), 0x10000001, 3, static_cast<uint32_t>(0x14 | (0x0100 + rng() % 0x400) << 16), 0, static_cast<uint32_t>(rng()), 0 };
+		memcpy(&body[offset], header, sizeof header);
+	}
+	body.resize(size);
+	return body;
+}
+
+static std::vector<uint8_t> MakeRandom(std::mt19937& rng, size_t size) {
+	std::vector<uint8_t> data(size);
+	for (auto& b : data)
+		b = static_cast<uint8_t>(rng());
+	return data;
+}
+
+static size_t RoundTrip() {
+	size_t failures = 0;
+	std::mt19937 rng(0);
+	Utils::QuickDeflater deflater;
+	Utils::ZlibReusableInflater inflater;
+	std::vector<uint8_t> inflated;
+
+	const auto check = [&](const std::vector<uint8_t>& data, const char* kind) {
+		const auto deflated = deflater(data);
+		bool ok;
+		try {
+			ok = std::ranges::equal(inflater.Inflate(deflated, inflated), data) && deflated.size() <= Utils::QuickDeflater::Bound(data.size());
+		} catch (const std::exception&) {
+			ok = false;
+		}
+		if (!ok && failures++ < 10)
+			std::cout << std::format("  {} bytes of {}: failed\n", data.size(), kind);
+	};
+
+	// Step. Sizes around the edges of matches, of the window, and of stored blocks.
+	for (const auto size : { 0, 1, 3, 4, 5, 15, 16, 17, 257, 258, 259, 32767, 32768, 32769, 65535, 65536, 65537, 200000 }) {
+		check(MakeBody(rng, size), "messages");
+		check(MakeRandom(rng, size), "random");
+		check(std::vector<uint8_t>(size, 0), "zeroes");
+	}
+
+	// Step. Many calls in a row on the same deflater, so that hashes left from earlier inputs are there to be ignored.
+	for (auto i = 0; i < 20000; ++i) {
+		const auto size = static_cast<size_t>(rng() % (i % 10 ? 2048 : 65536));
+		switch (rng() % 4) {
+			case 0:
+				check(MakeRandom(rng, size), "random");
+				break;
+			case 1: {
+				// Short repeating patterns, for distances of 1 and up.
+				auto data = MakeRandom(rng, 1 + rng() % 64);
+				while (data.size() < size)
+					data.push_back(data[data.size() - 1 - rng() % (std::min<size_t>)(data.size(), 1 + rng() % 64)]);
+				data.resize(size);
+				check(data, "patterns");
+				break;
+			}
+			default:
+				check(MakeBody(rng, size), "messages");
+		}
+	}
+
+	// Step. Checksum against zlib, with SIMD blocks of every alignment and remainder.
+	for (auto i = 0; i < 2000; ++i) {
+		const auto data = MakeRandom(rng, rng() % 20000);
+		const auto offset = (std::min<size_t>)(data.size(), rng() % 16);
+		const auto part = std::span(data).subspan(offset);
+		const auto initial = static_cast<uint32_t>(rng() % 65521) | static_cast<uint32_t>(rng() % 65521) << 16;
+		// zlib answers 1 when given no buffer at all, rather than the running value.
+		const auto expected = part.empty() ? initial : static_cast<uint32_t>(adler32(initial, part.data(), static_cast<uInt>(part.size())));
+		if (Utils::QuickDeflater::Adler32(part, initial) != expected && failures++ < 10)
+			std::cout << std::format("  adler32 of {} bytes: differs\n", part.size());
+	}
+
+	std::cout << std::format("Round trips through zlib: {} failure(s)\n", failures);
+	return failures;
+}
+
+struct Measurement {
+	double MeanNs;
+	double P99Ns;
+	double MiBPerSecond;
+	double Ratio;
+};
+
+static Measurement Measure(Utils::Deflater& deflater, const std::vector<std::vector<uint8_t>>& bodies) {
+	std::vector<double> times;
+	size_t inputBytes = 0, outputBytes = 0;
+	double totalNs = 0;
+	const auto start = std::chrono::steady_clock::now();
+	do {
+		for (const auto& body : bodies) {
+			const auto t0 = std::chrono::steady_clock::now();
+			const auto size = deflater.Deflate(body).size();
+			const auto ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+			times.push_back(ns);
+			totalNs += ns;
+			inputBytes += body.size();
+			outputBytes += size;
+		}
+	} while (std::chrono::steady_clock::now() - start < std::chrono::milliseconds(300));
+
+	const auto p99 = times.begin() + static_cast<ptrdiff_t>(times.size() * 99 / 100);
+	std::ranges::nth_element(times, p99);
+	return {
+		totalNs / static_cast<double>(times.size()),
+		*p99,
+		static_cast<double>(inputBytes) / 1048576. / (totalNs / 1e9),
+		static_cast<double>(outputBytes) / static_cast<double>(inputBytes),
+	};
+}
+
+static void Benchmark() {
+	std::cout << "Per call, on bodies made of messages:\n";
+	std::cout << std::format("  {:>6} {:<14} {:>10} {:>10} {:>11} {:>7}\n", "size", "backend", "mean", "p99", "throughput", "ratio");
+	for (const auto size : { 100, 256, 1024, 4096, 16384, 65536 }) {
+		std::mt19937 rng(1);
+		std::vector<std::vector<uint8_t>> bodies;
+		for (auto i = 0; i < 64; ++i)
+			bodies.emplace_back(MakeBody(rng, size));
+
+		// Level and parameters as SingleStream used before.
+		Utils::ZlibReusableDeflater zlibDefault;
+		Utils::ZlibReusableDeflater zlibFastest(1);
+		Utils::QuickDeflater quick;
+		for (const auto& [name, deflater] : std::initializer_list<std::pair<const char*, Utils::Deflater*>>{
+			{ "zlib default", &zlibDefault },
+			{ "zlib level 1", &zlibFastest },
+			{ "quick", &quick },
+		}) {
+			const auto m = Measure(*deflater, bodies);
+			std::cout << std::format("  {:>6} {:<14} {:>8.0f}ns {:>8.0f}ns {:>6.0f}MiB/s {:>6.1f}%\n",
+				size, name, m.MeanNs, m.P99Ns, m.MiBPerSecond, 100 * m.Ratio);
+		}
+	}
+}
+
+int main() {
+	size_t failures = 0;
+
+	// Step. Whatever comes out is what zlib takes.
+	failures += RoundTrip();
+
+	// Step. Time against zlib.
+	Benchmark();
+
+	std::cout << std::format("{} failure(s)\n", failures);
+	return failures ? 1 : 0;
+}
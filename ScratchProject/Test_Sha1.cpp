@@ -0,0 +1,156 @@
+#include "pch.h"
+
+#include <chrono>
+#include <random>
+
+#include <XivAlexanderCommon/Utils/Crypt.h>
+
+using Sha1 = Utils::Crypt::Sha1;
+
+static const std::pair<Sha1::Backend, const char*> Backends[]{
+	{ Sha1::Backend::Scalar, "Scalar" },
+	{ Sha1::Backend::ShaNi, "ShaNi" },
+	{ Sha1::Backend::Avx2, "Avx2" },
+};
+
+static std::string ToHex(std::span<const uint8_t> data) {
+	std::string res;
+	for (const auto b : data)
+		res += std::format("{:02x}", b);
+	return res;
+}
+
+static std::string Sha1Hex(std::span<const uint8_t> data, size_t chunkSize = SIZE_MAX) {
+	Sha1 sha1;
+	for (size_t i = 0; i < data.size(); i += chunkSize)
+		sha1.Update(data.subspan(i, std::min(chunkSize, data.size() - i)));
+	uint8_t digest[Sha1::DigestSize];
+	sha1.Final(digest);
+	return ToHex(digest);
+}
+
+static std::span<const uint8_t> AsBytes(std::string_view s) {
+	return { reinterpret_cast<const uint8_t*>(s.data()), s.size() };
+}
+
+static bool Check(const std::string& what, const std::string& actual, const std::string& expected) {
+	if (actual == expected)
+		return true;
+	std::cout << std::format("FAIL {}: {} != {}\n", what, actual, expected);
+	return false;
+}
+
+static bool KnownAnswerTests(const char* backendName) {
+	const std::string million(1000000, 'a');
+	const std::pair<std::string_view, const char*> vectors[]{
+		{ "", "da39a3ee5e6b4b0d3255bfef95601890afd80709" },
+		{ "abc", "a9993e364706816aba3e25717850c26c9cd0d89d" },
+		{ "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq", "84983e441c3bd26ebaae4aa1f95129e5e54670f1" },
+		{ million, "34aa973cd4c4daa4f61eeb2bdbad27316534016f" },
+	};
+
+	auto ok = true;
+	std::vector<std::span<const uint8_t>> inputs;
+	for (const auto& [message, expected] : vectors) {
+		for (const auto chunkSize : { SIZE_MAX, size_t{ 1 }, size_t{ 63 }, size_t{ 64 }, size_t{ 65 } }) {
+			if (chunkSize == 1 && message.size() > 4096)
+				continue;
+			ok &= Check(std::format("{} sha1(len={}, chunk={})", backendName, message.size(), chunkSize), Sha1Hex(AsBytes(message), chunkSize), expected);
+		}
+		inputs.emplace_back(AsBytes(message));
+	}
+
+	std::vector<uint8_t> digests(inputs.size() * Sha1::DigestSize);
+	Sha1::DigestMany(inputs, digests);
+	for (size_t i = 0; i < inputs.size(); ++i)
+		ok &= Check(std::format("{} DigestMany[{}]", backendName, i), ToHex(std::span(digests).subspan(i * Sha1::DigestSize, Sha1::DigestSize)), vectors[i].second);
+	return ok;
+}
+
+// Lengths around block and padding boundaries, in an order that makes lanes finish at different times.
+static bool DigestManyMatchesSingle(const char* backendName, std::mt19937& rng) {
+	std::vector<uint8_t> data(70000);
+	for (auto& b : data)
+		b = static_cast<uint8_t>(rng());
+
+	std::vector<std::span<const uint8_t>> inputs;
+	for (size_t len = 0; len <= 200; ++len)
+		inputs.emplace_back(std::span(data).subspan(rng() % 1000, len));
+	for (auto i = 0; i < 100; ++i)
+		inputs.emplace_back(std::span(data).subspan(rng() % 1000, rng() % 65536));
+
+	std::vector<uint8_t> digests(inputs.size() * Sha1::DigestSize);
+	Sha1::DigestMany(inputs, digests);
+
+	auto ok = true;
+	for (size_t i = 0; i < inputs.size(); ++i)
+		ok &= Check(std::format("{} DigestMany(len={})", backendName, inputs[i].size()), ToHex(std::span(digests).subspan(i * Sha1::DigestSize, Sha1::DigestSize)), Sha1Hex(inputs[i]));
+	return ok;
+}
+
+static bool HmacSha512KnownAnswerTests() {
+	const std::string longKey(131, '\xaa');
+	const std::tuple<std::string, std::string_view, const char*> vectors[]{
+		{ std::string(20, '\x0b'), "Hi There", "87aa7cdea5ef619d4ff0b4241a1d6cb02379f4e2ce4ec2787ad0b30545e17cdedaa833b7d6b8a702038b274eaea3f4e4be9d914eeb61f1702e696c203a126854" },
+		{ "Jefe", "what do ya want for nothing?", "164b7a7bfcf819e2e395fbe73b56e0a387bd64222e831fd610270cd7ea2505549758bf75c05a994a6d034f65f8f0e6fdcaeab1a34d4a6b4b636e070a38bce737" },
+		{ longKey, "Test Using Larger Than Block-Size Key - Hash Key First", "80b24263c7c1a3ebb71493c1dd7be8b49b46d1f41b4aeec1121b013783f8f3526b56d037e05f2598bd0fd2215d6a1e5295e64f73f63f0aec8b915a985d786598" },
+	};
+
+	auto ok = true;
+	for (const auto& [key, message, expected] : vectors) {
+		Utils::Crypt::HmacSha512 hmac(AsBytes(key));
+		hmac.Update(AsBytes(message));
+		uint8_t digest[Utils::Crypt::HmacSha512::DigestSize];
+		hmac.Final(digest);
+		ok &= Check(std::format("hmac-sha512(keylen={})", key.size()), ToHex(digest), expected);
+	}
+	return ok;
+}
+
+static void Benchmark(const char* backendName, std::mt19937& rng) {
+	// Sqpack data blocks hold at most 16000 bytes.
+	static constexpr size_t BlockSize = 16000;
+	static constexpr size_t BlockCount = 16384;
+
+	std::vector<uint8_t> data(BlockSize * BlockCount);
+	for (auto& b : data)
+		b = static_cast<uint8_t>(rng());
+
+	std::vector<std::span<const uint8_t>> inputs;
+	for (size_t i = 0; i < BlockCount; ++i)
+		inputs.emplace_back(std::span(data).subspan(i * BlockSize, BlockSize));
+	std::vector<uint8_t> digests(inputs.size() * Sha1::DigestSize);
+
+	const auto t0 = std::chrono::steady_clock::now();
+	{
+		Sha1 sha1;
+		sha1.Update(data);
+		sha1.Final(digests);
+	}
+	const auto t1 = std::chrono::steady_clock::now();
+	Sha1::DigestMany(inputs, digests);
+	const auto t2 = std::chrono::steady_clock::now();
+
+	const auto mbps = [&](auto d) { return data.size() / 1048576. / std::chrono::duration<double>(d).count(); };
+	std::cout << std::format("{}: single stream {:.1f}MB/s, DigestMany({} x {}) {:.1f}MB/s\n", backendName, mbps(t1 - t0), BlockCount, BlockSize, mbps(t2 - t1));
+}
+
+int main() {
+	std::mt19937 rng(0x5EED);
+	auto ok = HmacSha512KnownAnswerTests();
+
+	for (const auto& [backend, name] : Backends) {
+		if (!Sha1::IsBackendSupported(backend)) {
+			std::cout << std::format("{}: not supported\n", name);
+			continue;
+		}
+		Sha1::SetBackend(backend);
+		ok &= KnownAnswerTests(name);
+		ok &= DigestManyMatchesSingle(name, rng);
+		Benchmark(name, rng);
+	}
+	Sha1::SetBackend(Sha1::Backend::Auto);
+
+	std::cout << (ok ? "All tests passed\n" : "Some tests failed\n");
+	return ok ? 0 : 1;
+}
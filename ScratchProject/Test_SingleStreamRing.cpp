@@ -0,0 +1,187 @@
+#include "pch.h"
+
+#include <chrono>
+#include <random>
+
+#include <XivAlexanderCommon/Sqex/Network/Structure.h>
+#include <XivAlexanderCommon/Utils/RingBuffer.h>
+
+using namespace Sqex::Network::Structure;
+
+static uint64_t s_allocations = 0;
+static uint64_t s_allocatedBytes = 0;
+
+void* operator new(size_t size) {
+	s_allocations++;
+	s_allocatedBytes += size;
+	if (const auto p = std::malloc(size ? size : 1))
+		return p;
+	throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+	std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+	std::free(p);
+}
+
+// What SingleStream used to do: append to a vector, resize it by 64KiB for every recv, and only start over once drained.
+class VectorStream {
+	std::vector<uint8_t> m_buffer;
+	size_t m_pointer = 0;
+
+public:
+	template<typename TFn>
+	size_t Receive(const TFn& recv) {
+		const auto offset = m_buffer.size();
+		m_buffer.resize(offset + 65536);
+		const auto received = recv(std::span(m_buffer).subspan(offset));
+		m_buffer.resize(offset + received);
+		return received;
+	}
+
+	void Write(std::span<const uint8_t> data) {
+		m_buffer.insert(m_buffer.end(), data.begin(), data.end());
+	}
+
+	std::span<const uint8_t> Peek() {
+		return std::span(m_buffer).subspan(m_pointer);
+	}
+
+	void Consume(size_t length) {
+		m_pointer += length;
+		if (m_pointer == m_buffer.size()) {
+			m_buffer.clear();
+			m_pointer = 0;
+		}
+	}
+
+	size_t Read(std::span<uint8_t> target) {
+		const auto length = std::min(target.size(), m_buffer.size() - m_pointer);
+		memcpy(target.data(), &m_buffer[m_pointer], length);
+		Consume(length);
+		return length;
+	}
+};
+
+// What SingleStream does now.
+class RingStream {
+	Utils::RingBuffer m_buffer;
+
+public:
+	template<typename TFn>
+	size_t Receive(const TFn& recv) {
+		const auto received = recv(m_buffer.PrepareWrite(16384));
+		m_buffer.CommitWrite(received);
+		return received;
+	}
+
+	void Write(std::span<const uint8_t> data) {
+		m_buffer.Write(data);
+	}
+
+	std::span<const uint8_t> Peek() {
+		return m_buffer.Peek(SIZE_MAX);
+	}
+
+	void Consume(size_t length) {
+		m_buffer.Consume(length);
+	}
+
+	size_t Read(std::span<uint8_t> target) {
+		return m_buffer.Read(target);
+	}
+};
+
+static std::vector<uint8_t> MakeStream(size_t length) {
+	std::mt19937 rng(0);
+	std::vector<uint8_t> stream;
+	while (stream.size() < length) {
+		const auto bodyLength = rng() % 8 == 0 ? 0x800 + rng() % 0x4000 : 0x40 + rng() % 0x400;
+		const auto offset = stream.size();
+		stream.resize(offset + sizeof(XivBundleHeader) + bodyLength);
+		auto& header = *reinterpret_cast<XivBundleHeader*>(&stream[offset]);
+		std::ranges::copy(XivBundle::MagicConstant1, header.Magic);
+		header.TotalLength = static_cast<uint32_t>(sizeof(XivBundleHeader) + bodyLength);
+		header.CompressionType = CompressionType::None;
+		for (auto i = offset + sizeof(XivBundleHeader); i < stream.size(); ++i)
+			stream[i] = static_cast<uint8_t>(rng());
+	}
+	return stream;
+}
+
+struct Result {
+	uint64_t Bundles = 0;
+	bool Matches = true;
+	double Seconds = 0;
+	uint64_t Allocations = 0;
+	uint64_t AllocatedBytes = 0;
+};
+
+// The socket hands out whatever has arrived, so a bundle is usually split across receives; the game reads in 4KiB pieces.
+template<typename TStream>
+static Result Tunnel(const std::vector<uint8_t>& source, size_t maxReceive) {
+	std::mt19937 rng(1);
+	TStream raw, processed;
+	std::vector<uint8_t> gameBuffer(4096);
+	size_t sourceOffset = 0, outputOffset = 0;
+	Result result;
+
+	const auto allocationsBefore = s_allocations;
+	const auto allocatedBytesBefore = s_allocatedBytes;
+	const auto start = std::chrono::steady_clock::now();
+	while (sourceOffset < source.size()) {
+		raw.Receive([&](std::span<uint8_t> target) {
+			const auto length = std::min({ target.size(), source.size() - sourceOffset, static_cast<size_t>(1 + rng() % maxReceive) });
+			memcpy(target.data(), &source[sourceOffset], length);
+			sourceOffset += length;
+			return length;
+		});
+
+		while (true) {
+			const auto buf = raw.Peek();
+			if (buf.size() < sizeof(XivBundleHeader))
+				break;
+			const auto& header = *reinterpret_cast<const XivBundleHeader*>(buf.data());
+			if (buf.size() < header.TotalLength)
+				break;
+			processed.Write(buf.subspan(0, header.TotalLength));
+			raw.Consume(header.TotalLength);
+			result.Bundles++;
+		}
+
+		for (size_t read; (read = processed.Read(gameBuffer)) != 0; outputOffset += read)
+			result.Matches &= read <= source.size() - outputOffset && !memcmp(gameBuffer.data(), &source[outputOffset], read);
+	}
+	result.Matches &= outputOffset == source.size();
+	result.Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	result.Allocations = s_allocations - allocationsBefore;
+	result.AllocatedBytes = s_allocatedBytes - allocatedBytesBefore;
+	return result;
+}
+
+int main() {
+	const auto source = MakeStream(256 * 1024 * 1024);
+	std::cout << std::format("{} MiB stream\n", source.size() >> 20);
+
+	size_t failures = 0;
+	for (const auto maxReceive : { 1460, 8192, 65536 }) {
+		std::cout << std::format("receiving up to {} bytes at once:\n", maxReceive);
+		for (const auto& [name, result] : {
+			std::pair{ "vector", Tunnel<VectorStream>(source, maxReceive) },
+			std::pair{ "ring", Tunnel<RingStream>(source, maxReceive) },
+		}) {
+			std::cout << std::format("  {:<8} {:7.1f} MiB/s, {} allocations, {} MiB allocated\n",
+				name, static_cast<double>(source.size()) / result.Seconds / 1048576, result.Allocations, result.AllocatedBytes >> 20);
+			if (!result.Matches) {
+				std::cout << "  output differs\n";
+				failures++;
+			}
+		}
+	}
+
+	std::cout << std::format("{} failure(s)\n", failures);
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,266 @@
+#include "pch.h"
+
+#include <chrono>
+#include <map>
+#include <random>
+#include <set>
+
+#include <XivAlexanderCommon/Utils/FlatHandleMap.h>
+
+// Stands in for ws2_32, so that the hooked call path can be timed without a game or a network.
+// Addresses are kept per socket, and every getsockname/getpeername is counted as a syscall.
+class MockSocketLayer {
+public:
+	using Socket = uintptr_t;
+
+	struct Address {
+		uint32_t Ip = 0;
+		uint16_t Port = 0;
+
+		bool operator==(const Address&) const = default;
+	};
+
+private:
+	struct State {
+		Address Local;
+		Address Remote;
+		bool Connected = false;
+	};
+
+	std::map<Socket, State> m_sockets;
+	Socket m_next = 0x300;
+
+public:
+	mutable uint64_t Syscalls = 0;
+
+	Socket Open() {
+		const auto s = m_next;
+		m_next += 4;
+		m_sockets.emplace(s, State{});
+		return s;
+	}
+
+	void Connect(Socket s, Address remote) {
+		auto& state = m_sockets.at(s);
+		state.Local = { 0x0a000002, static_cast<uint16_t>(40000 + s % 20000) };
+		state.Remote = remote;
+		state.Connected = true;
+	}
+
+	void Close(Socket s) {
+		m_sockets.erase(s);
+	}
+
+	bool GetSockName(Socket s, Address& out) const {
+		Syscalls++;
+		const auto& state = m_sockets.at(s);
+		out = state.Local;
+		return true;
+	}
+
+	bool GetPeerName(Socket s, Address& out) const {
+		Syscalls++;
+		const auto& state = m_sockets.at(s);
+		if (!state.Connected)
+			return false;
+		out = state.Remote;
+		return true;
+	}
+};
+
+struct Connection {
+	MockSocketLayer::Socket Socket;
+	MockSocketLayer::Address Local;
+	MockSocketLayer::Address Remote;
+	bool AddressesResolved = false;
+	uint64_t Calls = 0;
+
+	void ResolveAddresses(const MockSocketLayer& layer) {
+		if (MockSocketLayer::Address local; layer.GetSockName(Socket, local))
+			Local = local;
+		if (MockSocketLayer::Address remote; layer.GetPeerName(Socket, remote))
+			Remote = remote;
+		AddressesResolved = Local.Ip && Remote.Ip;
+	}
+};
+
+enum class TestResult {
+	Pass,
+	Ignore,
+	TakeOver,
+};
+
+static TestResult TestRemoteAddress(const MockSocketLayer& layer, MockSocketLayer::Socket s) {
+	MockSocketLayer::Address remote;
+	if (!layer.GetPeerName(s, remote))
+		return TestResult::Pass;
+	return remote.Port >= 55000 ? TestResult::TakeOver : TestResult::Ignore;
+}
+
+// What SocketHook used to do: a map and a set, and both addresses looked up again on every call.
+class MapHook {
+	const MockSocketLayer& m_layer;
+	std::map<MockSocketLayer::Socket, std::unique_ptr<Connection>> m_sockets;
+	std::set<MockSocketLayer::Socket> m_nonGameSockets;
+
+public:
+	MapHook(const MockSocketLayer& layer) : m_layer(layer) {}
+
+	Connection* Find(MockSocketLayer::Socket s) {
+		if (const auto found = m_sockets.find(s); found != m_sockets.end()) {
+			found->second->ResolveAddresses(m_layer);
+			return found->second.get();
+		}
+		if (m_nonGameSockets.find(s) != m_nonGameSockets.end())
+			return nullptr;
+
+		switch (TestRemoteAddress(m_layer, s)) {
+			case TestResult::Pass:
+				return nullptr;
+			case TestResult::Ignore:
+				m_nonGameSockets.emplace(s);
+				return nullptr;
+			case TestResult::TakeOver:
+				break;
+		}
+		const auto conn = m_sockets.emplace(s, std::make_unique<Connection>(Connection{ s })).first->second.get();
+		conn->ResolveAddresses(m_layer);
+		return conn;
+	}
+
+	void Close(MockSocketLayer::Socket s) {
+		m_sockets.erase(s);
+		m_nonGameSockets.erase(s);
+	}
+};
+
+// What SocketHook does now.
+class FlatHook {
+	const MockSocketLayer& m_layer;
+	Utils::FlatHandleMap<MockSocketLayer::Socket, std::unique_ptr<Connection>> m_sockets;
+
+public:
+	FlatHook(const MockSocketLayer& layer) : m_layer(layer) {}
+
+	Connection* Find(MockSocketLayer::Socket s) {
+		if (const auto found = m_sockets.Find(s)) {
+			if (const auto& conn = *found; conn && !conn->AddressesResolved)
+				conn->ResolveAddresses(m_layer);
+			return found->get();
+		}
+
+		switch (TestRemoteAddress(m_layer, s)) {
+			case TestResult::Pass:
+				return nullptr;
+			case TestResult::Ignore:
+				m_sockets.Emplace(s);
+				return nullptr;
+			case TestResult::TakeOver:
+				break;
+		}
+		const auto conn = m_sockets.Emplace(s, std::make_unique<Connection>(Connection{ s })).first->get();
+		conn->ResolveAddresses(m_layer);
+		return conn;
+	}
+
+	void Close(MockSocketLayer::Socket s) {
+		m_sockets.Erase(s);
+	}
+};
+
+struct Result {
+	uint64_t HookCalls = 0;
+	uint64_t GameCalls = 0;
+	uint64_t Syscalls = 0;
+	double Seconds = 0;
+	std::vector<std::pair<MockSocketLayer::Address, MockSocketLayer::Address>> Endpoints;
+};
+
+// A frame is one select over every socket the game has open, then recv and send on each game connection.
+// Every so often, a connection that is not a game connection gets replaced, and a socket finishes connecting.
+template<typename THook>
+static Result Run(size_t frames, size_t gameSockets, size_t otherSockets) {
+	MockSocketLayer layer;
+	THook hook(layer);
+	std::mt19937 rng(0);
+
+	std::vector<MockSocketLayer::Socket> sockets;
+	for (size_t i = 0; i < gameSockets + otherSockets; ++i) {
+		sockets.emplace_back(layer.Open());
+		layer.Connect(sockets.back(), { 0x7c000000 + static_cast<uint32_t>(i), static_cast<uint16_t>(i < gameSockets ? 55000 + i : 443) });
+	}
+	auto pending = layer.Open();
+	sockets.emplace_back(pending);
+
+	Result result;
+	const auto start = std::chrono::steady_clock::now();
+	for (size_t frame = 0; frame < frames; ++frame) {
+		for (const auto s : sockets) {
+			result.HookCalls++;
+			if (const auto conn = hook.Find(s)) {
+				conn->Calls++;
+				result.GameCalls++;
+			}
+		}
+		for (size_t i = 0; i < gameSockets; ++i) {
+			for (auto j = 0; j < 2; ++j) {
+				result.HookCalls++;
+				if (const auto conn = hook.Find(sockets[i])) {
+					conn->Calls++;
+					result.GameCalls++;
+				}
+			}
+		}
+
+		if (frame % 100 == 99) {
+			layer.Connect(pending, { 0x08080808, 443 });
+			pending = layer.Open();
+			sockets.emplace_back(pending);
+		}
+		if (frame % 250 == 249) {
+			const auto index = gameSockets + rng() % otherSockets;
+			hook.Close(sockets[index]);
+			layer.Close(sockets[index]);
+			sockets[index] = layer.Open();
+			layer.Connect(sockets[index], { 0x01010101, 80 });
+		}
+		if (sockets.size() > gameSockets + otherSockets + 16) {
+			const auto s = sockets[gameSockets + otherSockets];
+			hook.Close(s);
+			layer.Close(s);
+			sockets.erase(sockets.begin() + static_cast<ptrdiff_t>(gameSockets + otherSockets));
+		}
+	}
+	result.Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	result.Syscalls = layer.Syscalls;
+
+	for (size_t i = 0; i < gameSockets; ++i) {
+		const auto conn = hook.Find(sockets[i]);
+		result.Endpoints.emplace_back(conn->Local, conn->Remote);
+	}
+	return result;
+}
+
+int main() {
+	constexpr size_t Frames = 200000;
+	size_t failures = 0;
+
+	for (const auto [gameSockets, otherSockets] : { std::pair<size_t, size_t>{ 2, 6 }, { 4, 60 } }) {
+		const auto before = Run<MapHook>(Frames, gameSockets, otherSockets);
+		const auto after = Run<FlatHook>(Frames, gameSockets, otherSockets);
+
+		std::cout << std::format("{} game and {} other sockets, {} frames:\n", gameSockets, otherSockets, Frames);
+		for (const auto& [name, r] : { std::pair{ "map+set", &before }, { "flat", &after } }) {
+			std::cout << std::format("  {:<8} {:7.1f}ns/call, {:.3f} syscalls/call\n",
+				name, r->Seconds * 1e9 / static_cast<double>(r->HookCalls), static_cast<double>(r->Syscalls) / static_cast<double>(r->HookCalls));
+		}
+
+		if (before.HookCalls != after.HookCalls || before.GameCalls != after.GameCalls || before.Endpoints != after.Endpoints) {
+			std::cout << "  results differ\n";
+			failures++;
+		}
+	}
+
+	std::cout << std::format("{} failure(s)\n", failures);
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,73 @@
+#include "pch.h"
+
+#include <chrono>
+
+#include <XivAlexanderCommon/Sqex/Sqpack/PathRouter.h>
+
+static constexpr auto Repeat = 100;
+
+// How VirtualSqPacks::Open decided whether to take over a file before the router existed.
+static int ResolveUsingFilesystem(const std::filesystem::path& sqpackPath, const std::filesystem::path& path) {
+	const auto fileToOpen = absolute(path);
+	const auto recreatedFilePath = sqpackPath / fileToOpen.parent_path().filename() / fileToOpen.filename();
+	const auto indexFile = std::filesystem::path(recreatedFilePath).replace_extension(L".index");
+	const auto index2File = std::filesystem::path(recreatedFilePath).replace_extension(L".index2");
+	if (!exists(indexFile) && !exists(index2File))
+		return Sqex::Sqpack::PathRouter::PathTypeInvalid;
+	if (fileToOpen == indexFile)
+		return Sqex::Sqpack::PathRouter::PathTypeIndex;
+	if (fileToOpen == index2File)
+		return Sqex::Sqpack::PathRouter::PathTypeIndex2;
+	for (auto i = 0; i < 8; ++i) {
+		if (fileToOpen == std::filesystem::path(recreatedFilePath).replace_extension(std::format(L".dat{}", i)))
+			return i;
+	}
+	return Sqex::Sqpack::PathRouter::PathTypeInvalid;
+}
+
+int main(int argc, char** argv) {
+	const std::filesystem::path sqpackPath = LR"(C:\Program Files (x86)\SquareEnix\FINAL FANTASY XIV - A Realm Reborn\game\sqpack)";
+
+	// One path per line, UTF-8, as recorded from the CreateFileW hook.
+	std::vector<std::wstring> paths;
+	{
+		std::ifstream in(argc > 1 ? argv[1] : "recorded_open_paths.txt");
+		for (std::string line; std::getline(in, line);) {
+			if (!line.empty())
+				paths.emplace_back(Utils::FromUtf8(line));
+		}
+	}
+
+	std::vector<std::unique_ptr<Sqex::Sqpack::Creator::SqpackViews>> views;
+	auto router = Sqex::Sqpack::PathRouter(sqpackPath);
+	for (const auto& iter : std::filesystem::recursive_directory_iterator(sqpackPath)) {
+		if (!iter.is_directory() && iter.path().wstring().ends_with(L".win32.index2"))
+			router.Add(iter.path(), *views.emplace_back(std::make_unique<Sqex::Sqpack::Creator::SqpackViews>()));
+	}
+
+	const auto t0 = std::chrono::steady_clock::now();
+	std::vector<int> filesystemResults;
+	for (auto i = 0; i < Repeat; ++i) {
+		filesystemResults.clear();
+		for (const auto& path : paths)
+			filesystemResults.emplace_back(ResolveUsingFilesystem(sqpackPath, path));
+	}
+
+	const auto t1 = std::chrono::steady_clock::now();
+	std::vector<int> routerResults;
+	for (auto i = 0; i < Repeat; ++i) {
+		routerResults.clear();
+		for (const auto& path : paths) {
+			const auto match = router.Resolve(path);
+			routerResults.emplace_back(match ? match->PathType : Sqex::Sqpack::PathRouter::PathTypeInvalid);
+		}
+	}
+	const auto t2 = std::chrono::steady_clock::now();
+
+	const auto us = [](auto d) { return std::chrono::duration_cast<std::chrono::microseconds>(d).count(); };
+	const auto taken = std::ranges::count_if(routerResults, [](int r) { return r != Sqex::Sqpack::PathRouter::PathTypeInvalid; });
+	std::cout << std::format("{} paths ({} sqpack files) x {}: filesystem {}us, router {}us; {}\n",
+		paths.size(), taken, Repeat, us(t1 - t0), us(t2 - t1),
+		filesystemResults == routerResults ? "identical" : "MISMATCH");
+	return 0;
+}
@@ -0,0 +1,51 @@
+#include "pch.h"
+
+#include <random>
+
+#include <XivAlexanderCommon/Sqex/Sqpack/EntryRawStream.h>
+#include <XivAlexanderCommon/Sqex/Sqpack/TextureEntryProvider.h>
+#include <XivAlexanderCommon/Sqex/Texture.h>
+
+int main(int argc, char** argv) {
+	// A large texture, such as a 4096x4096 one with a full mipmap chain.
+	const std::filesystem::path texPath = argc > 1 ? argv[1] : R"(Z:\tex\4k.tex)";
+	const auto original = Sqex::FileRandomAccessStream(texPath).ReadStreamIntoVector<uint8_t>(0);
+	const auto& header = *reinterpret_cast<const Sqex::Texture::Header*>(&original[0]);
+	const auto mipmapOffsets = std::span(reinterpret_cast<const uint32_t*>(&original[sizeof header]), header.MipmapCount);
+
+	size_t mismatches = 0;
+	const auto readMipmaps = [&](size_t firstMipmap, size_t count) {
+		const auto provider = std::make_shared<Sqex::Sqpack::OnTheFlyTextureEntryProvider>(Sqex::Sqpack::EntryPathSpec("test.tex"), texPath);
+		const auto raw = Sqex::Sqpack::EntryRawStream(provider);
+
+		std::mt19937 rng(0);
+		std::uniform_int_distribution<size_t> dist(firstMipmap, mipmapOffsets.size() - 1);
+		std::vector<uint8_t> buf;
+		for (size_t i = 0; i < count; ++i) {
+			const auto mipmapIndex = dist(rng);
+			const auto length = Sqex::Texture::RawDataLength(header, mipmapIndex);
+			buf.resize(length);
+			raw.ReadStream(mipmapOffsets[mipmapIndex], std::span(buf));
+			if (!std::equal(buf.begin(), buf.end(), original.begin() + mipmapOffsets[mipmapIndex]))
+				mismatches++;
+		}
+		std::cout << std::format("mipmaps {}..{}: {}\n", firstMipmap, mipmapOffsets.size() - 1, provider->DescribeState());
+		std::cout << std::format("  {:.3f} source bytes per served byte\n", provider->ReadAmplification());
+	};
+
+	// Step. What the game usually asks for first; only the small mipmaps at the end of the file should be touched.
+	readMipmaps(std::min<size_t>(2, mipmapOffsets.size() - 1), 1000);
+
+	// Step. Every mipmap, including the full resolution one.
+	readMipmaps(0, 100);
+
+	// Step. The whole file must decode to the original.
+	{
+		const auto raw = Sqex::Sqpack::EntryRawStream(std::make_shared<Sqex::Sqpack::OnTheFlyTextureEntryProvider>(Sqex::Sqpack::EntryPathSpec("test.tex"), texPath));
+		if (raw.ReadStreamIntoVector<uint8_t>(0) != original)
+			mismatches++;
+	}
+
+	std::cout << std::format("{} mismatches\n", mismatches);
+	return mismatches ? 1 : 0;
+}
@@ -0,0 +1,68 @@
+#include "pch.h"
+
+#include <chrono>
+#include <random>
+#include <thread>
+
+#include <XivAlexanderCommon/Sqex/Sqpack/EntryRawStream.h>
+#include <XivAlexanderCommon/Sqex/Sqpack/RandomAccessStreamAsEntryProviderView.h>
+#include <XivAlexanderCommon/Sqex/Sqpack/TextureEntryProvider.h>
+#include <XivAlexanderCommon/Sqex/Texture.h>
+
+int main(int argc, char** argv) {
+	// A large texture, such as a 4096x4096 one with a full mipmap chain.
+	const std::filesystem::path texPath = argc > 1 ? argv[1] : R"(Z:\tex\4k.tex)";
+	constexpr size_t ReadCount = 2000;
+	constexpr size_t ThreadCount = 8;
+
+	// Step. Compress once into memory, so that timings are about decoding only.
+	const auto original = Sqex::FileRandomAccessStream(texPath).ReadStreamIntoVector<uint8_t>(0);
+	const auto compressed = std::make_shared<Sqex::MemoryRandomAccessStream>(
+		*std::make_shared<Sqex::Sqpack::OnTheFlyTextureEntryProvider>(Sqex::Sqpack::EntryPathSpec("test.tex"), texPath));
+	const auto provider = std::make_shared<Sqex::Sqpack::RandomAccessStreamAsEntryProviderView>(Sqex::Sqpack::EntryPathSpec("test.tex"), compressed);
+
+	const auto t0 = std::chrono::steady_clock::now();
+	const auto raw = Sqex::Sqpack::EntryRawStream(provider);
+	const auto t1 = std::chrono::steady_clock::now();
+	std::cout << std::format("{}: {} bytes -> {} bytes compressed; decoder created in {}us\n",
+		texPath.filename().wstring(), original.size(), compressed->StreamSize(),
+		std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count());
+
+	// Step. Locate every mipmap in the decoded stream.
+	const auto& header = *reinterpret_cast<const Sqex::Texture::Header*>(&original[0]);
+	const auto mipmapOffsets = std::span(reinterpret_cast<const uint32_t*>(&original[sizeof header]), header.MipmapCount);
+	std::vector<std::pair<uint32_t, uint32_t>> mipmaps;
+	for (size_t i = 0; i < mipmapOffsets.size(); ++i)
+		mipmaps.emplace_back(mipmapOffsets[i], static_cast<uint32_t>(Sqex::Texture::RawDataLength(header, i)));
+
+	// Step. Random whole-mipmap reads, first from one thread, then from many threads sharing the same decoder.
+	for (const auto threads : { size_t{ 1 }, ThreadCount }) {
+		std::atomic<size_t> mismatches = 0;
+		std::atomic<uint64_t> bytes = 0;
+		const auto start = std::chrono::steady_clock::now();
+		std::vector<std::thread> workers;
+		for (size_t t = 0; t < threads; ++t) {
+			workers.emplace_back([&, t]() {
+				std::mt19937 rng(static_cast<uint32_t>(t));
+				std::uniform_int_distribution<size_t> dist(0, mipmaps.size() - 1);
+				std::vector<uint8_t> buf;
+				for (size_t i = 0; i < ReadCount / threads; ++i) {
+					const auto& [offset, length] = mipmaps[dist(rng)];
+					buf.resize(length);
+					raw.ReadStream(offset, std::span(buf));
+					if (!std::equal(buf.begin(), buf.end(), original.begin() + offset))
+						++mismatches;
+					bytes += length;
+				}
+			});
+		}
+		for (auto& w : workers)
+			w.join();
+		const auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		std::cout << std::format("{} thread(s): {:.1f}us/read, {:.0f}MB/s, {} mismatches\n",
+			threads, seconds * 1e6 * threads / ReadCount, bytes / seconds / 1048576, mismatches.load());
+		if (mismatches)
+			return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,242 @@
+#include "pch.h"
+
+#include <deque>
+#include <random>
+
+#include <XivAlexanderCommon/Sqex/ThirdParty/TexTools.h>
+#include "XivAlexanderCommon/Sqex/Est.h"
+#include "XivAlexanderCommon/Sqex/EqpGmp.h"
+#include "XivAlexanderCommon/Sqex/Imc.h"
+#include "XivAlexanderCommon/Sqex/Eqdp.h"
+
+using ItemMetadata = Sqex::ThirdParty::TexTools::ItemMetadata;
+
+static constexpr auto ItemCount = 5000;
+static constexpr auto Iterations = 20;
+
+static const char* const EquipmentSlots[]{ "met", "top", "glv", "dwn", "sho", "ear", "nek", "wrs", "rir", "ril" };
+
+static std::vector<uint8_t> MakeMetadata(std::mt19937& rng, std::string& gamePath) {
+	const auto primaryId = std::uniform_int_distribution<uint16_t>(1, 400)(rng);
+	const auto isHuman = rng() % 8 == 0;
+	std::string slot;
+	if (isHuman) {
+		gamePath = std::format("chara/human/c0101/obj/hair/h{:04}/c0101h{:04}_hir.meta", primaryId, primaryId);
+	} else {
+		slot = EquipmentSlots[rng() % std::size(EquipmentSlots)];
+		gamePath = std::format("chara/equipment/e{:04}/e{:04}_{}.meta", primaryId, primaryId, slot);
+	}
+
+	std::vector<std::pair<ItemMetadata::MetaDataType, std::vector<uint8_t>>> sections;
+	if (rng() % 2) {
+		std::vector<uint8_t> imc(sizeof Sqex::Imc::Entry * (1 + rng() % 4));
+		for (auto& b : imc)
+			b = static_cast<uint8_t>(rng());
+		sections.emplace_back(ItemMetadata::MetaDataType::Imc, std::move(imc));
+	}
+	if (!isHuman && rng() % 2) {
+		std::vector<ItemMetadata::EqdpEntry> eqdp(1 + rng() % 6);
+		for (auto& e : eqdp) {
+			e.RaceCode = 101 + 100 * (rng() % 8);
+			e.Value = rng() % 4;
+			e.Padding = 0;
+		}
+		sections.emplace_back(ItemMetadata::MetaDataType::Eqdp, std::vector<uint8_t>(reinterpret_cast<uint8_t*>(&eqdp[0]), reinterpret_cast<uint8_t*>(&eqdp[0] + eqdp.size())));
+	}
+	if (!isHuman && rng() % 2) {
+		size_t size = 0;
+		if (slot == "met")
+			size = 3;
+		else if (slot == "top")
+			size = 2;
+		else if (slot == "glv" || slot == "dwn" || slot == "sho")
+			size = 1;
+		if (size) {
+			std::vector<uint8_t> eqp(size);
+			for (auto& b : eqp)
+				b = static_cast<uint8_t>(rng());
+			sections.emplace_back(ItemMetadata::MetaDataType::Eqp, std::move(eqp));
+		}
+	}
+	if (rng() % 4 == 0) {
+		std::vector<uint8_t> gmp(8);
+		for (auto& b : gmp)
+			b = static_cast<uint8_t>(rng());
+		sections.emplace_back(ItemMetadata::MetaDataType::Gmp, std::move(gmp));
+	}
+	if (rng() % 2) {
+		std::vector<ItemMetadata::EstEntry> est(1 + rng() % 4);
+		for (auto& e : est) {
+			e.RaceCode = static_cast<uint16_t>(101 + 100 * (rng() % 8));
+			e.SetId = static_cast<uint16_t>(1 + rng() % 400);
+			e.SkelId = rng() % 3 == 0 ? 0 : static_cast<uint16_t>(1 + rng() % 100);
+		}
+		sections.emplace_back(ItemMetadata::MetaDataType::Est, std::vector<uint8_t>(reinterpret_cast<uint8_t*>(&est[0]), reinterpret_cast<uint8_t*>(&est[0] + est.size())));
+	}
+
+	std::vector<uint8_t> data;
+	const auto append = [&data](const void* p, size_t len) {
+		data.insert(data.end(), static_cast<const uint8_t*>(p), static_cast<const uint8_t*>(p) + len);
+	};
+
+	append(&ItemMetadata::Version_Value, sizeof ItemMetadata::Version_Value);
+	append(gamePath.c_str(), gamePath.size() + 1);
+
+	const auto headerOffset = data.size();
+	const auto locatorOffset = headerOffset + sizeof ItemMetadata::MetaDataHeader;
+	auto dataOffset = locatorOffset + sizeof ItemMetadata::MetaDataEntryLocator * sections.size();
+	ItemMetadata::MetaDataHeader header{};
+	header.EntryCount = static_cast<uint32_t>(sections.size());
+	header.HeaderSize = sizeof header;
+	header.FirstEntryLocatorOffset = static_cast<uint32_t>(locatorOffset);
+	append(&header, sizeof header);
+	for (const auto& [type, body] : sections) {
+		ItemMetadata::MetaDataEntryLocator locator{};
+		locator.Type = type;
+		locator.Offset = static_cast<uint32_t>(dataOffset);
+		locator.Size = static_cast<uint32_t>(body.size());
+		append(&locator, sizeof locator);
+		dataOffset += body.size();
+	}
+	for (const auto& body : sections | std::views::values)
+		append(body.data(), body.size());
+
+	return data;
+}
+
+struct MetadataFiles {
+	std::map<std::string, Sqex::Imc::File> Imc;
+	std::map<std::pair<ItemMetadata::TargetItemType, uint32_t>, Sqex::Eqdp::ExpandedFile> Eqdp;
+	Sqex::EqpGmp::ExpandedFile Eqp;
+	Sqex::EqpGmp::ExpandedFile Gmp;
+	std::map<ItemMetadata::TargetEstType, Sqex::Est::File> Est;
+};
+
+struct OriginalFiles {
+	std::vector<uint8_t> Imc;
+	std::vector<uint8_t> Eqdp;
+	std::map<ItemMetadata::TargetEstType, std::vector<uint8_t>> Est;
+
+	explicit OriginalFiles(std::mt19937& rng) {
+		Imc.resize(sizeof Sqex::Imc::Header + sizeof Sqex::Imc::Entry * 5 * 3);
+		for (auto& b : Imc)
+			b = static_cast<uint8_t>(rng());
+		reinterpret_cast<Sqex::Imc::Header*>(&Imc[0])->SubsetCount = 2;
+		reinterpret_cast<Sqex::Imc::Header*>(&Imc[0])->Type = Sqex::Imc::Type::Set;
+
+		constexpr uint16_t blockMemberCount = 160, blockCount = 64;
+		Eqdp.resize(sizeof Sqex::Eqdp::Header + sizeof uint16_t * blockCount);
+		auto& eqdpHeader = *reinterpret_cast<Sqex::Eqdp::Header*>(&Eqdp[0]);
+		eqdpHeader.Identifier = 0;
+		eqdpHeader.BlockMemberCount = blockMemberCount;
+		eqdpHeader.BlockCount = blockCount;
+		uint16_t populated = 0;
+		for (size_t i = 0; i < blockCount; ++i) {
+			const auto present = i < 4 && rng() % 2;
+			*reinterpret_cast<uint16_t*>(&Eqdp[sizeof Sqex::Eqdp::Header + i * 2]) = present ? populated : UINT16_MAX;
+			if (present)
+				populated += blockMemberCount;
+		}
+		for (size_t i = 0; i < populated; ++i) {
+			const auto v = static_cast<uint16_t>(rng());
+			Eqdp.insert(Eqdp.end(), reinterpret_cast<const uint8_t*>(&v), reinterpret_cast<const uint8_t*>(&v) + 2);
+		}
+		Eqdp.resize(Sqex::Align<size_t>(Eqdp.size(), 512).Alloc);
+
+		for (const auto type : { ItemMetadata::TargetEstType::Face, ItemMetadata::TargetEstType::Hair, ItemMetadata::TargetEstType::Head, ItemMetadata::TargetEstType::Body }) {
+			std::map<Sqex::Est::EntryDescriptor, uint16_t> pairs;
+			for (size_t i = 0; i < 500; ++i)
+				pairs.insert_or_assign(Sqex::Est::EntryDescriptor{ .SetId = static_cast<uint16_t>(1 + rng() % 400), .RaceCode = static_cast<uint16_t>(101 + 100 * (rng() % 8)) }, static_cast<uint16_t>(1 + rng() % 100));
+			Est.emplace(type, Sqex::Est::File(pairs).Data());
+		}
+	}
+};
+
+static void ApplySequential(const std::deque<ItemMetadata>& items, const OriginalFiles& orig, MetadataFiles& files) {
+	for (const auto& metadata : items) {
+		metadata.ApplyImcEdits([&]() -> Sqex::Imc::File& {
+			if (const auto it = files.Imc.find(metadata.TargetImcPath); it == files.Imc.end())
+				return files.Imc[metadata.TargetImcPath] = Sqex::Imc::File(Sqex::MemoryRandomAccessStream(orig.Imc));
+			else
+				return it->second;
+			});
+		metadata.ApplyEqdpEdits([&](auto type, auto race) -> Sqex::Eqdp::ExpandedFile& {
+			const auto key = std::make_pair(type, race);
+			if (const auto it = files.Eqdp.find(key); it == files.Eqdp.end())
+				return files.Eqdp[key] = Sqex::Eqdp::ExpandedFile(Sqex::Eqdp::File(orig.Eqdp));
+			else
+				return it->second;
+			});
+		metadata.ApplyEqpEdits(files.Eqp);
+		metadata.ApplyGmpEdits(files.Gmp);
+		if (ItemMetadata::EstPath(metadata.EstType) && !metadata.Get<ItemMetadata::EstEntry>(ItemMetadata::MetaDataType::Est).empty()) {
+			if (const auto it = files.Est.find(metadata.EstType); it == files.Est.end())
+				metadata.ApplyEstEdits(files.Est[metadata.EstType] = Sqex::Est::File(orig.Est.at(metadata.EstType)));
+			else
+				metadata.ApplyEstEdits(it->second);
+		}
+	}
+}
+
+static void ApplyBatch(const std::deque<ItemMetadata>& items, const OriginalFiles& orig, MetadataFiles& files) {
+	Sqex::ThirdParty::TexTools::ItemMetadataBatch batch;
+	for (const auto& metadata : items)
+		batch.Add(metadata);
+
+	batch.ApplyImcEdits([&](const auto& targetImcPath, const auto&) -> Sqex::Imc::File& {
+		return files.Imc[targetImcPath] = Sqex::Imc::File(Sqex::MemoryRandomAccessStream(orig.Imc));
+		});
+	batch.ApplyEqdpEdits([&](auto type, auto race) -> Sqex::Eqdp::ExpandedFile& {
+		return files.Eqdp[std::make_pair(type, race)] = Sqex::Eqdp::ExpandedFile(Sqex::Eqdp::File(orig.Eqdp));
+		});
+	batch.ApplyEqpEdits(files.Eqp);
+	batch.ApplyGmpEdits(files.Gmp);
+	batch.ApplyEstEdits([&](auto type) -> Sqex::Est::File& {
+		return files.Est[type] = Sqex::Est::File(orig.Est.at(type));
+		});
+}
+
+static bool Compare(const MetadataFiles& l, const MetadataFiles& r) {
+	if (l.Eqp.Data() != r.Eqp.Data() || l.Gmp.Data() != r.Gmp.Data())
+		return false;
+	if (l.Imc.size() != r.Imc.size() || l.Eqdp.size() != r.Eqdp.size() || l.Est.size() != r.Est.size())
+		return false;
+	for (const auto& [k, v] : l.Imc)
+		if (!r.Imc.contains(k) || r.Imc.at(k).Data() != v.Data())
+			return false;
+	for (const auto& [k, v] : l.Eqdp)
+		if (!r.Eqdp.contains(k) || r.Eqdp.at(k).Data() != v.Data())
+			return false;
+	for (const auto& [k, v] : l.Est)
+		if (!r.Est.contains(k) || r.Est.at(k).Data() != v.Data())
+			return false;
+	return true;
+}
+
+int main() {
+	std::mt19937 rng(0x5EED);
+	const OriginalFiles orig(rng);
+
+	for (auto iteration = 0; iteration < Iterations; ++iteration) {
+		std::deque<ItemMetadata> items;
+		for (auto i = 0; i < ItemCount; ++i) {
+			std::string gamePath;
+			const auto data = MakeMetadata(rng, gamePath);
+			items.emplace_back(gamePath, Sqex::MemoryRandomAccessStream(data));
+		}
+
+		MetadataFiles sequential, batched;
+		const auto t0 = std::chrono::steady_clock::now();
+		ApplySequential(items, orig, sequential);
+		const auto t1 = std::chrono::steady_clock::now();
+		ApplyBatch(items, orig, batched);
+		const auto t2 = std::chrono::steady_clock::now();
+
+		std::cout << std::format("#{}: {} items; sequential {}us, batch {}us; {}\n",
+			iteration, ItemCount,
+			std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count(),
+			std::chrono::duration_cast<std::chrono::microseconds>(t2 - t1).count(),
+			Compare(sequential, batched) ? "identical" : "MISMATCH");
+	}
+	return 0;
+}
@@ -0,0 +1,194 @@
+#include "pch.h"
+
+#include <atomic>
+#include <chrono>
+
+#include <XivAlexanderCommon/Sqex/ThirdParty/TexTools.h>
+
+static std::atomic<size_t> s_allocated = 0;
+static std::atomic<size_t> s_peak = 0;
+
+void* operator new(size_t size) {
+	const auto p = static_cast<size_t*>(std::malloc(size + sizeof(size_t) * 2));
+	if (!p)
+		throw std::bad_alloc();
+	p[0] = size;
+	const auto now = s_allocated += size;
+	for (auto peak = s_peak.load(); now > peak && !s_peak.compare_exchange_weak(peak, now);) {}
+	return p + 2;
+}
+
+void operator delete(void* ptr) noexcept {
+	if (!ptr)
+		return;
+	const auto p = static_cast<size_t*>(ptr) - 2;
+	s_allocated -= p[0];
+	std::free(p);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+	operator delete(ptr);
+}
+
+static std::string MakeTtmpl(size_t pages, size_t groups, size_t options, size_t entries, size_t simpleEntries, size_t descriptionLength) {
+	const auto entry = [](std::string& s, size_t i) {
+		s += std::format(R"({{"Name":"Item {}","Category":"Gear","FullPath":"chara/equipment/e{:04}/texture/v01_c0101e{:04}_top_{}.tex","ModOffset":{},"ModSize":{},"DatFile":"040000","IsDefault":false,"ModPackEntry":{{"Name":"Pack","Author":"Author","Version":"1.0","Url":""}}}})",
+			i, i % 10000, i % 10000, i % 3 ? "d" : "n", i * 4096, 4096 + i % 1000);
+	};
+
+	size_t index = 0;
+	std::string s = R"({"MinimumFrameworkVersion":"1.0.0.0","FormatVersion":"1.3","Name":"Test Pack","Author":"Tester","Version":"1.0.0","Description":"Test","Url":"","ModPackPages":[)";
+	for (size_t p = 0; p < pages; ++p) {
+		s += std::format(R"({}{{"PageIndex":{},"ModGroups":[)", p ? "," : "", p);
+		for (size_t g = 0; g < groups; ++g) {
+			s += std::format(R"({}{{"GroupName":"Group {}","SelectionType":"Single","OptionList":[)", g ? "," : "", g);
+			for (size_t o = 0; o < options; ++o) {
+				s += std::format(R"({}{{"Name":"Option {}","Description":")", o ? "," : "", o);
+				s.append(descriptionLength, 'x');
+				s += std::format(R"(","ImagePath":"images/{}.png","GroupName":"Group {}","SelectionType":"Single","IsChecked":{},"ModsJsons":[)", o, g, o == 0);
+				for (size_t e = 0; e < entries; ++e) {
+					if (e)
+						s += ',';
+					entry(s, index++);
+				}
+				s += "]}";
+			}
+			s += "]}";
+		}
+		s += "]}";
+	}
+	s += R"(],"SimpleModsList":[)";
+	for (size_t e = 0; e < simpleEntries; ++e) {
+		if (e)
+			s += ',';
+		entry(s, index++);
+	}
+	s += "]}";
+	return s;
+}
+
+static Sqex::MemoryRandomAccessStream ToStream(const std::string& s) {
+	return Sqex::MemoryRandomAccessStream(std::vector<uint8_t>(s.begin(), s.end()));
+}
+
+// What TTMPL::FromStream used to do.
+static Sqex::ThirdParty::TexTools::TTMPL ParseWithDom(const Sqex::RandomAccessStream& stream) {
+	std::string buf(static_cast<size_t>(stream.StreamSize()), '\0');
+	stream.ReadStream(0, &buf[0], buf.size());
+
+	std::istringstream in(buf);
+	Sqex::ThirdParty::TexTools::TTMPL res;
+	while (!in.eof()) {
+		nlohmann::json j;
+		try {
+			in >> j;
+		} catch (...) {
+			if (in.eof())
+				break;
+		}
+		if (j.find("ModOffset") != j.end()) {
+			res.SimpleModsList.emplace_back(j.get<Sqex::ThirdParty::TexTools::ModEntry>());
+		} else {
+			return j.get<Sqex::ThirdParty::TexTools::TTMPL>();
+		}
+	}
+	return res;
+}
+
+template<typename T>
+static T Measure(const char* name, const std::function<T()>& fn) {
+	const auto base = s_allocated.load();
+	s_peak = base;
+	const auto start = std::chrono::steady_clock::now();
+	auto res = fn();
+	const auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	std::cout << std::format("{:<16} {:8.1f}ms, peak {:7.1f}MB, retained {:7.1f}MB\n",
+		name, seconds * 1000, (s_peak - base) / 1048576., (s_allocated - base) / 1048576.);
+	return res;
+}
+
+static size_t Compare(const Sqex::ThirdParty::TexTools::TTMPL& expected, const Sqex::ThirdParty::TexTools::TTMPL& actual, const Sqex::ThirdParty::TexTools::ModEntryTable& table) {
+	size_t failures = 0;
+	if (nlohmann::json(expected) != nlohmann::json(actual))
+		failures++;
+	if (table.Name() != expected.Name)
+		failures++;
+
+	size_t i = 0;
+	const auto entries = table.Entries();
+	for (const auto& entry : expected.SimpleModsList) {
+		if (i >= entries.size() || entries[i].Name != entry.Name || entries[i].FullPath != entry.FullPath
+			|| entries[i].ModOffset != entry.ModOffset || entries[i].ModSize != entry.ModSize
+			|| entries[i].PageIndex != Sqex::ThirdParty::TexTools::ModEntryTable::SimpleModsListIndex)
+			failures++;
+		i++;
+	}
+	for (size_t p = 0; p < expected.ModPackPages.size(); ++p) {
+		for (size_t g = 0; g < expected.ModPackPages[p].ModGroups.size(); ++g) {
+			for (size_t o = 0; o < expected.ModPackPages[p].ModGroups[g].OptionList.size(); ++o) {
+				for (const auto& entry : expected.ModPackPages[p].ModGroups[g].OptionList[o].ModsJsons) {
+					if (i >= entries.size() || entries[i].Name != entry.Name || entries[i].FullPath != entry.FullPath
+						|| entries[i].ModOffset != entry.ModOffset || entries[i].ModSize != entry.ModSize
+						|| entries[i].PageIndex != p || entries[i].GroupIndex != g || entries[i].OptionIndex != o)
+						failures++;
+					i++;
+				}
+			}
+		}
+	}
+	if (i != entries.size())
+		failures++;
+	return failures;
+}
+
+static size_t CheckSame(const char* name, const std::string& s) {
+	const auto stream = ToStream(s);
+	const auto expected = ParseWithDom(stream);
+	const auto failures = Compare(expected, Sqex::ThirdParty::TexTools::TTMPL::FromStream(stream), Sqex::ThirdParty::TexTools::ModEntryTable::FromStream(stream));
+	if (failures)
+		std::cout << std::format("{}: {} failure(s)\n", name, failures);
+	return failures;
+}
+
+static size_t CheckThrows(const char* name, const std::string& s) {
+	const auto stream = ToStream(s);
+	try {
+		void(Sqex::ThirdParty::TexTools::TTMPL::FromStream(stream));
+	} catch (const Sqex::CorruptDataException&) {
+		return 0;
+	}
+	std::cout << std::format("{}: expected an error\n", name);
+	return 1;
+}
+
+int main() {
+	size_t failures = 0;
+
+	// Step. Both formats, and the corner cases that from_json handles.
+	failures += CheckSame("small", MakeTtmpl(2, 2, 3, 4, 5, 10));
+	failures += CheckSame("simple list", R"({"Name":"A","FullPath":"a.tex","ModOffset":0,"ModSize":16}
+{"Name":"B","FullPath":"b.tex","ModOffset":16,"ModSize":32,"ModPackEntry":null}
+)");
+	failures += CheckSame("simple list, truncated", R"({"Name":"A","FullPath":"a.tex","ModOffset":0,"ModSize":16}
+{"Name":"B","FullPath":"b.te)");
+	failures += CheckSame("nulls and unknown keys", R"({"Name":null,"Unknown":{"a":[1,{"b":2}]},"ModPackPages":[{"PageIndex":null,"ModGroups":null}],"SimpleModsList":[{"Name":"A","FullPath":"a.tex","ModOffset":1.0,"ModSize":null,"Extra":[[]]}]})");
+	failures += CheckSame("empty", "");
+	failures += CheckThrows("array", "[]");
+	failures += CheckThrows("wrong string type", R"({"SimpleModsList":[{"FullPath":1}]})");
+	failures += CheckThrows("wrong item type", R"({"ModPackPages":[1]})");
+	failures += CheckThrows("wrong array type", R"({"ModPackPages":{}})");
+	failures += CheckThrows("syntax error", R"({"Name" "A"}   {})");
+
+	// Step. A large mod pack with long option descriptions.
+	const auto large = MakeTtmpl(20, 10, 25, 10, 5000, 6000);
+	const auto stream = ToStream(large);
+	std::cout << std::format("{:.1f}MB, {} entries\n", large.size() / 1048576., 20 * 10 * 25 * 10 + 5000);
+
+	const auto dom = Measure<Sqex::ThirdParty::TexTools::TTMPL>("DOM", [&]() { return ParseWithDom(stream); });
+	const auto sax = Measure<Sqex::ThirdParty::TexTools::TTMPL>("SAX", [&]() { return Sqex::ThirdParty::TexTools::TTMPL::FromStream(stream); });
+	const auto table = Measure<Sqex::ThirdParty::TexTools::ModEntryTable>("ModEntryTable", [&]() { return Sqex::ThirdParty::TexTools::ModEntryTable::FromStream(stream); });
+	failures += Compare(dom, sax, table);
+
+	std::cout << std::format("{} failure(s)\n", failures);
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,210 @@
+#include "pch.h"
+
+#include <chrono>
+#include <random>
+
+#include <XivAlexanderCommon/Sqex/Network/Structure.h>
+#include <XivAlexanderCommon/Utils/Oodle.h>
+#include <XivAlexanderCommon/Utils/ZlibWrapper.h>
+
+using namespace Sqex::Network::Structure;
+
+static uint64_t s_allocations = 0;
+
+void* operator new(size_t size) {
+	s_allocations++;
+	if (const auto p = std::malloc(size ? size : 1))
+		return p;
+	throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+	std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+	std::free(p);
+}
+
+// Bundles of a busy zone: a dozen messages each, mostly small IPCs with an occasional large one.
+static std::vector<std::vector<uint8_t>> MakeBundles(size_t count, CompressionType compressionType) {
+	std::mt19937 rng(0);
+	Utils::ZlibReusableDeflater deflater;
+	std::vector<std::vector<uint8_t>> bundles;
+
+	for (size_t i = 0; i < count; ++i) {
+		std::vector<uint8_t> body;
+		const auto messageCount = 1 + rng() % 24;
+		for (size_t j = 0; j < messageCount; ++j) {
+			const auto length = static_cast<uint32_t>(rng() % 16 == 0 ? 0x29c + 8 * (rng() % 64) : 0x20 + 8 * (rng() % 16));
+			const auto offset = body.size();
+			body.resize(offset + length);
+			for (auto k = offset + sizeof(XivMessageHeader); k < body.size(); ++k)
+				body[k] = static_cast<uint8_t>(rng() % 4 ? 0 : rng());
+
+			auto& message = *reinterpret_cast<XivMessage*>(&body[offset]);
+			message.Length = length;
+			message.SourceActor = 0x10000100 + rng() % 24;
+			message.CurrentActor = 0x10000001;
+			message.Type = MessageType::Ipc;
+			message.Data.Ipc.Type = IpcType::InterestedType;
+			message.Data.Ipc.SubType = static_cast<uint16_t>(0x0100 + rng() % 0x400);
+		}
+
+		const auto encoded = compressionType == CompressionType::Deflate ? deflater(body) : std::span(body);
+		auto& bundle = bundles.emplace_back(sizeof(XivBundleHeader) + encoded.size());
+		auto& header = *reinterpret_cast<XivBundleHeader*>(bundle.data());
+		std::ranges::copy(XivBundle::MagicConstant1, header.Magic);
+		header.TotalLength = static_cast<uint32_t>(bundle.size());
+		header.MessageCount = static_cast<uint16_t>(messageCount);
+		header.CompressionType = compressionType;
+		header.DecodedBodyLength = static_cast<uint32_t>(body.size());
+		std::ranges::copy(encoded, bundle.begin() + sizeof(XivBundleHeader));
+	}
+	return bundles;
+}
+
+// Splits a captured stream, such as the TCP payload of a game connection saved from a packet capture, into bundles.
+static std::vector<std::vector<uint8_t>> ReadBundles(const std::filesystem::path& path) {
+	std::ifstream in(path, std::ios::binary);
+	const std::vector<uint8_t> data{ std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>() };
+
+	std::vector<std::vector<uint8_t>> bundles;
+	for (auto view = std::span(data); view.size() >= sizeof(XivBundleHeader);) {
+		view = view.subspan(XivBundle::ExtractFrontTrash(view).size());
+		if (view.size() < sizeof(XivBundleHeader))
+			break;
+		const auto& header = *reinterpret_cast<const XivBundleHeader*>(view.data());
+		if (!header.TotalLength || header.TotalLength > view.size()) {
+			view = view.subspan(1);
+			continue;
+		}
+		if (header.CompressionType == CompressionType::Deflate)
+			bundles.emplace_back(view.begin(), view.begin() + header.TotalLength);
+		view = view.subspan(header.TotalLength);
+	}
+	return bundles;
+}
+
+// Drops about one in eight messages, and touches the rest, as message handlers would.
+static bool Filter(XivMessage* pMessage) {
+	pMessage->Unknown1 ^= 1;
+	return (pMessage->Data.Ipc.SubType & 7) != 0;
+}
+
+struct Result {
+	uint64_t Messages = 0;
+	uint64_t BodyBytes = 0;
+	uint64_t Checksum = 0;
+
+	bool operator==(const Result&) const = default;
+};
+
+// What SocketHook used to do: copy each message into its own vector, and then concatenate those kept into a new body.
+static Result RunCopying(const std::vector<std::vector<uint8_t>>& bundles, Utils::ZlibReusableInflater& inflater, bool checksum) {
+	Result result;
+	for (const auto& bundle : bundles) {
+		const auto& header = *reinterpret_cast<const XivBundle*>(bundle.data());
+		const auto encoded = std::span(header.Data, header.TotalLength - sizeof(XivBundleHeader));
+		const auto decoded = header.CompressionType == CompressionType::Deflate ? inflater(encoded) : encoded;
+
+		std::vector<std::vector<uint8_t>> messages;
+		messages.reserve(header.MessageCount);
+		for (size_t i = 0; i < decoded.size();) {
+			const auto length = reinterpret_cast<const XivMessage*>(&decoded[i])->Length;
+			if (!length || i + length > decoded.size())
+				throw std::runtime_error("bad message");
+			messages.emplace_back(decoded.begin() + static_cast<ptrdiff_t>(i), decoded.begin() + static_cast<ptrdiff_t>(i + length));
+			i += length;
+		}
+
+		uint32_t bodyLength = 0;
+		for (auto& message : messages) {
+			const auto pMessage = reinterpret_cast<XivMessage*>(&message[0]);
+			if (!Filter(pMessage))
+				pMessage->Length = 0;
+			bodyLength += pMessage->Length;
+		}
+
+		std::vector<uint8_t> body;
+		body.reserve(bodyLength);
+		for (const auto& message : messages) {
+			if (!reinterpret_cast<const XivMessage*>(&message[0])->Length)
+				continue;
+			body.insert(body.end(), message.begin(), message.end());
+			result.Messages++;
+		}
+		result.BodyBytes += body.size();
+		if (checksum)
+			result.Checksum = std::accumulate(body.begin(), body.end(), result.Checksum, [](uint64_t a, uint8_t b) { return a * 31 + b; });
+	}
+	return result;
+}
+
+static Result RunInPlace(const std::vector<std::vector<uint8_t>>& bundles, Utils::ZlibReusableInflater& inflater, Utils::Oodle::Oodler& oodler, std::vector<uint8_t>& arena, bool checksum) {
+	Result result;
+	for (const auto& bundle : bundles) {
+		const auto& header = *reinterpret_cast<const XivBundle*>(bundle.data());
+		const auto [body, count] = XivBundle::FilterMessages(header.DecodeBody(inflater, oodler, arena), Filter);
+		result.Messages += count;
+		result.BodyBytes += body.size();
+		if (checksum)
+			result.Checksum = std::accumulate(body.begin(), body.end(), result.Checksum, [](uint64_t a, uint8_t b) { return a * 31 + b; });
+	}
+	return result;
+}
+
+static bool Run(const std::vector<std::vector<uint8_t>>& bundles) {
+	constexpr auto Repeats = 200;
+
+	Utils::Oodle::OodleModule oodleModule;
+	Utils::Oodle::Oodler oodler(oodleModule, false);
+	Utils::ZlibReusableInflater inflater, copyingInflater;
+	std::vector<uint8_t> arena;
+
+	// Step. Compare, which also warms up reusable buffers.
+	const auto copying = RunCopying(bundles, copyingInflater, true);
+	const auto inPlace = RunInPlace(bundles, inflater, oodler, arena, true);
+	const auto same = copying == inPlace;
+	std::cout << std::format("{} bundles replayed {} times, {} messages kept, {} bytes; results {}\n",
+		bundles.size(), Repeats, copying.Messages, copying.BodyBytes, same ? "match" : "differ");
+
+	// Step. Time both, counting allocations; decoding alone is there to tell how much of it is spent on splitting messages.
+	for (const auto& [name, run] : std::initializer_list<std::pair<const char*, std::function<void()>>>{
+		{ "decode", [&] {
+			for (const auto& bundle : bundles)
+				void(reinterpret_cast<const XivBundle*>(bundle.data())->DecodeBody(inflater, oodler, arena));
+		} },
+		{ "copying", [&] { void(RunCopying(bundles, copyingInflater, false)); } },
+		{ "in place", [&] { void(RunInPlace(bundles, inflater, oodler, arena, false)); } },
+	}) {
+		const auto allocationsBefore = s_allocations;
+		const auto start = std::chrono::steady_clock::now();
+		for (auto i = 0; i < Repeats; ++i)
+			run();
+		const auto elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+		std::cout << std::format("  {:<8} {:.2f}us/bundle, {:.2f} allocations/bundle\n",
+			name, elapsed / static_cast<double>(bundles.size() * Repeats),
+			static_cast<double>(s_allocations - allocationsBefore) / static_cast<double>(bundles.size() * Repeats));
+	}
+
+	return same;
+}
+
+int main(int argc, char** argv) {
+	size_t failures = 0;
+	if (argc > 1) {
+		std::cout << "Captured, deflate:\n";
+		failures += !Run(ReadBundles(argv[1]));
+	} else {
+		std::cout << "Synthesized, deflate:\n";
+		failures += !Run(MakeBundles(2000, CompressionType::Deflate));
+	}
+
+	// Without compression, what is left is splitting and filtering.
+	std::cout << "Synthesized, uncompressed:\n";
+	failures += !Run(MakeBundles(2000, CompressionType::None));
+
+	std::cout << std::format("{} failure(s)\n", failures);
+	return failures ? 1 : 0;
+}
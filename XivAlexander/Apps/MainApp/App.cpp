@@ -49,6 +49,8 @@ struct XivAlexander::Apps::MainApp::App::Implementation_GameWindow final {
 	DWORD GetThreadId(bool wait = false) const;
 
 	void RunOnGameLoop(std::function<void()> f);
+	void PostOnGameLoop(std::function<void()> f);
+	void CallLoggingErrors(const std::function<void()>& f) const;
 
 	LRESULT CALLBACK SubclassProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam);
 };
@@ -119,6 +121,17 @@ struct XivAlexander::Apps::MainApp::App::Implementation {
 	}
 
 	void LoadAfterThisConstruct() {
+		Cleanup += Config->Runtime.MinimumLogLevels.AddAndCallOnChange([this]() {
+			const auto& levels = Config->Runtime.MinimumLogLevels.Value();
+			for (const auto& [category, name] : Misc::Logger::LogCategoryNames) {
+				const auto it = levels.find(name);
+				Logger->SetMinimumLevel(category, it == levels.end() ? LogLevel::Unset : static_cast<LogLevel>(it->second));
+			}
+		}, [this]() {
+			for (const auto& category : Misc::Logger::LogCategoryNames | std::views::keys)
+				Logger->SetMinimumLevel(category, LogLevel::Unset);
+		});
+
 		PatchCode.emplace(App);
 		
 		SocketHook.emplace(App);
@@ -269,18 +282,7 @@ void XivAlexander::Apps::MainApp::App::Implementation_GameWindow::RunOnGameLoop(
 	{
 		std::lock_guard _lock(RunOnGameLoopMtx);
 		RunOnGameLoopQueue.emplace([this, &f, &hEvent]() {
-			try {
-				try {
-					f();
-				} catch (const _com_error& e) {
-					if (e.Error() != HRESULT_FROM_WIN32(ERROR_CANCELLED))
-						throw Utils::Win32::Error(e);
-				}
-			} catch (const std::exception& e) {
-				App.m_pImpl->Logger->Log(LogCategory::General, App.m_pImpl->Config->Runtime.FormatStringRes(IDS_ERROR_UNEXPECTED, e.what()), LogLevel::Error);
-			} catch (...) {
-				App.m_pImpl->Logger->Log(LogCategory::General, App.m_pImpl->Config->Runtime.FormatStringRes(IDS_ERROR_UNEXPECTED, L"?"), LogLevel::Error);
-			}
+			CallLoggingErrors(f);
 			hEvent.Set();
 			});
 	}
@@ -289,6 +291,38 @@ void XivAlexander::Apps::MainApp::App::Implementation_GameWindow::RunOnGameLoop(
 	hEvent.Wait();
 }
 
+void XivAlexander::Apps::MainApp::App::Implementation_GameWindow::PostOnGameLoop(std::function<void()> f) {
+	if (App.m_bInternalUnloadInitiated)
+		return;
+
+	{
+		std::lock_guard _lock(RunOnGameLoopMtx);
+		RunOnGameLoopQueue.emplace([this, f = std::move(f)]() {
+			if (!App.m_bInternalUnloadInitiated)
+				CallLoggingErrors(f);
+			});
+	}
+
+	// If the game window is not found yet, the queue will be processed on the first message after it is.
+	if (const auto hwnd = GetHwnd(false))
+		PostMessageW(hwnd, WM_NULL, 0, 0);
+}
+
+void XivAlexander::Apps::MainApp::App::Implementation_GameWindow::CallLoggingErrors(const std::function<void()>& f) const {
+	try {
+		try {
+			f();
+		} catch (const _com_error& e) {
+			if (e.Error() != HRESULT_FROM_WIN32(ERROR_CANCELLED))
+				throw Utils::Win32::Error(e);
+		}
+	} catch (const std::exception& e) {
+		App.m_pImpl->Logger->Log(LogCategory::General, App.m_pImpl->Config->Runtime.FormatStringRes(IDS_ERROR_UNEXPECTED, e.what()), LogLevel::Error);
+	} catch (...) {
+		App.m_pImpl->Logger->Log(LogCategory::General, App.m_pImpl->Config->Runtime.FormatStringRes(IDS_ERROR_UNEXPECTED, L"?"), LogLevel::Error);
+	}
+}
+
 HWND XivAlexander::Apps::MainApp::App::Implementation_GameWindow::GetHwnd(bool wait /*= false*/) const {
 	if (wait && ReadyEvent.Wait(false, { StopEvent }) == WAIT_OBJECT_0 + 1)
 		return nullptr;
@@ -433,6 +467,10 @@ void XivAlexander::Apps::MainApp::App::RunOnGameLoop(std::function<void()> f) {
 	m_pGameWindow->RunOnGameLoop(std::move(f));
 }
 
+void XivAlexander::Apps::MainApp::App::PostOnGameLoop(std::function<void()> f) {
+	m_pGameWindow->PostOnGameLoop(std::move(f));
+}
+
 std::string XivAlexander::Apps::MainApp::App::IsUnloadable() const {
 	if (const auto pszDisabledReason = Dll::GetUnloadDisabledReason())
 		return pszDisabledReason;
@@ -51,6 +51,8 @@ namespace XivAlexander::Apps::MainApp {
 		[[nodiscard]] bool IsGameWindowFocused() const;
 
 		void RunOnGameLoop(std::function<void()> f);
+		// Queues f to run on the game thread, without waiting for it. Dropped once unloading has begun.
+		void PostOnGameLoop(std::function<void()> f);
 		[[nodiscard]] std::string IsUnloadable() const;
 
 		[[nodiscard]] Internal::SocketHook& GetSocketHook();
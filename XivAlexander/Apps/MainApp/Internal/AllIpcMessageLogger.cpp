@@ -19,66 +19,62 @@ struct XivAlexander::Apps::MainApp::Internal::AllIpcMessageLogger::Implementatio
 			: Impl(impl)
 			, Conn(conn) {
 
-			conn.AddIncomingFFXIVMessageHandler(this, [&](auto pMessage) {
-				if (pMessage->Type == MessageType::Ipc && pMessage->Data.Ipc.Type == IpcType::InterestedType) {
-					const char* pszPossibleMessageType;
-					switch (pMessage->Length) {
-						case 0x09c:
-							pszPossibleMessageType = "ActionEffect01";
-							break;
-						case 0x29c:
-							pszPossibleMessageType = "ActionEffect08";
-							break;
-						case 0x4dc:
-							pszPossibleMessageType = "ActionEffect16";
-							break;
-						case 0x71c:
-							pszPossibleMessageType = "ActionEffect24";
-							break;
-						case 0x95c:
-							pszPossibleMessageType = "ActionEffect32";
-							break;
-						case (sizeof(XivMessageHeader) + sizeof(XivIpcHeader) + sizeof(XivIpcs::S2C_ActorControlSelf)):
-							pszPossibleMessageType = "ActorControlSelf";
-							break;
-						case (sizeof(XivMessageHeader) + sizeof(XivIpcHeader) + sizeof(XivIpcs::S2C_ActorCast)):
-							pszPossibleMessageType = "ActorCast";
-							break;
-						case (sizeof(XivMessageHeader) + sizeof(XivIpcHeader) + sizeof(XivIpcs::S2C_ActorControl)):
-							pszPossibleMessageType = "ActorControl";
-							break;
-						default:
-							pszPossibleMessageType = nullptr;
-					}
-					Impl.Logger->Format(LogCategory::AllIpcMessageLogger, "source={:08x} current={:08x} subtype={:04x} length={:x} (S2C{}{})\n{}",
-						pMessage->SourceActor, pMessage->CurrentActor,
-						pMessage->Data.Ipc.SubType, pMessage->Length,
-						pszPossibleMessageType ? ": Possibly " : "",
-						pszPossibleMessageType ? pszPossibleMessageType : "",
-						pMessage->Represent(true));
+			conn.AddIncomingFFXIVMessageHandler(this, { .Type = IpcType::InterestedType }, [&](auto pMessage) {
+				const char* pszPossibleMessageType;
+				switch (pMessage->Length) {
+					case 0x09c:
+						pszPossibleMessageType = "ActionEffect01";
+						break;
+					case 0x29c:
+						pszPossibleMessageType = "ActionEffect08";
+						break;
+					case 0x4dc:
+						pszPossibleMessageType = "ActionEffect16";
+						break;
+					case 0x71c:
+						pszPossibleMessageType = "ActionEffect24";
+						break;
+					case 0x95c:
+						pszPossibleMessageType = "ActionEffect32";
+						break;
+					case (sizeof(XivMessageHeader) + sizeof(XivIpcHeader) + sizeof(XivIpcs::S2C_ActorControlSelf)):
+						pszPossibleMessageType = "ActorControlSelf";
+						break;
+					case (sizeof(XivMessageHeader) + sizeof(XivIpcHeader) + sizeof(XivIpcs::S2C_ActorCast)):
+						pszPossibleMessageType = "ActorCast";
+						break;
+					case (sizeof(XivMessageHeader) + sizeof(XivIpcHeader) + sizeof(XivIpcs::S2C_ActorControl)):
+						pszPossibleMessageType = "ActorControl";
+						break;
+					default:
+						pszPossibleMessageType = nullptr;
 				}
+				Impl.Logger->Format(LogCategory::AllIpcMessageLogger, "source={:08x} current={:08x} subtype={:04x} length={:x} (S2C{}{})\n{}",
+					pMessage->SourceActor, pMessage->CurrentActor,
+					pMessage->Data.Ipc.SubType, pMessage->Length,
+					pszPossibleMessageType ? ": Possibly " : "",
+					pszPossibleMessageType ? pszPossibleMessageType : "",
+					pMessage->Represent(true));
 				return true;
 				});
-			conn.AddOutgoingFFXIVMessageHandler(this, [&](auto pMessage) {
-				if (pMessage->Type == MessageType::Ipc && pMessage->Data.Ipc.Type == IpcType::InterestedType) {
-					const char* pszPossibleMessageType;
-					switch (pMessage->Length) {
-						case 0x038:
-							pszPossibleMessageType = "PositionUpdate";
-							break;
-						case 0x040:
-							pszPossibleMessageType = "ActionRequest, C2S_ActionRequestGroundTargeted, InteractTarget";
-							break;
-						default:
-							pszPossibleMessageType = nullptr;
-					}
-					Impl.Logger->Format(LogCategory::AllIpcMessageLogger, "source={:08x} current={:08x} subtype={:04x} length={:x} (C2S{}{})\n{}",
-						pMessage->SourceActor, pMessage->CurrentActor,
-						pMessage->Data.Ipc.SubType, pMessage->Length,
-						pszPossibleMessageType ? ": Possibly " : "",
-						pszPossibleMessageType ? pszPossibleMessageType : "",
-						pMessage->Represent(true));
+			conn.AddOutgoingFFXIVMessageHandler(this, { .Type = IpcType::InterestedType }, [&](auto pMessage) {
+				const char* pszPossibleMessageType;
+				switch (pMessage->Length) {
+					case 0x038:
+						pszPossibleMessageType = "PositionUpdate";
+						break;
+					case 0x040:
+						pszPossibleMessageType = "ActionRequest, C2S_ActionRequestGroundTargeted, InteractTarget";
+						break;
+					default:
+						pszPossibleMessageType = nullptr;
 				}
+				Impl.Logger->Format(LogCategory::AllIpcMessageLogger, "source={:08x} current={:08x} subtype={:04x} length={:x} (C2S{}{})\n{}",
+					pMessage->SourceActor, pMessage->CurrentActor,
+					pMessage->Data.Ipc.SubType, pMessage->Length,
+					pszPossibleMessageType ? ": Possibly " : "",
+					pszPossibleMessageType ? pszPossibleMessageType : "",
+					pMessage->Represent(true));
 				return true;
 				});
 		}
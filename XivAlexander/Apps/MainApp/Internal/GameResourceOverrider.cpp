@@ -133,7 +133,7 @@ struct XivAlexander::Apps::MainApp::Internal::GameResourceOverrider::Implementat
 			_Out_opt_ LPDWORD lpNumberOfBytesRead,
 			_Inout_opt_ LPOVERLAPPED lpOverlapped
 			) {
-				if (const auto pvpath = Sqpacks ? Sqpacks->Get(hFile) : nullptr) {
+				if (const auto pvpath = Sqpacks ? Sqpacks->Get(hFile) : VirtualSqPacks::OverlayedHandleLease()) {
 					auto& vpath = *pvpath;
 					try {
 						Sqpacks->MarkIoRequest();
@@ -185,7 +185,7 @@ struct XivAlexander::Apps::MainApp::Internal::GameResourceOverrider::Implementat
 			_In_ LARGE_INTEGER liDistanceToMove,
 			_Out_opt_ PLARGE_INTEGER lpNewFilePointer,
 			_In_ DWORD dwMoveMethod) {
-				if (const auto pvpath = Sqpacks ? Sqpacks->Get(hFile) : nullptr) {
+				if (const auto pvpath = Sqpacks ? Sqpacks->Get(hFile) : VirtualSqPacks::OverlayedHandleLease()) {
 					if (lpNewFilePointer)
 						*lpNewFilePointer = {};
 
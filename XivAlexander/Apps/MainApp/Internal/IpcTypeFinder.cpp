@@ -19,129 +19,114 @@ struct XivAlexander::Apps::MainApp::Internal::IpcTypeFinder::Implementation {
 			: Impl(pImpl)
 			, Conn(conn) {
 
-			conn.AddIncomingFFXIVMessageHandler(this, [&](auto pMessage) {
-				if (pMessage->Type == MessageType::Ipc && pMessage->Data.Ipc.Type == IpcType::InterestedType) {
-					if (pMessage->CurrentActor == pMessage->SourceActor) {
-						if (pMessage->Length == 0x9c ||
-							pMessage->Length == 0x29c ||
-							pMessage->Length == 0x4dc ||
-							pMessage->Length == 0x71c ||
-							pMessage->Length == 0x95c) {
-							// Test ActionEffect
-
-							int expectedCount = 0;
-							if (pMessage->Length == 0x9c)
-								expectedCount = 1;
-							else if (pMessage->Length == 0x29c)
-								expectedCount = 8;
-							else if (pMessage->Length == 0x4dc)
-								expectedCount = 16;
-							else if (pMessage->Length == 0x71c)
-								expectedCount = 24;
-							else if (pMessage->Length == 0x95c)
-								expectedCount = 32;
-
-							const auto& actionEffect = pMessage->Data.Ipc.Data.S2C_ActionEffect;
-
-							Impl.Logger->Format(
-								LogCategory::IpcTypeFinder,
-								"{:x}: S2C_ActionEffect{:02}(0x{:04x}) length={:x} actionId={:04x} sequence={:04x} wait={:.3f}\n{}",
-								conn.Socket(),
-								expectedCount,
-								pMessage->Data.Ipc.SubType,
-								pMessage->Length,
-								actionEffect.ActionId,
-								actionEffect.SourceSequence,
-								actionEffect.AnimationLockDurationF,
-								pMessage->Represent(true));
-
-						} else if (pMessage->Length == sizeof(XivMessageHeader) + sizeof(XivIpcHeader) + sizeof(XivIpcs::S2C_ActorControlSelf)) {
-							const auto& actorControlSelf = pMessage->Data.Ipc.Data.S2C_ActorControlSelf;
-							if (actorControlSelf.Category == S2C_ActorControlSelfCategory::Cooldown) {
-								const auto& cooldown = actorControlSelf.Cooldown;
-								Impl.Logger->Format(
-									LogCategory::IpcTypeFinder,
-									"{:x}: S2C_ActorControlSelf(0x{:04x}): Cooldown: actionId={:04x} duration={:.02f}s\n{}",
-									conn.Socket(),
-									pMessage->Data.Ipc.SubType,
-									cooldown.ActionId,
-									cooldown.DurationF(),
-									pMessage->Represent(true));
-
-							} else if (pMessage->Data.Ipc.Data.S2C_ActorControlSelf.Category == S2C_ActorControlSelfCategory::ActionRejected) {
-								const auto& rollback = actorControlSelf.Rollback;
-								Impl.Logger->Format(
-									LogCategory::IpcTypeFinder,
-									"{:x}: S2C_ActorControlSelf(0x{:04x}): Rollback: actionId={:04x} sourceSequence={:04x}\n{}",
-									conn.Socket(),
-									pMessage->Data.Ipc.SubType,
-									rollback.ActionId,
-									rollback.SourceSequence,
-									pMessage->Represent(true));
-							}
-
-						} else if (pMessage->Length == sizeof(XivMessageHeader) + sizeof(XivIpcHeader) + sizeof(XivIpcs::S2C_ActorCast)) {
-							Impl.Logger->Format(
-								LogCategory::IpcTypeFinder,
-								"{:x}: S2C_ActorCast(0x{:04x}): actionId={:04x} time={:.3f} target={:08x}\n{}",
-								conn.Socket(),
-								pMessage->Data.Ipc.SubType,
-								pMessage->Data.Ipc.Data.S2C_ActorCast.ActionId,
-								pMessage->Data.Ipc.Data.S2C_ActorCast.CastTimeF,
-								pMessage->Data.Ipc.Data.S2C_ActorCast.TargetId,
-								pMessage->Represent(true));
-
-						} else if (pMessage->Length == 0x38) {
-							// Test ActorControl
-							const auto& actorControl = pMessage->Data.Ipc.Data.S2C_ActorControl;
-							if (actorControl.Category == S2C_ActorControlCategory::CancelCast) {
-								const auto& cancelCast = actorControl.CancelCast;
-								Impl.Logger->Format(
-									LogCategory::IpcTypeFinder,
-									"{:x}: S2C_ActorControl(0x{:04x}): CancelCast: actionId={:04x}\n{}",
-									conn.Socket(),
-									pMessage->Data.Ipc.SubType,
-									cancelCast.ActionId,
-									pMessage->Represent(true));
-							}
-						}
-					}
-				}
-				return true;
-			});
-			conn.AddOutgoingFFXIVMessageHandler(this, [&](auto pMessage) {
-				if (pMessage->Type == MessageType::Ipc && pMessage->Data.Ipc.Type == IpcType::InterestedType) {
-					if (pMessage->Length == sizeof(Sqex::Network::Structure::XivIpcs::C2S_ActionRequest)) {
-						// Test ActionRequest
-						const auto& actionRequest = pMessage->Data.Ipc.Data.C2S_ActionRequest;
-						Impl.Logger->Format(
-							LogCategory::IpcTypeFinder,
-							"{:x}: C2S_ActionRequest(0x{:04x}): actionId={:04x} sequence={:04x}\n{}",
-							conn.Socket(),
-							pMessage->Data.Ipc.SubType,
-							actionRequest.ActionId, actionRequest.Sequence,
-							pMessage->Represent(true));
-					}
-
-					if (pMessage->Length == sizeof(Sqex::Network::Structure::XivIpcs::C2S_ActionRequestGroundTargeted)) {
-						// Test ActionRequest
-						const auto& actionRequest = pMessage->Data.Ipc.Data.C2S_ActionRequest;
-						Impl.Logger->Format(
-							LogCategory::IpcTypeFinder,
-							"{:x}: C2S_ActionRequestGroundTargeted(0x{:04x}): actionId={:04x} sequence={:04x}\n{}",
-							conn.Socket(),
-							pMessage->Data.Ipc.SubType,
-							actionRequest.ActionId, actionRequest.Sequence,
-							pMessage->Represent(true));
-					}
-				}
-				return true;
-			});
+			// If lengths are shared, the first one listed here handles it.
+			std::map<uint32_t, SingleConnection::MessageMangler> incoming;
+			for (const auto [length, expectedCount] : { std::pair<uint32_t, int>{ 0x9c, 1 }, { 0x29c, 8 }, { 0x4dc, 16 }, { 0x71c, 24 }, { 0x95c, 32 } })
+				incoming.emplace(length, [this, expectedCount = expectedCount](auto pMessage) { return OnActionEffect(pMessage, expectedCount); });
+			incoming.emplace(static_cast<uint32_t>(sizeof(XivMessageHeader) + sizeof(XivIpcHeader) + sizeof(XivIpcs::S2C_ActorControlSelf)), [this](auto pMessage) { return OnActorControlSelf(pMessage); });
+			incoming.emplace(static_cast<uint32_t>(sizeof(XivMessageHeader) + sizeof(XivIpcHeader) + sizeof(XivIpcs::S2C_ActorCast)), [this](auto pMessage) { return OnActorCast(pMessage); });
+			incoming.emplace(0x38, [this](auto pMessage) { return OnActorControl(pMessage); });
+			// Only interested in incoming messages intended for the current player.
+			for (auto& [length, handler] : incoming)
+				conn.AddIncomingFFXIVMessageHandler(this, { .Length = length, .CurrentActorOnly = true }, std::move(handler));
+
+			conn.AddOutgoingFFXIVMessageHandler(this, { .Length = static_cast<uint32_t>(sizeof(XivIpcs::C2S_ActionRequest)) }, [this](auto pMessage) { return OnActionRequest(pMessage, "C2S_ActionRequest"); });
+			conn.AddOutgoingFFXIVMessageHandler(this, { .Length = static_cast<uint32_t>(sizeof(XivIpcs::C2S_ActionRequestGroundTargeted)) }, [this](auto pMessage) { return OnActionRequest(pMessage, "C2S_ActionRequestGroundTargeted"); });
 		}
 
 		~SingleConnectionHandler() {
 			Conn.RemoveMessageHandlers(this);
 		}
+
+		bool OnActionEffect(XivMessage* pMessage, int expectedCount) {
+			const auto& actionEffect = pMessage->Data.Ipc.Data.S2C_ActionEffect;
+
+			Impl.Logger->Format(
+				LogCategory::IpcTypeFinder,
+				"{:x}: S2C_ActionEffect{:02}(0x{:04x}) length={:x} actionId={:04x} sequence={:04x} wait={:.3f}\n{}",
+				Conn.Socket(),
+				expectedCount,
+				pMessage->Data.Ipc.SubType,
+				pMessage->Length,
+				actionEffect.ActionId,
+				actionEffect.SourceSequence,
+				actionEffect.AnimationLockDurationF,
+				pMessage->Represent(true));
+
+			return true;
+		}
+
+		bool OnActorControlSelf(XivMessage* pMessage) {
+			const auto& actorControlSelf = pMessage->Data.Ipc.Data.S2C_ActorControlSelf;
+			if (actorControlSelf.Category == S2C_ActorControlSelfCategory::Cooldown) {
+				const auto& cooldown = actorControlSelf.Cooldown;
+				Impl.Logger->Format(
+					LogCategory::IpcTypeFinder,
+					"{:x}: S2C_ActorControlSelf(0x{:04x}): Cooldown: actionId={:04x} duration={:.02f}s\n{}",
+					Conn.Socket(),
+					pMessage->Data.Ipc.SubType,
+					cooldown.ActionId,
+					cooldown.DurationF(),
+					pMessage->Represent(true));
+
+			} else if (pMessage->Data.Ipc.Data.S2C_ActorControlSelf.Category == S2C_ActorControlSelfCategory::ActionRejected) {
+				const auto& rollback = actorControlSelf.Rollback;
+				Impl.Logger->Format(
+					LogCategory::IpcTypeFinder,
+					"{:x}: S2C_ActorControlSelf(0x{:04x}): Rollback: actionId={:04x} sourceSequence={:04x}\n{}",
+					Conn.Socket(),
+					pMessage->Data.Ipc.SubType,
+					rollback.ActionId,
+					rollback.SourceSequence,
+					pMessage->Represent(true));
+			}
+
+			return true;
+		}
+
+		bool OnActorCast(XivMessage* pMessage) {
+			Impl.Logger->Format(
+				LogCategory::IpcTypeFinder,
+				"{:x}: S2C_ActorCast(0x{:04x}): actionId={:04x} time={:.3f} target={:08x}\n{}",
+				Conn.Socket(),
+				pMessage->Data.Ipc.SubType,
+				pMessage->Data.Ipc.Data.S2C_ActorCast.ActionId,
+				pMessage->Data.Ipc.Data.S2C_ActorCast.CastTimeF,
+				pMessage->Data.Ipc.Data.S2C_ActorCast.TargetId,
+				pMessage->Represent(true));
+
+			return true;
+		}
+
+		bool OnActorControl(XivMessage* pMessage) {
+			const auto& actorControl = pMessage->Data.Ipc.Data.S2C_ActorControl;
+			if (actorControl.Category == S2C_ActorControlCategory::CancelCast) {
+				const auto& cancelCast = actorControl.CancelCast;
+				Impl.Logger->Format(
+					LogCategory::IpcTypeFinder,
+					"{:x}: S2C_ActorControl(0x{:04x}): CancelCast: actionId={:04x}\n{}",
+					Conn.Socket(),
+					pMessage->Data.Ipc.SubType,
+					cancelCast.ActionId,
+					pMessage->Represent(true));
+			}
+
+			return true;
+		}
+
+		bool OnActionRequest(XivMessage* pMessage, const char* name) {
+			const auto& actionRequest = pMessage->Data.Ipc.Data.C2S_ActionRequest;
+			Impl.Logger->Format(
+				LogCategory::IpcTypeFinder,
+				"{:x}: {}(0x{:04x}): actionId={:04x} sequence={:04x}\n{}",
+				Conn.Socket(),
+				name,
+				pMessage->Data.Ipc.SubType,
+				actionRequest.ActionId, actionRequest.Sequence,
+				pMessage->Represent(true));
+
+			return true;
+		}
 	};
 
 	const std::shared_ptr<Misc::Logger> Logger;
@@ -1,6 +1,7 @@
 ﻿#include "pch.h"
 
 #include <XivAlexanderCommon/Utils/CallOnDestruction.h>
+#include <XivAlexanderCommon/Utils/FramePacing.h>
 #include <XivAlexanderCommon/Utils/Signatures.h>
 
 #include "Config.h"
@@ -33,6 +34,18 @@ struct XivAlexander::Apps::MainApp::Internal::MainThreadTimingHandler::Implement
 	int64_t LastLockedFramerateRenderIntervalUs{};
 	int64_t LastLockedFramerateRenderDriftUs{};
 	Utils::Win32::Handle HighResTimer{};
+	Utils::FramePacing::HybridWaiter FrameWaiter{
+		[]() { return Utils::QpcUs(); },
+		[this](int64_t us) {
+			if (HighResTimer) {
+				// 100-nanosecond intervals, negative for relative time
+				const auto li = LARGE_INTEGER{ .QuadPart = us * -10 };
+				SetWaitableTimer(HighResTimer, &li, 0, nullptr, nullptr, FALSE);
+				WaitForSingleObject(HighResTimer, INFINITE);
+			} else
+				::Sleep(static_cast<DWORD>(us / 1000));
+		},
+	};
 
 	Implementation(Apps::MainApp::App& app)
 		: App(app)
@@ -125,20 +138,8 @@ struct XivAlexander::Apps::MainApp::Internal::MainThreadTimingHandler::Implement
 						rt.LockFramerateMaximumRenderIntervalDeviation
 					));
 					if (frameInterval && LastLockedFramerateRenderIntervalUs && LastLockedFramerateRenderIntervalUs != frameInterval) {
-						const auto prevRenderTimestamp = nowUs / LastLockedFramerateRenderIntervalUs * LastLockedFramerateRenderIntervalUs + LastLockedFramerateRenderDriftUs + frameInterval;
-						int64_t minDiff = UINT64_MAX;
-						int64_t minDriftUs = 0;
-						for (int64_t i = 0; i < frameInterval; ++i) {
-							const auto nextRenderTimestamp = static_cast<int64_t>((1 + (nowUs - i) / frameInterval) * frameInterval + i);
-							if (nextRenderTimestamp < prevRenderTimestamp)
-								continue;
-							const auto diff = nextRenderTimestamp - prevRenderTimestamp;
-							if (diff < minDiff) {
-								minDiff = diff;
-								minDriftUs = i;
-							}
-						}
-						LastLockedFramerateRenderDriftUs = minDriftUs;
+						LastLockedFramerateRenderDriftUs = Utils::FramePacing::CalculateRenderDriftUs(
+							nowUs, LastLockedFramerateRenderIntervalUs, LastLockedFramerateRenderDriftUs, frameInterval);
 					}
 					waitForUs = LastLockedFramerateRenderIntervalUs = frameInterval;
 					waitForDrift = LastLockedFramerateRenderDriftUs;
@@ -169,15 +170,8 @@ struct XivAlexander::Apps::MainApp::Internal::MainThreadTimingHandler::Implement
 			if (useMoreCpuTime) {
 				while (waitUntilCounterUs > Utils::QpcUs())
 					(void)0;
-			} else {
-				const auto remainingUs = waitUntilCounterUs - Utils::QpcUs();
-				if (remainingUs > 0) {
-					// 100-nanosecond intervals, negative for relative time
-					const auto li = LARGE_INTEGER{.QuadPart = remainingUs * -10 };
-					SetWaitableTimer(HighResTimer, &li, 0, nullptr, nullptr, FALSE);
-					WaitForSingleObject(HighResTimer, INFINITE);
-				}
-			}
+			} else
+				FrameWaiter.WaitUntil(waitUntilCounterUs);
 			LastMessagePumpCounterUs.push_back(Utils::QpcUs());
 		} else {
 			LastMessagePumpCounterUs.push_back(nowUs);
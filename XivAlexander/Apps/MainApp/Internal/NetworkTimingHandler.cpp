@@ -12,385 +12,306 @@
 
 using namespace Sqex::Network::Structure;
 
-struct XivAlexander::Apps::MainApp::Internal::NetworkTimingHandler::Implementation {
-	static constexpr int64_t AutoAttackDelayUs = 100000;
+static_assert(static_cast<int>(XivAlexander::HighLatencyMitigationMode::SubtractLatency) == static_cast<int>(Utils::AnimationLock::MitigationMode::SubtractLatency));
+static_assert(static_cast<int>(XivAlexander::HighLatencyMitigationMode::SimulateRtt) == static_cast<int>(Utils::AnimationLock::MitigationMode::SimulateRtt));
+static_assert(static_cast<int>(XivAlexander::HighLatencyMitigationMode::SimulateNormalizedRttAndLatency) == static_cast<int>(Utils::AnimationLock::MitigationMode::SimulateNormalizedRttAndLatency));
 
+struct XivAlexander::Apps::MainApp::Internal::NetworkTimingHandler::Implementation {
 	static constexpr auto SecondToMicrosecondMultiplier = 1000000;
 
 	std::map<uint32_t, CooldownGroup> LastCooldownGroup;
 
+	// Outlives Implementation, so that opcode change callbacks that are still running, or queued to the game thread, can tell it is gone.
+	struct SharedState {
+		std::mutex Mtx;
+		Implementation* Impl = nullptr;
+	};
+
 	class SingleConnectionHandler {
 		const std::shared_ptr<Config> Config;
 		Implementation& Impl;
 		SingleConnection& Conn;
 
-		struct PendingAction {
-			uint32_t ActionId{};
-			uint32_t Sequence{};
-			int64_t RequestUs{};
-			int64_t ResponseUs{};
-			int64_t OriginalWaitUs{};
-			int64_t WaitTimeUs{};
-			int64_t CastTimeUs{};
-		};
-
 	public:
-		// The game will allow the user to use an action, if server does not respond in 500ms since last action usage.
-		// This will result in cancellation of following actions, so to prevent this, we keep track of outgoing action
-		// request timestamps, and stack up required animation lock time responses from server.
-		// The game will only process the latest animation lock duration information.
-		std::deque<PendingAction> PendingActions;
-		std::optional<PendingAction> LatestSuccessfulRequest;
-		std::optional<int64_t> LastAnimationLockEndsAtUs;
+		const uint64_t Id;
+		Utils::AnimationLock::Tracker LockTracker;
 		std::map<int, int64_t> OriginalWaitUsMap;
+		Utils::CallOnDestruction::Multiple Cleanup;
 
-		SingleConnectionHandler(Implementation* pImpl, SingleConnection& conn)
+		SingleConnectionHandler(Implementation* pImpl, SingleConnection& conn, uint64_t id)
 			: Config(Config::Acquire())
 			, Impl(*pImpl)
-			, Conn(conn) {
+			, Conn(conn)
+			, Id(id) {
+
+			Impl.LastCooldownGroup.clear();
+
+			// Callbacks may still be running after this handler is gone, so they must not touch it.
+			const auto onOpcodeChange = [state = Impl.State, pConn = &Conn, id]() { QueueRegisterHandlers(state, pConn, id); };
+			auto& gameConfig = Config->Game;
+			for (auto& item : gameConfig.C2S_ActionRequest)
+				Cleanup += item.OnChange(onOpcodeChange);
+			for (auto& item : gameConfig.S2C_ActionEffects)
+				Cleanup += item.OnChange(onOpcodeChange);
+			Cleanup += gameConfig.S2C_ActorControlSelf.OnChange(onOpcodeChange);
+			Cleanup += gameConfig.S2C_ActorControl.OnChange(onOpcodeChange);
+			Cleanup += gameConfig.S2C_ActorCast.OnChange(onOpcodeChange);
+			RegisterHandlers();
+		}
 
+		~SingleConnectionHandler() {
+			Conn.RemoveMessageHandlers(this);
+		}
+
+		// Opcodes may change from the main window or from a configuration reload, but handlers are only dispatched on the game thread,
+		// so the dispatch tables have to be rebuilt there; by then the handler may have gone with its connection.
+		static void QueueRegisterHandlers(const std::shared_ptr<SharedState>& state, SingleConnection* pConn, uint64_t id) {
+			const auto lock = std::lock_guard(state->Mtx);
+			if (!state->Impl)
+				return;
+
+			state->Impl->App.PostOnGameLoop([state, pConn, id]() {
+				const auto lock = std::lock_guard(state->Mtx);
+				if (!state->Impl)
+					return;
+
+				auto& impl = *state->Impl;
+				const auto handlersLock = std::lock_guard(impl.HandlersMutex);
+				if (const auto it = impl.Handlers.find(pConn); it != impl.Handlers.end() && it->second->Id == id)
+					it->second->RegisterHandlers();
+			});
+		}
+
+		void RegisterHandlers() {
+			Conn.RemoveMessageHandlers(this);
+
+			// If opcodes are shared, the first one listed here handles it.
 			const auto& gameConfig = Config->Game;
+			std::map<uint16_t, bool(SingleConnectionHandler::*)(XivMessage*)> outgoing, incoming;
+			for (const auto& item : gameConfig.C2S_ActionRequest)
+				outgoing.emplace(item.Value(), &SingleConnectionHandler::OnActionRequest);
+			for (const auto& item : gameConfig.S2C_ActionEffects)
+				incoming.emplace(item.Value(), &SingleConnectionHandler::OnActionEffect);
+			incoming.emplace(gameConfig.S2C_ActorControlSelf.Value(), &SingleConnectionHandler::OnActorControlSelf);
+			incoming.emplace(gameConfig.S2C_ActorControl.Value(), &SingleConnectionHandler::OnActorControl);
+			incoming.emplace(gameConfig.S2C_ActorCast.Value(), &SingleConnectionHandler::OnActorCast);
+
+			for (const auto& [subType, handler] : outgoing)
+				Conn.AddOutgoingFFXIVMessageHandler(this, { .SubType = subType }, [this, handler = handler](auto pMessage) { return (this->*handler)(pMessage); });
+			// Only interested in incoming messages intended for the current player.
+			for (const auto& [subType, handler] : incoming)
+				Conn.AddIncomingFFXIVMessageHandler(this, { .SubType = subType, .CurrentActorOnly = true }, [this, handler = handler](auto pMessage) { return (this->*handler)(pMessage); });
+			Conn.AddIncomingFFXIVMessageHandler(this, { .Type = IpcType::CustomType }, [this](auto pMessage) { return OnCustomIpc(pMessage); });
+		}
+
+		void OnActionRequestIgnored(const Utils::AnimationLock::Tracker::PendingAction& item) const {
+			Impl.Logger->Format(
+				LogCategory::NetworkTimingHandler,
+				u8"\t┎ ActionRequest ignored for processing: actionId={:04x} sequence={:04x}",
+				item.ActionId, item.Sequence);
+		}
+
+		bool OnCustomIpc(XivMessage* pMessage) {
+			if (pMessage->Data.Ipc.SubType == static_cast<uint16_t>(IpcCustomSubtype::OriginalWaitTime)) {
+				const auto& data = pMessage->Data.Ipc.Data.S2C_Custom_OriginalWaitTime;
+				OriginalWaitUsMap[data.SourceSequence] = static_cast<uint64_t>(static_cast<double>(data.OriginalWaitTime) * SecondToMicrosecondMultiplier);
+			}
+
+			// Don't relay custom Ipc data to game.
+			return false;
+		}
+
+		bool OnActionRequest(XivMessage* pMessage) {
 			const auto& runtimeConfig = Config->Runtime;
+			const auto& actionRequest = pMessage->Data.Ipc.Data.C2S_ActionRequest;
+			Impl.CallOnActionRequestListener(actionRequest);
+			const auto nowUs = Utils::QpcUs();
+			const auto delayUs = LockTracker.LastAnimationLockEndsAtUs ? nowUs - *LockTracker.LastAnimationLockEndsAtUs : INT64_MAX;
+			LockTracker.OnActionRequest(actionRequest.ActionId, actionRequest.Sequence, nowUs);
+
+			if (runtimeConfig.UseHighLatencyMitigationLogging) {
+				const auto& latestSuccessfulRequest = LockTracker.LatestSuccessfulRequest;
+				const auto prevRelativeUs = latestSuccessfulRequest ? nowUs - latestSuccessfulRequest->RequestUs : INT64_MAX;
+
+				Impl.Logger->Format(
+					LogCategory::NetworkTimingHandler,
+					"{:x}: C2S_ActionRequest({:04x}): actionId={:04x} sequence={:04x}{}{}",
+					Conn.Socket(),
+					pMessage->Data.Ipc.SubType,
+					actionRequest.ActionId,
+					actionRequest.Sequence,
+					delayUs > 10 * SecondToMicrosecondMultiplier ? "" : std::format(" delay={}s", static_cast<double>(delayUs) / SecondToMicrosecondMultiplier),
+					prevRelativeUs > 10 * SecondToMicrosecondMultiplier ? "" : std::format(" prevRelative={}s", static_cast<double>(prevRelativeUs) / SecondToMicrosecondMultiplier));
+			}
 
-			Impl.LastCooldownGroup.clear();
+			// Refresh socket latency here, so that the response can be handled without a syscall.
+			void(Conn.FetchSocketLatencyUs());
 
-			conn.AddOutgoingFFXIVMessageHandler(this, [&](auto pMessage) {
-				if (pMessage->Type == MessageType::Ipc && pMessage->Data.Ipc.Type == IpcType::InterestedType) {
-					if (pMessage->Data.Ipc.SubType == gameConfig.C2S_ActionRequest[0]
-						|| pMessage->Data.Ipc.SubType == gameConfig.C2S_ActionRequest[1]) {
-						const auto& actionRequest = pMessage->Data.Ipc.Data.C2S_ActionRequest;
-						Impl.CallOnActionRequestListener(actionRequest);
-						PendingActions.emplace_back(PendingAction{
-							.ActionId = actionRequest.ActionId,
-							.Sequence = actionRequest.Sequence,
-							.RequestUs = Utils::QpcUs(),
-							});
-
-						if (runtimeConfig.UseHighLatencyMitigationLogging) {
-							const auto delayUs = LastAnimationLockEndsAtUs ? PendingActions.back().RequestUs - *LastAnimationLockEndsAtUs : INT64_MAX;
-							const auto prevRelativeUs = LatestSuccessfulRequest ? PendingActions.back().RequestUs - LatestSuccessfulRequest->RequestUs : INT64_MAX;
-
-							Impl.Logger->Format(
-								LogCategory::NetworkTimingHandler,
-								"{:x}: C2S_ActionRequest({:04x}): actionId={:04x} sequence={:04x}{}{}",
-								conn.Socket(),
-								pMessage->Data.Ipc.SubType,
-								actionRequest.ActionId,
-								actionRequest.Sequence,
-								delayUs > 10 * SecondToMicrosecondMultiplier ? "" : std::format(" delay={}s", static_cast<double>(delayUs) / SecondToMicrosecondMultiplier),
-								prevRelativeUs > 10 * SecondToMicrosecondMultiplier ? "" : std::format(" prevRelative={}s", static_cast<double>(prevRelativeUs) / SecondToMicrosecondMultiplier));
-						}
+			return true;
+		}
 
-						// If there was no action queued to begin with before the current one, update the base lock time to now.
-						if (PendingActions.size() == 1 && (!PendingActions.back().RequestUs || (!LastAnimationLockEndsAtUs || *LastAnimationLockEndsAtUs < PendingActions.back().RequestUs)))
-							LastAnimationLockEndsAtUs = PendingActions.back().RequestUs;
-					}
+		bool OnActionEffect(XivMessage* pMessage) {
+			const auto nowUs = Utils::QpcUs();
+			const auto& runtimeConfig = Config->Runtime;
+
+			// actionEffect has to be modified later on, so no const
+			auto& actionEffect = pMessage->Data.Ipc.Data.S2C_ActionEffect;
+			int64_t originalWaitUs;
+			if (const auto it = OriginalWaitUsMap.find(actionEffect.SourceSequence); it == OriginalWaitUsMap.end())
+				originalWaitUs = actionEffect.AnimationLockDurationUs();
+			else {
+				originalWaitUs = it->second;
+				OriginalWaitUsMap.erase(it);
+			}
+
+			const auto result = LockTracker.OnActionEffect(
+				actionEffect.ActionId, actionEffect.SourceSequence, originalWaitUs, nowUs,
+				runtimeConfig.UseHighLatencyMitigationPreviewMode,
+				[&](int64_t rttUs) {
+					Conn.ApplicationLatencyUs.AddValue(rttUs);
+					return Utils::AnimationLock::Resolve(
+						static_cast<Utils::AnimationLock::MitigationMode>(runtimeConfig.HighLatencyMitigationMode.Value()),
+						Conn.GetLatencySnapshot(),
+						nowUs, originalWaitUs, rttUs,
+						runtimeConfig.ExpectedAnimationLockDurationUs.Value());
+				},
+				[this](const auto& item) { OnActionRequestIgnored(item); });
+			if (result.Shortened && !runtimeConfig.UseHighLatencyMitigationPreviewMode)
+				actionEffect.AnimationLockDurationUs(result.WaitUs);
+
+			const auto& latestSuccessfulRequest = LockTracker.LatestSuccessfulRequest;
+			if (Config->Runtime.SynchronizeProcessing) {
+				if (auto& handler = Impl.App.GetMainThreadTimingHelper()) {
+					handler->GuaranteePumpBeginCounterAt(*LockTracker.LastAnimationLockEndsAtUs + (latestSuccessfulRequest ? latestSuccessfulRequest->CastTimeUs : 0));
 				}
-				return true;
-				});
-			conn.AddIncomingFFXIVMessageHandler(this, [&](auto pMessage) {
-				const auto nowUs = Utils::QpcUs();
-
-				if (pMessage->Type == MessageType::Ipc && pMessage->Data.Ipc.Type == IpcType::CustomType) {
-					if (pMessage->Data.Ipc.SubType == static_cast<uint16_t>(IpcCustomSubtype::OriginalWaitTime)) {
-						const auto& data = pMessage->Data.Ipc.Data.S2C_Custom_OriginalWaitTime;
-						OriginalWaitUsMap[data.SourceSequence] = static_cast<uint64_t>(static_cast<double>(data.OriginalWaitTime) * SecondToMicrosecondMultiplier);
+			}
+
+			if (runtimeConfig.UseHighLatencyMitigationLogging) {
+				auto description = std::format("{:x}: S2C_ActionEffect({:04x}): actionId={:04x} sourceSequence={:04x}",
+					Conn.Socket(),
+					pMessage->Data.Ipc.SubType,
+					actionEffect.ActionId,
+					actionEffect.SourceSequence);
+				if (actionEffect.SourceSequence == 0)
+					description += " serverOriginated";
+				if (result.RttUs)
+					description += std::format(" rtt={}us", *result.RttUs);
+				if (const auto& resolution = result.Resolved) {
+					description += std::format(" mode={} latency={}us{}",
+						static_cast<int>(runtimeConfig.HighLatencyMitigationMode.Value()) + 1,
+						resolution->LatencyUs,
+						resolution->LatencyEstimated ? "*" : "");
+					if (resolution->BestLatencyUs != resolution->LatencyUs)
+						description += std::format("->{}us", resolution->BestLatencyUs);
+					description += std::format(" delay={}us", resolution->DelayUs);
+				}
+				if (result.KeepOriginal)
+					description += std::format(" wait={}us", originalWaitUs);
+				else if (result.ResolvedWaitUs < 0)
+					description += std::format(" wait={}us->{}us->{}us (ping/jitter too high)", originalWaitUs, result.ResolvedWaitUs, result.WaitUs);
+				else if (result.ResolvedWaitUs < originalWaitUs)
+					description += std::format(" wait={}us->{}us", originalWaitUs, result.WaitUs);
+				description += std::format(" next={:%H:%M:%S}", std::chrono::system_clock::now() + std::chrono::microseconds(result.WaitUs));
+				Impl.Logger->Log(LogCategory::NetworkTimingHandler, description);
+			}
+
+			return true;
+		}
+
+		bool OnActorControlSelf(XivMessage* pMessage) {
+			const auto& runtimeConfig = Config->Runtime;
+
+			auto& actorControlSelf = pMessage->Data.Ipc.Data.S2C_ActorControlSelf;
+
+			if (actorControlSelf.Category == S2C_ActorControlSelfCategory::Cooldown) {
+				// Received cooldown information; try to make the game accept input and process stuff as soon as cooldown expires
+				const auto& cooldown = actorControlSelf.Cooldown;
+				auto& group = Impl.LastCooldownGroup[cooldown.CooldownGroupId];
+				auto newDriftItem = false;
+				group.Id = cooldown.CooldownGroupId;
+
+				if (const auto& pendingActions = LockTracker.PendingActions; !pendingActions.empty() && pendingActions.front().ActionId == cooldown.ActionId) {
+					if (group.DurationUs != UINT64_MAX && group.TimestampUs && pendingActions.front().RequestUs - group.TimestampUs > 0 && pendingActions.front().RequestUs - group.TimestampUs < group.DurationUs * 2) {
+						group.DriftTrackerUs.AddValue(pendingActions.front().RequestUs - group.TimestampUs - group.DurationUs);
+						newDriftItem = true;
 					}
+					group.TimestampUs = pendingActions.front().RequestUs;
 
-					// Don't relay custom Ipc data to game.
-					return false;
-
-				} else if (pMessage->Type == MessageType::Ipc && pMessage->Data.Ipc.Type == IpcType::InterestedType) {
-					// Only interested in messages intended for the current player
-					if (pMessage->CurrentActor == pMessage->SourceActor) {
-						if (gameConfig.S2C_ActionEffects[0] == pMessage->Data.Ipc.SubType
-							|| gameConfig.S2C_ActionEffects[1] == pMessage->Data.Ipc.SubType
-							|| gameConfig.S2C_ActionEffects[2] == pMessage->Data.Ipc.SubType
-							|| gameConfig.S2C_ActionEffects[3] == pMessage->Data.Ipc.SubType
-							|| gameConfig.S2C_ActionEffects[4] == pMessage->Data.Ipc.SubType) {
-
-							// actionEffect has to be modified later on, so no const
-							auto& actionEffect = pMessage->Data.Ipc.Data.S2C_ActionEffect;
-							int64_t originalWaitUs, waitUs;
-
-							std::stringstream description;
-							description << std::format("{:x}: S2C_ActionEffect({:04x}): actionId={:04x} sourceSequence={:04x}",
-								conn.Socket(),
-								pMessage->Data.Ipc.SubType,
-								actionEffect.ActionId,
-								actionEffect.SourceSequence);
-
-							if (const auto it = OriginalWaitUsMap.find(actionEffect.SourceSequence); it == OriginalWaitUsMap.end())
-								waitUs = originalWaitUs = actionEffect.AnimationLockDurationUs();
-							else {
-								waitUs = originalWaitUs = it->second;
-								OriginalWaitUsMap.erase(it);
-							}
-
-							if (actionEffect.SourceSequence == 0) {
-								// Process actions originating from server.
-								if (LatestSuccessfulRequest && !LatestSuccessfulRequest->CastTimeUs && LatestSuccessfulRequest->Sequence) {
-									LatestSuccessfulRequest->ActionId = actionEffect.ActionId;
-									LatestSuccessfulRequest->Sequence = 0;
-									*LastAnimationLockEndsAtUs += (originalWaitUs + nowUs) - (LatestSuccessfulRequest->OriginalWaitUs + LatestSuccessfulRequest->ResponseUs);
-									LastAnimationLockEndsAtUs = Utils::Clamp(*LastAnimationLockEndsAtUs, nowUs + AutoAttackDelayUs, nowUs + AutoAttackDelayUs + originalWaitUs);
-
-								} else {
-									LastAnimationLockEndsAtUs = nowUs + waitUs;
-								}
-								description << " serverOriginated";
-
-							} else {
-								// find the one sharing Sequence, assuming action responses are always in order
-								while (!PendingActions.empty() && PendingActions.front().Sequence != actionEffect.SourceSequence) {
-									const auto& item = PendingActions.front();
-									Impl.Logger->Format(
-										LogCategory::NetworkTimingHandler,
-										u8"\t┎ ActionRequest ignored for processing: actionId={:04x} sequence={:04x}",
-										item.ActionId, item.Sequence);
-									PendingActions.pop_front();
-								}
-
-								if (!PendingActions.empty()) {
-									LatestSuccessfulRequest = PendingActions.front();
-									LatestSuccessfulRequest->ResponseUs = nowUs;
-									LatestSuccessfulRequest->OriginalWaitUs = originalWaitUs;
-
-									// 100ms animation lock after cast ends stays. Modify animation lock duration for instant actions only.
-									// Since no other action is in progress right before the cast ends, we can safely replace the animation lock with the latest after-cast lock.
-									if (!LatestSuccessfulRequest->CastTimeUs) {
-										const auto rttUs = static_cast<int64_t>(nowUs - LatestSuccessfulRequest->RequestUs);
-										conn.ApplicationLatencyUs.AddValue(rttUs);
-										description << std::format(" rtt={}us", rttUs);
-										LastAnimationLockEndsAtUs = ResolveNextAnimationLockEndUs(*LastAnimationLockEndsAtUs, nowUs, originalWaitUs, rttUs, description);
-
-									} else {
-										LastAnimationLockEndsAtUs = LatestSuccessfulRequest->RequestUs + LatestSuccessfulRequest->CastTimeUs + waitUs;
-									}
-									PendingActions.pop_front();
-
-								} else {
-									LastAnimationLockEndsAtUs = nowUs + waitUs;
-								}
-							}
-
-							waitUs = *LastAnimationLockEndsAtUs - nowUs;
-							if (waitUs == originalWaitUs || (LatestSuccessfulRequest && LatestSuccessfulRequest->CastTimeUs)) {
-								description << std::format(" wait={}us", originalWaitUs);
-							} else if (waitUs < 0) {
-								const auto invalidWaitUs = waitUs;
-								waitUs = 0;
-								description << std::format(" wait={}us->{}us->{}us (ping/jitter too high)", originalWaitUs, invalidWaitUs, waitUs);
-
-								if (!runtimeConfig.UseHighLatencyMitigationPreviewMode) {
-									actionEffect.AnimationLockDurationUs(0);
-									if (LatestSuccessfulRequest)
-										LatestSuccessfulRequest->WaitTimeUs = -LatestSuccessfulRequest->OriginalWaitUs;
-								}
-
-							} else if (waitUs < originalWaitUs) {
-								description << std::format(" wait={}us->{}us", originalWaitUs, waitUs);
-
-								if (!runtimeConfig.UseHighLatencyMitigationPreviewMode) {
-									actionEffect.AnimationLockDurationUs(waitUs);
-									if (LatestSuccessfulRequest)
-										LatestSuccessfulRequest->WaitTimeUs = waitUs - originalWaitUs;
-								}
-
-							}
-							description << std::format(" next={:%H:%M:%S}", std::chrono::system_clock::now() + std::chrono::microseconds(waitUs));
-
-							if (Config->Runtime.SynchronizeProcessing) {
-								if (auto& handler = Impl.App.GetMainThreadTimingHelper()) {
-									handler->GuaranteePumpBeginCounterAt(*LastAnimationLockEndsAtUs + (LatestSuccessfulRequest ? LatestSuccessfulRequest->CastTimeUs : 0));
-								}
-							}
-
-							if (runtimeConfig.UseHighLatencyMitigationLogging)
-								Impl.Logger->Log(LogCategory::NetworkTimingHandler, description.str());
-
-						} else if (pMessage->Data.Ipc.SubType == gameConfig.S2C_ActorControlSelf) {
-							auto& actorControlSelf = pMessage->Data.Ipc.Data.S2C_ActorControlSelf;
-
-							if (actorControlSelf.Category == S2C_ActorControlSelfCategory::Cooldown) {
-								// Received cooldown information; try to make the game accept input and process stuff as soon as cooldown expires
-								const auto& cooldown = actorControlSelf.Cooldown;
-								auto& group = Impl.LastCooldownGroup[cooldown.CooldownGroupId];
-								auto newDriftItem = false;
-								group.Id = cooldown.CooldownGroupId;
-
-								if (!PendingActions.empty() && PendingActions.front().ActionId == cooldown.ActionId) {
-									if (group.DurationUs != UINT64_MAX && group.TimestampUs && PendingActions.front().RequestUs - group.TimestampUs > 0 && PendingActions.front().RequestUs - group.TimestampUs < group.DurationUs * 2) {
-										group.DriftTrackerUs.AddValue(PendingActions.front().RequestUs - group.TimestampUs - group.DurationUs);
-										newDriftItem = true;
-									}
-									group.TimestampUs = PendingActions.front().RequestUs;
-
-									if (Config->Runtime.SynchronizeProcessing) {
-										if (group.Id != CooldownGroup::Id_Gcd || !(Config->Runtime.LockFramerateAutomatic || Config->Runtime.LockFramerateInterval)) {
-											if (auto& handler = Impl.App.GetMainThreadTimingHelper())
-												handler->GuaranteePumpBeginCounterAt(PendingActions.front().RequestUs + cooldown.DurationUs());
-										}
-									}
-
-									if (runtimeConfig.UseHighLatencyMitigationLogging) {
-										Impl.Logger->Format(
-											LogCategory::NetworkTimingHandler,
-											"{:x}: S2C_ActorControlSelf/Cooldown: actionId={:04x} group={:04x} duration={:.02f}s",
-											conn.Socket(),
-											cooldown.ActionId, cooldown.CooldownGroupId,
-											cooldown.DurationF());
-									}
-								}
-
-								group.DurationUs = cooldown.DurationUs();
-								Impl.CallOnCooldownGroupUpdateListener(group.Id, newDriftItem);
-
-							} else if (actorControlSelf.Category == S2C_ActorControlSelfCategory::ActionRejected) {
-								// Oldest action request has been rejected from server.
-								const auto& rollback = actorControlSelf.Rollback;
-
-								// find the one sharing Sequence, assuming action responses are always in order
-								while (!PendingActions.empty()
-									&& (
-										// Sometimes SourceSequence is empty, in which case, we use ActionId to judge.
-										(rollback.SourceSequence != 0 && PendingActions.front().Sequence != rollback.SourceSequence)
-										|| (rollback.SourceSequence == 0 && PendingActions.front().ActionId != rollback.ActionId)
-										)) {
-									const auto& item = PendingActions.front();
-									Impl.Logger->Format(
-										LogCategory::NetworkTimingHandler,
-										u8"\t┎ ActionRequest ignored for processing: actionId={:04x} sequence={:04x}",
-										item.ActionId, item.Sequence);
-									PendingActions.pop_front();
-								}
-
-								if (!PendingActions.empty())
-									PendingActions.pop_front();
-
-								if (runtimeConfig.UseHighLatencyMitigationLogging)
-									Impl.Logger->Format(
-										LogCategory::NetworkTimingHandler,
-										"{:x}: S2C_ActorControlSelf/ActionRejected: actionId={:04x} sourceSequence={:04x}",
-										conn.Socket(),
-										rollback.ActionId,
-										rollback.SourceSequence);
-							}
-
-						} else if (pMessage->Data.Ipc.SubType == gameConfig.S2C_ActorControl) {
-							const auto& actorControl = pMessage->Data.Ipc.Data.S2C_ActorControl;
-
-							// The server has cancelled an oldest action (which is a cast) in progress.
-							if (actorControl.Category == S2C_ActorControlCategory::CancelCast) {
-								const auto& cancelCast = actorControl.CancelCast;
-
-								// find the one sharing Sequence, assuming action responses are always in order
-								while (!PendingActions.empty() && PendingActions.front().ActionId != cancelCast.ActionId) {
-									const auto& item = PendingActions.front();
-									Impl.Logger->Format(
-										LogCategory::NetworkTimingHandler,
-										u8"\t┎ ActionRequest ignored for processing: actionId={:04x} sequence={:04x}",
-										item.ActionId, item.Sequence);
-									PendingActions.pop_front();
-								}
-
-								if (!PendingActions.empty())
-									PendingActions.pop_front();
-
-								if (runtimeConfig.UseHighLatencyMitigationLogging)
-									Impl.Logger->Format(
-										LogCategory::NetworkTimingHandler,
-										"{:x}: S2C_ActorControl/CancelCast: actionId={:04x}",
-										conn.Socket(),
-										cancelCast.ActionId);
-							}
-
-						} else if (pMessage->Data.Ipc.SubType == gameConfig.S2C_ActorCast) {
-							const auto& actorCast = pMessage->Data.Ipc.Data.S2C_ActorCast;
-							// Mark that the last request was a cast.
-							// If it indeed is a cast, the game UI will block the user from generating additional requests,
-							// so first item is guaranteed to be the cast action.
-							if (!PendingActions.empty())
-								PendingActions.front().CastTimeUs = actorCast.CastTimeUs();
-
-							if (runtimeConfig.UseHighLatencyMitigationLogging)
-								Impl.Logger->Format(
-									LogCategory::NetworkTimingHandler,
-									"{:x}: S2C_ActorCast: actionId={:04x} time={:.3f} target={:08x}",
-									conn.Socket(),
-									actorCast.ActionId,
-									actorCast.CastTimeF,
-									actorCast.TargetId);
+					if (Config->Runtime.SynchronizeProcessing) {
+						if (group.Id != CooldownGroup::Id_Gcd || !(Config->Runtime.LockFramerateAutomatic || Config->Runtime.LockFramerateInterval)) {
+							if (auto& handler = Impl.App.GetMainThreadTimingHelper())
+								handler->GuaranteePumpBeginCounterAt(pendingActions.front().RequestUs + cooldown.DurationUs());
 						}
 					}
+
+					if (runtimeConfig.UseHighLatencyMitigationLogging) {
+						Impl.Logger->Format(
+							LogCategory::NetworkTimingHandler,
+							"{:x}: S2C_ActorControlSelf/Cooldown: actionId={:04x} group={:04x} duration={:.02f}s",
+							Conn.Socket(),
+							cooldown.ActionId, cooldown.CooldownGroupId,
+							cooldown.DurationF());
+					}
 				}
-				return true;
-				});
-		}
 
-		~SingleConnectionHandler() {
-			Conn.RemoveMessageHandlers(this);
+				group.DurationUs = cooldown.DurationUs();
+				Impl.CallOnCooldownGroupUpdateListener(group.Id, newDriftItem);
+
+			} else if (actorControlSelf.Category == S2C_ActorControlSelfCategory::ActionRejected) {
+				// Oldest action request has been rejected from server.
+				const auto& rollback = actorControlSelf.Rollback;
+				LockTracker.OnActionRejected(rollback.ActionId, rollback.SourceSequence, [this](const auto& item) { OnActionRequestIgnored(item); });
+
+				if (runtimeConfig.UseHighLatencyMitigationLogging)
+					Impl.Logger->Format(
+						LogCategory::NetworkTimingHandler,
+						"{:x}: S2C_ActorControlSelf/ActionRejected: actionId={:04x} sourceSequence={:04x}",
+						Conn.Socket(),
+						rollback.ActionId,
+						rollback.SourceSequence);
+			}
+
+			return true;
 		}
 
-		int64_t ResolveNextAnimationLockEndUs(const int64_t lastAnimationLockEndsAtUs, const int64_t nowUs, const int64_t originalWaitUs, const int64_t rttUs, std::stringstream& description) {
+		bool OnActorControl(XivMessage* pMessage) {
 			const auto& runtimeConfig = Config->Runtime;
-			const auto mode = runtimeConfig.HighLatencyMitigationMode.Value();
-			description << std::format(" mode={}", static_cast<int>(mode) + 1);
-
-			// Obtain actual connection latency statistics.
-			// Preference for socket latency measurement if available.
-			const auto pingTrackerUs = Conn.GetPingLatencyTrackerUs();
-			const auto socketLatencyUs = (std::max)(Conn.FetchSocketLatencyUs().value_or(INT64_MAX) - 20000, 1LL);  // Socket latency can be any higher value up to 40ms.
-			const auto pingLatencyUs = pingTrackerUs ? pingTrackerUs->Latest() : INT64_MAX;
-			auto latencyUs = socketLatencyUs != INT64_MAX ? socketLatencyUs : pingLatencyUs;
-
-			// Additionally, obtain estimated latency for use as fallback.
-			const auto rttMinUs = Conn.ApplicationLatencyUs.Min();
-			const auto [rttMeanUs, rttDeviationUs] = Conn.ApplicationLatencyUs.MeanAndDeviation();
-			const auto latencyEstimateUs = ((rttMinUs + rttMeanUs) / 2) - ((rttDeviationUs + 25000) / 2);
-
-			// Replace latency with estimated latency under certain circumstances:
-			// - Failed to obtain measurement
-			// - Server RTT measurement is faster than actual latency
-			if (latencyUs == INT64_MAX || rttUs < latencyUs) {
-				latencyUs = latencyEstimateUs;
-				description << std::format(" latency={}us*", latencyUs);
-			} else {
-				description << std::format(" latency={}us", latencyUs);
-			}
 
-			auto delay = 0LL;
-
-			switch (mode) {
-				case HighLatencyMitigationMode::SubtractLatency:
-					delay = (rttUs - latencyUs);
-					break;
-				
-				case HighLatencyMitigationMode::SimulateRtt:
-					delay = Config->Runtime.ExpectedAnimationLockDurationUs.Value();
-					break;
-
-				case HighLatencyMitigationMode::SimulateNormalizedRttAndLatency: {
-					// Server-side focused mode. Attempts to guess the server delay from response time statistics.
-					// Handles fake-ping VPN usage by using estimated latency when necessary.
-					auto bestLatencyUs = std::max(latencyUs, latencyEstimateUs);
-					
-					if(bestLatencyUs != latencyUs) {
-						description << std::format("->{}us", bestLatencyUs);
-					}
+			const auto& actorControl = pMessage->Data.Ipc.Data.S2C_ActorControl;
 
-					// Estimate server delay, using modulus to handle high ping rtt multipliers.
-					delay = bestLatencyUs > 0 ? ((rttUs % bestLatencyUs) + (rttUs - bestLatencyUs)) / 2 : rttUs;
-					break;
-				}
+			// The server has cancelled an oldest action (which is a cast) in progress.
+			if (actorControl.Category == S2C_ActorControlCategory::CancelCast) {
+				const auto& cancelCast = actorControl.CancelCast;
+				LockTracker.OnCastCancelled(cancelCast.ActionId, [this](const auto& item) { OnActionRequestIgnored(item); });
+
+				if (runtimeConfig.UseHighLatencyMitigationLogging)
+					Impl.Logger->Format(
+						LogCategory::NetworkTimingHandler,
+						"{:x}: S2C_ActorControl/CancelCast: actionId={:04x}",
+						Conn.Socket(),
+						cancelCast.ActionId);
 			}
 
-			// Disallow negative delay values.
-			delay = std::max(delay, 0LL);
+			return true;
+		}
+
+		bool OnActorCast(XivMessage* pMessage) {
+			const auto& runtimeConfig = Config->Runtime;
+
+			const auto& actorCast = pMessage->Data.Ipc.Data.S2C_ActorCast;
+			// Mark that the last request was a cast.
+			LockTracker.OnCast(actorCast.CastTimeUs());
 
-			// Return the new animation lock time without server response time delay, but with artificial delay (safety/lag) value.
-			description << std::format(" delay={}us", delay);
-			return nowUs + (originalWaitUs - rttUs) + delay;
+			if (runtimeConfig.UseHighLatencyMitigationLogging)
+				Impl.Logger->Format(
+					LogCategory::NetworkTimingHandler,
+					"{:x}: S2C_ActorCast: actionId={:04x} time={:.3f} target={:08x}",
+					Conn.Socket(),
+					actorCast.ActionId,
+					actorCast.CastTimeF,
+					actorCast.TargetId);
+
+			return true;
 		}
 	};
 
@@ -398,7 +319,9 @@ struct XivAlexander::Apps::MainApp::Internal::NetworkTimingHandler::Implementati
 	Apps::MainApp::App& App;
 	const std::shared_ptr<Misc::Logger> Logger;
 	SocketHook& SocketHook;
+	const std::shared_ptr<SharedState> State;
 	std::map<SingleConnection*, std::unique_ptr<SingleConnectionHandler>> Handlers{};
+	uint64_t LastHandlerId = 0;
 	std::mutex HandlersMutex;
 	Utils::CallOnDestruction::Multiple Cleanup;
 
@@ -406,10 +329,12 @@ struct XivAlexander::Apps::MainApp::Internal::NetworkTimingHandler::Implementati
 		: This(this_)
 		, App(app)
 		, Logger(Misc::Logger::Acquire())
-		, SocketHook(app.GetSocketHook()) {
+		, SocketHook(app.GetSocketHook())
+		, State(std::make_shared<SharedState>()) {
+		State->Impl = this;
 		Cleanup += SocketHook.OnSocketFound([&](SingleConnection& conn) {
 			const auto lock = std::lock_guard(HandlersMutex);
-			Handlers.emplace(&conn, std::make_unique<SingleConnectionHandler>(this, conn));
+			Handlers.emplace(&conn, std::make_unique<SingleConnectionHandler>(this, conn, ++LastHandlerId));
 			});
 		Cleanup += SocketHook.OnSocketGone([&](SingleConnection& conn) {
 			std::unique_ptr<SingleConnectionHandler> sch;
@@ -426,6 +351,10 @@ struct XivAlexander::Apps::MainApp::Internal::NetworkTimingHandler::Implementati
 	}
 
 	~Implementation() {
+		{
+			const auto lock = std::lock_guard(State->Mtx);
+			State->Impl = nullptr;
+		}
 		Cleanup.Clear();
 		Handlers.clear();
 	}
@@ -1,8 +1,11 @@
 #include "pch.h"
 #include "SocketHook.h"
 
+#include <XivAlexanderCommon/Sqex/Network/IpcDispatcher.h>
 #include <XivAlexanderCommon/Sqex/Network/Structure.h>
+#include <XivAlexanderCommon/Utils/FlatHandleMap.h>
 #include <XivAlexanderCommon/Utils/Oodle.h>
+#include <XivAlexanderCommon/Utils/RingBuffer.h>
 #include <XivAlexanderCommon/Utils/ZlibWrapper.h>
 
 #include "Apps/MainApp/App.h"
@@ -16,55 +19,38 @@ using namespace Sqex::Network::Structure;
 class XivAlexander::Apps::MainApp::Internal::SingleConnection::SingleStream {
 	Misc::Logger& m_logger;
 	const std::string m_name;
-	Utils::ZlibReusableDeflater m_deflater;
+	const std::unique_ptr<Utils::Deflater> m_deflater;
 	Utils::ZlibReusableInflater m_inflater;
 	Utils::Oodle::Oodler m_oodler, m_unoodler;
 
-	std::vector<uint8_t> m_buffer{};
-	size_t m_pointer = 0;
+	// Decoded bundle bodies, which messages are filtered in place.
+	std::vector<uint8_t> m_arena{};
 
-public:
-	class SingleStreamWriter {
-		SingleStream& m_stream;
-		const size_t m_offset;
-		size_t m_commitLength = 0;
-
-	public:
-		SingleStreamWriter(SingleStream& stream)
-			: m_stream(stream)
-			, m_offset(stream.m_buffer.size()) {
-		}
-
-		template<typename T>
-		T* Allocate(size_t length) {
-			m_stream.m_buffer.resize(m_offset + m_commitLength + length);
-			return reinterpret_cast<T*>(&m_stream.m_buffer[m_offset + m_commitLength]);
-		}
+	Utils::RingBuffer m_buffer;
 
-		size_t Write(size_t length) {
-			m_commitLength += length;
-			return length;
-		}
-
-		~SingleStreamWriter() {  // NOLINT(bugprone-exception-escape)
-			m_stream.m_buffer.resize(m_offset + m_commitLength);
-		}
-	};
+	// Set once a bundle has gone through; until then, the stream may well not be made of bundles at all.
+	bool m_bundleSeen = false;
 
-	SingleStream(Misc::Logger& logger, std::string name, const Utils::Oodle::OodleModule& oodleModule, bool oodleTcp)
+public:
+	SingleStream(Misc::Logger& logger, std::string name, const Utils::Oodle::OodleModule& oodleModule, bool oodleTcp, bool quickDeflate)
 		: m_logger(logger)
 		, m_name(std::move(name))
+		, m_deflater(quickDeflate ? std::unique_ptr<Utils::Deflater>(std::make_unique<Utils::QuickDeflater>()) : std::make_unique<Utils::ZlibReusableDeflater>())
 		, m_oodler(oodleModule, !oodleTcp)
 		, m_unoodler(oodleModule, !oodleTcp) {
 	}
 
-	SingleStreamWriter Write() {
-		return { *this };
+	// Gets space to receive into directly; follow with CommitWrite.
+	[[nodiscard]] std::span<uint8_t> PrepareWrite(size_t minSize) {
+		return m_buffer.PrepareWrite(minSize);
+	}
+
+	void CommitWrite(size_t length) {
+		m_buffer.CommitWrite(length);
 	}
 
 	void Write(const void* buf, size_t length) {
-		const auto uint8buf = static_cast<const uint8_t*>(buf);
-		m_buffer.insert(m_buffer.end(), uint8buf, uint8buf + length);
+		m_buffer.Write({ static_cast<const uint8_t*>(buf), length });
 	}
 
 	template<typename T, typename = std::enable_if_t<std::is_standard_layout_v<T>>>
@@ -77,49 +63,38 @@ public:
 		Write(data.data(), data.size_bytes());
 	}
 
+	// Data may wrap around; only minContiguous bytes are guaranteed to be returned at once.
 	template<typename T = uint8_t, typename = std::enable_if_t<std::is_standard_layout_v<T>>>
-	[[nodiscard]] std::span<const T> Peek(size_t count = SIZE_MAX) const {
-		if (m_buffer.empty())
-			return {};
-		return {
-			reinterpret_cast<const T*>(&m_buffer[m_pointer]),
-			count == SIZE_MAX ? (m_buffer.size() - m_pointer) / sizeof(T) : count
-		};
+	[[nodiscard]] std::span<const T> Peek(size_t minContiguous = 0) {
+		const auto data = m_buffer.Peek(minContiguous == SIZE_MAX ? SIZE_MAX : minContiguous * sizeof(T));
+		return { reinterpret_cast<const T*>(data.data()), data.size() / sizeof(T) };
 	}
 
 	template<typename T = uint8_t, typename = std::enable_if_t<std::is_standard_layout_v<T>>>
 	void Consume(size_t count) {
-		m_pointer += count * sizeof(T);
-		if (m_pointer == m_buffer.size()) {
-			m_buffer.clear();
-			m_pointer = 0;
-		} else if (m_pointer > m_buffer.size()) {
-			m_buffer.clear();
-			m_pointer = 0;
+		if (m_buffer.Consume(count * sizeof(T)) != count * sizeof(T))
 			m_logger.Log(LogCategory::SocketHook, "SingleStream: overconsuming", LogLevel::Warning);
-		}
 	}
 
 	template<typename T, typename = std::enable_if_t<std::is_standard_layout_v<T>>>
 	size_t Read(T* buf, size_t count) {
-		count = std::min(count, (m_buffer.size() - m_pointer) / sizeof(T));
-		memcpy(buf, &m_buffer[m_pointer], count * sizeof(T));
-		Consume<T>(count);
-		return count;
+		count = std::min(count, m_buffer.Size() / sizeof(T));
+		return m_buffer.Read({ reinterpret_cast<uint8_t*>(buf), count * sizeof(T) }) / sizeof(T);
 	}
 
 	template<typename T = uint8_t, typename = std::enable_if_t<std::is_standard_layout_v<T>>>
 	[[nodiscard]] size_t Available() const {
-		return (m_buffer.size() - m_pointer) / sizeof(T);
+		return m_buffer.Size() / sizeof(T);
 	}
 
 	void TunnelXivStream(SingleStream& target, const XivAlexander::Apps::MainApp::Internal::SingleConnection::MessageMangler& messageMangler) {
 		while (true) {
-			auto buf = Peek();
+			// Looking for the next bundle and decoding it in place need everything in one piece.
+			auto buf = Peek(SIZE_MAX);
 			if (buf.empty())
 				break;
 
-			if (const auto trash = XivBundle::ExtractFrontTrash(buf); !trash.empty()) {
+			if (const auto trash = XivBundle::ExtractFrontTrash(buf, m_bundleSeen); !trash.empty()) {
 				target.Write(trash);
 				Consume(trash.size_bytes());
 				buf = buf.subspan(trash.size_bytes());
@@ -129,55 +104,28 @@ public:
 			if (buf.size_bytes() < sizeof XivBundleHeader)
 				break;
 
+			// TotalLength has been validated by ExtractFrontTrash.
 			const auto* pGamePacket = reinterpret_cast<const XivBundle*>(buf.data());
 
-			// Invalid TotalLength
-			if (pGamePacket->TotalLength == 0) {
-				target.Write(buf.subspan(0, 1));
-				Consume(1);
-				continue;
-			}
-
 			// Incomplete data
 			if (buf.size_bytes() < pGamePacket->TotalLength)
 				break;
 
 			try {
-				auto messages = pGamePacket->GetMessages(m_inflater, m_unoodler);
+				const auto [body, messageCount] = XivBundle::FilterMessages(pGamePacket->DecodeBody(m_inflater, m_unoodler, m_arena), messageMangler);
 				auto header = *pGamePacket;
 				header.TotalLength = static_cast<uint32_t>(sizeof XivBundleHeader);
-				header.MessageCount = 0;
+				header.MessageCount = messageCount;
 				header.CompressionType = pGamePacket->CompressionType;
-				header.DecodedBodyLength = 0;
-
-				for (auto& message : messages) {
-					const auto pMessage = reinterpret_cast<XivMessage*>(&message[0]);
-
-					if (!messageMangler(pMessage))
-						pMessage->Length = 0;
-
-					if (!pMessage->Length)
-						continue;
-
-					header.DecodedBodyLength += pMessage->Length;
-					header.MessageCount += 1;
-				}
-
-				std::vector<uint8_t> body;
-				body.reserve(header.DecodedBodyLength);
-				for (const auto& message : messages) {
-					if (!reinterpret_cast<const XivMessage*>(&message[0])->Length)
-						continue;
-					body.insert(body.end(), message.begin(), message.end());
-				}
+				header.DecodedBodyLength = static_cast<uint32_t>(body.size());
 
 				std::span<uint8_t> encoded;
 				switch (header.CompressionType) {
 					case CompressionType::None:
-						encoded = { body };
+						encoded = body;
 						break;
 					case CompressionType::Deflate:
-						encoded = m_deflater(body);
+						encoded = m_deflater->Deflate(body);
 						break;
 					case CompressionType::Oodle:
 						encoded = m_oodler.Encode(body);
@@ -195,6 +143,7 @@ public:
 			}
 
 			Consume(pGamePacket->TotalLength);
+			m_bundleSeen = true;
 		}
 	}
 };
@@ -204,8 +153,11 @@ struct XivAlexander::Apps::MainApp::Internal::SingleConnection::Implementation {
 	Internal::SocketHook& SocketHook;
 	bool Detaching = false;
 
-	std::map<size_t, std::vector<MessageMangler>> IncomingHandlers{};
-	std::map<size_t, std::vector<MessageMangler>> OutgoingHandlers{};
+	// Receive directly into RecvRaw, but not into a sliver of free space left right before its end.
+	static constexpr size_t MinReceiveSize = 16384;
+
+	Sqex::Network::IpcDispatcher IncomingHandlers;
+	Sqex::Network::IpcDispatcher OutgoingHandlers;
 
 	std::deque<uint64_t> KeepAliveRequestTimestampsUs{};
 	std::deque<uint64_t> ObservedServerResponseList{};
@@ -219,9 +171,15 @@ struct XivAlexander::Apps::MainApp::Internal::SingleConnection::Implementation {
 	sockaddr_storage LocalAddress = { AF_UNSPEC };
 	sockaddr_storage RemoteAddress = { AF_UNSPEC };
 
+	// Set once both ends are known; until then, or until invalidated, every hooked call looks the addresses up again.
+	bool AddressesResolved = false;
+
 	Utils::CallOnDestruction PingTrackKeeper;
 
 	mutable int IoctlTcpInfoFailureCount = 0;
+
+	// Result of the last successful FetchSocketLatencyUs, so that GetLatencySnapshot can do without a syscall.
+	int64_t LastSocketLatencyUs = INT64_MAX;
 	uint64_t NextTcpDelaySetAttempt = 0;
 
 	Implementation(Internal::SingleConnection& singleConnection, Internal::SocketHook& socketHook);
@@ -251,24 +209,36 @@ struct XivAlexander::Apps::MainApp::Internal::SingleConnection::Implementation {
 
 	void ResolveAddresses();
 
+	void ResolveAddressesIfNeeded() {
+		if (!AddressesResolved)
+			ResolveAddresses();
+	}
+
 	void AttemptReceive() {
-		if (auto write = RecvRaw.Write();
-			!write.Write(std::max(0, SocketHook.recv.bridge(SingleConnection.m_socket, write.Allocate<char>(65536), 65536, 0))))
+		const auto space = RecvRaw.PrepareWrite(MinReceiveSize);
+		const auto received = SocketHook.recv.bridge(SingleConnection.m_socket, reinterpret_cast<char*>(space.data()), static_cast<int>(std::min<size_t>(space.size(), INT_MAX)), 0);
+		if (received <= 0)
 			return;
 
+		RecvRaw.CommitWrite(received);
 		ProcessRecvData();
 	}
 
 	void AttemptSend() {
-		const auto data = SendProcessed.Peek<char>();
-		if (data.empty())
-			return;
+		// Pending data may wrap around the end of the buffer, in which case it takes two sends.
+		while (true) {
+			const auto data = SendProcessed.Peek<char>();
+			if (data.empty())
+				return;
 
-		const auto sent = SocketHook.send.bridge(SingleConnection.m_socket, data.data(), static_cast<int>(data.size_bytes()), 0);
-		if (sent == SOCKET_ERROR)
-			return;
+			const auto sent = SocketHook.send.bridge(SingleConnection.m_socket, data.data(), static_cast<int>(data.size_bytes()), 0);
+			if (sent == SOCKET_ERROR)
+				return;
 
-		SendProcessed.Consume(sent);
+			SendProcessed.Consume(sent);
+			if (static_cast<size_t>(sent) != data.size_bytes())
+				return;
+		}
 	}
 
 	void ProcessRecvData() {
@@ -292,11 +262,7 @@ struct XivAlexander::Apps::MainApp::Internal::SingleConnection::Implementation {
 					break;
 
 				case MessageType::Ipc:
-					for (const auto& cbs : IncomingHandlers) {
-						for (const auto& cb : cbs.second) {
-							use &= cb(pMessage);
-						}
-					}
+					use = IncomingHandlers.Dispatch(pMessage);
 			}
 
 			return use;
@@ -313,11 +279,7 @@ struct XivAlexander::Apps::MainApp::Internal::SingleConnection::Implementation {
 					break;
 
 				case MessageType::Ipc:
-					for (const auto& cbs : OutgoingHandlers) {
-						for (const auto& cb : cbs.second) {
-							use &= cb(pMessage);
-						}
-					}
+					use = OutgoingHandlers.Dispatch(pMessage);
 			}
 
 			return use;
@@ -335,8 +297,9 @@ struct XivAlexander::Apps::MainApp::Internal::SocketHook::Implementation {
 	Apps::MainApp::App& App;
 	const DWORD GameMainThreadId;
 	Misc::IcmpPingTracker PingTracker;
-	std::map<SOCKET, std::unique_ptr<SingleConnection>> Sockets;
-	std::set<SOCKET> NonGameSockets;
+
+	// Every socket seen on the game thread after it got connected; value is nullptr if it is not a game connection.
+	Utils::FlatHandleMap<SOCKET, std::unique_ptr<SingleConnection>> Sockets;
 	std::vector<std::pair<uint32_t, uint32_t>> AllowedIpRange;
 	std::vector<std::pair<uint32_t, uint32_t>> AllowedPortRange;
 	Utils::CallOnDestruction::Multiple Cleanup;
@@ -369,12 +332,12 @@ struct XivAlexander::Apps::MainApp::Internal::SocketHook::Implementation {
 		try {
 			AllowedIpRange = Utils::ParseIpRange(game.Server_IpRange, runtime.TakeOverAllAddresses, runtime.TakeOverPrivateAddresses, runtime.TakeOverLoopbackAddresses);
 		} catch (const std::exception& e) {
-			SocketHook.m_logger->Format<LogLevel::Error>(LogCategory::SocketHook, e.what());
+			SocketHook.m_logger->Log(LogCategory::SocketHook, e.what(), LogLevel::Error);
 		}
 		try {
 			AllowedPortRange = Utils::ParsePortRange(game.Server_PortRange, runtime.TakeOverAllPorts);
 		} catch (const std::exception& e) {
-			SocketHook.m_logger->Format<LogLevel::Error>(LogCategory::SocketHook, e.what());
+			SocketHook.m_logger->Log(LogCategory::SocketHook, e.what(), LogLevel::Error);
 		}
 	}
 
@@ -392,7 +355,6 @@ struct XivAlexander::Apps::MainApp::Internal::SocketHook::Implementation {
 
 		if (addr.sin_family != AF_INET) {
 			SocketHook.m_logger->Format(LogCategory::SocketHook, Config->Runtime.GetLangId(), IDS_SOCKETHOOK_SOCKET_IGNORED_NOT_IPV4, s);
-			NonGameSockets.emplace(s);
 			return TestRemoteAddressResult::RegisterIgnore;
 		}
 
@@ -427,39 +389,39 @@ struct XivAlexander::Apps::MainApp::Internal::SocketHook::Implementation {
 	}
 
 	SingleConnection* FindOrCreateSingleConnection(SOCKET s, bool existingOnly = false) {
-		if (const auto found = Sockets.find(s); found != Sockets.end()) {
-			found->second->ResolveAddresses();
-			return found->second.get();
+		if (const auto found = Sockets.Find(s)) {
+			if (const auto& conn = *found)
+				conn->m_pImpl->ResolveAddressesIfNeeded();
+			return found->get();
 		}
-		if (SocketHook.m_unloading
-			|| existingOnly
-			|| NonGameSockets.find(s) != NonGameSockets.end())
+		if (SocketHook.m_unloading || existingOnly)
 			return nullptr;
 
 		switch (TestRemoteAddressAndLog(s)) {
 			case TestRemoteAddressResult::Pass:
 				return nullptr;
 			case TestRemoteAddressResult::RegisterIgnore:
-				NonGameSockets.emplace(s);
+				Sockets.Emplace(s);
 				return nullptr;
 			case TestRemoteAddressResult::TakeOver:
 				break;
 		}
-		Sockets.emplace(s, std::make_unique<SingleConnection>(SocketHook, s));
-		const auto ptr = Sockets.at(s).get();
+		const auto ptr = Sockets.Emplace(s, std::make_unique<SingleConnection>(SocketHook, s)).first->get();
 		SocketHook.OnSocketFound(*ptr);
 		return ptr;
 	}
 
-	decltype(Sockets.end()) CleanupSocket(decltype(Sockets.end()) it) {
-		if (it == Sockets.end())
-			return it;
-		SocketHook.OnSocketGone(*it->second);
-		return Sockets.erase(it);
+	void CleanupSocket(SOCKET s) {
+		const auto found = Sockets.Find(s);
+		if (!found)
+			return;
+		if (*found)
+			SocketHook.OnSocketGone(**found);
+		Sockets.Erase(s);
 	}
 
-	decltype(Sockets.end()) CleanupSocket(SOCKET s) {
-		return CleanupSocket(Sockets.find(s));
+	[[nodiscard]] bool HasGameConnections() const {
+		return std::ranges::any_of(Sockets, [](const auto& entry) { return entry.Value != nullptr; });
 	}
 };
 
@@ -492,15 +454,17 @@ void XivAlexander::Apps::MainApp::Internal::SingleConnection::Implementation::Re
 			reinterpret_cast<sockaddr_in*>(&LocalAddress)->sin_addr,
 			reinterpret_cast<sockaddr_in*>(&RemoteAddress)->sin_addr
 		);
+
+	AddressesResolved = !!PingTrackKeeper;
 }
 
 XivAlexander::Apps::MainApp::Internal::SingleConnection::Implementation::Implementation(Internal::SingleConnection& singleConnection, Internal::SocketHook& socketHook)
 	: SingleConnection(singleConnection)
 	, SocketHook(socketHook)
-	, RecvRaw(*socketHook.m_logger, "S2C_Raw", socketHook.m_pImpl->OodleModule, socketHook.m_pImpl->Config->Game.Common_UseOodleTcp)
-	, RecvProcessed(*socketHook.m_logger, "S2C_Processed", socketHook.m_pImpl->OodleModule, socketHook.m_pImpl->Config->Game.Common_UseOodleTcp)
-	, SendRaw(*socketHook.m_logger, "C2S_Raw", socketHook.m_pImpl->OodleModule, socketHook.m_pImpl->Config->Game.Common_UseOodleTcp)
-	, SendProcessed(*socketHook.m_logger, "C2S_Processed", socketHook.m_pImpl->OodleModule, socketHook.m_pImpl->Config->Game.Common_UseOodleTcp) {
+	, RecvRaw(*socketHook.m_logger, "S2C_Raw", socketHook.m_pImpl->OodleModule, socketHook.m_pImpl->Config->Game.Common_UseOodleTcp, socketHook.m_pImpl->Config->Runtime.UseQuickDeflate)
+	, RecvProcessed(*socketHook.m_logger, "S2C_Processed", socketHook.m_pImpl->OodleModule, socketHook.m_pImpl->Config->Game.Common_UseOodleTcp, socketHook.m_pImpl->Config->Runtime.UseQuickDeflate)
+	, SendRaw(*socketHook.m_logger, "C2S_Raw", socketHook.m_pImpl->OodleModule, socketHook.m_pImpl->Config->Game.Common_UseOodleTcp, socketHook.m_pImpl->Config->Runtime.UseQuickDeflate)
+	, SendProcessed(*socketHook.m_logger, "C2S_Processed", socketHook.m_pImpl->OodleModule, socketHook.m_pImpl->Config->Game.Common_UseOodleTcp, socketHook.m_pImpl->Config->Runtime.UseQuickDeflate) {
 	socketHook.m_logger->Format(LogCategory::SocketHook, socketHook.m_pImpl->Config->Runtime.GetLangId(), IDS_SOCKETHOOK_SOCKET_FOUND, SingleConnection.m_socket);
 	ResolveAddresses();
 }
@@ -513,22 +477,34 @@ XivAlexander::Apps::MainApp::Internal::SingleConnection::SingleConnection(Intern
 XivAlexander::Apps::MainApp::Internal::SingleConnection::~SingleConnection() = default;
 
 void XivAlexander::Apps::MainApp::Internal::SingleConnection::AddIncomingFFXIVMessageHandler(void* token, MessageMangler cb) {
-	m_pImpl->IncomingHandlers[reinterpret_cast<size_t>(token)].emplace_back(std::move(cb));
+	m_pImpl->IncomingHandlers.Add(token, std::move(cb));
+}
+
+void XivAlexander::Apps::MainApp::Internal::SingleConnection::AddIncomingFFXIVMessageHandler(void* token, const Sqex::Network::IpcDispatcher::Filter& filter, MessageMangler cb) {
+	m_pImpl->IncomingHandlers.Add(token, filter, std::move(cb));
 }
 
 void XivAlexander::Apps::MainApp::Internal::SingleConnection::AddOutgoingFFXIVMessageHandler(void* token, MessageMangler cb) {
-	m_pImpl->OutgoingHandlers[reinterpret_cast<size_t>(token)].emplace_back(std::move(cb));
+	m_pImpl->OutgoingHandlers.Add(token, std::move(cb));
+}
+
+void XivAlexander::Apps::MainApp::Internal::SingleConnection::AddOutgoingFFXIVMessageHandler(void* token, const Sqex::Network::IpcDispatcher::Filter& filter, MessageMangler cb) {
+	m_pImpl->OutgoingHandlers.Add(token, filter, std::move(cb));
 }
 
 void XivAlexander::Apps::MainApp::Internal::SingleConnection::RemoveMessageHandlers(void* token) {
-	m_pImpl->IncomingHandlers.erase(reinterpret_cast<size_t>(token));
-	m_pImpl->OutgoingHandlers.erase(reinterpret_cast<size_t>(token));
+	m_pImpl->IncomingHandlers.Remove(token);
+	m_pImpl->OutgoingHandlers.Remove(token);
 }
 
 void XivAlexander::Apps::MainApp::Internal::SingleConnection::ResolveAddresses() {
 	m_pImpl->ResolveAddresses();
 }
 
+void XivAlexander::Apps::MainApp::Internal::SingleConnection::InvalidateAddresses() {
+	m_pImpl->AddressesResolved = false;
+}
+
 std::optional<int64_t> XivAlexander::Apps::MainApp::Internal::SingleConnection::FetchSocketLatencyUs() {
 	// Give up after 5 consecutive failures on measuring socket latency
 	if (m_pImpl->IoctlTcpInfoFailureCount >= 5)
@@ -551,10 +527,23 @@ std::optional<int64_t> XivAlexander::Apps::MainApp::Internal::SingleConnection::
 	} else {
 		const auto latency = static_cast<int64_t>(info.RttUs);
 		SocketLatencyUs.AddValue(latency);
+		m_pImpl->LastSocketLatencyUs = latency;
 		return std::make_optional(latency);
 	}
 };
 
+Utils::AnimationLock::LatencySnapshot XivAlexander::Apps::MainApp::Internal::SingleConnection::GetLatencySnapshot() const {
+	const auto application = ApplicationLatencyUs.Summarize();
+	const auto pingTracker = GetPingLatencyTrackerUs();
+	return {
+		.SocketLatencyUs = m_pImpl->LastSocketLatencyUs,
+		.PingLatencyUs = pingTracker ? pingTracker->Summarize().Latest : INT64_MAX,
+		.RttMinUs = application.Min,
+		.RttMeanUs = application.Mean,
+		.RttDeviationUs = application.Deviation,
+	};
+}
+
 const Utils::NumericStatisticsTracker* XivAlexander::Apps::MainApp::Internal::SingleConnection::GetPingLatencyTrackerUs() const {
 	if (m_pImpl->LocalAddress.ss_family != AF_INET || m_pImpl->RemoteAddress.ss_family != AF_INET)
 		return nullptr;
@@ -567,7 +556,7 @@ const Utils::NumericStatisticsTracker* XivAlexander::Apps::MainApp::Internal::Si
 
 XivAlexander::Apps::MainApp::Internal::SocketHook::SocketHook(Apps::MainApp::App & app)
 	: m_logger(Misc::Logger::Acquire())
-	, OnSocketFound([this](const auto& cb) { if (m_pImpl) { for (const auto& val : m_pImpl->Sockets | std::views::values) cb(*val); } }) {
+	, OnSocketFound([this](const auto& cb) { if (m_pImpl) { for (const auto& entry : m_pImpl->Sockets) { if (entry.Value) cb(*entry.Value); } } }) {
 
 	m_hThreadSetupHook = Utils::Win32::Thread(L"SocketHook::SocketHook/WaitGameWindow", [this, &app]() {
 		m_logger->Log(LogCategory::SocketHook, "Waiting for game window to stabilize before setting up redirecting network operations.");
@@ -599,7 +588,6 @@ XivAlexander::Apps::MainApp::Internal::SocketHook::SocketHook(Apps::MainApp::App
 
 							m_pImpl->CleanupSocket(s);
 							m_logger->Format(LogCategory::SocketHook, "{:x}: API(closesocket)", s);
-							m_pImpl->NonGameSockets.erase(s);
 							return closesocket.bridge(s);
 							}).Wrap([&app](auto fn) { app.RunOnGameLoop(std::move(fn)); }));
 
@@ -663,13 +651,14 @@ XivAlexander::Apps::MainApp::Internal::SocketHook::SocketHook(Apps::MainApp::App
 									m_pImpl->CleanupSocket(s);
 							}
 
-							for (auto it = m_pImpl->Sockets.begin(); it != m_pImpl->Sockets.end();) {
-								it->second->m_pImpl->AttemptSend();
+							for (const auto& entry : m_pImpl->Sockets) {
+								if (!entry.Value)
+									continue;
+
+								entry.Value->m_pImpl->AttemptSend();
 
-								if (it->second->m_pImpl->CanCompleteDetach())
-									it = m_pImpl->CleanupSocket(it->first);
-								else
-									++it;
+								if (entry.Value->m_pImpl->CanCompleteDetach())
+									m_pImpl->CleanupSocket(entry.Key);
 							}
 
 							return static_cast<int>((readfds ? readfds->fd_count : 0) +
@@ -683,6 +672,10 @@ XivAlexander::Apps::MainApp::Internal::SocketHook::SocketHook(Apps::MainApp::App
 
 							const auto result = connect.bridge(s, name, namelen);
 							m_logger->Format(LogCategory::SocketHook, "{:x}: API(connect): {}", s, Utils::ToString(*name));
+
+							// Endpoints change on connect, even for a non-blocking connect that has yet to complete.
+							if (const auto found = m_pImpl->Sockets.Find(s); found && *found)
+								(*found)->InvalidateAddresses();
 							return result;
 							}).Wrap([&app](auto fn) { app.RunOnGameLoop(std::move(fn)); }));
 						m_logger->Log(LogCategory::SocketHook, "Network operation has been redirected.");
@@ -703,7 +696,7 @@ XivAlexander::Apps::MainApp::Internal::SocketHook::~SocketHook() {
 	if (!m_pImpl)
 		return;
 
-	while (!m_pImpl->Sockets.empty()) {
+	while (m_pImpl->HasGameConnections()) {
 		m_pImpl->App.RunOnGameLoop([this]() { ReleaseSockets(); });
 		Sleep(1);
 	}
@@ -730,13 +723,17 @@ void XivAlexander::Apps::MainApp::Internal::SocketHook::ReleaseSockets() const {
 		return;
 
 	for (const auto& entry : m_pImpl->Sockets) {
-		if (entry.second->m_pImpl->Detaching)
+		if (!entry.Value) {
+			// Forget that it was not a game connection, as the address ranges may have changed.
+			m_pImpl->Sockets.Erase(entry.Key);
+			continue;
+		}
+		if (entry.Value->m_pImpl->Detaching)
 			continue;
 
-		m_logger->Format(LogCategory::SocketHook, m_pImpl->Config->Runtime.GetLangId(), IDS_SOCKETHOOK_SOCKET_DETACH, entry.first);
-		entry.second->m_pImpl->Detaching = true;
+		m_logger->Format(LogCategory::SocketHook, m_pImpl->Config->Runtime.GetLangId(), IDS_SOCKETHOOK_SOCKET_DETACH, entry.Key);
+		entry.Value->m_pImpl->Detaching = true;
 	}
-	m_pImpl->NonGameSockets.clear();
 }
 
 void XivAlexander::Apps::MainApp::Internal::SocketHook::ResetAllConnections() const {
@@ -744,13 +741,9 @@ void XivAlexander::Apps::MainApp::Internal::SocketHook::ResetAllConnections() co
 		return;
 
 	std::vector<SOCKET> sockets;
-	sockets.reserve(m_pImpl->Sockets.size() + m_pImpl->NonGameSockets.size());
-	std::ranges::copy(m_pImpl->Sockets | std::views::keys, std::back_inserter(sockets));
-	std::ranges::copy(m_pImpl->NonGameSockets, std::back_inserter(sockets));
-	for (const auto& entry : m_pImpl->Sockets | std::views::keys)
-		sockets.push_back(entry);
-	for (const auto& entry : m_pImpl->NonGameSockets)
-		sockets.push_back(entry);
+	sockets.reserve(m_pImpl->Sockets.Size());
+	for (const auto& entry : m_pImpl->Sockets)
+		sockets.push_back(entry.Key);
 
 	for (const auto& entry : sockets) {
 		m_logger->Format(
@@ -770,9 +763,11 @@ std::wstring XivAlexander::Apps::MainApp::Internal::SocketHook::Describe() const
 		try {
 			std::wstring result;
 			for (const auto& entry : m_pImpl->Sockets) {
-				const auto& conn = entry.second;
+				const auto& conn = entry.Value;
+				if (!conn)
+					continue;
 				result += m_pImpl->Config->Runtime.FormatStringRes(IDS_SOCKETHOOK_SOCKET_DESCRIBE_TITLE,
-					entry.first,
+					entry.Key,
 					Utils::FromUtf8(Utils::ToString(conn->m_pImpl->LocalAddress)),
 					Utils::FromUtf8(Utils::ToString(conn->m_pImpl->RemoteAddress)));
 
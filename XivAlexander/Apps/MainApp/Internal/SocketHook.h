@@ -1,5 +1,7 @@
 #pragma once
 
+#include <XivAlexanderCommon/Sqex/Network/IpcDispatcher.h>
+#include <XivAlexanderCommon/Utils/AnimationLock.h>
 #include <XivAlexanderCommon/Utils/ListenerManager.h>
 #include <XivAlexanderCommon/Utils/NumericStatisticsTracker.h>
 
@@ -13,13 +15,6 @@ namespace XivAlexander::Apps::MainApp {
 	class App;
 }
 
-namespace Sqex::Network {
-	namespace Structure {
-		struct XivBundle;
-		struct XivMessage;
-	}
-}
-
 namespace XivAlexander::Apps::MainApp::Internal {
 	class SocketHook;
 
@@ -37,11 +32,16 @@ namespace XivAlexander::Apps::MainApp::Internal {
 		SingleConnection(SocketHook& hook, SOCKET s);
 		~SingleConnection();
 
-		typedef std::function<bool(Sqex::Network::Structure::XivMessage*)> MessageMangler;
+		typedef Sqex::Network::IpcDispatcher::Handler MessageMangler;
+
+		// Without a filter, the handler sees every IPC message.
 		void AddIncomingFFXIVMessageHandler(void* token, MessageMangler cb);
+		void AddIncomingFFXIVMessageHandler(void* token, const Sqex::Network::IpcDispatcher::Filter& filter, MessageMangler cb);
 		void AddOutgoingFFXIVMessageHandler(void* token, MessageMangler cb);
+		void AddOutgoingFFXIVMessageHandler(void* token, const Sqex::Network::IpcDispatcher::Filter& filter, MessageMangler cb);
 		void RemoveMessageHandlers(void* token);
 		void ResolveAddresses();
+		void InvalidateAddresses();
 
 		[[nodiscard]] auto Socket() const { return m_socket; }
 
@@ -50,6 +50,9 @@ namespace XivAlexander::Apps::MainApp::Internal {
 		Utils::NumericStatisticsTracker SocketLatencyUs{ 10, 0 };
 		Utils::NumericStatisticsTracker ApplicationLatencyUs{ 10, 0 };
 		const Utils::NumericStatisticsTracker* GetPingLatencyTrackerUs() const;
+
+		// Uses the socket latency from the last FetchSocketLatencyUs, instead of querying it again.
+		[[nodiscard]] Utils::AnimationLock::LatencySnapshot GetLatencySnapshot() const;
 	};
 
 	class SocketHook {
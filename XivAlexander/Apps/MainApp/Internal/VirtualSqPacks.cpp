@@ -12,9 +12,11 @@
 #include <XivAlexanderCommon/Sqex/Sound/Writer.h>
 #include <XivAlexanderCommon/Sqex/Sqpack/BinaryEntryProvider.h>
 #include <XivAlexanderCommon/Sqex/Sqpack/Creator.h>
+#include <XivAlexanderCommon/Sqex/Sqpack/EntryLookup.h>
 #include <XivAlexanderCommon/Sqex/Sqpack/EntryProvider.h>
 #include <XivAlexanderCommon/Sqex/Sqpack/EntryRawStream.h>
 #include <XivAlexanderCommon/Sqex/Sqpack/HotSwappableEntryProvider.h>
+#include <XivAlexanderCommon/Sqex/Sqpack/PathRouter.h>
 #include <XivAlexanderCommon/Sqex/Sqpack/ModelEntryProvider.h>
 #include <XivAlexanderCommon/Sqex/Sqpack/RandomAccessStreamAsEntryProviderView.h>
 #include <XivAlexanderCommon/Sqex/Sqpack/Reader.h>
@@ -39,14 +41,12 @@ struct XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::Implementation {
 	const std::shared_ptr<XivAlexander::Misc::Logger> Logger;
 	const std::filesystem::path SqpackPath;
 
-	static constexpr int PathTypeIndex = -1;
-	static constexpr int PathTypeIndex2 = -2;
-	static constexpr int PathTypeInvalid = -3;
-
 	const Misc::GameInstallationDetector::GameReleaseInfo GameReleaseInfo;
 
 	std::map<std::filesystem::path, Sqex::Sqpack::Creator::SqpackViews> SqpackViews;
-	std::map<HANDLE, std::unique_ptr<OverlayedHandleData>> OverlayedHandles;
+	Sqex::Sqpack::EntryLookup Entries;
+	Sqex::Sqpack::PathRouter Router;
+	Utils::ConcurrentHandleTable<HANDLE, OverlayedHandleData> OverlayedHandles{ 4096 };
 
 	uint64_t LastIoRequestTimestamp = 0;
 	Utils::Win32::Event IoEvent = Utils::Win32::Event::Create();
@@ -64,16 +64,22 @@ struct XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::Implementation {
 		, Config(XivAlexander::Config::Acquire())
 		, Logger(XivAlexander::Misc::Logger::Acquire())
 		, SqpackPath(std::move(sqpackPath))
-		, GameReleaseInfo(Misc::GameInstallationDetector::GetGameReleaseInfo()) {
+		, GameReleaseInfo(Misc::GameInstallationDetector::GetGameReleaseInfo())
+		, Router(SqpackPath) {
 
 		const auto actCtx = Dll::ActivationContext().With();
 		{
 			Apps::MainApp::Window::ProgressPopupWindow progressWindow(Dll::FindGameMainWindow(false));
 			progressWindow.Show(std::chrono::milliseconds(5000));
 			InitializeSqPacks(progressWindow);
+			for (const auto& views : SqpackViews | std::views::values)
+				Entries.Add(views);
 			ReflectUsedEntries(true);
 		}
 
+		for (const auto& [indexFile, views] : SqpackViews)
+			Router.Add(indexFile, views);
+
 		Cleanup += Config->Runtime.MuteVoice_Battle.OnChange([this]() { ReflectUsedEntries(); });
 		Cleanup += Config->Runtime.MuteVoice_Cm.OnChange([this]() { ReflectUsedEntries(); });
 		Cleanup += Config->Runtime.MuteVoice_Emote.OnChange([this]() { ReflectUsedEntries(); });
@@ -84,22 +90,17 @@ struct XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::Implementation {
 		Cleanup.Clear();
 	}
 
-	std::shared_ptr<Sqex::RandomAccessStream> GetOriginalEntry(const Sqex::Sqpack::EntryPathSpec& pathSpec) const {
-		for (const auto& pack : SqpackViews | std::views::values) {
-			auto it = pack.HashOnlyEntries.find(pathSpec);
-			if (it == pack.HashOnlyEntries.end()) {
-				it = pack.FullPathEntries.find(pathSpec);
-				if (it == pack.FullPathEntries.end()) {
-					continue;
-				}
-			}
+	static std::shared_ptr<Sqex::RandomAccessStream> OpenOriginalEntry(const Sqex::Sqpack::Creator::Entry& entry) {
+		const auto provider = dynamic_cast<Sqex::Sqpack::HotSwappableEntryProvider*>(entry.Provider.get());
+		if (!provider)
+			return std::make_shared<Sqex::Sqpack::EntryRawStream>(entry.Provider);
 
-			const auto provider = dynamic_cast<Sqex::Sqpack::HotSwappableEntryProvider*>(it->second->Provider.get());
-			if (!provider)
-				return std::make_shared<Sqex::Sqpack::EntryRawStream>(it->second->Provider);
+		return std::make_shared<Sqex::Sqpack::EntryRawStream>(provider->GetBaseStream());
+	}
 
-			return std::make_shared<Sqex::Sqpack::EntryRawStream>(provider->GetBaseStream());
-		}
+	std::shared_ptr<Sqex::RandomAccessStream> GetOriginalEntry(const Sqex::Sqpack::EntryPathSpec& pathSpec) const {
+		if (const auto match = Entries.Find(pathSpec))
+			return OpenOriginalEntry(*match->Entry);
 		throw std::out_of_range("entry not found");
 	}
 
@@ -110,6 +111,7 @@ struct XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::Implementation {
 		Sqex::EqpGmp::ExpandedFile Gmp;
 		std::map<std::string, Sqex::Imc::File> Imc;
 		std::map<std::pair<Sqex::ThirdParty::TexTools::ItemMetadata::TargetItemType, uint32_t>, Sqex::Eqdp::ExpandedFile> Eqdp;
+		Sqex::ThirdParty::TexTools::ItemMetadataBatch MetadataEdits;
 	};
 
 	void ReflectUsedEntries(bool isCalledFromConstructor = false) {
@@ -266,6 +268,20 @@ struct XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::Implementation {
 			}
 			});
 
+		// Step. Apply collected metadata edits, loading each target file once
+		tempData.MetadataEdits.ApplyImcEdits([&](const auto& targetImcPath, const auto& sourceImcPath) -> Sqex::Imc::File& {
+			return tempData.Imc[targetImcPath] = Sqex::Imc::File(*GetOriginalEntry(sourceImcPath));
+			});
+		tempData.MetadataEdits.ApplyEqdpEdits([&](auto type, auto race) -> Sqex::Eqdp::ExpandedFile& {
+			return tempData.Eqdp[std::make_pair(type, race)] = Sqex::Eqdp::ExpandedFile(*GetOriginalEntry(Sqex::ThirdParty::TexTools::ItemMetadata::EqdpPath(type, race)));
+			});
+		tempData.MetadataEdits.ApplyEqpEdits(tempData.Eqp);
+		tempData.MetadataEdits.ApplyGmpEdits(tempData.Gmp);
+		tempData.MetadataEdits.ApplyEstEdits([&](auto type) -> Sqex::Est::File& {
+			const auto estPath = Sqex::ThirdParty::TexTools::ItemMetadata::EstPath(type);
+			return tempData.Est[estPath] = Sqex::Est::File(*GetOriginalEntry(estPath));
+			});
+
 		// Step. Replace metadata files
 		for (const auto& [path, data] : tempData.Est)
 			ReflectUsedEntries_SetFromBuffer(tempData, path, data.Data());
@@ -326,31 +342,7 @@ struct XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::Implementation {
 	) {
 		if (entry.IsMetadata()) {
 			const auto ttmpd = std::make_shared<Sqex::FileRandomAccessStream>(Utils::Win32::Handle{ ttmp.DataFile, false });
-			const auto metadata = Sqex::ThirdParty::TexTools::ItemMetadata(entry.FullPath, Sqex::Sqpack::EntryRawStream(std::make_shared<Sqex::Sqpack::RandomAccessStreamAsEntryProviderView>(entry.FullPath, ttmpd, entry.ModOffset, entry.ModSize)));
-			metadata.ApplyImcEdits([&]() -> Sqex::Imc::File& {
-				const auto imcPath = metadata.TargetImcPath;
-				if (const auto it = tempData.Imc.find(imcPath); it == tempData.Imc.end())
-					return tempData.Imc[imcPath] = Sqex::Imc::File(*GetOriginalEntry(metadata.SourceImcPath));
-				else
-					return it->second;
-				});
-			metadata.ApplyEqdpEdits([&](auto type, auto race) -> Sqex::Eqdp::ExpandedFile& {
-				const auto key = std::make_pair(type, race);
-				if (const auto it = tempData.Eqdp.find(key); it == tempData.Eqdp.end())
-					return tempData.Eqdp[key] = Sqex::Eqdp::ExpandedFile(*GetOriginalEntry(Sqex::ThirdParty::TexTools::ItemMetadata::EqdpPath(type, race)));
-				else
-					return it->second;
-				});
-			metadata.ApplyEqpEdits(tempData.Eqp);
-			metadata.ApplyGmpEdits(tempData.Gmp);
-
-			const auto estPath = Sqex::ThirdParty::TexTools::ItemMetadata::EstPath(metadata.EstType);
-			if (estPath) {
-				if (const auto it = tempData.Est.find(estPath); it == tempData.Est.end())
-					metadata.ApplyEstEdits(tempData.Est[estPath] = Sqex::Est::File(*GetOriginalEntry(estPath)));
-				else
-					metadata.ApplyEstEdits(it->second);
-			}
+			tempData.MetadataEdits.Add(Sqex::ThirdParty::TexTools::ItemMetadata(entry.FullPath, Sqex::Sqpack::EntryRawStream(std::make_shared<Sqex::Sqpack::RandomAccessStreamAsEntryProviderView>(entry.FullPath, ttmpd, entry.ModOffset, entry.ModSize))));
 		} else {
 			const auto entryIt = tempData.Replacements.find(entry.FullPath);
 			if (entryIt == tempData.Replacements.end())
@@ -861,99 +853,89 @@ XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::VirtualSqPacks(Apps::Main
 
 XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::~VirtualSqPacks() = default;
 
-HANDLE XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::Open(const std::filesystem::path & path) {
+HANDLE XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::Open(std::wstring_view path) {
 	try {
-		const auto fileToOpen = absolute(path);
-		const auto recreatedFilePath = m_pImpl->SqpackPath / fileToOpen.parent_path().filename() / fileToOpen.filename();
-		const auto indexFile = std::filesystem::path(recreatedFilePath).replace_extension(L".index");
-		const auto index2File = std::filesystem::path(recreatedFilePath).replace_extension(L".index2");
-		if (!exists(indexFile) && !exists(index2File))
-			return nullptr;
-
-		int pathType = Implementation::PathTypeInvalid;
-
-		if (fileToOpen == indexFile) {
-			pathType = Implementation::PathTypeIndex;
-		} else if (fileToOpen == index2File) {
-			pathType = Implementation::PathTypeIndex2;
-		} else {
-			for (auto i = 0; i < 8; ++i) {
-				const auto datFile = std::filesystem::path(recreatedFilePath).replace_extension(std::format(L".dat{}", i));
-				if (fileToOpen == datFile) {
-					pathType = i;
-					break;
-				}
-			}
+		// Most paths opened by the game are absolute and not sqpack files; those get rejected without allocating.
+		auto match = m_pImpl->Router.Resolve(path);
+		if (!match) {
+			if (Sqex::Sqpack::PathRouter::IsAbsolute(path))
+				return nullptr;
+			match = m_pImpl->Router.Resolve(absolute(std::filesystem::path(path)).wstring());
+			if (!match)
+				return nullptr;
 		}
 
-		if (pathType == Implementation::PathTypeInvalid)
-			return nullptr;
-
+		const auto fileToOpen = std::filesystem::path(path);
 		auto overlayedHandle = std::make_unique<OverlayedHandleData>(Utils::Win32::Event::Create(), fileToOpen, LARGE_INTEGER{}, nullptr);
 
-		for (const auto& view : m_pImpl->SqpackViews) {
-			if ((exists(indexFile) && equivalent(view.first, indexFile))
-				|| (exists(index2File) && equivalent(view.first, index2File))) {
-				switch (pathType) {
-					case Implementation::PathTypeIndex:
-						overlayedHandle->Stream = view.second.Index1;
-						break;
-
-					case Implementation::PathTypeIndex2:
-						overlayedHandle->Stream = view.second.Index2;
-						break;
+		switch (match->PathType) {
+			case Sqex::Sqpack::PathRouter::PathTypeIndex:
+				overlayedHandle->Stream = match->Views->Index1;
+				break;
 
-					default:
-						if (pathType < 0 || static_cast<size_t>(pathType) >= view.second.Data.size())
-							throw std::runtime_error("invalid #");
-						overlayedHandle->Stream = view.second.Data[pathType];
-				}
+			case Sqex::Sqpack::PathRouter::PathTypeIndex2:
+				overlayedHandle->Stream = match->Views->Index2;
 				break;
-			}
+
+			default:
+				if (match->PathType < 0 || static_cast<size_t>(match->PathType) >= match->Views->Data.size())
+					throw std::runtime_error("invalid #");
+				overlayedHandle->Stream = match->Views->Data[match->PathType];
 		}
 
 		m_pImpl->Logger->Format<LogLevel::Info>(LogCategory::VirtualSqPacks,
-			"Taking control of {}/{} (parent: {}/{}, type: {})",
+			"Taking control of {}/{} (type: {})",
 			fileToOpen.parent_path().filename(), fileToOpen.filename(),
-			indexFile.parent_path().filename(), indexFile.filename(),
-			pathType);
+			match->PathType);
 
 		if (!overlayedHandle->Stream)
 			return nullptr;
 
 		const auto key = static_cast<HANDLE>(overlayedHandle->IdentifierHandle);
-		m_pImpl->OverlayedHandles.insert_or_assign(key, std::move(overlayedHandle));
+		m_pImpl->OverlayedHandles.Insert(key, std::move(overlayedHandle));
 		return key;
 	} catch (const Utils::Win32::Error& e) {
-		m_pImpl->Logger->Format<LogLevel::Warning>(LogCategory::VirtualSqPacks, L"CreateFileW: {}, Message: {}", path.wstring(), e.what());
+		m_pImpl->Logger->Format<LogLevel::Warning>(LogCategory::VirtualSqPacks, L"CreateFileW: {}, Message: {}", path, e.what());
 	} catch (const std::exception& e) {
-		m_pImpl->Logger->Format<LogLevel::Warning>(LogCategory::VirtualSqPacks, "CreateFileW: {}, Message: {}", path.wstring(), e.what());
+		m_pImpl->Logger->Format<LogLevel::Warning>(LogCategory::VirtualSqPacks, "CreateFileW: {}, Message: {}", std::wstring(path), e.what());
 	}
 	return nullptr;
 }
 
 bool XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::Close(HANDLE handle) {
-	return m_pImpl->OverlayedHandles.erase(handle);
+	return m_pImpl->OverlayedHandles.Erase(handle);
 }
 
-XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::OverlayedHandleData* XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::Get(HANDLE handle) {
-	const auto vpit = m_pImpl->OverlayedHandles.find(handle);
-	if (vpit != m_pImpl->OverlayedHandles.end())
-		return vpit->second.get();
-	return nullptr;
+XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::OverlayedHandleLease XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::Get(HANDLE handle) {
+	return m_pImpl->OverlayedHandles.Find(handle);
 }
 
 bool XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::EntryExists(const Sqex::Sqpack::EntryPathSpec & pathSpec) const {
-	return std::ranges::any_of(m_pImpl->SqpackViews | std::views::values, [&pathSpec](const auto& t) {
-		return t.HashOnlyEntries.find(pathSpec) != t.HashOnlyEntries.end()
-			|| (pathSpec.HasOriginal() && t.FullPathEntries.find(pathSpec) != t.FullPathEntries.end());
-		});
+	return m_pImpl->Entries.Find(pathSpec).has_value();
 }
 
 std::shared_ptr<Sqex::RandomAccessStream> XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::GetOriginalEntry(const Sqex::Sqpack::EntryPathSpec & pathSpec) const {
 	return m_pImpl->GetOriginalEntry(pathSpec);
 }
 
+std::vector<bool> XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::EntryExists(std::span<const Sqex::Sqpack::EntryPathSpec> pathSpecs) const {
+	const auto matches = m_pImpl->Entries.Find(pathSpecs);
+	std::vector<bool> result(matches.size());
+	for (size_t i = 0; i < matches.size(); ++i)
+		result[i] = matches[i].has_value();
+	return result;
+}
+
+std::vector<std::shared_ptr<Sqex::RandomAccessStream>> XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::GetOriginalEntry(std::span<const Sqex::Sqpack::EntryPathSpec> pathSpecs) const {
+	const auto matches = m_pImpl->Entries.Find(pathSpecs);
+	std::vector<std::shared_ptr<Sqex::RandomAccessStream>> result(matches.size());
+	for (size_t i = 0; i < matches.size(); ++i) {
+		if (matches[i])
+			result[i] = Implementation::OpenOriginalEntry(*matches[i]->Entry);
+	}
+	return result;
+}
+
 void XivAlexander::Apps::MainApp::Internal::VirtualSqPacks::MarkIoRequest() {
 	m_pImpl->IoLockEvent.Wait();
 	m_pImpl->LastIoRequestTimestamp = GetTickCount64();
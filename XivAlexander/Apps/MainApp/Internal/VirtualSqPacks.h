@@ -5,6 +5,7 @@
 #include <XivAlexanderCommon/Sqex/ThirdParty/TexTools.h>
 #include <XivAlexanderCommon/Utils/Win32/Handle.h>
 
+#include "XivAlexanderCommon/Utils/ConcurrentHandleTable.h"
 #include "XivAlexanderCommon/Utils/ListenerManager.h"
 
 namespace XivAlexander::Apps::MainApp {
@@ -24,7 +25,7 @@ namespace XivAlexander::Apps::MainApp::Internal {
 		VirtualSqPacks(Apps::MainApp::App& App, std::filesystem::path sqpackPath);
 		~VirtualSqPacks();
 
-		HANDLE Open(const std::filesystem::path& path);
+		HANDLE Open(std::wstring_view path);
 		bool Close(HANDLE handle);
 
 		struct OverlayedHandleData {
@@ -34,11 +35,18 @@ namespace XivAlexander::Apps::MainApp::Internal {
 			std::shared_ptr<Sqex::RandomAccessStream> Stream;
 		};
 
-		OverlayedHandleData* Get(HANDLE handle);
+		using OverlayedHandleLease = Utils::ConcurrentHandleTable<HANDLE, OverlayedHandleData>::Lease;
+
+		// The returned lease keeps the handle data alive even if the handle is closed meanwhile.
+		OverlayedHandleLease Get(HANDLE handle);
 
 		bool EntryExists(const Sqex::Sqpack::EntryPathSpec& pathSpec) const;
 		std::shared_ptr<Sqex::RandomAccessStream> GetOriginalEntry(const Sqex::Sqpack::EntryPathSpec& pathSpec) const;
 
+		// Batch versions of the above; results are in the same order as pathSpecs, and missing entries yield false or nullptr.
+		std::vector<bool> EntryExists(std::span<const Sqex::Sqpack::EntryPathSpec> pathSpecs) const;
+		std::vector<std::shared_ptr<Sqex::RandomAccessStream>> GetOriginalEntry(std::span<const Sqex::Sqpack::EntryPathSpec> pathSpecs) const;
+
 		void MarkIoRequest();
 
 		struct TtmpGroupChoices {
@@ -277,6 +277,18 @@ namespace XivAlexander {
 			// Should be the doubled value of the above.
 			Item<int64_t> MaximumAnimationLockDurationUs = CreateConfigItem(this, "MaximumAnimationLockDurationUs", 150000LL);
 
+			// How often to measure latency to each game server, and by how much to randomly vary it.
+			Item<int64_t> PingTrackerIntervalUs = CreateConfigItem<int64_t>(this, "PingTrackerIntervalUs", 1000000LL, [](const int64_t& val) {
+				return std::min<int64_t>(std::max<int64_t>(100000, val), 60000000);
+				});
+			Item<int64_t> PingTrackerJitterUs = CreateConfigItem<int64_t>(this, "PingTrackerJitterUs", 100000LL, [](const int64_t& val) {
+				return std::min<int64_t>(std::max<int64_t>(0, val), 1000000);
+				});
+
+			// Recompress game network bundles with a fast deflate encoder, instead of zlib at its default level.
+			// Output is somewhat larger. Takes effect for connections made afterwards.
+			Item<bool> UseQuickDeflate = CreateConfigItem(this, "UseQuickDeflate", false);
+
 			Item<bool> ReducePacketDelay = CreateConfigItem(this, "ReducePacketDelay", false);
 			Item<bool> TakeOverLoopbackAddresses = CreateConfigItem(this, "TakeOverLoopback", false);
 			Item<bool> TakeOverPrivateAddresses = CreateConfigItem(this, "TakeOverPrivateAddresses", false);
@@ -288,6 +300,10 @@ namespace XivAlexander {
 			Item<bool> ShowControlWindow = CreateConfigItem(this, "ShowControlWindow", true);
 			Item<bool> UseAllIpcMessageLogger = CreateConfigItem(this, "UseAllIpcMessageLogger", false);
 
+			// Minimum log level by category name as shown in the log window: 10 for debug, 20 for info, 30 for warning, and 40 for error.
+			// Anything below is dropped before being formatted. Categories not listed here log everything.
+			Item<std::map<std::string, int>> MinimumLogLevels = CreateConfigItem(this, "MinimumLogLevels", std::map<std::string, int>());
+
 			Item<std::vector<std::string>> EnabledPatchCodes = CreateConfigItem(this, "EnabledPatchCodes", std::vector<std::string>());
 			
 			Item<bool> LogAllDataFileRead = CreateConfigItem(this, "LogAllDataFileRead", false);
@@ -2,6 +2,7 @@
 #include "IcmpPingTracker.h"
 
 #include <XivAlexanderCommon/Utils/NumericStatisticsTracker.h>
+#include <XivAlexanderCommon/Utils/ProbeScheduler.h>
 #include <XivAlexanderCommon/Utils/Win32/Closeable.h>
 
 #include "Config.h"
@@ -23,109 +24,171 @@ struct ConnectionPair {
 };
 
 struct XivAlexander::Misc::IcmpPingTracker::Implementation {
-	struct SingleTracker;
+	static constexpr DWORD TimeoutMs = 5000;
+
+	// Leave room for ExitEvent and WakeEvent.
+	static constexpr size_t MaxInFlight = MAXIMUM_WAIT_OBJECTS - 2;
+
+	// An ICMP handle can have many echo requests pending, each with its own event and reply buffer.
+	struct Probe {
+		const Utils::Win32::Event CompletionEvent = Utils::Win32::Event::Create();
+		ConnectionPair Pair{};
+		Utils::ProbeScheduler<ConnectionPair>::ProbeId Id = 0;
+		int64_t SentUs = 0;
+		bool InUse = false;
+		bool SendFailed = false;
+		unsigned char ReplyBuf[sizeof(ICMP_ECHO_REPLY) + 32 + 8]{};
+	};
+
+	struct Target {
+		const std::shared_ptr<Utils::NumericStatisticsTracker> Tracker = std::make_shared<Utils::NumericStatisticsTracker>(8, INT64_MAX, 60 * 1000 * 1000);
+		size_t ReferenceCount = 0;
+	};
 
 	const std::shared_ptr<Misc::Logger> Logger;
 	const std::shared_ptr<Config> Config;
 
-	std::mutex TrackersMtx;
-	std::map<ConnectionPair, std::shared_ptr<SingleTracker>> Trackers;
-
-	struct SingleTracker {
-		Misc::IcmpPingTracker& IcmpPingTracker;
-		const std::shared_ptr<Utils::NumericStatisticsTracker> Tracker;
-		const Utils::Win32::Event ExitEvent;
-		const ConnectionPair Pair;
-		// needs to be last, as "this" needs to be done initializing
-		const Utils::Win32::Thread WorkerThread;
-
-		SingleTracker(Misc::IcmpPingTracker& icmpPingTracker, const ConnectionPair& pair)
-			: IcmpPingTracker(icmpPingTracker)
-			, Tracker(std::make_shared<Utils::NumericStatisticsTracker>(8, INT64_MAX, 60 * 1000 * 1000))
-			, ExitEvent(Utils::Win32::Event::Create())
-			, Pair(pair)
-			, WorkerThread(std::format(L"XivAlexander::App::Network::IcmpPingTracker({:x})::SingleTracker({:x}: {} <-> {})",
-					reinterpret_cast<size_t>(&icmpPingTracker), reinterpret_cast<size_t>(this),
-					Utils::ToString(pair.Source), Utils::ToString(pair.Destination)
-				), [this]() { Run(); }) {
+	std::mutex Mtx;
+	std::map<ConnectionPair, Target> Targets;
+	Utils::ProbeScheduler<ConnectionPair> Scheduler;
+
+	const Utils::Win32::Event ExitEvent;
+	const Utils::Win32::Event WakeEvent;
+	// needs to be last, as "this" needs to be done initializing
+	const Utils::Win32::Thread WorkerThread;
+
+	Implementation()
+		: Logger(Misc::Logger::Acquire())
+		, Config(Config::Acquire())
+		, ExitEvent(Utils::Win32::Event::Create())
+		, WakeEvent(Utils::Win32::Event::Create(nullptr, FALSE))
+		, WorkerThread(std::format(L"XivAlexander::App::Network::IcmpPingTracker({:x})", reinterpret_cast<size_t>(this)), [this]() { Run(); }) {
+	}
+
+	~Implementation() {
+		ExitEvent.Set();
+		WorkerThread.Wait();
+	}
+
+	void Log(UINT formatStringId, const ConnectionPair& pair) const {
+		Logger->Format(LogCategory::SocketHook,
+			Config->Runtime.GetLangId(),
+			formatStringId,
+			Utils::ToString(pair.Source),
+			Utils::ToString(pair.Destination));
+	}
+
+private:
+	void UpdateOptions() {
+		auto options = Scheduler.GetOptions();
+		options.IntervalUs = Config->Runtime.PingTrackerIntervalUs;
+		options.JitterUs = Config->Runtime.PingTrackerJitterUs;
+		Scheduler.SetOptions(options);
+	}
+
+	void Send(HANDLE hIcmp, Probe& probe, const ConnectionPair& pair, Utils::ProbeScheduler<ConnectionPair>::ProbeId probeId) {
+		static unsigned char sendBuf[32]{};
+
+		probe.Pair = pair;
+		probe.Id = probeId;
+		probe.InUse = true;
+		probe.SendFailed = false;
+		probe.CompletionEvent.Reset();
+		probe.SentUs = Utils::QpcUs();
+		if (!IcmpSendEcho2Ex(hIcmp, probe.CompletionEvent, nullptr, nullptr, pair.Source.s_addr, pair.Destination.s_addr, sendBuf, sizeof sendBuf, nullptr, probe.ReplyBuf, sizeof probe.ReplyBuf, TimeoutMs)
+			&& GetLastError() != ERROR_IO_PENDING) {
+			probe.SendFailed = true;
+			probe.CompletionEvent.Set();
 		}
+	}
 
-		~SingleTracker() {
-			ExitEvent.Set();
-			WorkerThread.Wait();
+	void Receive(Probe& probe, int64_t nowUs) {
+		probe.InUse = false;
+
+		std::optional<int64_t> latencyUs;
+		if (!probe.SendFailed
+			&& IcmpParseReplies(probe.ReplyBuf, sizeof probe.ReplyBuf)
+			&& reinterpret_cast<const ICMP_ECHO_REPLY*>(probe.ReplyBuf)->Status == IP_SUCCESS)
+			latencyUs = nowUs - probe.SentUs;
+
+		// The scheduler counts every probe until it completes, even if the pair is not tracked anymore.
+		const auto it = Targets.find(probe.Pair);
+		const auto outcome = Scheduler.Complete(probe.Id, nowUs, latencyUs, it == Targets.end() ? 0 : it->second.Tracker->NextBlankInUs());
+
+		// Not tracked anymore, or sent before the pair was tracked again.
+		if (!outcome)
+			return;
+
+		if (latencyUs)
+			it->second.Tracker->AddValue(*latencyUs);
+
+		if (outcome == Utils::ProbeScheduler<ConnectionPair>::Outcome::GaveUp) {
+			Logger->Format<LogLevel::Warning>(LogCategory::SocketHook,
+				Config->Runtime.GetLangId(),
+				IDS_PINGTRACKER_END_FAILURE_COUNT,
+				Utils::ToString(probe.Pair.Source),
+				Utils::ToString(probe.Pair.Destination),
+				Scheduler.GetOptions().MaxConsecutiveFailures);
 		}
+	}
 
-	private:
-		void Run() {
-			static constexpr auto SecondToMicrosecondMultiplier = 1000000;
-
-			const auto& logger = IcmpPingTracker.m_pImpl->Logger;
-			const auto& config = IcmpPingTracker.m_pImpl->Config;
-			try {
-				const auto hIcmp = Utils::Win32::Icmp(IcmpCreateFile(), INVALID_HANDLE_VALUE);
-
-				unsigned char sendBuf[32]{};
-				unsigned char replyBuf[sizeof(ICMP_ECHO_REPLY) + sizeof sendBuf + 8]{};
-
-				logger->Format(LogCategory::SocketHook,
-					config->Runtime.GetLangId(),
-					IDS_PINGTRACKER_START,
-					Utils::ToString(Pair.Source),
-					Utils::ToString(Pair.Destination));
-				size_t consecutiveFailureCount = 0;
-				do {
-					const auto intervalUs = std::max<DWORD>(SecondToMicrosecondMultiplier, static_cast<DWORD>(std::min<uint64_t>(INT32_MAX, Tracker->NextBlankInUs())));
-					const auto startUs = Utils::QpcUs();
-					const auto ok = IcmpSendEcho2Ex(hIcmp, nullptr, nullptr, nullptr, Pair.Source.s_addr, Pair.Destination.s_addr, sendBuf, sizeof sendBuf, nullptr, replyBuf, sizeof replyBuf, 5000);  // wait up to 5s
-					const auto endUs = Utils::QpcUs();
-					const auto latencyUs = endUs - startUs;
-					auto waitTimeUs = static_cast<DWORD>(intervalUs - latencyUs);
-
-					if (ok) {
-						consecutiveFailureCount = 0;
-
-						const auto latest = Tracker->Latest();
-						Tracker->AddValue(latencyUs);
-
-						// if ping changes by more than 10%, then ping again to confirm
-						if (latencyUs > 0 && 100 * std::abs(latest - latencyUs) / latencyUs >= 10)
-							waitTimeUs = 1;
-					} else
-						consecutiveFailureCount++;
-
-					if (ExitEvent.Wait(waitTimeUs / 1000) != WAIT_TIMEOUT) {
-						logger->Format(LogCategory::SocketHook,
-							config->Runtime.GetLangId(),
-							IDS_PINGTRACKER_END,
-							Utils::ToString(Pair.Source),
-							Utils::ToString(Pair.Destination));
-						break;
-					}
-
-					if (consecutiveFailureCount >= 10) {
-						logger->Format<LogLevel::Warning>(LogCategory::SocketHook,
-							config->Runtime.GetLangId(),
-							IDS_PINGTRACKER_END_FAILURE_COUNT,
-							Utils::ToString(Pair.Source),
-							Utils::ToString(Pair.Destination),
-							10);
-						break;
-					}
-				} while (true);
-			} catch (const std::exception& e) {
-				logger->Format<LogLevel::Error>(LogCategory::SocketHook,
-					config->Runtime.GetLangId(),
+	void Run() {
+		// Must outlive hIcmp, which cancels pending requests when closed.
+		std::vector<std::unique_ptr<Probe>> probes;
+
+		try {
+			const auto hIcmp = Utils::Win32::Icmp(IcmpCreateFile(), INVALID_HANDLE_VALUE);
+
+			std::vector<HANDLE> handles;
+			while (true) {
+				auto nextDueUs = INT64_MAX;
+				{
+					std::lock_guard lock(Mtx);
+					UpdateOptions();
+					nextDueUs = Scheduler.Poll(Utils::QpcUs(), MaxInFlight, [&](const ConnectionPair& pair, Utils::ProbeScheduler<ConnectionPair>::ProbeId probeId) {
+						auto it = std::ranges::find_if(probes, [](const auto& probe) { return !probe->InUse; });
+						if (it == probes.end())
+							it = probes.emplace(probes.end(), std::make_unique<Probe>());
+						Send(hIcmp, **it, pair, probeId);
+					});
+				}
+
+				handles.clear();
+				handles.push_back(ExitEvent);
+				handles.push_back(WakeEvent);
+				for (const auto& probe : probes) {
+					if (probe->InUse)
+						handles.push_back(probe->CompletionEvent);
+				}
+
+				const auto waitMs = nextDueUs == INT64_MAX ? INFINITE : static_cast<DWORD>(std::clamp<int64_t>((nextDueUs - Utils::QpcUs() + 999) / 1000, 0, INT32_MAX));
+				const auto res = WaitForMultipleObjects(static_cast<DWORD>(handles.size()), handles.data(), FALSE, waitMs);
+				if (res == WAIT_FAILED)
+					throw Utils::Win32::Error("WaitForMultipleObjects");
+				if (res == WAIT_OBJECT_0)
+					break;
+
+				// Take every reply that has arrived, not just the one that woke this up.
+				const auto nowUs = Utils::QpcUs();
+				std::lock_guard lock(Mtx);
+				for (const auto& probe : probes) {
+					if (probe->InUse && probe->CompletionEvent.Wait(0) == WAIT_OBJECT_0)
+						Receive(*probe, nowUs);
+				}
+			}
+		} catch (const std::exception& e) {
+			std::lock_guard lock(Mtx);
+			for (const auto& pair : Targets | std::views::keys) {
+				if (!Scheduler.Remove(pair))
+					continue;
+				Logger->Format<LogLevel::Error>(LogCategory::SocketHook,
+					Config->Runtime.GetLangId(),
 					IDS_PINGTRACKER_END_ERROR,
-					Utils::ToString(Pair.Source),
-					Utils::ToString(Pair.Destination),
+					Utils::ToString(pair.Source),
+					Utils::ToString(pair.Destination),
 					e.what());
 			}
 		}
-	};
-
-	Implementation()
-		: Logger(Misc::Logger::Acquire())
-		, Config(Config::Acquire()) {
 	}
 };
 
@@ -137,17 +200,30 @@ XivAlexander::Misc::IcmpPingTracker::~IcmpPingTracker() = default;
 
 Utils::CallOnDestruction XivAlexander::Misc::IcmpPingTracker::Track(const in_addr& source, const in_addr& destination) {
 	const auto pair = ConnectionPair{source, destination};
-	std::lock_guard _lock(m_pImpl->TrackersMtx);
-	if (const auto it = m_pImpl->Trackers.find(pair); it == m_pImpl->Trackers.end())
-		m_pImpl->Trackers.emplace(pair, std::make_shared<Implementation::SingleTracker>(*this, pair));
+	{
+		std::lock_guard _lock(m_pImpl->Mtx);
+		if (m_pImpl->Targets[pair].ReferenceCount++ == 0) {
+			m_pImpl->Scheduler.Add(pair, Utils::QpcUs());
+			m_pImpl->Log(IDS_PINGTRACKER_START, pair);
+		}
+	}
+	m_pImpl->WakeEvent.Set();
+
 	return Utils::CallOnDestruction([this, pair]() {
-		m_pImpl->Trackers.erase(pair);
+		std::lock_guard _lock(m_pImpl->Mtx);
+		const auto it = m_pImpl->Targets.find(pair);
+		if (--it->second.ReferenceCount)
+			return;
+		m_pImpl->Targets.erase(it);
+		if (m_pImpl->Scheduler.Remove(pair))
+			m_pImpl->Log(IDS_PINGTRACKER_END, pair);
 	});
 }
 
 const Utils::NumericStatisticsTracker* XivAlexander::Misc::IcmpPingTracker::GetTrackerUs(const in_addr& source, const in_addr& destination) const {
 	const auto pair = ConnectionPair{source, destination};
-	if (const auto it = m_pImpl->Trackers.find(pair); it != m_pImpl->Trackers.end())
-		return it->second->Tracker.get();
+	std::lock_guard _lock(m_pImpl->Mtx);
+	if (const auto it = m_pImpl->Targets.find(pair); it != m_pImpl->Targets.end())
+		return it->second.Tracker.get();
 	return nullptr;
 }
@@ -2,6 +2,7 @@
 #include "Misc/Logger.h"
 
 #include <XivAlexanderCommon/Sqex/CommandLine.h>
+#include <XivAlexanderCommon/Utils/LogStore.h>
 #include <XivAlexanderCommon/Utils/Win32/Handle.h>
 #include <XivAlexanderCommon/Utils/Win32/Process.h>
 #include <XivAlexanderCommon/Utils/Win32/Resource.h>
@@ -26,23 +27,40 @@ std::weak_ptr<XivAlexander::Misc::Logger> XivAlexander::Misc::Logger::s_instance
 
 struct XivAlexander::Misc::Logger::Implementation final {
 	static const int MaxLogCount = 128 * 1024;
+	static const size_t InMemoryLogCount = 64 * 1024;
+	static const size_t InMemoryLogBytes = 8 * 1024 * 1024;
+	static const size_t LogPageSize = 4096;
 	Logger& logger;
 	std::condition_variable m_threadTrigger;
 
 	bool m_bQuitting = false;
+	std::atomic_bool m_bDispatcherIdle = false;
 	std::mutex m_pendingItemLock;
 	std::mutex m_itemLock;
-	std::deque<LogItem> m_items, m_pendingItems;
-	uint64_t m_logIdCounter = 1;
+	std::deque<LogItem> m_pendingItems;
+	uint64_t m_lastStoredId = 0;
+
+	// Recent logs stay in memory; everything is also spilled to a temporary file so that older logs can be paged in.
+	std::unique_ptr<Utils::LogStore> m_store;
 
 	Utils::Win32::Thread m_hDispatcherThread;
 
 	Implementation(Logger& logger)
 		: logger(logger) {
+		try {
+			m_store = std::make_unique<Utils::LogStore>(InMemoryLogCount, InMemoryLogBytes,
+				std::filesystem::temp_directory_path() / std::format(L"XivAlexander.{}.{:x}.logs", GetCurrentProcessId(), reinterpret_cast<size_t>(this)));
+		} catch (const std::exception& e) {
+			Utils::Win32::DebugPrint(L"Logger: Keeping logs only in memory: {}", e.what());
+			m_store = std::make_unique<Utils::LogStore>(InMemoryLogCount, InMemoryLogBytes);
+		}
 	}
 
 	~Implementation() {
-		m_bQuitting = true;
+		{
+			std::lock_guard lock(m_pendingItemLock);
+			m_bQuitting = true;
+		}
 		m_threadTrigger.notify_all();
 		if (m_hDispatcherThread)
 			void(m_hDispatcherThread.Wait(INFINITE));
@@ -50,17 +68,66 @@ struct XivAlexander::Misc::Logger::Implementation final {
 
 	void AddLogItem(LogItem item) {
 		std::lock_guard lock(m_pendingItemLock);
-		item.id = m_logIdCounter++;
+		item.id = logger.m_nextLogId.fetch_add(1, std::memory_order_relaxed);
 		if (m_hDispatcherThread) {
 			m_pendingItems.push_back(std::move(item));
 			while (m_pendingItems.size() > MaxLogCount)
 				m_pendingItems.pop_front();
 			m_threadTrigger.notify_all();
 		} else {
-			m_items.push_back(item);
+			std::lock_guard lock2(m_itemLock);
+			StoreLogItem(item);
 		}
 	}
 
+	// Must be called with m_itemLock held.
+	void StoreLogItem(const LogItem& item) {
+		m_lastStoredId = item.id;
+		m_store->Append(item.id, item.timestamp.time_since_epoch().count(), static_cast<uint8_t>(item.category), static_cast<uint8_t>(item.level), item.log);
+	}
+
+	// Must be called with m_itemLock held.
+	std::deque<LogItem> ReadLogItems(uint64_t fromId, size_t count) const {
+		std::deque<LogItem> items;
+		m_store->Read(fromId, count, [&items](const Utils::LogStore::RecordView& r) {
+			items.push_back(LogItem{
+				r.Id,
+				static_cast<LogCategory>(r.Category),
+				std::chrono::system_clock::time_point(std::chrono::system_clock::duration(r.Timestamp)),
+				static_cast<LogLevel>(r.Level),
+				std::string(r.Text),
+			});
+		});
+		return items;
+	}
+
+	void NotifyDeferredRecord() {
+		// Pairs with the fence in the dispatcher thread; either it sees the new record, or we see it idle.
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (!m_bDispatcherIdle.load(std::memory_order_relaxed))
+			return;
+
+		std::lock_guard lock(m_pendingItemLock);
+		m_threadTrigger.notify_all();
+	}
+
+	// Must be called only from the dispatcher thread.
+	void FormatDeferredRecords(std::deque<LogItem>& items) {
+		logger.m_deferredRecords.Drain([&items](const DeferredRecordMeta& meta, DeferredRecordQueue::FormattedText& text) {
+			auto log = std::holds_alternative<std::string>(text)
+				? std::move(std::get<std::string>(text))
+				: Utils::ToUtf8(std::get<std::wstring>(text));
+			OutputDebugStringW(std::format(L"{}\n", log).c_str());
+			items.push_back(LogItem{
+				meta.Id,
+				meta.Category,
+				meta.Timestamp,
+				meta.Level,
+				std::move(log),
+			});
+		});
+	}
+
 	void StartDispatcher() {
 		if (m_hDispatcherThread)
 			return;
@@ -74,26 +141,46 @@ struct XivAlexander::Misc::Logger::Implementation final {
 		), [this]() {
 			while (true) {
 				std::deque<LogItem> pendingItems;
+				FormatDeferredRecords(pendingItems);
 				{
 					std::unique_lock lock(m_pendingItemLock);
-					if (m_pendingItems.empty()) {
-						m_threadTrigger.wait(lock);
-						if (m_bQuitting)
-							return;
+					if (m_bQuitting)
+						return;
+
+					if (pendingItems.empty() && m_pendingItems.empty()) {
+						m_bDispatcherIdle.store(true, std::memory_order_relaxed);
+						std::atomic_thread_fence(std::memory_order_seq_cst);
+						if (logger.m_deferredRecords.Empty())
+							m_threadTrigger.wait(lock);
+						m_bDispatcherIdle.store(false, std::memory_order_relaxed);
+						continue;
 					}
-					pendingItems = std::move(m_pendingItems);
+
+					std::ranges::move(m_pendingItems, std::back_inserter(pendingItems));
+					m_pendingItems.clear();
 				}
+
+				// Both sources took their ids when they were logged; store them in that order.
+				std::ranges::sort(pendingItems, {}, &LogItem::id);
+				while (pendingItems.size() > MaxLogCount)
+					pendingItems.pop_front();
 				{
 					std::lock_guard lock(m_itemLock);
-					for (auto& item : pendingItems) {
-						m_items.push_back(item);
-						if (m_items.size() > MaxLogCount)
-							m_items.pop_front();
-					}
+
+					// A deferred record still being pushed when a later one got stored has missed its place; store it as the newest instead,
+					// as ids in the store must keep increasing.
+					const auto late = std::ranges::upper_bound(pendingItems, m_lastStoredId, {}, &LogItem::id) - pendingItems.begin();
+					std::rotate(pendingItems.begin(), pendingItems.begin() + late, pendingItems.end());
+					for (auto it = pendingItems.end() - late; it != pendingItems.end(); ++it)
+						it->id = logger.m_nextLogId.fetch_add(1, std::memory_order_relaxed);
+
+					for (const auto& item : pendingItems)
+						StoreLogItem(item);
 				}
 				logger.OnNewLogItem(pendingItems);
 			}
 		});
+		logger.m_deferredRecordsEnabled = true;
 	}
 };
 
@@ -121,7 +208,7 @@ XivAlexander::Misc::Logger::Logger()
 	: m_pImpl(std::make_unique<Implementation>(*this))
 	, OnNewLogItem([this](const auto& cb) {
 		std::lock_guard lock(m_pImpl->m_itemLock);
-		cb(m_pImpl->m_items);
+		cb(m_pImpl->ReadLogItems(m_pImpl->m_store->FirstInMemoryId(), m_pImpl->m_store->InMemoryCount()));
 		m_pImpl->StartDispatcher();
 	}) {
 	Utils::Win32::DebugPrint(L"Logger: New");
@@ -145,6 +232,8 @@ XivAlexander::Misc::Logger::~Logger() {
 }
 
 void XivAlexander::Misc::Logger::Log(LogCategory category, const char* s, LogLevel level) {
+	if (!IsEnabled(category, level))
+		return;
 	Log(category, std::string(s), level);
 }
 
@@ -153,10 +242,14 @@ void XivAlexander::Misc::Logger::Log(LogCategory category, const char8_t* s, Log
 }
 
 void XivAlexander::Misc::Logger::Log(LogCategory category, const wchar_t* s, LogLevel level) {
+	if (!IsEnabled(category, level))
+		return;
 	Log(category, Utils::ToUtf8(s), level);
 }
 
 void XivAlexander::Misc::Logger::Log(LogCategory category, const std::string& s, LogLevel level) {
+	if (!IsEnabled(category, level))
+		return;
 	OutputDebugStringW(std::format(L"{}\n", s).c_str());
 	m_pImpl->AddLogItem(LogItem{
 		0,
@@ -168,20 +261,35 @@ void XivAlexander::Misc::Logger::Log(LogCategory category, const std::string& s,
 }
 
 void XivAlexander::Misc::Logger::Log(LogCategory category, const std::wstring& s, LogLevel level) {
+	if (!IsEnabled(category, level))
+		return;
 	Log(category, Utils::ToUtf8(s), level);
 }
 
 void XivAlexander::Misc::Logger::Log(LogCategory category, WORD wLanguage, UINT uStringResId, LogLevel level) {
+	if (!IsEnabled(category, level))
+		return;
 	Log(category, FindStringResourceEx(Dll::Module(), uStringResId, wLanguage) + 1, level);
 }
 
 void XivAlexander::Misc::Logger::Clear() {
-	std::lock_guard lock(m_pImpl->m_itemLock);
-	std::lock_guard lock2(m_pImpl->m_pendingItemLock);
-	m_pImpl->m_items.clear();
+	std::scoped_lock lock(m_pImpl->m_itemLock, m_pImpl->m_pendingItemLock);
+	m_pImpl->m_store->Clear();
 	m_pImpl->m_pendingItems.clear();
 }
 
+void XivAlexander::Misc::Logger::SetMinimumLevel(LogCategory category, LogLevel level) {
+	m_minimumLevels[static_cast<size_t>(category)] = level;
+}
+
+XivAlexander::LogLevel XivAlexander::Misc::Logger::GetMinimumLevel(LogCategory category) const {
+	return m_minimumLevels[static_cast<size_t>(category)];
+}
+
+void XivAlexander::Misc::Logger::OnDeferredRecordPushed() {
+	m_pImpl->NotifyDeferredRecord();
+}
+
 void XivAlexander::Misc::Logger::AskAndExportLogs(HWND hwndDialogParent, std::string_view heading, std::string_view preformatted) {
 	static const COMDLG_FILTERSPEC saveFileTypes[] = {
 		{FindStringResourceEx(Dll::Module(), IDS_FILTERSPEC_LOGFILES) + 1, L"*.log"},
@@ -367,8 +475,17 @@ void XivAlexander::Misc::Logger::AskAndExportLogs(HWND hwndDialogParent, std::st
 }
 
 void XivAlexander::Misc::Logger::WithLogs(const std::function<void(const std::deque<LogItem>& items)>& cb) const {
-	std::lock_guard lock(m_pImpl->m_itemLock);
-	cb(m_pImpl->m_items);
+	for (uint64_t nextId = 0;;) {
+		std::deque<LogItem> items;
+		{
+			std::lock_guard lock(m_pImpl->m_itemLock);
+			items = m_pImpl->ReadLogItems(nextId, Implementation::LogPageSize);
+		}
+		if (items.empty())
+			return;
+		nextId = items.back().id + 1;
+		cb(items);
+	}
 }
 
 const wchar_t* XivAlexander::Misc::Logger::GetStringResource(UINT uStringResFormatId, WORD wLanguage) {
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <XivAlexanderCommon/Utils/DeferredFormatQueue.h>
 #include <XivAlexanderCommon/Utils/ListenerManager.h>
 #include <XivAlexanderCommon/Utils/Win32/Resource.h>
 
@@ -22,6 +23,9 @@ namespace XivAlexander {
 		MusicImporter,
 		PatchCode,
 	};
+
+	// Update when adding a new LogCategory.
+	constexpr size_t LogCategoryCount = static_cast<size_t>(LogCategory::PatchCode) + 1;
 }
 
 namespace XivAlexander::Misc {
@@ -41,6 +45,23 @@ namespace XivAlexander::Misc {
 		};
 
 	protected:
+		struct DeferredRecordMeta {
+			uint64_t Id;
+			LogCategory Category;
+			LogLevel Level;
+			std::chrono::system_clock::time_point Timestamp;
+		};
+
+		using DeferredRecordQueue = Utils::DeferredFormatQueue<DeferredRecordMeta>;
+
+		// Declared before m_pImpl, so that the dispatcher thread is gone before this gets destroyed.
+		DeferredRecordQueue m_deferredRecords{ 4096 };
+		std::atomic_bool m_deferredRecordsEnabled = false;
+		std::array<std::atomic<LogLevel>, LogCategoryCount> m_minimumLevels{};
+
+		// Taken when a record is logged, whether it is formatted right away or deferred, so that both can be stored in the order they were logged.
+		std::atomic<uint64_t> m_nextLogId = 1;
+
 		struct Implementation;
 		const std::unique_ptr<Implementation> m_pImpl;
 
@@ -66,23 +87,56 @@ namespace XivAlexander::Misc {
 		void Log(LogCategory category, WORD wLanguage, UINT uStringResId, LogLevel level = LogLevel::Info);
 		void Clear();
 
+		void SetMinimumLevel(LogCategory category, LogLevel level);
+		[[nodiscard]] LogLevel GetMinimumLevel(LogCategory category) const;
+
+		[[nodiscard]] bool IsEnabled(LogCategory category, LogLevel level) const {
+			return level >= m_minimumLevels[static_cast<size_t>(category)].load(std::memory_order_relaxed);
+		}
+
 		void AskAndExportLogs(HWND hwndDialogParent, std::string_view heading = std::string_view(), std::string_view preformatted = std::string_view());
 
+		// Calls cb once per page, from the oldest log, including the ones no longer kept in memory.
 		void WithLogs(const std::function<void(const std::deque<LogItem>& items)>& cb) const;
 		Utils::ListenerManager<Logger, void, const std::deque<LogItem>&> OnNewLogItem;
 
+	private:
+		void OnDeferredRecordPushed();
+
+		// Captures arguments to be formatted in the dispatcher thread. format must have static storage duration.
+		template <typename CharT, typename ... Args>
+		bool TryDefer(LogCategory category, LogLevel level, const CharT* format, Args&&...args) {
+			if constexpr (!DeferredRecordQueue::IsDeferrable<CharT, Args...>) {
+				return false;
+			} else {
+				if (!m_deferredRecordsEnabled.load(std::memory_order_relaxed))
+					return false;
+				if (!m_deferredRecords.TryPush(DeferredRecordMeta{ m_nextLogId.fetch_add(1, std::memory_order_relaxed), category, level, std::chrono::system_clock::now() }, format, std::forward<Args>(args)...))
+					return false;
+				OnDeferredRecordPushed();
+				return true;
+			}
+		}
+
+	public:
 		template <LogLevel Level = LogLevel::Info, typename ... Args>
 		void Format(LogCategory category, const char* format, Args&&...args) {
+			if (!IsEnabled(category, Level) || TryDefer(category, Level, format, std::forward<Args>(args)...))
+				return;
 			Log(category, std::vformat(format, std::make_format_args(std::forward<Args&>(args)...)), Level);
 		}
 
 		template <LogLevel Level = LogLevel::Info, typename ... Args>
 		void Format(LogCategory category, const wchar_t* format, Args&&...args) {
+			if (!IsEnabled(category, Level) || TryDefer(category, Level, format, std::forward<Args>(args)...))
+				return;
 			Log(category, std::vformat(format, std::make_wformat_args(std::forward<Args&>(args)...)), Level);
 		}
 
 		template <LogLevel Level = LogLevel::Info, typename ... Args>
 		void Format(LogCategory category, const char8_t* format, Args&&...args) {
+			if (!IsEnabled(category, Level) || TryDefer(category, Level, reinterpret_cast<const char*>(format), std::forward<Args>(args)...))
+				return;
 			Log(category, std::vformat(reinterpret_cast<const char*>(format), std::make_format_args(std::forward<Args&>(args)...)), Level);
 		}
 
@@ -92,12 +146,22 @@ namespace XivAlexander::Misc {
 	public:
 		template <LogLevel Level = LogLevel::Info, typename ... Args>
 		void Format(LogCategory category, WORD wLanguage, UINT uStringResFormatId, Args&&...args) {
-			Log(category, std::vformat(GetStringResource(uStringResFormatId, wLanguage), std::make_wformat_args(std::forward<Args&>(args)...)), Level);
+			if (!IsEnabled(category, Level))
+				return;
+			const auto format = GetStringResource(uStringResFormatId, wLanguage);
+			if (TryDefer(category, Level, format, std::forward<Args>(args)...))
+				return;
+			Log(category, std::vformat(format, std::make_wformat_args(std::forward<Args&>(args)...)), Level);
 		}
 
 		template <LogLevel Level = LogLevel::Info, typename ... Args>
 		void FormatDefaultLanguage(LogCategory category, UINT uStringResFormatId, Args&&...args) {
-			Log(category, std::vformat(GetStringResource(uStringResFormatId), std::make_wformat_args(std::forward<Args&>(args)...)), Level);
+			if (!IsEnabled(category, Level))
+				return;
+			const auto format = GetStringResource(uStringResFormatId);
+			if (TryDefer(category, Level, format, std::forward<Args>(args)...))
+				return;
+			Log(category, std::vformat(format, std::make_wformat_args(std::forward<Args&>(args)...)), Level);
 		}
 	};
 }
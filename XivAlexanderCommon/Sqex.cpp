@@ -131,19 +131,6 @@ void Sqex::from_json(const nlohmann::json& j, GameReleaseRegion& newValue) {
 		newValue = GameReleaseRegion::Korean;
 }
 
-Sqex::RandomAccessStream::RandomAccessStream() = default;
-
-Sqex::RandomAccessStream::~RandomAccessStream() = default;
-
-uint64_t Sqex::RandomAccessStream::ReadStreamPartial(uint64_t offset, void* buf, uint64_t length) const {
-	return ReadStreamPartial(offset, buf, length);
-}
-
-void Sqex::RandomAccessStream::ReadStream(uint64_t offset, void* buf, uint64_t length) const {
-	if (ReadStreamPartial(offset, buf, length) != length)
-		throw std::runtime_error("Reached end of stream before reading all of the requested data.");
-}
-
 Sqex::BufferedRandomAccessStream::~BufferedRandomAccessStream() {
 	for (const auto addr : m_buffers)
 		if (addr)
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <algorithm>
 #include <cstdint>
 #include <map>
 #include <span>
@@ -124,5 +125,27 @@ namespace Sqex::Est {
 				i++;
 			}
 		}
+
+		// Same ordering and duplicate handling as ToPairs, without going through a std::map.
+		std::vector<std::pair<EntryDescriptor, uint16_t>> ToSortedPairs() const {
+			std::vector<std::pair<EntryDescriptor, uint16_t>> res;
+			res.reserve(Count());
+			for (size_t i = 0, i_ = Count(); i < i_; ++i)
+				res.emplace_back(Descriptor(i), SkelId(i));
+			std::ranges::stable_sort(res, [](const auto& l, const auto& r) { return l.first < r.first; });
+			res.erase(std::ranges::unique(res, [](const auto& l, const auto& r) { return l.first == r.first; }).begin(), res.end());
+			return res;
+		}
+
+		// pairs must be sorted by descriptor and contain no duplicates.
+		void Update(std::span<const std::pair<EntryDescriptor, uint16_t>> pairs) {
+			m_data.resize(4 + pairs.size() * 6);
+			Count() = static_cast<uint32_t>(pairs.size());
+
+			for (size_t i = 0; i < pairs.size(); ++i) {
+				Descriptor(i) = pairs[i].first;
+				SkelId(i) = pairs[i].second;
+			}
+		}
 	};
 }
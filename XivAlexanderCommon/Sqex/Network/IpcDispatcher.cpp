@@ -0,0 +1,150 @@
+#include "pch.h"
+#include "XivAlexanderCommon/Sqex/Network/IpcDispatcher.h"
+
+uint64_t Sqex::Network::IpcDispatcher::KeyOf(Structure::IpcType type, uint64_t subType, uint64_t length, uint64_t wildcardBits) {
+	return (static_cast<uint64_t>(type) << 48)
+		| (wildcardBits & AnySubTypeBit ? 0 : subType << 32)
+		| wildcardBits
+		| (wildcardBits & AnyLengthBit ? 0 : length);
+}
+
+uint64_t Sqex::Network::IpcDispatcher::KeyOf(const Filter& filter) {
+	if (filter.Length && *filter.Length >= AnySubTypeBit)
+		throw std::invalid_argument("length too large");
+
+	return KeyOf(filter.Type,
+		filter.SubType.value_or(0),
+		filter.Length.value_or(0),
+		(filter.SubType ? 0 : AnySubTypeBit) | (filter.Length ? 0 : AnyLengthBit));
+}
+
+bool Sqex::Network::IpcDispatcher::TestBit(const std::vector<uint64_t>& bits, size_t index) {
+	return bits[(index >> 6) & 0x3FF] & (1ULL << (index & 63));
+}
+
+size_t Sqex::Network::IpcDispatcher::Hash(uint64_t key) const {
+	// Type and subtype live in the upper half of the key, so fold them down before multiplying.
+	return static_cast<size_t>(((key ^ (key >> 32)) * 0x9E3779B97F4A7C15ULL) >> m_shift);
+}
+
+const Sqex::Network::IpcDispatcher::Route* Sqex::Network::IpcDispatcher::Find(uint64_t key) const {
+	const auto mask = m_keys.size() - 1;
+	for (auto index = Hash(key); m_keys[index] != EmptyKey; index = (index + 1) & mask) {
+		if (m_keys[index] == key)
+			return &m_routes[m_routeIndices[index]];
+	}
+	return nullptr;
+}
+
+void Sqex::Network::IpcDispatcher::Rebuild() {
+	std::erase_if(m_routes, [](const Route& route) { return route.Registrations.empty(); });
+
+	// Keep the table at most half full, so that a miss usually stops at the first slot.
+	const auto capacity = std::bit_ceil(std::max<size_t>(16, m_routes.size() * 2));
+	m_keys.assign(capacity, EmptyKey);
+	m_routeIndices.assign(capacity, 0);
+	m_shift = 64 - std::countr_zero(static_cast<uint64_t>(capacity));
+	m_subTypeBits.assign(1024, 0);
+	m_lengthBits.assign(1024, 0);
+	m_hasExact = m_hasSubTypeOnly = m_hasLengthOnly = false;
+	m_subTypeAnyActor = m_lengthAnyActor = false;
+	m_typeRoutes.clear();
+
+	for (size_t i = 0; i < m_routes.size(); ++i) {
+		const auto key = m_routes[i].Key;
+		const auto subType = static_cast<uint16_t>(key >> 32);
+		const auto length = static_cast<uint32_t>(key & (AnySubTypeBit - 1));
+		const auto anyActor = std::ranges::any_of(m_routes[i].Registrations, [](const Registration& r) { return !r.CurrentActorOnly; });
+
+		switch (key & (AnySubTypeBit | AnyLengthBit)) {
+			case 0:
+				m_hasExact = true;
+				m_subTypeAnyActor |= anyActor;
+				m_subTypeBits[subType >> 6] |= 1ULL << (subType & 63);
+				break;
+			case AnyLengthBit:
+				m_hasSubTypeOnly = true;
+				m_subTypeAnyActor |= anyActor;
+				m_subTypeBits[subType >> 6] |= 1ULL << (subType & 63);
+				break;
+			case AnySubTypeBit:
+				m_hasLengthOnly = true;
+				m_lengthAnyActor |= anyActor;
+				m_lengthBits[(length >> 6) & 0x3FF] |= 1ULL << (length & 63);
+				break;
+			default:
+				m_typeRoutes.emplace_back(static_cast<Structure::IpcType>(key >> 48), static_cast<uint32_t>(i));
+				continue;
+		}
+
+		auto index = Hash(key);
+		while (m_keys[index] != EmptyKey)
+			index = (index + 1) & (capacity - 1);
+		m_keys[index] = key;
+		m_routeIndices[index] = static_cast<uint32_t>(i);
+	}
+}
+
+Sqex::Network::IpcDispatcher::IpcDispatcher() {
+	Rebuild();
+}
+
+void Sqex::Network::IpcDispatcher::Add(void* token, const Filter& filter, Handler handler) {
+	const auto key = KeyOf(filter);
+	auto it = std::ranges::find_if(m_routes, [key](const Route& route) { return route.Key == key; });
+	if (it == m_routes.end())
+		it = m_routes.insert(m_routes.end(), Route{ key });
+	it->Registrations.emplace_back(Registration{ token, std::move(handler), filter.CurrentActorOnly });
+	Rebuild();
+}
+
+void Sqex::Network::IpcDispatcher::Add(void* token, Handler handler) {
+	m_catchAll.emplace_back(Registration{ token, std::move(handler) });
+}
+
+void Sqex::Network::IpcDispatcher::Remove(void* token) {
+	const auto byToken = [token](const Registration& r) { return r.Token == token; };
+	for (auto& route : m_routes)
+		std::erase_if(route.Registrations, byToken);
+	std::erase_if(m_catchAll, byToken);
+	Rebuild();
+}
+
+bool Sqex::Network::IpcDispatcher::Dispatch(Structure::XivMessage* pMessage) const {
+	auto use = true;
+	const auto currentActor = pMessage->CurrentActor == pMessage->SourceActor;
+	const auto call = [&use, pMessage, currentActor](const Route* route) {
+		if (!route)
+			return;
+		for (const auto& registration : route->Registrations) {
+			if (currentActor || !registration.CurrentActorOnly)
+				use &= registration.Callback(pMessage);
+		}
+	};
+
+	const auto type = pMessage->Data.Ipc.Type;
+	const auto subType = pMessage->Data.Ipc.SubType;
+	const auto length = pMessage->Length;
+	if (length < AnySubTypeBit) {
+		if ((currentActor || m_subTypeAnyActor) && TestBit(m_subTypeBits, subType)) {
+			if (m_hasExact)
+				call(Find(KeyOf(type, subType, length, 0)));
+			if (m_hasSubTypeOnly)
+				call(Find(KeyOf(type, subType, 0, AnyLengthBit)));
+		}
+		if (m_hasLengthOnly && (currentActor || m_lengthAnyActor) && TestBit(m_lengthBits, length))
+			call(Find(KeyOf(type, 0, length, AnySubTypeBit)));
+	}
+
+	for (const auto& [routeType, routeIndex] : m_typeRoutes) {
+		if (routeType == type)
+			call(&m_routes[routeIndex]);
+	}
+
+	if (!m_catchAll.empty()) {
+		for (const auto& registration : m_catchAll)
+			use &= registration.Callback(pMessage);
+	}
+
+	return use;
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "XivAlexanderCommon/Sqex/Network/Structure.h"
+
+namespace Sqex::Network {
+	// Calls only the handlers registered for the type, subtype and length of an IPC message,
+	// instead of having every handler look at every message.
+	// Not thread safe; add, remove, and dispatch from the same thread.
+	class IpcDispatcher {
+	public:
+		// Return false to drop the message.
+		using Handler = std::function<bool(Structure::XivMessage*)>;
+
+		// Leave SubType or Length empty to match any.
+		struct Filter {
+			Structure::IpcType Type = Structure::IpcType::InterestedType;
+			std::optional<uint16_t> SubType;
+			std::optional<uint32_t> Length;
+
+			// Match only messages about the current player (CurrentActor == SourceActor).
+			bool CurrentActorOnly = false;
+		};
+
+	private:
+		static constexpr uint64_t AnyLengthBit = 1ULL << 31;
+		static constexpr uint64_t AnySubTypeBit = 1ULL << 30;
+		static constexpr uint64_t EmptyKey = UINT64_MAX;
+
+		struct Registration {
+			void* Token;
+			Handler Callback;
+			bool CurrentActorOnly = false;
+		};
+
+		struct Route {
+			uint64_t Key;
+			std::vector<Registration> Registrations;
+		};
+
+		std::vector<Route> m_routes;
+		std::vector<Registration> m_catchAll;
+
+		// Open-addressed table from keys to indices into m_routes, for routes with a subtype or a length.
+		std::vector<uint64_t> m_keys;
+		std::vector<uint32_t> m_routeIndices;
+		int m_shift = 0;
+
+		// Set if any route may match a subtype or a length (modulo 65536), so that most messages skip the table altogether.
+		std::vector<uint64_t> m_subTypeBits;
+		std::vector<uint64_t> m_lengthBits;
+		bool m_hasExact = false;
+		bool m_hasSubTypeOnly = false;
+		bool m_hasLengthOnly = false;
+
+		// Set if any route of the tier takes messages about other actors too. Most handlers do not,
+		// and most messages are about other actors, so checking that first skips the bitmaps for most messages.
+		bool m_subTypeAnyActor = false;
+		bool m_lengthAnyActor = false;
+
+		// Routes that match every subtype and length of a type; there are only a few of them.
+		std::vector<std::pair<Structure::IpcType, uint32_t>> m_typeRoutes;
+
+		static uint64_t KeyOf(Structure::IpcType type, uint64_t subType, uint64_t length, uint64_t wildcardBits);
+		static uint64_t KeyOf(const Filter& filter);
+		static bool TestBit(const std::vector<uint64_t>& bits, size_t index);
+
+		size_t Hash(uint64_t key) const;
+		const Route* Find(uint64_t key) const;
+		void Rebuild();
+
+	public:
+		IpcDispatcher();
+
+		void Add(void* token, const Filter& filter, Handler handler);
+
+		// Catch-all handlers see every IPC message, after the handlers registered with a filter.
+		void Add(void* token, Handler handler);
+
+		void Remove(void* token);
+
+		// Calls every matching handler, even after one returned false, from the most specific filter:
+		// subtype and length, subtype only, length only, type only, and then catch-all.
+		// Returns false if any handler wants the message dropped.
+		bool Dispatch(Structure::XivMessage* pMessage) const;
+	};
+}
@@ -6,6 +6,13 @@
 #include "Utils/Oodle.h"
 #include "Utils/ZlibWrapper.h"
 
+#include <bit>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define XIVALEX_NETWORK_SSE2
+#include <emmintrin.h>
+#endif
+
 const uint8_t Sqex::Network::Structure::XivBundle::MagicConstant1[]{
 	0x52, 0x52, 0xa0, 0x41,
 	0xff, 0x5d, 0x46, 0xe2,
@@ -19,15 +26,52 @@ const uint8_t Sqex::Network::Structure::XivBundle::MagicConstant2[]{
 	0, 0, 0, 0,
 };
 
-std::span<const uint8_t> Sqex::Network::Structure::XivBundle::ExtractFrontTrash(const std::span<const uint8_t>& buf) {
-	const auto searchLength = std::min(sizeof Magic, buf.size());
-	return {
-		buf.begin(),
-		std::min(
-			std::search(buf.begin(), buf.end(), MagicConstant1, MagicConstant1 + searchLength),
-			std::search(buf.begin(), buf.end(), MagicConstant2, MagicConstant2 + searchLength)
-		)
-	};
+// Whether a bundle may start at p, given that only available bytes have arrived.
+// Anything may end with a zero or two, so a part of a magic counts only if allowed.
+static bool IsBundleCandidate(const uint8_t* p, size_t available, bool allowPartialMagic) {
+	using namespace Sqex::Network::Structure;
+
+	if (!allowPartialMagic && available < sizeof XivBundle::MagicConstant1)
+		return false;
+
+	const auto magicLength = std::min(sizeof XivBundle::MagicConstant1, available);
+	if (memcmp(p, XivBundle::MagicConstant1, magicLength) != 0 && memcmp(p, XivBundle::MagicConstant2, magicLength) != 0)
+		return false;
+
+	// A bundle cannot be shorter than its header.
+	return available < sizeof XivBundleHeader || reinterpret_cast<const XivBundleHeader*>(p)->TotalLength >= sizeof XivBundleHeader;
+}
+
+std::span<const uint8_t> Sqex::Network::Structure::XivBundle::ExtractFrontTrash(const std::span<const uint8_t>& buf, bool keepPartialMagic) {
+	const auto p = buf.data();
+	const auto size = buf.size();
+	size_t i = 0;
+
+#ifdef XIVALEX_NETWORK_SSE2
+	// Look at 16 offsets at once, and only check the offsets whose first two bytes match either magic in full.
+	const auto magic1First = _mm_set1_epi8(static_cast<char>(MagicConstant1[0]));
+	const auto magic1Second = _mm_set1_epi8(static_cast<char>(MagicConstant1[1]));
+	const auto magic2First = _mm_set1_epi8(static_cast<char>(MagicConstant2[0]));
+	const auto magic2Second = _mm_set1_epi8(static_cast<char>(MagicConstant2[1]));
+	for (; i + 17 <= size; i += 16) {
+		const auto first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+		const auto second = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i + 1));
+		const auto matches = _mm_or_si128(
+			_mm_and_si128(_mm_cmpeq_epi8(first, magic1First), _mm_cmpeq_epi8(second, magic1Second)),
+			_mm_and_si128(_mm_cmpeq_epi8(first, magic2First), _mm_cmpeq_epi8(second, magic2Second)));
+		for (auto mask = static_cast<uint32_t>(_mm_movemask_epi8(matches)); mask; mask &= mask - 1) {
+			const auto offset = i + std::countr_zero(mask);
+			if (IsBundleCandidate(p + offset, size - offset, keepPartialMagic || offset == 0))
+				return buf.subspan(0, offset);
+		}
+	}
+#endif
+
+	for (; i < size; ++i) {
+		if (IsBundleCandidate(p + i, size - i, keepPartialMagic || i == 0))
+			return buf.subspan(0, i);
+	}
+	return buf;
 }
 
 std::string Sqex::Network::Structure::XivBundle::Represent() const {
@@ -41,36 +85,52 @@ std::string Sqex::Network::Structure::XivBundle::Represent() const {
 	);
 }
 
-std::vector<std::vector<uint8_t>> Sqex::Network::Structure::XivBundle::SplitMessages(uint16_t expectedMessageCount, const std::span<const uint8_t>& buf) {
-	std::vector<std::vector<uint8_t>> result;
-	result.reserve(expectedMessageCount);
-	for (size_t i = 0; i < buf.size();) {
-		const auto& message = *reinterpret_cast<const XivMessage*>(&buf[i]);
-		if (i + message.Length > buf.size() || !message.Length)
-			throw std::runtime_error("Could not parse game message (sum(message.length for each message) > total message length)");
-
-		const auto sub = buf.subspan(i, static_cast<size_t>(message.Length));
-		result.emplace_back(sub.begin(), sub.end());
-		i += message.Length;
-	}
-	return result;
-}
-
-std::vector<std::vector<uint8_t>> Sqex::Network::Structure::XivBundle::GetMessages(Utils::ZlibReusableInflater& inflater, Utils::Oodle::Oodler& oodler) const {
+std::span<uint8_t> Sqex::Network::Structure::XivBundle::DecodeBody(Utils::ZlibReusableInflater& inflater, Utils::Oodle::Oodler& oodler, std::vector<uint8_t>& arena) const {
 	const auto view = std::span(Data, TotalLength - sizeof XivBundleHeader);
 
 	switch (CompressionType) {
 		case CompressionType::None:
-			return SplitMessages(MessageCount, view);
+			if (arena.size() < view.size())
+				arena.resize(view.size());
+			memcpy(arena.data(), view.data(), view.size());
+			return std::span(arena).subspan(0, view.size());
 		case CompressionType::Deflate:
-			return SplitMessages(MessageCount, inflater(view));
+			return inflater.Inflate(view, arena);
 		case CompressionType::Oodle:
-			return SplitMessages(MessageCount, oodler.Decode(view, DecodedBodyLength));
+			if (arena.size() < DecodedBodyLength)
+				arena.resize(DecodedBodyLength);
+			return oodler.Decode(view, std::span(arena).subspan(0, DecodedBodyLength));
 		default:
 			throw CorruptDataException(std::format("Unsupported compression type {}", static_cast<int>(CompressionType)));
 	}
 }
 
+std::pair<std::span<uint8_t>, uint16_t> Sqex::Network::Structure::XivBundle::FilterMessages(std::span<uint8_t> body, const std::function<bool(XivMessage*)>& filter) {
+	// Step. Make sure that every message is within body, before letting filter see any of them.
+	for (size_t i = 0; i < body.size();) {
+		const auto length = reinterpret_cast<const XivMessage*>(&body[i])->Length;
+		if (!length || length > body.size() - i)
+			throw std::runtime_error("Could not parse game message (sum(message.length for each message) > total message length)");
+		i += length;
+	}
+
+	// Step. Filter in place, and move kept messages over dropped ones.
+	size_t keptLength = 0;
+	uint16_t keptCount = 0;
+	for (size_t i = 0; i < body.size();) {
+		const auto pMessage = reinterpret_cast<XivMessage*>(&body[i]);
+		const auto length = pMessage->Length;
+		if (filter(pMessage) && pMessage->Length) {
+			if (keptLength != i)
+				memmove(&body[keptLength], &body[i], length);
+			keptLength += length;
+			keptCount++;
+		}
+		i += length;
+	}
+	return { body.subspan(0, keptLength), keptCount };
+}
+
 std::string Sqex::Network::Structure::XivMessage::Represent(bool dump) const {
 	std::string dumpstr;
 	if (Type == MessageType::ClientKeepAlive || Type == MessageType::ServerKeepAlive) {
@@ -240,11 +240,23 @@ namespace Sqex::Network::Structure {
 
 		static const uint8_t MagicConstant1[sizeof Magic];
 		static const uint8_t MagicConstant2[sizeof Magic];
-		[[nodiscard]] static std::span<const uint8_t> ExtractFrontTrash(const std::span<const uint8_t>& buf);
+
+		// Returns the bytes before where the next bundle may start, in one pass over buf.
+		// A bundle may start where either magic appears with a TotalLength no shorter than the header,
+		// or where buf ends with a part of such a header, in which case more data is needed to tell.
+		// A part of a magic at the end is waited for only if keepPartialMagic is set, as when the stream is known to carry bundles,
+		// or if it is all there is in buf.
+		[[nodiscard]] static std::span<const uint8_t> ExtractFrontTrash(const std::span<const uint8_t>& buf, bool keepPartialMagic = false);
 
 		std::string Represent() const;
 
-		[[nodiscard]] static std::vector<std::vector<uint8_t>> SplitMessages(uint16_t expectedMessageCount, const std::span<const uint8_t>& buf);
-		[[nodiscard]] std::vector<std::vector<uint8_t>> GetMessages(Utils::ZlibReusableInflater&, Utils::Oodle::Oodler&) const;
+		// Decodes the body into arena, which is only ever grown, so that decoding does not allocate once it is large enough.
+		[[nodiscard]] std::span<uint8_t> DecodeBody(Utils::ZlibReusableInflater&, Utils::Oodle::Oodler&, std::vector<uint8_t>& arena) const;
+
+		// Calls filter on each message of a decoded body in place, and moves the messages it keeps to the front of body.
+		// A message is dropped if filter returns false or sets its Length to 0.
+		// Throws without calling filter if the body cannot be split into messages.
+		// Returns the kept messages and their count.
+		[[nodiscard]] static std::pair<std::span<uint8_t>, uint16_t> FilterMessages(std::span<uint8_t> body, const std::function<bool(XivMessage*)>& filter);
 	};
 }
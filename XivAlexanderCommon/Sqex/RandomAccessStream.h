@@ -0,0 +1,244 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <format>
+#include <functional>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "XivAlexanderCommon/Utils/Endian.h"
+
+namespace Sqex {
+	using namespace Utils;
+
+	class CorruptDataException : public std::runtime_error {
+	public:
+		using std::runtime_error::runtime_error;
+	};
+
+	static constexpr uint32_t EntryAlignment = 128;
+
+	template<typename T, typename CountT = T>
+	struct AlignResult {
+		CountT Count;
+		T Value;
+		T By;
+		T Alloc;
+		T Pad;
+		T Last;
+
+		operator T() const {
+			return Alloc;
+		}
+
+		void IterateChunkedBreakable(std::function<bool(CountT, T, T)> cb, T baseOffset = 0, CountT baseIndex = 0) const {
+			if (Pad == 0) {
+				for (CountT i = baseIndex; i < Count; ++i)
+					if (!cb(i, baseOffset + i * By, By))
+						return;
+			} else {
+				CountT i = baseIndex;
+				for (; i < Count - 1; ++i)
+					if (!cb(i, baseOffset + i * By, By))
+						return;
+				if (i == Count - 1)
+					cb(i, baseOffset + i * By, Value - i * By);
+			}
+		}
+
+		void IterateChunked(std::function<void(CountT, T, T)> cb, T baseOffset = 0, CountT baseIndex = 0) const {
+			if (Pad == 0) {
+				for (CountT i = baseIndex; i < Count; ++i)
+					cb(i, baseOffset + i * By, By);
+			} else {
+				CountT i = baseIndex;
+				for (; i < Count - 1; ++i)
+					cb(i, baseOffset + i * By, By);
+				if (i == Count - 1)
+					cb(i, baseOffset + i * By, Value - i * By);
+			}
+		}
+	};
+
+	template<typename T, typename CountT = T>
+	AlignResult<T, CountT> Align(T value, T by = static_cast<T>(EntryAlignment)) {
+		const auto count = (value + by - 1) / by;
+		const auto alloc = count * by;
+		const auto pad = alloc - value;
+		return {
+			.Count = static_cast<CountT>(count),
+			.Value = value,
+			.By = by,
+			.Alloc = static_cast<T>(alloc),
+			.Pad = static_cast<T>(pad),
+			.Last = value - (count - 1) * by,
+		};
+	}
+
+	class RandomAccessStream : public std::enable_shared_from_this<RandomAccessStream> {
+	public:
+		RandomAccessStream();
+		RandomAccessStream(RandomAccessStream&&) = delete;
+		RandomAccessStream(const RandomAccessStream&) = delete;
+		RandomAccessStream& operator=(RandomAccessStream&&) = delete;
+		RandomAccessStream& operator=(const RandomAccessStream&) = delete;
+		virtual ~RandomAccessStream();
+
+		[[nodiscard]] virtual uint64_t StreamSize() const = 0;
+		virtual uint64_t ReadStreamPartial(uint64_t offset, void* buf, uint64_t length) const = 0;
+
+		void ReadStream(uint64_t offset, void* buf, uint64_t length) const;
+
+		template<typename T>
+		T ReadStream(uint64_t offset) const {
+			T buf;
+			ReadStream(offset, &buf, sizeof(T));
+			return buf;
+		}
+
+		template<typename T>
+		void ReadStream(uint64_t offset, std::span<T> buf) const {
+			ReadStream(offset, buf.data(), buf.size_bytes());
+		}
+
+		template<typename T>
+		std::vector<T> ReadStreamIntoVector(uint64_t offset, size_t count = SIZE_MAX, size_t maxCount = SIZE_MAX) const {
+			if (count > maxCount)
+				throw std::runtime_error("trying to read too many");
+			if (count == SIZE_MAX)
+				count = static_cast<size_t>(StreamSize() / sizeof(T));
+			std::vector<T> result(count);
+			ReadStream(offset, std::span(result));
+			return result;
+		}
+
+		template<typename T>
+		std::function<std::span<T>(size_t len, bool throwOnIncompleteRead)> AsLinearReader() const {
+			return [this, buf = std::vector<T>(), ptr = uint64_t(), to = StreamSize()](size_t len, bool throwOnIncompleteRead) mutable {
+				if (ptr == to)
+					return std::span<T>();
+				buf.resize(static_cast<size_t>(std::min<uint64_t>(len, to - ptr)));
+				const auto read = ReadStreamPartial(ptr, buf.data(), buf.size());
+				if (read < buf.size() && throwOnIncompleteRead)
+					throw std::runtime_error("incomplete read");
+				ptr += buf.size();
+				return std::span(buf);
+			};
+		}
+
+		virtual std::string DescribeState() const { return {}; }
+
+		virtual void EnableBuffering(bool bEnable) {}
+
+		virtual void Flush() const {}
+	};
+
+	class RandomAccessStreamPartialView : public RandomAccessStream {
+		const std::shared_ptr<const RandomAccessStream> m_stream;
+		const uint64_t m_offset;
+		const uint64_t m_size;
+
+	public:
+		RandomAccessStreamPartialView(std::shared_ptr<const RandomAccessStream> stream, uint64_t offset = 0, uint64_t length = UINT64_MAX)
+			: m_stream(std::move(stream))
+			, m_offset(offset)
+			, m_size(std::min(length, m_stream->StreamSize() - offset)) {
+		}
+
+		[[nodiscard]] uint64_t StreamSize() const override { return m_size; }
+
+		uint64_t ReadStreamPartial(uint64_t offset, void* buf, uint64_t length) const override {
+			if (offset >= m_size)
+				return 0;
+			length = std::min(length, m_size - offset);
+			return m_stream->ReadStreamPartial(m_offset + offset, buf, length);
+		}
+
+		std::string DescribeState() const override {
+			return std::format("RandomAccessStreamPartialView({}, {}, {})", m_stream->DescribeState(), m_offset, m_size);
+		}
+	};
+
+	class MemoryRandomAccessStream : public RandomAccessStream {
+		std::vector<uint8_t> m_buffer;
+		std::span<const uint8_t> m_view;
+
+	public:
+		MemoryRandomAccessStream() = default;
+		
+		MemoryRandomAccessStream(MemoryRandomAccessStream&& r) noexcept
+			: m_buffer(std::move(r.m_buffer))
+			, m_view(std::move(r.m_view)) {
+			r.m_view = {};
+		}
+
+		MemoryRandomAccessStream(const MemoryRandomAccessStream& r)
+			: m_buffer(r.m_buffer)
+			, m_view(r.OwnsData() ? std::span(m_buffer) : r.m_view) {
+		}
+
+		MemoryRandomAccessStream(const RandomAccessStream& r)
+			: m_buffer(static_cast<size_t>(r.StreamSize()))
+			, m_view(std::span(m_buffer)) {
+			r.ReadStream(0, std::span(m_buffer));
+		}
+
+		MemoryRandomAccessStream(std::vector<uint8_t> buffer)
+			: m_buffer(std::move(buffer))
+			, m_view(m_buffer) {
+		}
+
+		MemoryRandomAccessStream(std::span<const uint8_t> view)
+			: m_view(view) {
+		}
+		
+		MemoryRandomAccessStream& operator=(std::vector<uint8_t>&& buf) noexcept {
+			m_buffer = std::move(buf);
+			m_view = std::span(m_buffer);
+			return *this;
+		}
+
+		MemoryRandomAccessStream& operator=(const std::vector<uint8_t>& buf) {
+			m_buffer = buf;
+			m_view = std::span(m_buffer);
+			return *this;
+		}
+		
+		MemoryRandomAccessStream& operator=(MemoryRandomAccessStream&& r) noexcept {
+			m_buffer = std::move(r.m_buffer);
+			m_view = std::move(r.m_view);
+			r.m_view = {};
+			return *this;
+		}
+		
+		MemoryRandomAccessStream& operator=(const MemoryRandomAccessStream& r) {
+			if (r.OwnsData()) {
+				m_buffer = r.m_buffer;
+				m_view = std::span(m_buffer);
+			} else {
+				m_buffer.clear();
+				m_view = r.m_view;
+			}
+			return *this;
+		}
+
+		[[nodiscard]] uint64_t StreamSize() const override { return m_view.size(); }
+
+		uint64_t ReadStreamPartial(uint64_t offset, void* buf, uint64_t length) const override {
+			if (offset >= m_view.size())
+				return 0;
+			if (offset + length > m_view.size())
+				length = m_view.size() - offset;
+			std::copy_n(&m_view[static_cast<size_t>(offset)], static_cast<size_t>(length), static_cast<char*>(buf));
+			return length;
+		}
+
+		bool OwnsData() const {
+			return !m_buffer.empty() && m_view.data() == m_buffer.data();
+		}
+	};
+}
@@ -38,8 +38,106 @@ struct Sqex::Sqpack::Creator::Implementation {
 
 		this_->Log(std::vformat(std::forward<Arg>(arg), std::make_format_args(std::forward<Args&>(args)...)));
 	}
+
+	struct DeduplicationResult {
+		// Index of the earliest entry with identical provider output; equals own index if unique.
+		std::vector<size_t> Canonical;
+		uint64_t SavedBytes = 0;
+		size_t DuplicateCount = 0;
+	};
+	DeduplicationResult FindIdenticalEntries(std::span<const Entry* const> entries, std::span<const uint32_t> entrySizes);
 };
 
+Sqex::Sqpack::Creator::Implementation::DeduplicationResult Sqex::Sqpack::Creator::Implementation::FindIdenticalEntries(std::span<const Entry* const> entries, std::span<const uint32_t> entrySizes) {
+	static constexpr size_t ChunkSize = 65536;
+
+	DeduplicationResult res;
+	res.Canonical.resize(entries.size());
+	for (size_t i = 0; i < entries.size(); ++i)
+		res.Canonical[i] = i;
+
+	const auto st = Utils::QpcUs();
+
+	// Step. Group by stream size; entries with an unique size cannot have a duplicate and are never read.
+	std::vector<uint64_t> sizes(entries.size());
+	std::vector<size_t> order(entries.size());
+	for (size_t i = 0; i < entries.size(); ++i) {
+		sizes[i] = entries[i]->Provider->StreamSize();
+		order[i] = i;
+	}
+	std::ranges::stable_sort(order, [&sizes](size_t l, size_t r) { return sizes[l] < sizes[r]; });
+
+	// Step. Fingerprint the candidates.
+	std::vector<uint32_t> crcs(entries.size());
+	std::vector<uint8_t> buf1(ChunkSize), buf2(ChunkSize);
+	uint64_t fingerprintedBytes = 0;
+	for (size_t i = 0; i < order.size();) {
+		auto j = i + 1;
+		while (j < order.size() && sizes[order[j]] == sizes[order[i]])
+			++j;
+		if (j - i >= 2 && sizes[order[i]]) {
+			for (auto k = i; k < j; ++k) {
+				const auto& provider = *entries[order[k]]->Provider;
+				auto crc = crc32(0, nullptr, 0);
+				for (uint64_t offset = 0, size = sizes[order[k]]; offset < size; offset += ChunkSize) {
+					const auto readlen = static_cast<size_t>(std::min<uint64_t>(ChunkSize, size - offset));
+					provider.ReadStream(offset, &buf1[0], readlen);
+					crc = crc32(crc, &buf1[0], static_cast<uInt>(readlen));
+				}
+				crcs[order[k]] = static_cast<uint32_t>(crc);
+				fingerprintedBytes += sizes[order[k]];
+			}
+		}
+		i = j;
+	}
+
+	// Step. Confirm candidates with matching size and fingerprint by comparing bytes.
+	std::ranges::stable_sort(order, [&sizes, &crcs](size_t l, size_t r) {
+		if (sizes[l] != sizes[r])
+			return sizes[l] < sizes[r];
+		return crcs[l] < crcs[r];
+		});
+	std::vector<size_t> distinct;
+	for (size_t i = 0; i < order.size();) {
+		auto j = i + 1;
+		while (j < order.size() && sizes[order[j]] == sizes[order[i]] && crcs[order[j]] == crcs[order[i]])
+			++j;
+		if (j - i >= 2 && sizes[order[i]]) {
+			// order is stable-sorted, so each group is in ascending entry index order and the first one found is the earliest.
+			distinct.clear();
+			for (auto k = i; k < j; ++k) {
+				const auto& provider = *entries[order[k]]->Provider;
+				const auto size = sizes[order[k]];
+				for (const auto candidate : distinct) {
+					const auto& candidateProvider = *entries[candidate]->Provider;
+					auto identical = true;
+					for (uint64_t offset = 0; identical && offset < size; offset += ChunkSize) {
+						const auto readlen = static_cast<size_t>(std::min<uint64_t>(ChunkSize, size - offset));
+						provider.ReadStream(offset, &buf1[0], readlen);
+						candidateProvider.ReadStream(offset, &buf2[0], readlen);
+						identical = 0 == memcmp(&buf1[0], &buf2[0], readlen);
+					}
+					if (identical) {
+						res.Canonical[order[k]] = candidate;
+						break;
+					}
+				}
+				if (res.Canonical[order[k]] == order[k])
+					distinct.emplace_back(order[k]);
+				else {
+					res.DuplicateCount++;
+					res.SavedBytes += entrySizes[order[k]];
+				}
+			}
+		}
+		i = j;
+	}
+
+	Log("Deduplication: {} entries share data with an identical entry, saving {} bytes (fingerprinted {} bytes in {}us)",
+		res.DuplicateCount, res.SavedBytes, fingerprintedBytes, Utils::QpcUs() - st);
+	return res;
+}
+
 Sqex::Sqpack::Creator::Creator(std::string ex, std::string name, uint64_t maxFileSize)
 	: m_maxFileSize(maxFileSize)
 	, DatExpac(std::move(ex))
@@ -173,7 +271,7 @@ Sqex::Sqpack::Creator::AddEntryResult Sqex::Sqpack::Creator::AddEntryFromFile(En
 
 Sqex::Sqpack::Creator::AddEntryResult Sqex::Sqpack::Creator::AddAllEntriesFromSimpleTTMP(const std::filesystem::path & extractedDir, bool overwriteExisting) {
 	const auto ttmpdPath = extractedDir / "TTMPD.mpd";
-	const auto ttmpl = ThirdParty::TexTools::TTMPL::FromStream(FileRandomAccessStream{ Win32::Handle::FromCreateFile(extractedDir / "TTMPL.mpl", GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, 0) });
+	const auto ttmpl = ThirdParty::TexTools::ModEntryTable::FromStream(FileRandomAccessStream{ Win32::Handle::FromCreateFile(extractedDir / "TTMPL.mpl", GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, 0) });
 
 	if (DatExpac != "ffxiv")
 		return {};
@@ -181,17 +279,20 @@ Sqex::Sqpack::Creator::AddEntryResult Sqex::Sqpack::Creator::AddAllEntriesFromSi
 	const auto dataStream = std::make_shared<FileRandomAccessStream>(Win32::Handle::FromCreateFile(ttmpdPath, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN));
 
 	AddEntryResult result;
-	for (size_t i = 0; i < ttmpl.SimpleModsList.size(); ++i) {
-		const auto& entry = ttmpl.SimpleModsList[i];
-		EntryPathSpec entryPathSpec(entry.FullPath);
+	for (const auto& entry : ttmpl.Entries()) {
+		if (entry.PageIndex != ThirdParty::TexTools::ModEntryTable::SimpleModsListIndex)
+			break;
+
+		const auto fullPath = std::string(entry.FullPath);
+		EntryPathSpec entryPathSpec(fullPath);
 		if (entryPathSpec.DatFile() != DatName)
 			continue;
 
 		try {
-			m_pImpl->AddEntry(result, std::make_shared<RandomAccessStreamAsEntryProviderView>(entry.FullPath, dataStream, entry.ModOffset, entry.ModSize), overwriteExisting);
+			m_pImpl->AddEntry(result, std::make_shared<RandomAccessStreamAsEntryProviderView>(entryPathSpec, dataStream, entry.ModOffset, entry.ModSize), overwriteExisting);
 		} catch (const std::exception& e) {
-			result.Error.emplace_back(EntryPathSpec{ entry.FullPath }, std::string(e.what()));
-			m_pImpl->Log("Error: {} (Name: {} > {})", entry.FullPath, ttmpl.Name, entry.Name);
+			result.Error.emplace_back(std::move(entryPathSpec), std::string(e.what()));
+			m_pImpl->Log("Error: {} (Name: {} > {})", fullPath, ttmpl.Name(), entry.Name);
 		}
 	}
 	return result;
@@ -482,7 +583,7 @@ public:
 	}
 };
 
-Sqex::Sqpack::Creator::SqpackViews Sqex::Sqpack::Creator::AsViews(bool strict, const std::shared_ptr<SqpackViewEntryCache>&dataBuffer) {
+Sqex::Sqpack::Creator::SqpackViews Sqex::Sqpack::Creator::AsViews(bool strict, const std::shared_ptr<SqpackViewEntryCache>&dataBuffer, bool deduplicate) {
 	SqpackHeader dataHeader{};
 	std::vector<SqData::Header> dataSubheaders;
 	std::vector<std::pair<size_t, size_t>> dataEntryRanges;
@@ -506,10 +607,35 @@ Sqex::Sqpack::Creator::SqpackViews Sqex::Sqpack::Creator::AsViews(bool strict, c
 		fullHashes[pathSpec.FullPathHash].emplace_back(entry);
 	}
 
-	for (size_t i = 0; i < res.Entries.size(); ++i) {
+	for (const auto& entry : res.Entries)
+		entry->EntrySize = Align(std::max(entry->EntrySize, static_cast<uint32_t>(entry->Provider->StreamSize()))).Alloc;
+
+	// Duplicates are moved past the unique entries, so that each DataView still covers a contiguous range of Entries.
+	std::vector<std::pair<Entry*, Entry*>> duplicates;
+	if (deduplicate) {
+		std::vector<uint32_t> entrySizes;
+		entrySizes.reserve(res.Entries.size());
+		for (const auto& entry : res.Entries)
+			entrySizes.emplace_back(entry->EntrySize);
+
+		const auto dedup = m_pImpl->FindIdenticalEntries(res.Entries, entrySizes);
+		std::vector<Entry*> uniqueEntries;
+		uniqueEntries.reserve(res.Entries.size() - dedup.DuplicateCount);
+		for (size_t i = 0; i < res.Entries.size(); ++i) {
+			if (dedup.Canonical[i] == i)
+				uniqueEntries.emplace_back(res.Entries[i]);
+			else
+				duplicates.emplace_back(res.Entries[i], res.Entries[dedup.Canonical[i]]);
+		}
+		for (const auto& entry : duplicates | std::views::keys)
+			uniqueEntries.emplace_back(entry);
+		res.Entries = std::move(uniqueEntries);
+		res.DeduplicatedSize = dedup.SavedBytes;
+	}
+
+	for (size_t i = 0; i < res.Entries.size() - duplicates.size(); ++i) {
 		auto& entry = res.Entries[i];
 		const auto& pathSpec = entry->Provider->PathSpec();
-		entry->EntrySize = Align(std::max(entry->EntrySize, static_cast<uint32_t>(entry->Provider->StreamSize()))).Alloc;
 		entry->Provider = std::make_shared<HotSwappableEntryProvider>(pathSpec, entry->EntrySize, std::move(entry->Provider));
 
 		if (dataSubheaders.empty() ||
@@ -546,6 +672,13 @@ Sqex::Sqpack::Creator::SqpackViews Sqex::Sqpack::Creator::AsViews(bool strict, c
 		dataEntryRanges.back().second++;
 	}
 
+	for (const auto& [entry, canonical] : duplicates) {
+		const auto& pathSpec = entry->Provider->PathSpec();
+		entry->EntrySize = canonical->EntrySize;
+		entry->Locator = canonical->Locator;
+		entry->Provider = std::make_shared<HotSwappableEntryProvider>(pathSpec, entry->EntrySize, std::move(entry->Provider));
+	}
+
 	if (strict && !dataSubheaders.empty()) {
 		Crypt::Sha1 sha1;
 		for (auto j = dataEntryRanges.back().first, j_ = j + dataEntryRanges.back().second; j < j_; ++j) {
@@ -653,7 +786,7 @@ std::vector<Sqex::Sqpack::EntryPathSpec> Sqex::Sqpack::Creator::AllPathSpec() co
 	return res;
 }
 
-void Sqex::Sqpack::Creator::WriteToFiles(const std::filesystem::path & dir, bool strict) {
+void Sqex::Sqpack::Creator::WriteToFiles(const std::filesystem::path & dir, bool strict, bool deduplicate) {
 	SqpackHeader dataHeader{};
 	memcpy(dataHeader.Signature, SqpackHeader::Signature_Value, sizeof(SqpackHeader::Signature_Value));
 	dataHeader.HeaderSize = sizeof(SqpackHeader);
@@ -686,6 +819,19 @@ void Sqex::Sqpack::Creator::WriteToFiles(const std::filesystem::path & dir, bool
 
 	std::vector<SqIndex::LEDataLocator> locators;
 
+	std::vector<size_t> canonical;
+	if (deduplicate) {
+		std::vector<const Entry*> entryPointers;
+		std::vector<uint32_t> entrySizes;
+		entryPointers.reserve(entries.size());
+		entrySizes.reserve(entries.size());
+		for (const auto& entry : entries) {
+			entryPointers.emplace_back(entry.get());
+			entrySizes.emplace_back(static_cast<uint32_t>(entry->Provider->StreamSize()));
+		}
+		canonical = m_pImpl->FindIdenticalEntries(entryPointers, entrySizes).Canonical;
+	}
+
 	Win32::Handle dataFile;
 	std::vector<uint8_t> buf(1024 * 1024);
 	for (size_t i = 0; i < entries.size(); ++i) {
@@ -693,6 +839,12 @@ void Sqex::Sqpack::Creator::WriteToFiles(const std::filesystem::path & dir, bool
 		const auto provider{ std::move(entry.Provider) };
 		const auto entrySize = provider->StreamSize();
 
+		// Canonical entry always precedes its duplicates, so its locator is already assigned.
+		if (!canonical.empty() && canonical[i] != i) {
+			entry.Locator = entries[canonical[i]]->Locator;
+			continue;
+		}
+
 		if (dataSubheaders.empty() ||
 			sizeof(SqpackHeader) + sizeof(SqData::Header) + dataSubheaders.back().DataSize + entrySize > dataSubheaders.back().MaxFileSize) {
 			if (strict && !dataSubheaders.empty()) {
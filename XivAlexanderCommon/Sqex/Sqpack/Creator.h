@@ -63,6 +63,9 @@ namespace Sqex::Sqpack {
 			std::vector<Entry*> Entries;
 			std::map<EntryPathSpec, std::unique_ptr<Entry>, EntryPathSpec::AllHashComparator> HashOnlyEntries;
 			std::map<EntryPathSpec, std::unique_ptr<Entry>, EntryPathSpec::FullPathComparator> FullPathEntries;
+
+			// Number of bytes not emitted into data files because the entry shared its data with an identical entry.
+			uint64_t DeduplicatedSize = 0;
 		};
 
 		class SqpackViewEntryCache {
@@ -127,8 +130,10 @@ namespace Sqex::Sqpack {
 			void Flush();
 		};
 
-		SqpackViews AsViews(bool strict, const std::shared_ptr<SqpackViewEntryCache>& buffer = nullptr);
-		void WriteToFiles(const std::filesystem::path& dir, bool strict = false);
+		// If deduplicate is set, entries with byte-identical provider output share one data region and locator.
+		// Entries of such views must not be hot-swapped individually, as sharing entries are served from the first one's data region.
+		SqpackViews AsViews(bool strict, const std::shared_ptr<SqpackViewEntryCache>& buffer = nullptr, bool deduplicate = false);
+		void WriteToFiles(const std::filesystem::path& dir, bool strict = false, bool deduplicate = false);
 
 		std::shared_ptr<RandomAccessStream> operator[](const EntryPathSpec& pathSpec) const;
 		std::vector<EntryPathSpec> AllPathSpec() const;
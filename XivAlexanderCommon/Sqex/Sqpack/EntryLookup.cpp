@@ -0,0 +1,105 @@
+#include "pch.h"
+#include "XivAlexanderCommon/Sqex/Sqpack/EntryLookup.h"
+
+Sqex::Sqpack::EntryLookup::Key Sqex::Sqpack::EntryLookup::KeyOf(const EntryPathSpec& pathSpec) {
+	return { pathSpec.FullPathHash, pathSpec.PathHash, pathSpec.NameHash };
+}
+
+Sqex::Sqpack::EntryLookup::Key Sqex::Sqpack::EntryLookup::FullPathKeyOf(const EntryPathSpec& pathSpec) {
+	// Full path matches are looked up by the hashes of the path, in case pathSpec came with some of them missing.
+	if (pathSpec.FullPathHash != EntryPathSpec::EmptyHashValue
+		&& pathSpec.PathHash != EntryPathSpec::EmptyHashValue
+		&& pathSpec.NameHash != EntryPathSpec::EmptyHashValue)
+		return KeyOf(pathSpec);
+	return KeyOf(EntryPathSpec(pathSpec.FullPath));
+}
+
+bool Sqex::Sqpack::EntryLookup::IsBetter(const Record& l, const Record& r) {
+	if (l.ViewIndex != r.ViewIndex)
+		return l.ViewIndex < r.ViewIndex;
+	return !l.FullPathSpec && r.FullPathSpec;
+}
+
+void Sqex::Sqpack::EntryLookup::Add(const Creator::SqpackViews& views) {
+	const auto viewIndex = static_cast<uint32_t>(m_views.size());
+	m_views.emplace_back(&views);
+
+	const auto oldSize = m_records.size();
+	m_records.reserve(oldSize + views.HashOnlyEntries.size() + views.FullPathEntries.size());
+	for (const auto& [pathSpec, entry] : views.HashOnlyEntries)
+		m_records.emplace_back(Record{ KeyOf(pathSpec), viewIndex, nullptr, entry.get() });
+	for (const auto& [pathSpec, entry] : views.FullPathEntries)
+		m_records.emplace_back(Record{ FullPathKeyOf(pathSpec), viewIndex, &pathSpec, entry.get() });
+
+	// Within the same hashes, records are ordered by the order of probing: earlier views first, and HashOnlyEntries first.
+	const auto comparator = [](const Record& l, const Record& r) {
+		if (l.Hashes != r.Hashes)
+			return l.Hashes < r.Hashes;
+		return IsBetter(l, r);
+	};
+	const auto mid = m_records.begin() + static_cast<ptrdiff_t>(oldSize);
+	std::sort(mid, m_records.end(), comparator);
+	std::inplace_merge(m_records.begin(), mid, m_records.end(), comparator);
+}
+
+const Sqex::Sqpack::EntryLookup::Record* Sqex::Sqpack::EntryLookup::FindIn(std::vector<Record>::const_iterator first, const Key& key, const EntryPathSpec& pathSpec, bool hashOnly, bool fullPath, std::vector<Record>::const_iterator* pNext) const {
+	auto it = std::lower_bound(first, m_records.cend(), key, [](const Record& l, const Key& r) { return l.Hashes < r; });
+	if (pNext)
+		*pNext = it;
+
+	for (; it != m_records.cend() && it->Hashes == key; ++it) {
+		if (!it->FullPathSpec) {
+			if (hashOnly)
+				return &*it;
+		} else if (fullPath && lstrcmpiW(it->FullPathSpec->FullPath.c_str(), pathSpec.FullPath.c_str()) == 0) {
+			return &*it;
+		}
+	}
+	return nullptr;
+}
+
+const Sqex::Sqpack::EntryLookup::Record* Sqex::Sqpack::EntryLookup::Find(const EntryPathSpec& pathSpec, std::vector<Record>::const_iterator first, std::vector<Record>::const_iterator* pNext) const {
+	const auto key = KeyOf(pathSpec);
+	if (!pathSpec.HasOriginal())
+		return FindIn(first, key, pathSpec, true, false, pNext);
+
+	const auto fullPathKey = FullPathKeyOf(pathSpec);
+	if (key == fullPathKey)
+		return FindIn(first, key, pathSpec, true, true, pNext);
+
+	const auto hashOnlyMatch = FindIn(first, key, pathSpec, true, false, pNext);
+	const auto fullPathMatch = FindIn(m_records.cbegin(), fullPathKey, pathSpec, false, true, nullptr);
+	if (!hashOnlyMatch || (fullPathMatch && IsBetter(*fullPathMatch, *hashOnlyMatch)))
+		return fullPathMatch;
+	return hashOnlyMatch;
+}
+
+Sqex::Sqpack::EntryLookup::Match Sqex::Sqpack::EntryLookup::ToMatch(const Record& record) const {
+	return { m_views[record.ViewIndex], record.Entry };
+}
+
+std::optional<Sqex::Sqpack::EntryLookup::Match> Sqex::Sqpack::EntryLookup::Find(const EntryPathSpec& pathSpec) const {
+	if (const auto record = Find(pathSpec, m_records.cbegin(), nullptr))
+		return ToMatch(*record);
+	return std::nullopt;
+}
+
+std::vector<std::optional<Sqex::Sqpack::EntryLookup::Match>> Sqex::Sqpack::EntryLookup::Find(std::span<const EntryPathSpec> pathSpecs) const {
+	// Step. Visit in the order of hashes, so that each search only needs to look past the previous one.
+	std::vector<size_t> order(pathSpecs.size());
+	std::iota(order.begin(), order.end(), size_t{});
+	std::ranges::sort(order, [pathSpecs](size_t l, size_t r) { return KeyOf(pathSpecs[l]) < KeyOf(pathSpecs[r]); });
+
+	// Step. Search.
+	std::vector<std::optional<Match>> result(pathSpecs.size());
+	auto next = m_records.cbegin();
+	for (const auto i : order) {
+		if (const auto record = Find(pathSpecs[i], next, &next))
+			result[i] = ToMatch(*record);
+	}
+	return result;
+}
+
+size_t Sqex::Sqpack::EntryLookup::Size() const {
+	return m_records.size();
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "XivAlexanderCommon/Sqex/Sqpack/Creator.h"
+
+namespace Sqex::Sqpack {
+	// Finds entries across many SqpackViews with one binary search, instead of probing the maps of every view in turn.
+	// Matches the same entry as searching HashOnlyEntries and then FullPathEntries of each view in the order they were added.
+	// Views must outlive this object, and must not be modified after being added.
+	class EntryLookup {
+	public:
+		struct Match {
+			const Creator::SqpackViews* Views;
+			Creator::Entry* Entry;
+		};
+
+	private:
+		struct Key {
+			uint32_t FullPathHash;
+			uint32_t PathHash;
+			uint32_t NameHash;
+
+			auto operator<=>(const Key&) const = default;
+		};
+
+		struct Record {
+			Key Hashes;
+			uint32_t ViewIndex;
+
+			// Set if this came from FullPathEntries, in which case the full path must match too.
+			const EntryPathSpec* FullPathSpec;
+
+			Creator::Entry* Entry;
+		};
+
+		std::vector<const Creator::SqpackViews*> m_views;
+		std::vector<Record> m_records;
+
+		static Key KeyOf(const EntryPathSpec& pathSpec);
+		static Key FullPathKeyOf(const EntryPathSpec& pathSpec);
+		static bool IsBetter(const Record& l, const Record& r);
+
+		const Record* FindIn(std::vector<Record>::const_iterator first, const Key& key, const EntryPathSpec& pathSpec, bool hashOnly, bool fullPath, std::vector<Record>::const_iterator* pNext) const;
+		const Record* Find(const EntryPathSpec& pathSpec, std::vector<Record>::const_iterator first, std::vector<Record>::const_iterator* pNext) const;
+		[[nodiscard]] Match ToMatch(const Record& record) const;
+
+	public:
+		EntryLookup() = default;
+
+		void Add(const Creator::SqpackViews& views);
+
+		[[nodiscard]] std::optional<Match> Find(const EntryPathSpec& pathSpec) const;
+
+		// Same as calling Find for each item, but faster for large batches; results are in the same order as pathSpecs.
+		[[nodiscard]] std::vector<std::optional<Match>> Find(std::span<const EntryPathSpec> pathSpecs) const;
+
+		[[nodiscard]] size_t Size() const;
+	};
+}
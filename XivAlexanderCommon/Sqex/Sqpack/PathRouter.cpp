@@ -0,0 +1,117 @@
+#include "pch.h"
+#include "XivAlexanderCommon/Sqex/Sqpack/PathRouter.h"
+
+static wchar_t FoldCase(wchar_t c) {
+	return L'A' <= c && c <= L'Z' ? static_cast<wchar_t>(c - L'A' + L'a') : c;
+}
+
+static bool IsSeparator(wchar_t c) {
+	return c == L'\\' || c == L'/';
+}
+
+static std::wstring Normalize(std::wstring s) {
+	for (auto& c : s)
+		c = IsSeparator(c) ? L'\\' : FoldCase(c);
+	while (!s.empty() && s.back() == L'\\')
+		s.pop_back();
+	return s;
+}
+
+static int CompareFolded(std::wstring_view l, std::wstring_view folded) {
+	for (size_t i = 0, i_ = std::min(l.size(), folded.size()); i < i_; ++i) {
+		if (const auto c = FoldCase(l[i]); c != folded[i])
+			return c < folded[i] ? -1 : 1;
+	}
+	return l.size() == folded.size() ? 0 : (l.size() < folded.size() ? -1 : 1);
+}
+
+// Runs of separators count as one, as in std::filesystem::path comparison.
+static bool EqualsNormalizedPath(std::wstring_view l, std::wstring_view normalized) {
+	size_t i = 0, j = 0;
+	while (i < l.size() && j < normalized.size()) {
+		if (IsSeparator(l[i])) {
+			if (normalized[j] != L'\\')
+				return false;
+			while (i < l.size() && IsSeparator(l[i]))
+				++i;
+			++j;
+		} else if (FoldCase(l[i++]) != normalized[j++])
+			return false;
+	}
+	while (i < l.size() && IsSeparator(l[i]))
+		++i;
+	return i == l.size() && j == normalized.size();
+}
+
+Sqex::Sqpack::PathRouter::PathRouter(const std::filesystem::path& sqpackPath)
+	: m_sqpackPath(Normalize(sqpackPath.lexically_normal().wstring())) {
+}
+
+void Sqex::Sqpack::PathRouter::Add(const std::filesystem::path& indexPath, const Creator::SqpackViews& views) {
+	auto route = Route{
+		.Expac = Normalize(indexPath.parent_path().filename().wstring()),
+		.Name = Normalize(indexPath.filename().replace_extension().wstring()),
+		.Views = &views,
+	};
+	const auto it = std::ranges::lower_bound(m_routes, route, [](const Route& l, const Route& r) {
+		return std::tie(l.Expac, l.Name) < std::tie(r.Expac, r.Name);
+		});
+	if (it != m_routes.end() && it->Expac == route.Expac && it->Name == route.Name)
+		it->Views = &views;
+	else
+		m_routes.insert(it, std::move(route));
+}
+
+std::optional<Sqex::Sqpack::PathRouter::Match> Sqex::Sqpack::PathRouter::Resolve(std::wstring_view path) const {
+	if (path.starts_with(LR"(\\?\)"))
+		path = path.substr(4);
+
+	// Step. Split into <prefix>\<expac>\<name>.<extension>, rejecting by extension first as most paths fail there.
+	auto sep = path.find_last_of(L"\\/");
+	if (sep == std::wstring_view::npos)
+		return std::nullopt;
+	const auto fileName = path.substr(sep + 1);
+	const auto dot = fileName.find_last_of(L'.');
+	if (dot == std::wstring_view::npos)
+		return std::nullopt;
+
+	const auto extension = fileName.substr(dot + 1);
+	int pathType;
+	if (0 == CompareFolded(extension, L"index"))
+		pathType = PathTypeIndex;
+	else if (0 == CompareFolded(extension, L"index2"))
+		pathType = PathTypeIndex2;
+	else if (extension.size() == 4 && 0 == CompareFolded(extension.substr(0, 3), L"dat") && L'0' <= extension[3] && extension[3] <= L'7')
+		pathType = extension[3] - L'0';
+	else
+		return std::nullopt;
+
+	const auto name = fileName.substr(0, dot);
+	while (sep > 0 && IsSeparator(path[sep - 1]))
+		--sep;
+	path = path.substr(0, sep);
+	sep = path.find_last_of(L"\\/");
+	if (sep == std::wstring_view::npos)
+		return std::nullopt;
+	const auto expac = path.substr(sep + 1);
+
+	// Step. Find the route.
+	const auto it = std::lower_bound(m_routes.begin(), m_routes.end(), std::make_pair(expac, name), [](const Route& l, const std::pair<std::wstring_view, std::wstring_view>& r) {
+		const auto c = CompareFolded(r.first, l.Expac);
+		return c > 0 || (c == 0 && CompareFolded(r.second, l.Name) > 0);
+		});
+	if (it == m_routes.end() || CompareFolded(expac, it->Expac) || CompareFolded(name, it->Name))
+		return std::nullopt;
+
+	// Step. Confirm that the file is inside the sqpack directory.
+	if (!EqualsNormalizedPath(path.substr(0, sep), m_sqpackPath))
+		return std::nullopt;
+
+	return Match{ it->Views, pathType };
+}
+
+bool Sqex::Sqpack::PathRouter::IsAbsolute(std::wstring_view path) {
+	if (path.size() >= 2 && IsSeparator(path[0]) && IsSeparator(path[1]))
+		return true;
+	return path.size() >= 3 && path[1] == L':' && IsSeparator(path[2]);
+}
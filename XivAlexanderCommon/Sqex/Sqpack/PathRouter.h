@@ -0,0 +1,44 @@
+#pragma once
+
+#include "XivAlexanderCommon/Sqex/Sqpack/Creator.h"
+
+namespace Sqex::Sqpack {
+	// Resolves paths of sqpack files (<sqpack>/<expac>/<name>.win32.index/.index2/.datN) to their views,
+	// using case-insensitive string matching only; neither allocates nor touches the filesystem.
+	class PathRouter {
+	public:
+		static constexpr int PathTypeIndex = -1;
+		static constexpr int PathTypeIndex2 = -2;
+		static constexpr int PathTypeInvalid = -3;
+
+		struct Match {
+			const Creator::SqpackViews* Views;
+
+			// PathTypeIndex, PathTypeIndex2, or the dat file index.
+			int PathType;
+		};
+
+	private:
+		struct Route {
+			// Both in lowercase; Name excludes the extension (ex. "0a0000.win32").
+			std::wstring Expac;
+			std::wstring Name;
+			const Creator::SqpackViews* Views;
+		};
+
+		// In lowercase, with backslash as separator and without trailing separators.
+		std::wstring m_sqpackPath;
+		std::vector<Route> m_routes;
+
+	public:
+		PathRouter() = default;
+		explicit PathRouter(const std::filesystem::path& sqpackPath);
+
+		void Add(const std::filesystem::path& indexPath, const Creator::SqpackViews& views);
+
+		// Path must be absolute; relative ones never match.
+		[[nodiscard]] std::optional<Match> Resolve(std::wstring_view path) const;
+
+		[[nodiscard]] static bool IsAbsolute(std::wstring_view path);
+	};
+}
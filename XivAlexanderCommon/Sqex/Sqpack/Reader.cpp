@@ -3,6 +3,7 @@
 
 #include "XivAlexanderCommon/Sqex/Sqpack/EntryRawStream.h"
 #include "XivAlexanderCommon/Sqex/Sqpack/RandomAccessStreamAsEntryProviderView.h"
+#include "XivAlexanderCommon/Utils/Win32/ThreadPool.h"
 
 template<typename HashLocatorT, typename TextLocatorT>
 Sqex::Sqpack::Reader::SqIndexType<HashLocatorT, TextLocatorT>::SqIndexType(const RandomAccessStream* stream, bool strictVerify)
@@ -309,7 +310,15 @@ std::shared_ptr<Sqex::Sqpack::EntryProvider> Sqex::Sqpack::GameReader::GetEntryP
 	if (pathSpec.HasOriginal())
 		return GetReaderForPath(pathSpec).GetEntryProvider(pathSpec);
 
-	PreloadAllSqpackFiles();
+	std::call_once(m_hashIndexOnce, [this]() { BuildHashIndex(); });
+	const auto entry = FindFromHashIndex(pathSpec);
+	if (!entry)
+		throw std::out_of_range("File not found in any sqpack file");
+
+	if (entry->Source)
+		return entry->Source->GetEntryProvider(pathSpec, entry->Locator, entry->Allocation);
+
+	// Synonyms cannot be told apart by hash alone; let each reader decide.
 	for (const auto& reader : m_readers | std::views::values) {
 		try {
 			return reader->GetEntryProvider(pathSpec);
@@ -340,12 +349,108 @@ Sqex::Sqpack::Reader& Sqex::Sqpack::GameReader::GetReaderForPath(const EntryPath
 void Sqex::Sqpack::GameReader::PreloadAllSqpackFiles() const {
 	const auto lock = std::lock_guard(m_readersMtx);
 
+	std::vector<std::pair<std::optional<Reader>*, std::filesystem::path>> pending;
 	for (const auto& iter : std::filesystem::recursive_directory_iterator(m_gamePath / "sqpack")) {
 		if (iter.is_directory() || !iter.path().wstring().ends_with(L".win32.index"))
 			continue;
-		const auto datFileName = std::filesystem::path{ iter.path() }.replace_extension("").replace_extension("").string();
+		const auto datFileName = std::filesystem::path{ iter.path().filename() }.replace_extension("").replace_extension("").string();
 		auto& item = m_readers[datFileName];
 		if (!item)
-			item.emplace(Sqex::Sqpack::Reader::FromPath(iter.path()));
+			pending.emplace_back(&item, iter.path());
+	}
+
+	std::mutex errorMtx;
+	std::exception_ptr error;
+	{
+		Utils::Win32::TpEnvironment pool(L"GameReader::PreloadAllSqpackFiles");
+		for (size_t i = 0; i < pending.size(); ++i) {
+			pool.SubmitWork([&, i]() {
+				try {
+					pending[i].first->emplace(Reader::FromPath(pending[i].second));
+				} catch (...) {
+					const auto lock = std::lock_guard(errorMtx);
+					if (!error)
+						error = std::current_exception();
+				}
+			});
+		}
+		pool.WaitOutstanding();
+	}
+	if (error)
+		std::rethrow_exception(error);
+}
+
+void Sqex::Sqpack::GameReader::BuildHashIndex() const {
+	PreloadAllSqpackFiles();
+
+	std::vector<const Reader*> readers;
+	{
+		const auto lock = std::lock_guard(m_readersMtx);
+		for (const auto& reader : m_readers | std::views::values) {
+			if (reader)
+				readers.emplace_back(&*reader);
+		}
 	}
+
+	std::vector<std::vector<std::pair<uint64_t, HashIndexEntry>>> pairHashes(readers.size());
+	std::vector<std::vector<std::pair<uint32_t, HashIndexEntry>>> fullPathHashes(readers.size());
+	{
+		Utils::Win32::TpEnvironment pool(L"GameReader::BuildHashIndex");
+		for (size_t i = 0; i < readers.size(); ++i) {
+			pool.SubmitWork([&, i]() {
+				for (const auto& [locator, info] : readers[i]->EntryInfo) {
+					const auto entry = HashIndexEntry{ readers[i], locator, info.Allocation };
+					if (info.PathSpec.HasComponentHash())
+						pairHashes[i].emplace_back(static_cast<uint64_t>(info.PathSpec.PathHash) << 32 | info.PathSpec.NameHash, entry);
+					if (info.PathSpec.HasFullPathHash())
+						fullPathHashes[i].emplace_back(info.PathSpec.FullPathHash, entry);
+				}
+			});
+		}
+		pool.WaitOutstanding();
+	}
+
+	// Entries are merged in reader order, so that the first reader containing a hash wins, as it did when readers were tried in turn.
+	const auto merge = []<typename T>(std::vector<std::vector<std::pair<T, HashIndexEntry>>>& perReader) {
+		std::vector<std::pair<T, HashIndexEntry>> all;
+		size_t count = 0;
+		for (const auto& items : perReader)
+			count += items.size();
+		all.reserve(count);
+		for (auto& items : perReader) {
+			all.insert(all.end(), items.begin(), items.end());
+			std::vector<std::pair<T, HashIndexEntry>>().swap(items);
+		}
+		std::stable_sort(all.begin(), all.end(), [](const auto& l, const auto& r) { return l.first < r.first; });
+
+		std::vector<std::pair<T, HashIndexEntry>> result;
+		result.reserve(all.size());
+		for (auto it = all.begin(); it != all.end();) {
+			auto& item = result.emplace_back(*it);
+			for (++it; it != all.end() && it->first == item.first; ++it) {
+				if (it->second.Source == item.second.Source)
+					item.second.Source = nullptr;
+			}
+		}
+		result.shrink_to_fit();
+		return result;
+	};
+
+	m_pairHashIndex = merge(pairHashes);
+	m_fullPathHashIndex = merge(fullPathHashes);
+}
+
+const Sqex::Sqpack::GameReader::HashIndexEntry* Sqex::Sqpack::GameReader::FindFromHashIndex(const EntryPathSpec& pathSpec) const {
+	const auto find = [](const auto& index, const auto key) -> const HashIndexEntry* {
+		const auto it = std::lower_bound(index.begin(), index.end(), key, [](const auto& l, const auto& r) { return l.first < r; });
+		if (it == index.end() || it->first != key)
+			return nullptr;
+		return &it->second;
+	};
+
+	if (pathSpec.HasFullPathHash())
+		return find(m_fullPathHashIndex, pathSpec.FullPathHash);
+	if (pathSpec.HasComponentHash())
+		return find(m_pairHashIndex, static_cast<uint64_t>(pathSpec.PathHash) << 32 | pathSpec.NameHash);
+	return nullptr;
 }
@@ -78,10 +78,21 @@ namespace Sqex::Sqpack {
 	};
 
 	class GameReader {
+		struct HashIndexEntry {
+			// nullptr if the first reader containing the hash has more than one entry for it.
+			const Reader* Source;
+			SqIndex::LEDataLocator Locator;
+			uint64_t Allocation;
+		};
+
 		const std::filesystem::path m_gamePath;
 		mutable std::mutex m_readersMtx;
 		mutable std::map<std::string, std::optional<Reader>> m_readers;
 
+		mutable std::once_flag m_hashIndexOnce;
+		mutable std::vector<std::pair<uint64_t, HashIndexEntry>> m_pairHashIndex;
+		mutable std::vector<std::pair<uint32_t, HashIndexEntry>> m_fullPathHashIndex;
+
 	public:
 		GameReader(std::filesystem::path gamePath);
 
@@ -92,5 +103,9 @@ namespace Sqex::Sqpack {
 		[[nodiscard]] Reader& GetReaderForPath(const EntryPathSpec& rawPathSpec) const;
 
 		void PreloadAllSqpackFiles() const;
+
+	private:
+		void BuildHashIndex() const;
+		[[nodiscard]] const HashIndexEntry* FindFromHashIndex(const EntryPathSpec& pathSpec) const;
 	};
 }
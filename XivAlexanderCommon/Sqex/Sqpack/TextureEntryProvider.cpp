@@ -27,34 +27,34 @@ void Sqex::Sqpack::OnTheFlyTextureEntryProvider::Initialize(const RandomAccessSt
 	stream.ReadStream(0, std::span(m_texHeaderBytes).subspan(0, AsMipmapOffsets()[0]));
 
 	std::vector<uint32_t> mipmapOffsets(AsMipmapOffsets().begin(), AsMipmapOffsets().end());;
-	m_mipmapSizes.resize(mipmapOffsets.size());
+	std::vector<uint32_t> mipmapSizes(mipmapOffsets.size());
 	const auto repeatCount = mipmapOffsets.size() < 2 ? 1 : (size_t{} + mipmapOffsets[1] - mipmapOffsets[0]) / Texture::RawDataLength(AsTexHeader(), 0);
 	for (size_t i = 0; i < mipmapOffsets.size(); ++i)
-		m_mipmapSizes[i] = static_cast<uint32_t>(Texture::RawDataLength(AsTexHeader(), i));
+		mipmapSizes[i] = static_cast<uint32_t>(Texture::RawDataLength(AsTexHeader(), i));
 
 	// Actual data exists but the mipmap offset array after texture header does not bother to refer
 	// to the ones after the first set of mipmaps?
 	// For example: if there are mipmaps of 4x4, 2x2, 1x1, 4x4, 2x2, 1x2, 4x4, 2x2, and 1x1,
 	// then it will record mipmap offsets only up to the first occurrence of 1x1.
-	for (auto forceQuit = false; !forceQuit && (mipmapOffsets.empty() || mipmapOffsets.back() + m_mipmapSizes.back() * repeatCount < entryHeader.DecompressedSize);) {
+	for (auto forceQuit = false; !forceQuit && (mipmapOffsets.empty() || mipmapOffsets.back() + mipmapSizes.back() * repeatCount < entryHeader.DecompressedSize);) {
 		for (size_t i = 0, i_ = AsTexHeader().MipmapCount; i < i_; ++i) {
 
 			// <caused by TexTools export>
 			const auto size = static_cast<uint32_t>(Texture::RawDataLength(AsTexHeader(), i));
-			if (mipmapOffsets.back() + m_mipmapSizes.back() + size > entryHeader.DecompressedSize) {
+			if (mipmapOffsets.back() + mipmapSizes.back() + size > entryHeader.DecompressedSize) {
 				forceQuit = true;
 				break;
 			}
 			// </caused by TexTools export>
 
-			mipmapOffsets.push_back(mipmapOffsets.back() + m_mipmapSizes.back());
-			m_mipmapSizes.push_back(static_cast<uint32_t>(Texture::RawDataLength(AsTexHeader(), i)));
+			mipmapOffsets.push_back(mipmapOffsets.back() + mipmapSizes.back());
+			mipmapSizes.push_back(static_cast<uint32_t>(Texture::RawDataLength(AsTexHeader(), i)));
 		}
 	}
 
 	auto blockOffsetCounter = static_cast<uint32_t>(std::span(m_texHeaderBytes).size_bytes());
 	for (size_t i = 0; i < mipmapOffsets.size(); ++i) {
-		const auto mipmapSize = m_mipmapSizes[i];
+		const auto mipmapSize = mipmapSizes[i];
 		for (uint32_t repeatI = 0; repeatI < repeatCount; repeatI++) {
 			const auto blockAlignment = Align<uint32_t>(mipmapSize, EntryBlockDataSize);
 			SqData::TextureBlockHeaderLocator loc{
@@ -75,10 +75,16 @@ void Sqex::Sqpack::OnTheFlyTextureEntryProvider::Initialize(const RandomAccessSt
 
 				m_size += alignmentInfo.Alloc;
 				m_subBlockSizes.push_back(static_cast<uint16_t>(alignmentInfo.Alloc));
+				m_subBlocks.emplace_back(SubBlockInfo{
+					.BlockOffset = blockOffsetCounter,
+					.SourceOffset = offset,
+					.DecompressedSize = static_cast<uint16_t>(length),
+					.AllocatedSize = static_cast<uint16_t>(alignmentInfo.Alloc),
+				});
 				blockOffsetCounter += m_subBlockSizes.back();
 				loc.TotalSize += m_subBlockSizes.back();
 
-				}, mipmapOffsets[i] + m_mipmapSizes[i] * repeatI);
+				}, mipmapOffsets[i] + mipmapSizes[i] * repeatI);
 
 			m_blockLocators.emplace_back(loc);
 		}
@@ -117,9 +123,6 @@ uint64_t Sqex::Sqpack::OnTheFlyTextureEntryProvider::MaxPossibleStreamSize() con
 }
 
 uint64_t Sqex::Sqpack::OnTheFlyTextureEntryProvider::ReadStreamPartial(const RandomAccessStream& stream, uint64_t offset, void* buf, uint64_t length) const {
-	const auto AsTexHeader = [&]() { return *reinterpret_cast<const Texture::Header*>(&m_texHeaderBytes[0]); };
-	const auto AsMipmapOffsets = [&]() { return span_cast<uint32_t>(m_texHeaderBytes, sizeof(Texture::Header), AsTexHeader().MipmapCount); };
-
 	if (!length)
 		return 0;
 
@@ -133,94 +136,72 @@ uint64_t Sqex::Sqpack::OnTheFlyTextureEntryProvider::ReadStreamPartial(const Ran
 		std::copy_n(src.begin(), available, out.begin());
 		out = out.subspan(available);
 		relativeOffset = 0;
-
-		if (out.empty()) return length;
 	} else
 		relativeOffset -= m_mergedHeader.size();
 
-	if (relativeOffset < m_size - m_mergedHeader.size()) {
-		relativeOffset += std::span(m_texHeaderBytes).size_bytes();
-		auto it = std::lower_bound(m_blockLocators.begin(), m_blockLocators.end(),
-			SqData::TextureBlockHeaderLocator{ .FirstBlockOffset = static_cast<uint32_t>(relativeOffset) },
-			[&](const SqData::TextureBlockHeaderLocator& l, const SqData::TextureBlockHeaderLocator& r) {
-				return l.FirstBlockOffset < r.FirstBlockOffset;
-			});
-
-		if (it == m_blockLocators.end())
-			--it;
-		while (it->FirstBlockOffset > relativeOffset) {
-			if (it == m_blockLocators.begin()) {
-				const auto available = std::min(out.size_bytes(), static_cast<size_t>(it->FirstBlockOffset - relativeOffset));
-				std::fill_n(out.begin(), available, 0);
-				out = out.subspan(available);
-				relativeOffset = 0;
-
-				if (out.empty()) return length;
-				break;
-			} else
-				--it;
+	// Sub-blocks are contiguous, so the requested range maps to a run of sub-blocks; only their data is read from the source.
+	uint64_t sourceBytesRead = 0;
+	relativeOffset += m_texHeaderBytes.size();
+	auto it = std::upper_bound(m_subBlocks.begin(), m_subBlocks.end(), relativeOffset, [](uint64_t l, const SubBlockInfo& r) {
+		return l < r.BlockOffset;
+		});
+	if (it != m_subBlocks.begin())
+		--it;
+
+	for (; !out.empty() && it != m_subBlocks.end(); ++it) {
+		if (relativeOffset >= it->BlockOffset + it->AllocatedSize)
+			continue;
+		auto blockRelativeOffset = static_cast<size_t>(relativeOffset - it->BlockOffset);
+
+		if (blockRelativeOffset < sizeof(SqData::BlockHeader)) {
+			const auto header = SqData::BlockHeader{
+				.HeaderSize = sizeof(SqData::BlockHeader),
+				.Version = 0,
+				.CompressedSize = SqData::BlockHeader::CompressedSizeNotCompressed,
+				.DecompressedSize = it->DecompressedSize,
+			};
+			const auto src = span_cast<uint8_t>(1, &header).subspan(blockRelativeOffset);
+			const auto available = std::min(out.size_bytes(), src.size_bytes());
+			std::copy_n(src.begin(), available, out.begin());
+			out = out.subspan(available);
+			blockRelativeOffset = sizeof(SqData::BlockHeader);
 		}
 
-		relativeOffset -= it->FirstBlockOffset;
-
-		for (; it != m_blockLocators.end(); ++it) {
-			const auto blockIndex = it - m_blockLocators.begin();
-			auto j = relativeOffset / (sizeof(SqData::BlockHeader) + EntryBlockDataSize);
-			relativeOffset -= j * (sizeof(SqData::BlockHeader) + EntryBlockDataSize);
-			for (; j < it->SubBlockCount; ++j) {
-				const auto decompressedSize = j == it->SubBlockCount - 1 ? m_mipmapSizes[blockIndex] % EntryBlockDataSize : EntryBlockDataSize;
-				const auto pad = Align(sizeof(SqData::BlockHeader) + decompressedSize).Pad;
-
-				if (relativeOffset < sizeof(SqData::BlockHeader)) {
-					const auto header = SqData::BlockHeader{
-						.HeaderSize = sizeof(SqData::BlockHeader),
-						.Version = 0,
-						.CompressedSize = SqData::BlockHeader::CompressedSizeNotCompressed,
-						.DecompressedSize = decompressedSize,
-					};
-					const auto src = span_cast<uint8_t>(1, &header).subspan(static_cast<size_t>(relativeOffset));
-					const auto available = std::min(out.size_bytes(), src.size_bytes());
-					std::copy_n(src.begin(), available, out.begin());
-					out = out.subspan(available);
-					relativeOffset = 0;
-
-					if (out.empty()) return length;
-				} else
-					relativeOffset -= sizeof(SqData::BlockHeader);
-
-				if (relativeOffset < decompressedSize) {
-					const auto available = std::min(out.size_bytes(), static_cast<size_t>(decompressedSize - relativeOffset));
-					stream.ReadStream(AsMipmapOffsets()[blockIndex] + j * EntryBlockDataSize + relativeOffset, &out[0], available);
-					out = out.subspan(available);
-					relativeOffset = 0;
-
-					if (out.empty()) return length;
-				} else
-					relativeOffset -= decompressedSize;
-
-				if (relativeOffset < pad) {
-					const auto available = std::min(out.size_bytes(), pad);
-					std::fill_n(&out[0], available, 0);
-					out = out.subspan(available);
-					relativeOffset = 0;
-
-					if (out.empty()) return length;
-				} else {
-					relativeOffset -= pad;
-				}
-			}
+		if (!out.empty() && blockRelativeOffset < sizeof(SqData::BlockHeader) + it->DecompressedSize) {
+			const auto dataOffset = blockRelativeOffset - sizeof(SqData::BlockHeader);
+			const auto available = std::min(out.size_bytes(), it->DecompressedSize - dataOffset);
+			const auto read = static_cast<size_t>(stream.ReadStreamPartial(it->SourceOffset + dataOffset, &out[0], available));
+			// <caused by TexTools export>
+			std::fill_n(&out[read], available - read, 0);
+			// </caused by TexTools export>
+			sourceBytesRead += read;
+			out = out.subspan(available);
+			blockRelativeOffset = sizeof(SqData::BlockHeader) + it->DecompressedSize;
 		}
-	}
 
-	if (const auto endPadSize = StreamSize() - StreamSize(stream); relativeOffset < endPadSize) {
-		const auto available = std::min(out.size_bytes(), static_cast<size_t>(endPadSize - relativeOffset));
-		std::fill_n(out.begin(), available, 0);
-		out = out.subspan(static_cast<size_t>(available));
+		if (!out.empty()) {
+			const auto available = std::min(out.size_bytes(), it->AllocatedSize - blockRelativeOffset);
+			std::fill_n(&out[0], available, 0);
+			out = out.subspan(available);
+		}
+
+		relativeOffset = it->BlockOffset + it->AllocatedSize;
 	}
 
+	m_sourceBytesRead += sourceBytesRead;
+	m_servedBytes += length - out.size_bytes();
 	return length - out.size_bytes();
 }
 
+std::string Sqex::Sqpack::OnTheFlyTextureEntryProvider::DescribeState() const {
+	return std::format("OnTheFlyTextureEntryProvider(served {} bytes, read {} source bytes)", m_servedBytes.load(), m_sourceBytesRead.load());
+}
+
+double Sqex::Sqpack::OnTheFlyTextureEntryProvider::ReadAmplification() const {
+	const auto served = m_servedBytes.load();
+	return served ? static_cast<double>(m_sourceBytesRead.load()) / static_cast<double>(served) : 0.;
+}
+
 void Sqex::Sqpack::MemoryTextureEntryProvider::Initialize(const RandomAccessStream& stream) {
 	std::vector<SqData::TextureBlockHeaderLocator> blockLocators;
 	std::vector<uint8_t> readBuffer(EntryBlockDataSize);
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <atomic>
+
 #include "XivAlexanderCommon/Sqex/Sqpack/LazyEntryProvider.h"
 
 namespace Sqex::Texture {
@@ -26,9 +28,19 @@ namespace Sqex::Sqpack {
 
 		std::vector<uint8_t> m_mergedHeader;
 
-		std::vector<uint32_t> m_mipmapSizes;
+		// Where each sub-block is, both in this entry and in the source .tex file.
+		struct SubBlockInfo {
+			uint32_t BlockOffset;  // Relative to the beginning of texture header, like TextureBlockHeaderLocator::FirstBlockOffset.
+			uint32_t SourceOffset;
+			uint16_t DecompressedSize;
+			uint16_t AllocatedSize;
+		};
+		std::vector<SubBlockInfo> m_subBlocks;
 		size_t m_size = 0;
 
+		mutable std::atomic<uint64_t> m_sourceBytesRead = 0;
+		mutable std::atomic<uint64_t> m_servedBytes = 0;
+
 	public:
 		using LazyFileOpeningEntryProvider::LazyFileOpeningEntryProvider;
 		using LazyFileOpeningEntryProvider::StreamSize;
@@ -36,7 +48,10 @@ namespace Sqex::Sqpack {
 
 		[[nodiscard]] SqData::FileEntryType EntryType() const override { return SqData::FileEntryType::Texture; }
 
-		std::string DescribeState() const override { return "OnTheFlyTextureEntryProvider"; }
+		std::string DescribeState() const override;
+
+		/// \returns Bytes read from the source .tex file per byte served, since creation.
+		[[nodiscard]] double ReadAmplification() const;
 
 	protected:
 		void Initialize(const RandomAccessStream&) override;
@@ -15,27 +15,41 @@ Sqex::Sqpack::TextureStreamDecoder::TextureStreamDecoder(const SqData::FileEntry
 	const auto mipmapOffsets = span_cast<uint32_t>(m_head, sizeof texHeader, texHeader.MipmapCount);
 
 	const auto repeatCount = mipmapOffsets.size() < 2 ? 1 : (mipmapOffsets[1] - mipmapOffsets[0]) / static_cast<uint32_t>(Texture::RawDataLength(texHeader, 0));
+	const auto underlyingSize = m_stream->StreamSize();
+	uint32_t nextRequestOffset = 0;
 
 	for (uint32_t i = 0; i < locators.size(); ++i) {
 		const auto& locator = locators[i];
 		const auto mipmapIndex = i / repeatCount;
 		const auto mipmapPlaneIndex = i % repeatCount;
 		const auto mipmapPlaneSize = static_cast<uint32_t>(Texture::RawDataLength(texHeader, mipmapIndex));
-		uint32_t baseRequestOffset = 0;
+		uint32_t requestOffset = 0;
 		if (mipmapIndex < mipmapOffsets.size())
-			baseRequestOffset = mipmapOffsets[mipmapIndex] - mipmapOffsets[0] + mipmapPlaneSize * mipmapPlaneIndex;
-		else if (!m_blocks.empty())
-			baseRequestOffset = m_blocks.back().RequestOffset + m_blocks.back().RemainingDecompressedSize;
+			requestOffset = mipmapOffsets[mipmapIndex] - mipmapOffsets[0] + mipmapPlaneSize * mipmapPlaneIndex;
 		else
-			baseRequestOffset = 0;
-		m_blocks.emplace_back(BlockInfo{
-			.RequestOffset = baseRequestOffset,
-			.BlockOffset = header.HeaderSize + locator.FirstBlockOffset,
-			.RemainingDecompressedSize = locator.DecompressedSize,
-			.RemainingBlockSizes = m_stream->ReadStreamIntoVector<uint16_t>(readOffset, locator.SubBlockCount),
-			});
-		readOffset += std::span(m_blocks.back().RemainingBlockSizes).size_bytes();
-		baseRequestOffset += mipmapPlaneSize;
+			requestOffset = nextRequestOffset;
+
+		const auto subBlockSizes = m_stream->ReadStreamIntoVector<uint16_t>(readOffset, locator.SubBlockCount);
+		readOffset += std::span(subBlockSizes).size_bytes();
+
+		// Sub-block request offsets depend on their decompressed sizes, which are only in each block header.
+		auto blockOffset = header.HeaderSize + locator.FirstBlockOffset;
+		for (const auto subBlockSize : subBlockSizes) {
+			SqData::BlockHeader blockHeader;
+			if (blockOffset == underlyingSize)
+				blockHeader.DecompressedSize = blockHeader.CompressedSize = 0;
+			else
+				m_stream->ReadStream(blockOffset, &blockHeader, sizeof blockHeader);
+
+			m_maxBlockSize = std::max<size_t>(m_maxBlockSize, sizeof blockHeader + blockHeader.CompressedSize);
+			m_blocks.emplace_back(BlockInfo{
+				.RequestOffset = requestOffset,
+				.BlockOffset = blockOffset,
+				});
+			requestOffset += blockHeader.DecompressedSize;
+			blockOffset += subBlockSize;
+		}
+		nextRequestOffset = requestOffset;
 	}
 }
 
@@ -62,37 +76,14 @@ uint64_t Sqex::Sqpack::TextureStreamDecoder::ReadStreamPartial(uint64_t offset,
 	if (info.TargetBuffer.empty() || m_blocks.empty())
 		return length - info.TargetBuffer.size_bytes();
 
-	auto it = std::lower_bound(m_blocks.begin(), m_blocks.end(), static_cast<uint32_t>(info.RelativeOffset), [&](const BlockInfo& l, uint32_t r) {
-		return l.RequestOffset < r;
+	auto it = std::upper_bound(m_blocks.begin(), m_blocks.end(), info.RelativeOffset, [](uint64_t l, const BlockInfo& r) {
+		return l < r.RequestOffset;
 		});
-	if (it == m_blocks.end() || (it != m_blocks.end() && it != m_blocks.begin() && it->RequestOffset > info.RelativeOffset))
+	if (it != m_blocks.begin())
 		--it;
 
-	while (it != m_blocks.end()) {
+	for (; it != m_blocks.end() && !info.TargetBuffer.empty(); ++it)
 		info.Progress(it->RequestOffset, it->BlockOffset);
 
-		if (it->RemainingBlockSizes.empty()) {
-			++it;
-		} else {
-			const auto& blockHeader = info.AsHeader();
-			auto newBlockInfo = BlockInfo{
-				.RequestOffset = it->RequestOffset + blockHeader.DecompressedSize,
-				.BlockOffset = it->BlockOffset + it->RemainingBlockSizes.front(),
-				.RemainingDecompressedSize = it->RemainingDecompressedSize - blockHeader.DecompressedSize,
-				.RemainingBlockSizes = std::move(it->RemainingBlockSizes),
-			};
-
-			++it;
-			if (it == m_blocks.end() || (it->RequestOffset != newBlockInfo.RequestOffset && it->BlockOffset != newBlockInfo.BlockOffset)) {
-				newBlockInfo.RemainingBlockSizes.erase(newBlockInfo.RemainingBlockSizes.begin());
-				it = m_blocks.emplace(it, std::move(newBlockInfo));
-			}
-		}
-
-		if (info.TargetBuffer.empty())
-			break;
-	}
-
-	m_maxBlockSize = info.ReadBuffer.size();
 	return length - info.TargetBuffer.size_bytes();
 }
@@ -7,9 +7,9 @@ namespace Sqex::Sqpack {
 		struct BlockInfo {
 			uint32_t RequestOffset;
 			uint32_t BlockOffset;
-			uint32_t RemainingDecompressedSize;
-			std::vector<uint16_t> RemainingBlockSizes;
 		};
+
+		// Every sub-block, in order; never modified after construction, so that reads may run concurrently.
 		std::vector<uint8_t> m_head;
 		std::vector<BlockInfo> m_blocks;
 
@@ -156,31 +156,633 @@ void Sqex::ThirdParty::TexTools::from_json(const nlohmann::json& j, TTMPL& p) {
 		p.SimpleModsList = it->get<decltype(p.SimpleModsList)>();
 }
 
-Sqex::ThirdParty::TexTools::TTMPL Sqex::ThirdParty::TexTools::TTMPL::FromStream(const RandomAccessStream& stream) {
-	const auto size = stream.StreamSize();
-	if (size > 16 * 1024 * 1024)
-		throw CorruptDataException("File too big (>16MB).");
-
-	std::string buf(static_cast<size_t>(size), '\0');
-	stream.ReadStream(0, &buf[0], buf.size());
-
-	std::istringstream in(buf);
-	TTMPL res;
-	while (!in.eof()) {
-		nlohmann::json j;
-		try {
-			in >> j;
-		} catch (...) {
-			if (in.eof())
-				break;
-		}
-		if (j.find("ModOffset") != j.end()) {
-			res.SimpleModsList.emplace_back(j.get<ModEntry>());
-		} else {
-			return j.get<TTMPL>();
+namespace Sqex::ThirdParty::TexTools {
+	// Feeds a RandomAccessStream to nlohmann::json through a small buffer, so that the file never needs to be in memory as a whole.
+	class TtmplStreamReader {
+		static constexpr size_t BufferSize = 65536;
+
+		const RandomAccessStream& m_stream;
+		const uint64_t m_size;
+		uint64_t m_bufferOffset = 0;
+		std::vector<char> m_buffer;
+		size_t m_bufferPtr = 0;
+
+		bool Fill() {
+			if (m_bufferPtr < m_buffer.size())
+				return true;
+			m_bufferOffset += m_buffer.size();
+			m_bufferPtr = 0;
+			m_buffer.resize(static_cast<size_t>(std::min<uint64_t>(BufferSize, m_size - m_bufferOffset)));
+			if (m_buffer.empty())
+				return false;
+			m_stream.ReadStream(m_bufferOffset, m_buffer.data(), m_buffer.size());
+			return true;
 		}
-	}
-	return res;
+
+	public:
+		TtmplStreamReader(const RandomAccessStream& stream)
+			: m_stream(stream)
+			, m_size(stream.StreamSize()) {
+			m_buffer.reserve(BufferSize);
+		}
+
+		bool AtEnd() {
+			return !Fill();
+		}
+
+		char Peek() {
+			return m_buffer[m_bufferPtr];
+		}
+
+		void Advance() {
+			m_bufferPtr++;
+		}
+
+		bool SkipWhitespace() {
+			while (!AtEnd()) {
+				const auto c = Peek();
+				if (c != ' ' && c != '\t' && c != '\r' && c != '\n')
+					return true;
+				Advance();
+			}
+			return false;
+		}
+
+		class Iterator {
+			TtmplStreamReader* m_reader;
+
+		public:
+			using iterator_category = std::input_iterator_tag;
+			using value_type = char;
+			using difference_type = std::ptrdiff_t;
+			using pointer = const char*;
+			using reference = const char&;
+
+			Iterator(TtmplStreamReader* reader = nullptr) : m_reader(reader) {}
+
+			char operator*() const { return m_reader->Peek(); }
+			Iterator& operator++() { m_reader->Advance(); return *this; }
+			bool operator==(const Iterator& r) const { return (!m_reader || m_reader->AtEnd()) == (!r.m_reader || r.m_reader->AtEnd()); }
+			bool operator!=(const Iterator& r) const { return !(*this == r); }
+		};
+	};
+
+	// Builds TTMPL or ModEntryTable from nlohmann::json SAX events, following the same rules as from_json.
+	class TtmplSaxHandler {
+		enum class Context : uint8_t {
+			Skip,
+			Root,
+			ModEntry,
+			ModPackEntry,
+			Page,
+			ModGroup,
+			Option,
+
+			// Arrays; every item must be an object.
+			SimpleModsList,
+			ModPackPages,
+			ModGroups,
+			OptionList,
+			ModsJsons,
+		};
+
+		enum class Kind : uint8_t {
+			Skip,
+			String,
+			Unsigned,
+			Int,
+			Bool,
+			ModPackEntry,
+			Array,
+		};
+
+		// What to do with the value that follows a key.
+		struct Slot {
+			Kind Type = Kind::Skip;
+			const char* Name = nullptr;
+			void* Target = nullptr;
+			std::string* Target2 = nullptr;
+			Context ArrayContext = Context::Skip;
+		};
+
+		struct PendingEntry {
+			size_t NameOffset;
+			size_t NameLength;
+			size_t FullPathOffset;
+			size_t FullPathLength;
+			ModEntryTable::Entry Entry;
+		};
+
+		ModEntryTable* const m_table;
+		TTMPL m_result;
+
+		std::vector<Context> m_stack;
+		Slot m_slot;
+		std::string m_error;
+
+		TTMPL m_ttmpl;
+		ModEntry m_rootEntry;
+		bool m_rootIsModEntry = false;
+
+		ModEntry* m_entry = nullptr;
+		ModPackPage::Page* m_page = nullptr;
+		ModPackPage::ModGroup* m_group = nullptr;
+		ModPackPage::Option* m_option = nullptr;
+		ModPackEntry* m_modPack = nullptr;
+
+		// Used instead of the real objects when only a ModEntryTable is being built.
+		ModEntry m_scratchEntry;
+		ModPackPage::Page m_scratchPage;
+		ModPackPage::ModGroup m_scratchGroup;
+		ModPackPage::Option m_scratchOption;
+
+		uint32_t m_pageIndex = 0;
+		uint32_t m_groupIndex = 0;
+		uint32_t m_optionIndex = 0;
+
+		std::vector<PendingEntry> m_pendingEntries;
+		size_t m_pendingEntriesMark = 0;
+
+		[[nodiscard]] bool EntriesOnly() const {
+			return m_table != nullptr;
+		}
+
+		[[nodiscard]] bool InArray() const {
+			return m_stack.back() >= Context::SimpleModsList;
+		}
+
+		static const char* ArrayName(Context context) {
+			switch (context) {
+				case Context::SimpleModsList:
+					return "SimpleModsList";
+				case Context::ModPackPages:
+					return "ModPackPages";
+				case Context::ModGroups:
+					return "ModGroups";
+				case Context::OptionList:
+					return "OptionList";
+				case Context::ModsJsons:
+					return "ModsJsons";
+				default:
+					return "array";
+			}
+		}
+
+		static Slot String(std::string* target, const char* name, std::string* target2 = nullptr) {
+			return { .Type = Kind::String, .Name = name, .Target = target, .Target2 = target2 };
+		}
+
+		static Slot Array(Context context, const char* name) {
+			return { .Type = Kind::Array, .Name = name, .ArrayContext = context };
+		}
+
+		// Strings that are not part of ModEntryTable.
+		[[nodiscard]] Slot Text(std::string* target, const char* name) const {
+			return EntriesOnly() ? Slot{} : String(target, name);
+		}
+
+		[[nodiscard]] Slot EntryKey(const std::string& key, ModEntry& entry) const {
+			if (key == "Name")
+				return String(&entry.Name, "Name");
+			if (key == "FullPath")
+				return String(&entry.FullPath, "FullPath");
+			if (key == "ModOffset")
+				return { .Type = Kind::Unsigned, .Name = "ModOffset", .Target = &entry.ModOffset };
+			if (key == "ModSize")
+				return { .Type = Kind::Unsigned, .Name = "ModSize", .Target = &entry.ModSize };
+			if (EntriesOnly())
+				return {};
+			if (key == "Category")
+				return String(&entry.Category, "Category");
+			if (key == "DatFile")
+				return String(&entry.DatFile, "DatFile");
+			if (key == "IsDefault")
+				return { .Type = Kind::Bool, .Name = "IsDefault", .Target = &entry.IsDefault };
+			if (key == "ModPackEntry")
+				return { .Type = Kind::ModPackEntry, .Name = "ModPackEntry", .Target = &entry.ModPack };
+			return {};
+		}
+
+		[[noreturn]] void TypeMismatch() const {
+			if (InArray())
+				throw CorruptDataException(std::format("Items of {} must be objects", ArrayName(m_stack.back())));
+			throw CorruptDataException(std::format("Unexpected type for {}", m_slot.Name));
+		}
+
+		void CheckScalar() const {
+			if (m_stack.empty())
+				throw CorruptDataException("TTMPL must be an object");
+			if (InArray())
+				TypeMismatch();
+		}
+
+		template<typename T>
+		bool Number(T value) {
+			CheckScalar();
+			switch (m_slot.Type) {
+				case Kind::Skip:
+					return true;
+				case Kind::Unsigned:
+					*static_cast<uint64_t*>(m_slot.Target) = static_cast<uint64_t>(value);
+					return true;
+				case Kind::Int:
+					*static_cast<int*>(m_slot.Target) = static_cast<int>(value);
+					return true;
+				default:
+					TypeMismatch();
+			}
+		}
+
+		void AddEntry(const ModEntry& entry, bool fromSimpleModsList) {
+			auto& strings = m_table->m_strings;
+			auto& pending = m_pendingEntries.emplace_back(PendingEntry{
+				.NameOffset = strings.size(),
+				.NameLength = entry.Name.size(),
+				.FullPathOffset = strings.size() + entry.Name.size(),
+				.FullPathLength = entry.FullPath.size(),
+				.Entry = {
+					.ModOffset = entry.ModOffset,
+					.ModSize = entry.ModSize,
+				},
+				});
+			if (!fromSimpleModsList) {
+				pending.Entry.PageIndex = m_pageIndex - 1;
+				pending.Entry.GroupIndex = m_groupIndex - 1;
+				pending.Entry.OptionIndex = m_optionIndex - 1;
+			}
+			strings.insert(strings.end(), entry.Name.begin(), entry.Name.end());
+			strings.insert(strings.end(), entry.FullPath.begin(), entry.FullPath.end());
+		}
+
+		// Returns true if the object was a TTMPL, after which nothing more is read.
+		bool FinishTopLevel() {
+			if (m_rootIsModEntry) {
+				if (EntriesOnly())
+					AddEntry(m_rootEntry, true);
+				else
+					m_result.SimpleModsList.emplace_back(std::move(m_rootEntry));
+				return false;
+			}
+
+			// Entries read from preceding lines are discarded, as a TTMPL object describes the whole mod pack.
+			if (EntriesOnly()) {
+				m_table->m_name = std::move(m_ttmpl.Name);
+				m_pendingEntries.erase(m_pendingEntries.begin(), m_pendingEntries.begin() + static_cast<ptrdiff_t>(m_pendingEntriesMark));
+			} else {
+				m_result = std::move(m_ttmpl);
+			}
+			return true;
+		}
+
+		void FinishTable() {
+			auto& strings = m_table->m_strings;
+			strings.shrink_to_fit();
+
+			// Match the order of TTMPL::ForEachEntry; TexTools writes ModPackPages before SimpleModsList.
+			std::stable_partition(m_pendingEntries.begin(), m_pendingEntries.end(), [](const PendingEntry& e) {
+				return e.Entry.PageIndex == ModEntryTable::SimpleModsListIndex;
+			});
+
+			m_table->m_entries.reserve(m_pendingEntries.size());
+			for (auto& e : m_pendingEntries) {
+				e.Entry.Name = { strings.data() + e.NameOffset, e.NameLength };
+				e.Entry.FullPath = { strings.data() + e.FullPathOffset, e.FullPathLength };
+				m_table->m_entries.emplace_back(e.Entry);
+			}
+			m_pendingEntries.clear();
+			m_pendingEntries.shrink_to_fit();
+		}
+
+	public:
+		TtmplSaxHandler(ModEntryTable* table = nullptr)
+			: m_table(table) {
+		}
+
+		void Parse(const RandomAccessStream& stream) {
+			TtmplStreamReader reader(stream);
+			while (reader.SkipWhitespace()) {
+				const auto ok = nlohmann::json::sax_parse(TtmplStreamReader::Iterator(&reader), TtmplStreamReader::Iterator(), this, nlohmann::json::input_format_t::json, false);
+				if (!ok) {
+					// A truncated object at the end of the file is ignored.
+					if (!reader.AtEnd())
+						throw CorruptDataException(m_error);
+					if (EntriesOnly())
+						m_pendingEntries.resize(m_pendingEntriesMark);
+					break;
+				}
+				if (FinishTopLevel())
+					break;
+			}
+
+			if (EntriesOnly())
+				FinishTable();
+		}
+
+		TTMPL TakeResult() {
+			return std::move(m_result);
+		}
+
+		bool null() {
+			CheckScalar();
+			switch (m_slot.Type) {
+				case Kind::String:
+					static_cast<std::string*>(m_slot.Target)->clear();
+					if (m_slot.Target2)
+						m_slot.Target2->clear();
+					return true;
+				case Kind::Unsigned:
+					*static_cast<uint64_t*>(m_slot.Target) = 0;
+					return true;
+				case Kind::Int:
+					*static_cast<int*>(m_slot.Target) = 0;
+					return true;
+				case Kind::Bool:
+					*static_cast<bool*>(m_slot.Target) = false;
+					return true;
+				case Kind::ModPackEntry:
+					static_cast<std::optional<ModPackEntry>*>(m_slot.Target)->reset();
+					return true;
+				default:
+					return true;
+			}
+		}
+
+		bool boolean(bool val) {
+			CheckScalar();
+			if (m_slot.Type == Kind::Skip)
+				return true;
+			if (m_slot.Type != Kind::Bool)
+				TypeMismatch();
+			*static_cast<bool*>(m_slot.Target) = val;
+			return true;
+		}
+
+		bool number_integer(nlohmann::json::number_integer_t val) {
+			return Number(val);
+		}
+
+		bool number_unsigned(nlohmann::json::number_unsigned_t val) {
+			return Number(val);
+		}
+
+		bool number_float(nlohmann::json::number_float_t val, const nlohmann::json::string_t&) {
+			return Number(val);
+		}
+
+		bool string(nlohmann::json::string_t& val) {
+			CheckScalar();
+			if (m_slot.Type == Kind::Skip)
+				return true;
+			if (m_slot.Type != Kind::String)
+				TypeMismatch();
+			// Copy instead of moving, so that the lexer keeps reusing its buffer, and so that no slack is kept.
+			if (m_slot.Target2)
+				*m_slot.Target2 = val;
+			*static_cast<std::string*>(m_slot.Target) = val;
+			return true;
+		}
+
+		bool binary(nlohmann::json::binary_t&) {
+			throw CorruptDataException("Unexpected binary value");
+		}
+
+		bool start_object(std::size_t) {
+			if (m_stack.empty()) {
+				m_ttmpl = {};
+				m_rootEntry = {};
+				m_rootIsModEntry = false;
+				m_pageIndex = 0;
+				m_pendingEntriesMark = m_pendingEntries.size();
+				m_stack.push_back(Context::Root);
+				return true;
+			}
+
+			switch (m_stack.back()) {
+				case Context::SimpleModsList:
+					m_entry = EntriesOnly() ? &(m_scratchEntry = {}) : &m_ttmpl.SimpleModsList.emplace_back();
+					m_stack.push_back(Context::ModEntry);
+					return true;
+
+				case Context::ModsJsons:
+					m_entry = EntriesOnly() ? &(m_scratchEntry = {}) : &m_option->ModsJsons.emplace_back();
+					m_stack.push_back(Context::ModEntry);
+					return true;
+
+				case Context::ModPackPages:
+					m_page = EntriesOnly() ? &(m_scratchPage = {}) : &m_ttmpl.ModPackPages.emplace_back();
+					m_pageIndex++;
+					m_groupIndex = 0;
+					m_stack.push_back(Context::Page);
+					return true;
+
+				case Context::ModGroups:
+					m_group = EntriesOnly() ? &(m_scratchGroup = {}) : &m_page->ModGroups.emplace_back();
+					m_groupIndex++;
+					m_optionIndex = 0;
+					m_stack.push_back(Context::ModGroup);
+					return true;
+
+				case Context::OptionList:
+					m_option = EntriesOnly() ? &(m_scratchOption = {}) : &m_group->OptionList.emplace_back();
+					m_optionIndex++;
+					m_stack.push_back(Context::Option);
+					return true;
+
+				default:
+					break;
+			}
+
+			switch (m_slot.Type) {
+				case Kind::Skip:
+					m_stack.push_back(Context::Skip);
+					return true;
+
+				case Kind::ModPackEntry:
+					m_modPack = &static_cast<std::optional<ModPackEntry>*>(m_slot.Target)->emplace();
+					m_stack.push_back(Context::ModPackEntry);
+					return true;
+
+				default:
+					TypeMismatch();
+			}
+		}
+
+		bool key(nlohmann::json::string_t& key) {
+			m_slot = {};
+			switch (m_stack.back()) {
+				case Context::Root:
+					if (key == "ModOffset")
+						m_rootIsModEntry = true;
+
+					if (key == "Name")
+						m_slot = String(&m_ttmpl.Name, "Name", &m_rootEntry.Name);
+					else if (key == "ModPackPages")
+						m_slot = Array(Context::ModPackPages, "ModPackPages");
+					else if (key == "SimpleModsList")
+						m_slot = Array(Context::SimpleModsList, "SimpleModsList");
+					else if (key == "MinimumFrameworkVersion")
+						m_slot = Text(&m_ttmpl.MinimumFrameworkVersion, "MinimumFrameworkVersion");
+					else if (key == "FormatVersion")
+						m_slot = Text(&m_ttmpl.FormatVersion, "FormatVersion");
+					else if (key == "Author")
+						m_slot = Text(&m_ttmpl.Author, "Author");
+					else if (key == "Version")
+						m_slot = Text(&m_ttmpl.Version, "Version");
+					else if (key == "Description")
+						m_slot = Text(&m_ttmpl.Description, "Description");
+					else if (key == "Url")
+						m_slot = Text(&m_ttmpl.Url, "Url");
+					else
+						m_slot = EntryKey(key, m_rootEntry);
+					break;
+
+				case Context::ModEntry:
+					m_slot = EntryKey(key, *m_entry);
+					break;
+
+				case Context::ModPackEntry:
+					if (key == "Name")
+						m_slot = String(&m_modPack->Name, "Name");
+					else if (key == "Author")
+						m_slot = String(&m_modPack->Author, "Author");
+					else if (key == "Version")
+						m_slot = String(&m_modPack->Version, "Version");
+					else if (key == "Url")
+						m_slot = String(&m_modPack->Url, "Url");
+					break;
+
+				case Context::Page:
+					if (key == "ModGroups")
+						m_slot = Array(Context::ModGroups, "ModGroups");
+					else if (key == "PageIndex" && !EntriesOnly())
+						m_slot = { .Type = Kind::Int, .Name = "PageIndex", .Target = &m_page->PageIndex };
+					break;
+
+				case Context::ModGroup:
+					if (key == "OptionList")
+						m_slot = Array(Context::OptionList, "OptionList");
+					else if (key == "GroupName")
+						m_slot = Text(&m_group->GroupName, "GroupName");
+					else if (key == "SelectionType")
+						m_slot = Text(&m_group->SelectionType, "SelectionType");
+					break;
+
+				case Context::Option:
+					if (key == "ModsJsons")
+						m_slot = Array(Context::ModsJsons, "ModsJsons");
+					else if (key == "Name")
+						m_slot = Text(&m_option->Name, "Name");
+					else if (key == "Description")
+						m_slot = Text(&m_option->Description, "Description");
+					else if (key == "ImagePath")
+						m_slot = Text(&m_option->ImagePath, "ImagePath");
+					else if (key == "GroupName")
+						m_slot = Text(&m_option->GroupName, "GroupName");
+					else if (key == "SelectionType")
+						m_slot = Text(&m_option->SelectionType, "SelectionType");
+					else if (key == "IsChecked" && !EntriesOnly())
+						m_slot = { .Type = Kind::Bool, .Name = "IsChecked", .Target = &m_option->IsChecked };
+					break;
+
+				default:
+					break;
+			}
+			return true;
+		}
+
+		bool end_object() {
+			const auto context = m_stack.back();
+			m_stack.pop_back();
+			if (context == Context::ModEntry && EntriesOnly())
+				AddEntry(*m_entry, m_stack.back() == Context::SimpleModsList);
+			m_slot = {};
+			return true;
+		}
+
+		bool start_array(std::size_t) {
+			CheckScalar();
+			if (m_slot.Type == Kind::Skip) {
+				m_stack.push_back(Context::Skip);
+				return true;
+			}
+			if (m_slot.Type != Kind::Array)
+				TypeMismatch();
+
+			// A repeated key replaces the previous value.
+			if (!EntriesOnly()) {
+				switch (m_slot.ArrayContext) {
+					case Context::SimpleModsList:
+						m_ttmpl.SimpleModsList.clear();
+						break;
+					case Context::ModPackPages:
+						m_ttmpl.ModPackPages.clear();
+						break;
+					case Context::ModGroups:
+						m_page->ModGroups.clear();
+						break;
+					case Context::OptionList:
+						m_group->OptionList.clear();
+						break;
+					case Context::ModsJsons:
+						m_option->ModsJsons.clear();
+						break;
+					default:
+						break;
+				}
+			}
+			m_stack.push_back(m_slot.ArrayContext);
+			m_slot = {};
+			return true;
+		}
+
+		bool end_array() {
+			const auto context = m_stack.back();
+			m_stack.pop_back();
+			m_slot = {};
+			if (EntriesOnly())
+				return true;
+
+			switch (context) {
+				case Context::SimpleModsList:
+					m_ttmpl.SimpleModsList.shrink_to_fit();
+					break;
+				case Context::ModPackPages:
+					m_ttmpl.ModPackPages.shrink_to_fit();
+					break;
+				case Context::ModGroups:
+					m_page->ModGroups.shrink_to_fit();
+					break;
+				case Context::OptionList:
+					m_group->OptionList.shrink_to_fit();
+					break;
+				case Context::ModsJsons:
+					m_option->ModsJsons.shrink_to_fit();
+					break;
+				default:
+					break;
+			}
+			return true;
+		}
+
+		bool parse_error(std::size_t, const std::string&, const nlohmann::detail::exception& e) {
+			m_error = e.what();
+			m_stack.clear();
+			return false;
+		}
+	};
+}
+
+Sqex::ThirdParty::TexTools::TTMPL Sqex::ThirdParty::TexTools::TTMPL::FromStream(const RandomAccessStream& stream) {
+	TtmplSaxHandler handler;
+	handler.Parse(stream);
+	return handler.TakeResult();
+}
+
+Sqex::ThirdParty::TexTools::ModEntryTable Sqex::ThirdParty::TexTools::ModEntryTable::FromStream(const RandomAccessStream& stream) {
+	ModEntryTable table;
+	TtmplSaxHandler handler(&table);
+	handler.Parse(stream);
+	return table;
 }
 
 void Sqex::ThirdParty::TexTools::TTMPL::ForEachEntry(std::function<void(Sqex::ThirdParty::TexTools::ModEntry&)> cb) {
@@ -240,14 +842,22 @@ std::string Sqex::ThirdParty::TexTools::ModEntry::ToExpacDatPath() const {
 	return std::format("{}/{}", pathSpec.DatExpac(), pathSpec.DatFile());
 }
 
-bool Sqex::ThirdParty::TexTools::ModEntry::IsMetadata() const {
-	if (FullPath.length() < 5)
+static bool IsMetadataPath(std::string_view fullPath) {
+	if (fullPath.length() < 5)
 		return false;
-	auto metaExt = FullPath.substr(FullPath.length() - 5);
+	auto metaExt = std::string(fullPath.substr(fullPath.length() - 5));
 	CharLowerA(&metaExt[0]);
 	return metaExt == ".meta";
 }
 
+bool Sqex::ThirdParty::TexTools::ModEntry::IsMetadata() const {
+	return IsMetadataPath(FullPath);
+}
+
+bool Sqex::ThirdParty::TexTools::ModEntryTable::Entry::IsMetadata() const {
+	return IsMetadataPath(FullPath);
+}
+
 const srell::u8cregex Sqex::ThirdParty::TexTools::ItemMetadata::CharacterMetaPathTest(
 	"^(?<FullPathPrefix>chara"
 	"/(?<PrimaryType>[a-z]+)"
@@ -390,3 +1000,138 @@ void Sqex::ThirdParty::TexTools::ItemMetadata::ApplyEstEdits(Sqex::Est::File& es
 		est.Update(estpairs);
 	}
 }
+
+void Sqex::ThirdParty::TexTools::ItemMetadataBatch::Add(const ItemMetadata& metadata) {
+	if (const auto imcedit = metadata.Get<Sqex::Imc::Entry>(ItemMetadata::MetaDataType::Imc); !imcedit.empty()) {
+		const auto& typeStr = metadata.SecondaryType.empty() ? metadata.PrimaryType : metadata.SecondaryType;
+		auto& target = m_imc[metadata.TargetImcPath];
+		if (target.Edits.empty())
+			target.SourcePath = metadata.SourceImcPath;
+		target.Edits.emplace_back(ImcEdit{
+			.TypeIfUnknown = typeStr == "equipment" || typeStr == "accessory" ? Imc::Type::Set : Imc::Type::NonSet,
+			.SlotIndex = metadata.SlotIndex,
+			.Entries = std::vector<Imc::Entry>(imcedit.begin(), imcedit.end()),
+		});
+	}
+
+	if (const auto eqdpedit = metadata.Get<ItemMetadata::EqdpEntry>(ItemMetadata::MetaDataType::Eqdp); !eqdpedit.empty()) {
+		for (const auto& v : eqdpedit) {
+			m_eqdp[std::make_pair(metadata.ItemType, v.RaceCode)].emplace_back(EqdpEdit{
+				.SetId = metadata.PrimaryId,
+				.Shift = static_cast<uint8_t>(metadata.SlotIndex * 2),
+				.Value = v.Value,
+			});
+		}
+	}
+
+	if (const auto eqpedit = metadata.Get<uint8_t>(ItemMetadata::MetaDataType::Eqp); !eqpedit.empty()) {
+		if (eqpedit.size() != metadata.EqpEntrySize)
+			throw Sqex::CorruptDataException(std::format("expected {}b for eqp; got {}b", metadata.EqpEntrySize, eqpedit.size()));
+		auto& edit = m_eqp.emplace_back(EqpEdit{
+			.PrimaryId = metadata.PrimaryId,
+			.Offset = static_cast<uint8_t>(metadata.EqpEntryOffset),
+			.Size = static_cast<uint8_t>(metadata.EqpEntrySize),
+		});
+		std::copy_n(&eqpedit[0], eqpedit.size(), edit.Bytes);
+	}
+
+	if (const auto gmpedit = metadata.Get<uint8_t>(ItemMetadata::MetaDataType::Gmp); !gmpedit.empty()) {
+		if (gmpedit.size() != sizeof uint64_t)
+			throw Sqex::CorruptDataException(std::format("gmp data must be 8 bytes; {} byte(s) given", gmpedit.size()));
+		auto& edit = m_gmp.emplace_back(EqpEdit{
+			.PrimaryId = metadata.PrimaryId,
+			.Offset = 0,
+			.Size = static_cast<uint8_t>(gmpedit.size()),
+		});
+		std::copy_n(&gmpedit[0], gmpedit.size(), edit.Bytes);
+	}
+
+	if (ItemMetadata::EstPath(metadata.EstType)) {
+		if (const auto estedit = metadata.Get<ItemMetadata::EstEntry>(ItemMetadata::MetaDataType::Est); !estedit.empty()) {
+			auto& edits = m_est[metadata.EstType];
+			for (const auto& v : estedit)
+				edits.emplace_back(Sqex::Est::EntryDescriptor{ .SetId = v.SetId, .RaceCode = v.RaceCode }, v.SkelId);
+		}
+	}
+}
+
+void Sqex::ThirdParty::TexTools::ItemMetadataBatch::Clear() {
+	m_imc.clear();
+	m_eqdp.clear();
+	m_eqp.clear();
+	m_gmp.clear();
+	m_est.clear();
+}
+
+void Sqex::ThirdParty::TexTools::ItemMetadataBatch::ApplyImcEdits(std::function<Sqex::Imc::File& (const std::string&, const std::string&)> reader) const {
+	for (const auto& [targetPath, target] : m_imc) {
+		auto& imc = reader(targetPath, target.SourcePath);
+		for (const auto& edit : target.Edits) {
+			if (imc.Header().Type == Imc::Type::Unknown)
+				imc.Header().Type = edit.TypeIfUnknown;
+			imc.Ensure(edit.Entries.size() - 1);
+			const auto countPerSet = imc.EntryCountPerSet();
+			for (size_t i = 0; i < edit.Entries.size(); ++i)
+				imc.Entry(i * countPerSet + edit.SlotIndex) = edit.Entries[i];
+		}
+	}
+}
+
+void Sqex::ThirdParty::TexTools::ItemMetadataBatch::ApplyEqdpEdits(std::function<Sqex::Eqdp::ExpandedFile& (ItemMetadata::TargetItemType, uint32_t)> reader) const {
+	for (const auto& [key, edits] : m_eqdp) {
+		auto& eqdp = reader(key.first, key.second);
+		for (const auto& edit : edits) {
+			auto& target = eqdp.Set(edit.SetId);
+			target &= ~(0b11 << edit.Shift);
+			target |= edit.Value << edit.Shift;
+		}
+	}
+}
+
+void Sqex::ThirdParty::TexTools::ItemMetadataBatch::ApplyEqpEdits(Sqex::EqpGmp::ExpandedFile& eqp) const {
+	for (const auto& edit : m_eqp)
+		std::copy_n(edit.Bytes, edit.Size, &eqp.ParameterBytes(edit.PrimaryId)[edit.Offset]);
+}
+
+void Sqex::ThirdParty::TexTools::ItemMetadataBatch::ApplyGmpEdits(Sqex::EqpGmp::ExpandedFile& gmp) const {
+	for (const auto& edit : m_gmp)
+		std::copy_n(edit.Bytes, edit.Size, &gmp.ParameterBytes(edit.PrimaryId)[edit.Offset]);
+}
+
+void Sqex::ThirdParty::TexTools::ItemMetadataBatch::ApplyEstEdits(std::function<Sqex::Est::File& (ItemMetadata::TargetEstType)> reader) const {
+	const auto keyLess = [](const auto& l, const auto& r) { return l.first < r.first; };
+
+	for (const auto& [type, edits] : m_est) {
+		auto& est = reader(type);
+
+		// Later edits to the same descriptor win; a SkelId of 0 removes the entry.
+		auto sortedEdits = edits;
+		std::ranges::stable_sort(sortedEdits, keyLess);
+		size_t editCount = 0;
+		for (size_t i = 0; i < sortedEdits.size(); ++i) {
+			if (i + 1 < sortedEdits.size() && sortedEdits[i + 1].first == sortedEdits[i].first)
+				continue;
+			sortedEdits[editCount++] = sortedEdits[i];
+		}
+		sortedEdits.resize(editCount);
+
+		const auto original = est.ToSortedPairs();
+		std::vector<std::pair<Sqex::Est::EntryDescriptor, uint16_t>> merged;
+		merged.reserve(original.size() + sortedEdits.size());
+
+		auto o = original.begin();
+		auto e = sortedEdits.begin();
+		while (o != original.end() || e != sortedEdits.end()) {
+			if (e == sortedEdits.end() || (o != original.end() && o->first < e->first)) {
+				merged.emplace_back(*o++);
+			} else {
+				if (o != original.end() && o->first == e->first)
+					++o;
+				if (e->second != 0)
+					merged.emplace_back(*e);
+				++e;
+			}
+		}
+		est.Update(merged);
+	}
+}
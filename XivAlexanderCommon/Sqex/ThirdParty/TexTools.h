@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <map>
 #include <memory>
 #include <vector>
 #include <nlohmann/json.hpp>
@@ -79,6 +80,7 @@ namespace Sqex::ThirdParty::TexTools {
 		std::vector<ModPackPage::Page> ModPackPages;
 		std::vector<ModEntry> SimpleModsList;
 
+		// Parses either a TTMPL object, or newline-delimited ModEntry objects, directly from the stream without building a JSON document.
 		static TTMPL FromStream(const RandomAccessStream& stream);
 
 		enum TraverseCallbackResult {
@@ -94,6 +96,49 @@ namespace Sqex::ThirdParty::TexTools {
 	void to_json(nlohmann::json&, const TTMPL&);
 	void from_json(const nlohmann::json&, TTMPL&);
 
+	// Every ModEntry of a TTMPL, keeping only what is needed to locate the data in TTMPD.
+	// Page, group, and option texts are not kept; use TTMPL::FromStream for those, looking them up by index.
+	// All strings point into a single buffer owned by the table, so the table can be moved but not copied.
+	class ModEntryTable {
+	public:
+		static constexpr uint32_t SimpleModsListIndex = UINT32_MAX;
+
+		struct Entry {
+			std::string_view Name;
+			std::string_view FullPath;
+			uint64_t ModOffset{};
+			uint64_t ModSize{};
+
+			// Indices into TTMPL::ModPackPages, Page::ModGroups, and ModGroup::OptionList; SimpleModsListIndex if from SimpleModsList.
+			uint32_t PageIndex = SimpleModsListIndex;
+			uint32_t GroupIndex = SimpleModsListIndex;
+			uint32_t OptionIndex = SimpleModsListIndex;
+
+			bool IsMetadata() const;
+		};
+
+	private:
+		std::vector<char> m_strings;
+		std::string m_name;
+		std::vector<Entry> m_entries;
+
+	public:
+		ModEntryTable() = default;
+		ModEntryTable(ModEntryTable&&) = default;
+		ModEntryTable(const ModEntryTable&) = delete;
+		ModEntryTable& operator=(ModEntryTable&&) = default;
+		ModEntryTable& operator=(const ModEntryTable&) = delete;
+
+		// Accepts the same formats as TTMPL::FromStream, and lists entries in the same order as TTMPL::ForEachEntry.
+		static ModEntryTable FromStream(const RandomAccessStream& stream);
+
+		[[nodiscard]] const std::string& Name() const { return m_name; }
+		[[nodiscard]] std::span<const Entry> Entries() const { return m_entries; }
+
+	private:
+		friend class TtmplSaxHandler;
+	};
+
 	class ItemMetadata {
 	public:
 		static constexpr uint32_t Version_Value = 2;
@@ -233,4 +278,48 @@ namespace Sqex::ThirdParty::TexTools {
 		void ApplyGmpEdits(Sqex::EqpGmp::ExpandedFile& gmp) const;
 		void ApplyEstEdits(Sqex::Est::File& est) const;
 	};
+
+	// Collects edits from many ItemMetadata, so that each target file is loaded, merged, and serialized only once.
+	// Result is identical to calling ItemMetadata::Apply*Edits on each added item in the order they were added.
+	class ItemMetadataBatch {
+		struct ImcEdit {
+			Imc::Type TypeIfUnknown;
+			size_t SlotIndex;
+			std::vector<Imc::Entry> Entries;
+		};
+
+		struct ImcTarget {
+			std::string SourcePath;
+			std::vector<ImcEdit> Edits;
+		};
+
+		struct EqdpEdit {
+			uint16_t SetId;
+			uint8_t Shift;
+			uint8_t Value;
+		};
+
+		struct EqpEdit {
+			uint16_t PrimaryId;
+			uint8_t Offset;
+			uint8_t Size;
+			uint8_t Bytes[8];
+		};
+
+		std::map<std::string, ImcTarget> m_imc;
+		std::map<std::pair<ItemMetadata::TargetItemType, uint32_t>, std::vector<EqdpEdit>> m_eqdp;
+		std::vector<EqpEdit> m_eqp;
+		std::vector<EqpEdit> m_gmp;
+		std::map<ItemMetadata::TargetEstType, std::vector<std::pair<Est::EntryDescriptor, uint16_t>>> m_est;
+
+	public:
+		void Add(const ItemMetadata& metadata);
+		void Clear();
+
+		void ApplyImcEdits(std::function<Sqex::Imc::File& (const std::string& targetImcPath, const std::string& sourceImcPath)> reader) const;
+		void ApplyEqdpEdits(std::function<Sqex::Eqdp::ExpandedFile& (ItemMetadata::TargetItemType, uint32_t)> reader) const;
+		void ApplyEqpEdits(Sqex::EqpGmp::ExpandedFile& eqp) const;
+		void ApplyGmpEdits(Sqex::EqpGmp::ExpandedFile& gmp) const;
+		void ApplyEstEdits(std::function<Sqex::Est::File& (ItemMetadata::TargetEstType)> reader) const;
+	};
 }
\ No newline at end of file
@@ -0,0 +1,602 @@
+#include "pch.h"
+#include "XivAlexanderCommon/Sqex/ZiPatch.h"
+
+#include <atomic>
+#include <deque>
+#include <thread>
+
+#include "XivAlexanderCommon/Sqex/Sqpack/Structure.h"
+#include "XivAlexanderCommon/Utils/CallOnDestruction.h"
+
+const uint8_t Sqex::ZiPatch::Header::Signature_Value[12]{ 0x91, 0x5a, 0x49, 0x50, 0x41, 0x54, 0x43, 0x48, 0x0d, 0x0a, 0x1a, 0x0a };
+const char Sqex::ZiPatch::Chunk::PlatformNames[3][6]{
+	"win32", "ps3\0\0", "ps4\0\0",
+};
+
+void Sqex::ZiPatch::ReplaceBlock(std::vector<FilePart>& parts, const FilePart& part) {
+	if (part.TargetSize == 0)
+		return;
+	for (const auto splitOffset : std::set<uint64_t>{ part.TargetOffset, part.TargetOffset + part.TargetSize }) {
+		if (parts.empty()) {
+			if (splitOffset)
+				parts.emplace_back(FilePart{
+					.TargetOffset = 0,
+					.TargetSize = splitOffset,
+					.SourceIndex = FilePart::SourceIndex_Zeros,
+					});
+			continue;
+		}
+
+		const auto endOffset = parts.back().TargetOffset + parts.back().TargetSize;
+		auto i = std::lower_bound(parts.begin(), parts.end(), splitOffset);
+
+		if (i == parts.end() && endOffset == splitOffset)
+			continue;
+
+		if (i == parts.end() && splitOffset > endOffset) {
+			parts.emplace_back(FilePart{
+				.TargetOffset = endOffset,
+				.TargetSize = splitOffset - endOffset,
+				.SourceIndex = FilePart::SourceIndex_Zeros,
+				});
+			continue;
+		}
+
+		if (i < parts.end() && i->TargetOffset == splitOffset)
+			continue;
+
+		if (i == parts.begin()) {
+			if (splitOffset == 0) {
+				parts.emplace(i, FilePart{
+					.TargetOffset = 0,
+					.TargetSize = parts.front().TargetOffset,
+					});
+			} else {
+				i = parts.insert(i, FilePart{
+					.TargetOffset = 0,
+					.TargetSize = splitOffset,
+					.SourceIndex = FilePart::SourceIndex_Zeros,
+					});
+				parts.emplace(i, FilePart{
+					.TargetOffset = splitOffset,
+					.TargetSize = parts[1].TargetOffset - splitOffset,
+					.SourceIndex = FilePart::SourceIndex_Zeros,
+					});
+			}
+		} else {
+			const auto insertAt = i--;
+			const auto prevTargetSize = i->TargetSize;
+			i->TargetSize = splitOffset - i->TargetOffset;
+			parts.emplace(insertAt, FilePart{
+				.TargetOffset = splitOffset,
+				.TargetSize = i->TargetOffset + prevTargetSize - splitOffset,
+				.SourceIndex = i->SourceIndex,
+				.SourceOffset = i->SourceOffset,
+				.SourceSize = i->SourceSize,
+				.SplitFrom = static_cast<uint32_t>(i->SplitFrom + splitOffset - i->TargetOffset),
+				.SourceIsDeflated = i->SourceIsDeflated,
+				});
+		}
+	}
+
+	auto it1 = std::lower_bound(parts.begin(), parts.end(), part.TargetOffset);
+	const auto it2 = std::lower_bound(parts.begin(), parts.end(), part.TargetOffset + part.TargetSize);
+
+	if (it1 == parts.end() || it1->TargetOffset != part.TargetOffset)
+		throw std::logic_error("A");
+
+	if (it2 != parts.end() && it2->TargetOffset != part.TargetOffset + part.TargetSize)
+		throw std::logic_error("B");
+	else if (it2 == parts.end() && parts.back().TargetOffset + parts.back().TargetSize != part.TargetOffset + part.TargetSize)
+		throw std::logic_error("C");
+
+	*it1 = part;
+	++it1;
+	parts.erase(it1, it2);
+}
+
+Sqex::ZiPatch::MergedFilePartStream::MergedFilePartStream(std::vector<std::shared_ptr<const RandomAccessStream>> sources, std::vector<FilePart> parts)
+	: m_sources(std::move(sources))
+	, m_parts(std::move(parts)) {
+}
+
+uint64_t Sqex::ZiPatch::MergedFilePartStream::ReadStreamPartial(uint64_t offset, void* buf, uint64_t length) const {
+	if (m_parts.empty())
+		return 0;
+
+	std::unique_ptr<Utils::ZlibReusableInflater> inflater;
+	const auto inflaterCleanup = Utils::CallOnDestruction([&]() {
+		if (!inflater)
+			return;
+		const auto lock = std::lock_guard(m_inflaterMtx);
+		m_inflaters.emplace_back(std::move(inflater));
+		});
+
+	auto out = std::span(static_cast<uint8_t*>(buf), static_cast<size_t>(length));
+	auto relativeOffset = offset;
+
+	auto it = std::lower_bound(m_parts.begin(), m_parts.end(), offset);
+	if (it != m_parts.begin())
+		--it;
+	relativeOffset -= it->TargetOffset;
+
+	std::vector<uint8_t> deflated;
+	for (; !out.empty() && it != m_parts.end(); ++it) {
+		auto& part = *it;
+		if (part.TargetSize <= relativeOffset) {
+			relativeOffset -= part.TargetSize;
+			continue;
+		}
+
+		if (part.SourceIndex == FilePart::SourceIndex_Zeros) {
+			const auto available = std::min(out.size(), static_cast<size_t>(part.TargetSize - relativeOffset));
+			std::fill_n(out.begin(), available, 0);
+			out = out.subspan(available);
+			relativeOffset = 0;
+
+		} else if (part.SourceIndex == FilePart::SourceIndex_EmptyBlock) {
+			uint8_t srcbuf[256]{};
+			*reinterpret_cast<Sqpack::SqData::FileEntryHeader*>(srcbuf) = {
+					.HeaderSize = EntryAlignment,
+					.Type = Sqpack::SqData::FileEntryType::None,
+					.AllocatedSpaceUnitCount = part.SourceSize,
+			};
+			const auto src = std::span(srcbuf).subspan(part.SplitFrom, static_cast<size_t>(part.TargetSize)).subspan(static_cast<size_t>(relativeOffset));
+			const auto available = std::min(out.size_bytes(), src.size_bytes());
+			std::copy_n(src.begin(), available, out.begin());
+			out = out.subspan(available);
+			relativeOffset = 0;
+
+		} else {
+			const auto& in = m_sources[part.SourceIndex];
+
+			if (part.SourceIsDeflated) {
+				deflated.resize(part.SourceSize);
+				in->ReadStream(part.SourceOffset, &deflated[0], deflated.size());
+
+				if (!inflater) {
+					const auto lock = std::lock_guard(m_inflaterMtx);
+					if (!m_inflaters.empty()) {
+						inflater = std::move(m_inflaters.back());
+						m_inflaters.pop_back();
+					}
+				}
+				if (!inflater)
+					inflater = std::make_unique<Utils::ZlibReusableInflater>(-MAX_WBITS);
+
+				const auto src = (*inflater)(deflated)
+					.subspan(part.SplitFrom, static_cast<size_t>(part.TargetSize))
+					.subspan(static_cast<size_t>(relativeOffset));
+				const auto available = std::min(out.size_bytes(), src.size_bytes());
+				std::copy_n(src.begin(), available, out.begin());
+				out = out.subspan(available);
+				relativeOffset = 0;
+
+			} else {
+				const auto from = 0ULL + part.SourceOffset + part.SplitFrom + relativeOffset;
+				const auto available = std::min<uint64_t>(part.TargetSize - relativeOffset, out.size_bytes());
+				in->ReadStream(from, &out[0], available);
+				out = out.subspan(static_cast<size_t>(available));
+				relativeOffset = 0;
+			}
+		}
+	}
+
+	return length - out.size_bytes();
+}
+
+void Sqex::ZiPatch::PatchSet::AddPatch(std::shared_ptr<const RandomAccessStream> patch) {
+	if (m_sources.size() >= FilePart::SourceIndex_EmptyBlock)
+		throw std::out_of_range("too many patch files");
+	const auto sourceIndex = static_cast<uint32_t>(m_sources.size());
+
+	const auto patchHeader = patch->ReadStream<Header>(0);
+	if (0 != memcmp(patchHeader.Signature, Header::Signature_Value, sizeof Header::Signature_Value))
+		throw CorruptDataException("bad zipatch signature");
+
+	m_sources.emplace_back(patch);
+
+	const auto toSourceOffset = [](uint64_t offset) {
+		if (offset > UINT32_MAX)
+			throw CorruptDataException("patch file too big");
+		return static_cast<uint32_t>(offset);
+	};
+
+	auto platform = Chunk::Platform::Win32;
+	const auto patchSize = patch->StreamSize();
+	std::vector<uint8_t> chunk;
+	const auto readChunk = [&]<typename T>(uint64_t chunkOffset, size_t extraSize = 0) -> const T& {
+		chunk.resize(sizeof(T) + extraSize);
+		patch->ReadStream(chunkOffset, &chunk[0], chunk.size());
+		return *reinterpret_cast<const T*>(&chunk[0]);
+	};
+
+	for (uint64_t chunkOffset = sizeof(Header), chunkEndOffset; chunkOffset + sizeof(Chunk::ChunkHeader) <= patchSize; chunkOffset = chunkEndOffset) {
+		const auto chunkHeader = patch->ReadStream<Chunk::ChunkHeader>(chunkOffset);
+		const auto chunkType = chunkHeader.Type.Value();
+		chunkEndOffset = chunkOffset + sizeof(Chunk::ChunkHeader) + chunkHeader.Size + sizeof(Chunk::ChunkFooter);
+
+		switch (chunkType) {
+			case Chunk::TypeValues::AddDirectory:
+			{
+				const auto dirNameSize = readChunk.operator()<Chunk::AddDirectory>(chunkOffset).DirNameSize.Value();
+				const auto& data = readChunk.operator()<Chunk::AddDirectory>(chunkOffset, dirNameSize);
+				m_addedDirectories.emplace_back(data.DirName, dirNameSize - 1);
+				break;
+			}
+
+			case Chunk::TypeValues::DeleteDirectory:
+			{
+				const auto dirNameSize = readChunk.operator()<Chunk::DeleteDirectory>(chunkOffset).DirNameSize.Value();
+				const auto& data = readChunk.operator()<Chunk::DeleteDirectory>(chunkOffset, dirNameSize);
+				m_deletedDirectories.emplace_back(data.DirName, dirNameSize - 1);
+				break;
+			}
+
+			case Chunk::TypeValues::EndOfFile:
+				return;
+
+			case Chunk::TypeValues::Sqpk:
+			{
+				const auto sqpkChunkType = readChunk.operator()<Chunk::SqpkBase>(chunkOffset).SqpkChunkType.Value();
+				switch (sqpkChunkType) {
+					case Chunk::SqpkChunkTypeValues::FileAdd:
+					{
+						const auto pathSize = readChunk.operator()<Chunk::SqpkFile>(chunkOffset).PathSize.Value();
+						const auto& data = readChunk.operator()<Chunk::SqpkFile>(chunkOffset, pathSize);
+						const auto path = std::string(data.Path, pathSize - 1);
+						const auto targetBegin = data.TargetOffset.Value();
+						const auto targetEnd = targetBegin + data.TargetSize.Value();
+
+						auto& parts = m_files[path];
+						m_deletedFiles.erase(path);
+						if (targetBegin == 0)
+							parts.clear();
+
+						auto blockOffset = chunkOffset + offsetof(Chunk::SqpkFile, Path) + pathSize;
+						for (uint64_t targetOffset = targetBegin; targetOffset < targetEnd;) {
+							const auto blockHeader = patch->ReadStream<Sqpack::SqData::BlockHeader>(blockOffset);
+							if (blockHeader.DecompressedSize == 0)
+								throw CorruptDataException("empty block in SqpkFile");
+
+							const auto isDeflated = blockHeader.CompressedSize != Sqpack::SqData::BlockHeader::CompressedSizeNotCompressed;
+							const auto blockDataSize = isDeflated ? blockHeader.CompressedSize : blockHeader.DecompressedSize;
+							ReplaceBlock(parts, FilePart{
+								.TargetOffset = targetOffset,
+								.TargetSize = blockHeader.DecompressedSize,
+								.SourceIndex = sourceIndex,
+								.SourceOffset = toSourceOffset(blockOffset + blockHeader.HeaderSize),
+								.SourceSize = blockDataSize,
+								.SourceIsDeflated = isDeflated ? 1U : 0U,
+								});
+
+							blockOffset += Align(blockHeader.HeaderSize + blockDataSize).Alloc;
+							targetOffset += blockHeader.DecompressedSize;
+						}
+						break;
+					}
+
+					case Chunk::SqpkChunkTypeValues::FileRemoveAll:
+					{
+						const auto& data = readChunk.operator()<Chunk::SqpkFile>(chunkOffset);
+						const auto expacName = data.ExpacId == 0 ? std::string("ffxiv") : std::format("ex{}", data.ExpacId.Value());
+						const auto sqpackPrefix = std::format("sqpack/{}/", expacName);
+						const auto moviePrefix = std::format("movie/{}/", expacName);
+						for (auto it = m_files.begin(); it != m_files.end();) {
+							if (it->first.starts_with(sqpackPrefix) || it->first.starts_with(moviePrefix)) {
+								m_deletedFiles.insert(it->first);
+								it = m_files.erase(it);
+							} else
+								++it;
+						}
+						break;
+					}
+
+					case Chunk::SqpkChunkTypeValues::FileDelete:
+					{
+						const auto pathSize = readChunk.operator()<Chunk::SqpkFile>(chunkOffset).PathSize.Value();
+						const auto& data = readChunk.operator()<Chunk::SqpkFile>(chunkOffset, pathSize);
+						const auto path = std::string(data.Path, pathSize - 1);
+						m_files.erase(path);
+						m_deletedFiles.insert(path);
+						break;
+					}
+
+					case Chunk::SqpkChunkTypeValues::FileMakeTree:
+					{
+						const auto pathSize = readChunk.operator()<Chunk::SqpkFile>(chunkOffset).PathSize.Value();
+						const auto& data = readChunk.operator()<Chunk::SqpkFile>(chunkOffset, pathSize);
+						m_addedDirectories.emplace_back(data.Path, pathSize - 1);
+						break;
+					}
+
+					case Chunk::SqpkChunkTypeValues::TargetInfo:
+						platform = readChunk.operator()<Chunk::SqpkTargetInfo>(chunkOffset).Platform.Value();
+						break;
+
+					case Chunk::SqpkChunkTypeValues::DataAdd:
+					{
+						const auto& data = readChunk.operator()<Chunk::SqpkDataAdd>(chunkOffset);
+						auto& parts = m_files[data.ToPath(platform)];
+						ReplaceBlock(parts, FilePart{
+							.TargetOffset = 1ULL * data.TargetBlockIndex * EntryAlignment,
+							.TargetSize = 1ULL * data.TargetDataBlockCount * EntryAlignment,
+							.SourceIndex = sourceIndex,
+							.SourceOffset = toSourceOffset(chunkOffset + sizeof(Chunk::SqpkDataAdd)),
+							.SourceSize = data.TargetDataBlockCount * EntryAlignment,
+							});
+						if (data.TargetClearBlockCount) {
+							ReplaceBlock(parts, FilePart{
+								.TargetOffset = (1ULL * data.TargetBlockIndex + data.TargetDataBlockCount) * EntryAlignment,
+								.TargetSize = 1ULL * data.TargetClearBlockCount * EntryAlignment,
+								.SourceIndex = FilePart::SourceIndex_Zeros,
+								.SourceSize = data.TargetClearBlockCount - 1,
+								});
+						}
+						break;
+					}
+
+					case Chunk::SqpkChunkTypeValues::DataDelete:
+					case Chunk::SqpkChunkTypeValues::DataExpand:
+					{
+						const auto& data = readChunk.operator()<Chunk::SqpkDataExpandDelete>(chunkOffset);
+						auto& parts = m_files[data.ToPath(platform)];
+						ReplaceBlock(parts, FilePart{
+							.TargetOffset = 1ULL * data.TargetBlockIndex * EntryAlignment,
+							.TargetSize = EntryAlignment,
+							.SourceIndex = FilePart::SourceIndex_EmptyBlock,
+							.SourceSize = data.TargetDataBlockCount - 1,
+							});
+						if (data.TargetDataBlockCount) {
+							ReplaceBlock(parts, FilePart{
+								.TargetOffset = (1ULL * data.TargetBlockIndex + 1) * EntryAlignment,
+								.TargetSize = (data.TargetDataBlockCount - 1ULL) * EntryAlignment,
+								.SourceIndex = FilePart::SourceIndex_Zeros,
+								});
+						}
+						break;
+					}
+
+					case Chunk::SqpkChunkTypeValues::DatHeaderVersion:
+					case Chunk::SqpkChunkTypeValues::DatHeaderSqpack:
+					{
+						const auto& data = readChunk.operator()<Chunk::SqpkDatHeader>(chunkOffset);
+						ReplaceBlock(m_files[data.ToPath(platform)], FilePart{
+							.TargetOffset = sqpkChunkType == Chunk::SqpkChunkTypeValues::DatHeaderVersion ? 0ULL : 1024ULL,
+							.TargetSize = 1024,
+							.SourceIndex = sourceIndex,
+							.SourceOffset = toSourceOffset(chunkOffset + sizeof(Chunk::SqpkDatHeader)),
+							.SourceSize = 1024,
+							});
+						break;
+					}
+
+					case Chunk::SqpkChunkTypeValues::IndexHeaderVersion:
+					case Chunk::SqpkChunkTypeValues::IndexHeaderSqpack:
+					{
+						const auto& data = readChunk.operator()<Chunk::SqpkIndexHeader>(chunkOffset);
+						ReplaceBlock(m_files[data.ToPath(platform)], FilePart{
+							.TargetOffset = sqpkChunkType == Chunk::SqpkChunkTypeValues::IndexHeaderVersion ? 0ULL : 1024ULL,
+							.TargetSize = 1024,
+							.SourceIndex = sourceIndex,
+							.SourceOffset = toSourceOffset(chunkOffset + sizeof(Chunk::SqpkIndexHeader)),
+							.SourceSize = 1024,
+							});
+						break;
+					}
+
+					default:
+						// IndexAdd, IndexDelete, PatchInfo, and unknown commands do not change file contents.
+						break;
+				}
+				break;
+			}
+
+			default:
+				// FileHeader, ApplyOption, and unknown chunks do not change file contents.
+				break;
+		}
+	}
+}
+
+std::shared_ptr<Sqex::ZiPatch::MergedFilePartStream> Sqex::ZiPatch::PatchSet::GetFile(const std::string& path) const {
+	return std::make_shared<MergedFilePartStream>(m_sources, m_files.at(path));
+}
+
+namespace Sqex::ZiPatch {
+	class FilesystemTargetFile : public TargetFile {
+		std::mutex m_mtx;
+		std::fstream m_stream;
+
+	public:
+		FilesystemTargetFile(const std::filesystem::path& path, uint64_t size) {
+			create_directories(path.parent_path());
+			void(std::ofstream(path, std::ios::binary | std::ios::trunc));
+			std::filesystem::resize_file(path, size);
+			m_stream.exceptions(std::ios::failbit | std::ios::badbit);
+			m_stream.open(path, std::ios::binary | std::ios::in | std::ios::out);
+		}
+
+		void Write(uint64_t offset, std::span<const uint8_t> data) override {
+			const auto lock = std::lock_guard(m_mtx);
+			m_stream.seekp(static_cast<std::streamoff>(offset));
+			m_stream.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+		}
+	};
+}
+
+Sqex::ZiPatch::FilesystemTargetBackend::FilesystemTargetBackend(std::filesystem::path root)
+	: m_root(std::move(root)) {
+}
+
+void Sqex::ZiPatch::FilesystemTargetBackend::CreateDirectories(const std::string& path) {
+	create_directories(m_root / path);
+}
+
+void Sqex::ZiPatch::FilesystemTargetBackend::Remove(const std::string& path) {
+	std::filesystem::remove(m_root / path);
+}
+
+std::unique_ptr<Sqex::ZiPatch::TargetFile> Sqex::ZiPatch::FilesystemTargetBackend::Create(const std::string& path, uint64_t size) {
+	return std::make_unique<FilesystemTargetFile>(m_root / path, size);
+}
+
+Sqex::ZiPatch::ApplyResult Sqex::ZiPatch::Apply(const PatchSet& patchSet, TargetBackend& backend, const ApplyOptions& options) {
+	// Zero-filled ranges at least this big are left to TargetBackend::Create instead of being written.
+	static constexpr uint64_t MinSkippedZeroRangeSize = 65536;
+
+	// Targets are opened when their first unit gets picked up, and closed once their last unit is done,
+	// so that only about as many files as there are threads are open at a time.
+	struct FileWork {
+		std::string Path;
+		std::shared_ptr<MergedFilePartStream> Stream;
+		size_t UnitCount = 0;
+
+		std::mutex TargetMtx;
+		std::unique_ptr<TargetFile> Target;
+		std::atomic<size_t> UnitsDone = 0;
+	};
+
+	struct WorkUnit {
+		size_t FileIndex;
+		uint64_t Offset;
+		uint64_t Size;
+		bool AllZeros;
+	};
+
+	ApplyResult result;
+
+	for (const auto& path : patchSet.DeletedFiles())
+		backend.Remove(path);
+	for (const auto& path : patchSet.AddedDirectories())
+		backend.CreateDirectories(path);
+
+	// Step. Split every file into contiguous ranges that can be produced and written independently.
+	const auto maxWriteSize = std::clamp<uint64_t>(options.MaxWriteSize, EntryAlignment, 1 << 30);
+	std::deque<FileWork> files;
+	std::vector<WorkUnit> units;
+	for (const auto& path : patchSet.Files() | std::views::keys) {
+		auto& file = files.emplace_back();
+		file.Path = path;
+		file.Stream = patchSet.GetFile(path);
+		result.TotalBytes += file.Stream->StreamSize();
+		const auto firstUnit = units.size();
+
+		const auto fileIndex = files.size() - 1;
+		for (const auto& part : file.Stream->Parts()) {
+			const auto isLargeZeros = part.SourceIndex == FilePart::SourceIndex_Zeros && part.TargetSize >= MinSkippedZeroRangeSize;
+			for (uint64_t offset = part.TargetOffset, end = part.TargetOffset + part.TargetSize; offset < end;) {
+				if (!units.empty()) {
+					auto& prev = units.back();
+					if (prev.FileIndex == fileIndex && !prev.AllZeros && !isLargeZeros && prev.Size < maxWriteSize) {
+						const auto take = std::min(end - offset, maxWriteSize - prev.Size);
+						prev.Size += take;
+						offset += take;
+						continue;
+					}
+				}
+				const auto take = std::min(end - offset, maxWriteSize);
+				units.emplace_back(WorkUnit{ .FileIndex = fileIndex, .Offset = offset, .Size = take, .AllZeros = isLargeZeros });
+				offset += take;
+			}
+		}
+
+		// Empty files have no unit to open them.
+		file.UnitCount = units.size() - firstUnit;
+		if (!file.UnitCount)
+			void(backend.Create(path, 0));
+	}
+
+	// Step. Produce and write units in parallel; deflated blocks get inflated by whichever thread needs them.
+	std::vector<uint32_t> unitCrc32(options.Verify ? units.size() : 0);
+	std::atomic<size_t> nextUnit = 0;
+	std::atomic<uint64_t> progress = 0;
+	std::atomic<uint64_t> written = 0;
+	std::mutex createMtx;
+	std::mutex errorMtx;
+	std::exception_ptr error;
+
+	const auto worker = [&]() {
+		std::vector<uint8_t> buf;
+		std::vector<uint8_t> zeros;
+		try {
+			for (size_t i; (i = nextUnit++) < units.size();) {
+				const auto& unit = units[i];
+				auto& file = files[unit.FileIndex];
+
+				TargetFile* target;
+				{
+					const auto lock = std::lock_guard(file.TargetMtx);
+					if (!file.Target) {
+						const auto createLock = std::lock_guard(createMtx);
+						file.Target = backend.Create(file.Path, file.Stream->StreamSize());
+					}
+					target = file.Target.get();
+				}
+
+				if (unit.AllZeros) {
+					if (options.Verify) {
+						zeros.resize(std::max(zeros.size(), static_cast<size_t>(unit.Size)));
+						const auto crc = crc32_z(0, &zeros[0], static_cast<size_t>(unit.Size));
+						unitCrc32[i] = static_cast<uint32_t>(crc);
+					}
+
+				} else {
+					buf.resize(static_cast<size_t>(unit.Size));
+					file.Stream->ReadStream(unit.Offset, std::span(buf));
+					target->Write(unit.Offset, buf);
+					written += unit.Size;
+
+					if (options.Verify)
+						unitCrc32[i] = static_cast<uint32_t>(crc32_z(0, &buf[0], buf.size()));
+				}
+
+				if (++file.UnitsDone == file.UnitCount) {
+					const auto lock = std::lock_guard(file.TargetMtx);
+					file.Target.reset();
+				}
+
+				const auto current = progress += unit.Size;
+				if (options.OnProgress)
+					options.OnProgress(current, result.TotalBytes);
+			}
+		} catch (...) {
+			const auto lock = std::lock_guard(errorMtx);
+			if (!error)
+				error = std::current_exception();
+			nextUnit = units.size();
+		}
+	};
+
+	{
+		auto threadCount = options.ThreadCount ? options.ThreadCount : std::max<size_t>(1, std::thread::hardware_concurrency());
+		threadCount = std::min(threadCount, std::max<size_t>(1, units.size()));
+		std::vector<std::thread> threads;
+		threads.reserve(threadCount - 1);
+		for (size_t i = 1; i < threadCount; ++i)
+			threads.emplace_back(worker);
+		worker();
+		for (auto& thread : threads)
+			thread.join();
+	}
+	if (error)
+		std::rethrow_exception(error);
+
+	result.WrittenBytes = written;
+
+	// Step. Combine CRC32 of units, which are ordered by file and then by offset.
+	if (options.Verify) {
+		for (size_t i = 0; i < units.size(); ++i) {
+			const auto& unit = units[i];
+			const auto [it, isNew] = result.FileCrc32.emplace(files[unit.FileIndex].Path, unitCrc32[i]);
+			if (!isNew)
+				it->second = static_cast<uint32_t>(crc32_combine(it->second, unitCrc32[i], static_cast<z_off_t>(unit.Size)));
+		}
+		for (const auto& file : files) {
+			if (!file.Stream->StreamSize())
+				result.FileCrc32.emplace(file.Path, static_cast<uint32_t>(crc32_z(0, nullptr, 0)));
+		}
+	}
+
+	return result;
+}
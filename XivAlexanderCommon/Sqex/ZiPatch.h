@@ -0,0 +1,321 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "XivAlexanderCommon/Sqex/RandomAccessStream.h"
+#include "XivAlexanderCommon/Utils/ZlibWrapper.h"
+
+namespace Sqex::ZiPatch {
+	static constexpr uint32_t FromChars(char c1 = 0, char c2 = 0, char c3 = 0, char c4 = 0) {
+		return static_cast<uint32_t>(c1) << 24
+			| static_cast<uint32_t>(c2) << 16
+			| static_cast<uint32_t>(c3) << 8
+			| static_cast<uint32_t>(c4) << 0;
+	}
+
+	struct Header {
+		static const uint8_t Signature_Value[12];
+
+		char Signature[12];
+	};
+
+	namespace Chunk {
+		enum class TypeValues {
+			AddDirectory = FromChars('A', 'D', 'I', 'R'),
+			ApplyOption = FromChars('A', 'P', 'L', 'Y'),
+			DeleteDirectory = FromChars('D', 'E', 'L', 'D'),
+			EndOfFile = FromChars('E', 'O', 'F', '_'),
+			FileHeader = FromChars('F', 'H', 'D', 'R'),
+			Sqpk = FromChars('S', 'Q', 'P', 'K'),
+		};
+
+		struct ChunkHeader {
+			Utils::BE<uint32_t> Size;
+			Utils::BE<TypeValues> Type;
+		};
+
+		struct ChunkFooter {
+			Utils::BE<uint32_t> Crc32;
+		};
+
+		struct AddDirectory : ChunkHeader {
+			Utils::BE<uint32_t> DirNameSize;
+			char DirName[1];
+		};
+
+		struct ApplyOption : ChunkHeader {
+			enum class OptionType : uint32_t {
+				IgnoreMissing = 1,
+				IgnoreOldMismatch = 2,
+			};
+
+			Utils::BE<OptionType> Type;
+			Utils::BE<uint32_t> Unknown_0x004;
+			Utils::BE<uint32_t> Value;
+		};
+
+		struct DeleteDirectory : ChunkHeader {
+			Utils::BE<uint32_t> DirNameSize;
+			char DirName[1];
+		};
+
+		struct EndOfFile : ChunkHeader {
+		};
+
+		struct FileHeader : ChunkHeader {
+			Utils::BE<uint16_t> Unknown_0x000;
+			uint8_t Version;
+			uint8_t Unknown_0x003;
+			char PatchType[4];
+			Utils::BE<uint32_t> EntryFiles;
+		};
+
+		struct FileHeaderV3 : ChunkHeader {
+			Utils::BE<uint32_t> AddDirectories;
+			Utils::BE<uint32_t> DeleteDirectories;
+			Utils::BE<uint64_t> DeleteDataSize;
+			Utils::BE<uint32_t> MinorVersion;
+			Utils::BE<uint32_t> RepositoryName;
+			Utils::BE<uint32_t> Commands;
+			Utils::BE<uint32_t> SqpkAddCommands;
+			Utils::BE<uint32_t> SqpkDeleteCommands;
+			Utils::BE<uint32_t> SqpkExpandCommands;
+			Utils::BE<uint32_t> SqpkHeaderCommands;
+			Utils::BE<uint32_t> SqpkFileCommands;
+		};
+
+		enum class SqpkChunkTypeValues : uint32_t {
+			FileAdd = FromChars('F', 'A'),
+			FileRemoveAll = FromChars('F', 'R'),
+			FileDelete = FromChars('F', 'D'),
+			FileMakeTree = FromChars('F', 'M'),
+			IndexAdd = FromChars('I', 'A'),
+			IndexDelete = FromChars('I', 'D'),
+			PatchInfo = FromChars('X', 0, 1),
+			TargetInfo = FromChars('T'),
+			DataAdd = FromChars('A'),
+			DataDelete = FromChars('D'),
+			DataExpand = FromChars('E', 'A'),
+			DatHeaderVersion = FromChars('H', 'D', 'V'),
+			DatHeaderSqpack = FromChars('H', 'D', 'D'),
+			IndexHeaderVersion = FromChars('H', 'I', 'V'),
+			IndexHeaderSqpack = FromChars('H', 'I', 'I'),
+		};
+
+		struct SqpkBase : ChunkHeader {
+			Utils::BE<uint32_t> Size;
+			Utils::BE<SqpkChunkTypeValues> SqpkChunkType;
+		};
+
+		struct SqpkFile : SqpkBase {
+			Utils::BE<uint64_t> TargetOffset;
+			Utils::BE<uint64_t> TargetSize;
+			Utils::BE<uint32_t> PathSize;
+			Utils::BE<uint16_t> ExpacId;
+			Utils::BE<uint16_t> Padding_0x016;
+			char Path[1];
+		};
+
+		enum class Platform : uint16_t {
+			Win32 = 0,
+			Ps3 = 1,
+			Ps4 = 2,
+		};
+
+		extern const char PlatformNames[3][6];
+
+		struct SqpkTargetInfo : SqpkBase {
+			Utils::BE<Chunk::Platform> Platform;
+			Utils::BE<uint16_t> Region;
+			Utils::BE<uint16_t> IsDebug;
+			Utils::BE<uint16_t> Version;
+			Utils::BE<uint64_t> DeletedDataSize;
+			Utils::BE<uint64_t> SeekCount;
+		};
+
+		struct BaseSqpkTargetedCommand : SqpkBase {
+			Utils::BE<uint16_t> MainId;
+			union {
+				uint8_t ExpacId;
+				Utils::BE<uint16_t> SubId;
+			};
+			Utils::BE<uint32_t> FileId;
+		};
+
+		struct BaseSqpkDataTargetedCommand : BaseSqpkTargetedCommand {
+			std::string ToPath(Platform platform) const {
+				if (ExpacId)
+					return std::format("sqpack/ex{}/{:02x}{:04x}.{}.dat{}", ExpacId, MainId.Value(), SubId.Value(), PlatformNames[static_cast<size_t>(platform)], FileId.Value());
+				else
+					return std::format("sqpack/ffxiv/{:02x}{:04x}.{}.dat{}", MainId.Value(), SubId.Value(), PlatformNames[static_cast<size_t>(platform)], FileId.Value());
+			}
+		};
+
+		struct BaseSqpkIndexTargetedCommand : BaseSqpkTargetedCommand {
+			std::string ToPath(Platform platform) const {
+				if (ExpacId)
+					return std::format("sqpack/ex{}/{:02x}{:04x}.{}.index", ExpacId, MainId.Value(), SubId.Value(), PlatformNames[static_cast<size_t>(platform)]);
+				else
+					return std::format("sqpack/ffxiv/{:02x}{:04x}.{}.index", MainId.Value(), SubId.Value(), PlatformNames[static_cast<size_t>(platform)]);
+			}
+		};
+
+		struct SqpkDataAdd : BaseSqpkDataTargetedCommand {
+			Utils::BE<uint32_t> TargetBlockIndex;
+			Utils::BE<uint32_t> TargetDataBlockCount;
+			Utils::BE<uint32_t> TargetClearBlockCount;
+		};
+
+		struct SqpkDataExpandDelete : BaseSqpkDataTargetedCommand {
+			Utils::BE<uint32_t> TargetBlockIndex;
+			Utils::BE<uint32_t> TargetDataBlockCount;
+		};
+
+		struct SqpkDatHeader : BaseSqpkDataTargetedCommand {
+		};
+
+		struct SqpkIndexHeader : BaseSqpkIndexTargetedCommand {
+		};
+	}
+
+	struct FilePart {
+		static constexpr uint16_t SourceIndex_Zeros = UINT16_MAX;
+		static constexpr uint16_t SourceIndex_EmptyBlock = UINT16_MAX - 1;
+
+		uint64_t TargetOffset;
+		uint64_t TargetSize;
+		
+		uint32_t SourceIndex;
+		uint32_t SourceOffset;
+		uint32_t SourceSize;
+		uint32_t SplitFrom;
+
+		uint32_t SourceIsDeflated : 1;
+		uint32_t Reserved : 31;
+
+		bool operator <(const FilePart& r) const {
+			return TargetOffset < r.TargetOffset;
+		}
+
+		bool operator >(const FilePart& r) const {
+			return TargetOffset > r.TargetOffset;
+		}
+
+		bool operator <(const uint64_t& r) const {
+			return TargetOffset < r;
+		}
+
+		bool operator >(const uint64_t& r) const {
+			return TargetOffset > r;
+		}
+	};
+
+	void ReplaceBlock(std::vector<FilePart>& parts, const FilePart& part);
+
+	class MergedFilePartStream : public RandomAccessStream {
+		const std::vector<std::shared_ptr<const RandomAccessStream>> m_sources;
+		const std::vector<FilePart> m_parts;
+
+		mutable std::mutex m_inflaterMtx;
+		mutable std::vector<std::unique_ptr<Utils::ZlibReusableInflater>> m_inflaters;
+
+	public:
+		MergedFilePartStream(std::vector<std::shared_ptr<const RandomAccessStream>> sources, std::vector<FilePart> parts);
+
+		[[nodiscard]] uint64_t StreamSize() const override {
+			return m_parts.empty() ? 0 : m_parts.back().TargetOffset + m_parts.back().TargetSize;
+		}
+
+		uint64_t ReadStreamPartial(uint64_t offset, void* buf, uint64_t length) const override;
+
+		[[nodiscard]] const std::vector<FilePart>& Parts() const {
+			return m_parts;
+		}
+	};
+
+	// Accumulates the effect of a sequence of patch files, without touching any target file.
+	class PatchSet {
+		std::vector<std::shared_ptr<const RandomAccessStream>> m_sources;
+		std::map<std::string, std::vector<FilePart>> m_files;
+		std::set<std::string> m_deletedFiles;
+		std::vector<std::string> m_addedDirectories;
+		std::vector<std::string> m_deletedDirectories;
+
+	public:
+		// Patches must be added in the order they are meant to be applied.
+		void AddPatch(std::shared_ptr<const RandomAccessStream> patch);
+
+		[[nodiscard]] const std::vector<std::shared_ptr<const RandomAccessStream>>& Sources() const { return m_sources; }
+		[[nodiscard]] const std::map<std::string, std::vector<FilePart>>& Files() const { return m_files; }
+		[[nodiscard]] const std::set<std::string>& DeletedFiles() const { return m_deletedFiles; }
+		[[nodiscard]] const std::vector<std::string>& AddedDirectories() const { return m_addedDirectories; }
+		[[nodiscard]] const std::vector<std::string>& DeletedDirectories() const { return m_deletedDirectories; }
+
+		[[nodiscard]] std::shared_ptr<MergedFilePartStream> GetFile(const std::string& path) const;
+	};
+
+	class TargetFile {
+	public:
+		virtual ~TargetFile() = default;
+
+		// May be called from multiple threads at once, with non-overlapping ranges.
+		virtual void Write(uint64_t offset, std::span<const uint8_t> data) = 0;
+	};
+
+	class TargetBackend {
+	public:
+		virtual ~TargetBackend() = default;
+
+		virtual void CreateDirectories(const std::string& path) = 0;
+		virtual void Remove(const std::string& path) = 0;
+
+		// Returned file must be exactly size bytes long and read as zeros until written.
+		// Called from worker threads as files get their turn, though never more than one call at a time.
+		virtual std::unique_ptr<TargetFile> Create(const std::string& path, uint64_t size) = 0;
+	};
+
+	// Writes under a root directory using only the standard library.
+	class FilesystemTargetBackend : public TargetBackend {
+		const std::filesystem::path m_root;
+
+	public:
+		FilesystemTargetBackend(std::filesystem::path root);
+
+		void CreateDirectories(const std::string& path) override;
+		void Remove(const std::string& path) override;
+		std::unique_ptr<TargetFile> Create(const std::string& path, uint64_t size) override;
+	};
+
+	struct ApplyOptions {
+		// 0 to use as many threads as there are logical processors.
+		size_t ThreadCount = 0;
+
+		// Contiguous target ranges up to this size are read, inflated, and written as one unit.
+		size_t MaxWriteSize = 8 * 1048576;
+
+		// Calculate CRC32 of every target file into ApplyResult::FileCrc32, for comparing against a known good copy.
+		bool Verify = false;
+
+		// Called from worker threads.
+		std::function<void(uint64_t progress, uint64_t max)> OnProgress;
+	};
+
+	struct ApplyResult {
+		uint64_t TotalBytes{};
+		uint64_t WrittenBytes{};
+		std::map<std::string, uint32_t> FileCrc32;
+	};
+
+	ApplyResult Apply(const PatchSet& patchSet, TargetBackend& backend, const ApplyOptions& options = {});
+}
@@ -0,0 +1,262 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <optional>
+
+namespace Utils::AnimationLock {
+	/// \brief Same values and order as XivAlexander::HighLatencyMitigationMode.
+	enum class MitigationMode {
+		SubtractLatency,
+		SimulateRtt,
+		SimulateNormalizedRttAndLatency,
+	};
+
+	/// \brief Latency statistics of a connection, gathered ahead of time so that resolving needs neither a syscall nor a pass over samples.
+	struct LatencySnapshot {
+		// Latest round trip time reported by TCP, or INT64_MAX if unavailable.
+		int64_t SocketLatencyUs = INT64_MAX;
+
+		// Latest ICMP round trip time, or INT64_MAX if unavailable.
+		int64_t PingLatencyUs = INT64_MAX;
+
+		// Statistics of the time between requests and responses at application level, including the current one.
+		int64_t RttMinUs = 0;
+		int64_t RttMeanUs = 0;
+		int64_t RttDeviationUs = 0;
+	};
+
+	struct Resolution {
+		// Latency used as the baseline.
+		int64_t LatencyUs;
+
+		// Whether LatencyUs came from application level statistics, because measurements were missing or implausible.
+		bool LatencyEstimated;
+
+		// Latency used for estimating the server delay; differs from LatencyUs only in SimulateNormalizedRttAndLatency mode.
+		int64_t BestLatencyUs;
+
+		int64_t DelayUs;
+
+		int64_t AnimationLockEndsAtUs;
+	};
+
+	/// \brief Decides when the animation lock of an instant action should end, with the server response time taken out.
+	/// \param nowUs Time the response has been received.
+	/// \param originalWaitUs Animation lock duration sent by the server.
+	/// \param rttUs Time between the request and the response.
+	/// \param expectedDelayUs Delay to use in SimulateRtt mode.
+	constexpr Resolution Resolve(MitigationMode mode, const LatencySnapshot& latency, int64_t nowUs, int64_t originalWaitUs, int64_t rttUs, int64_t expectedDelayUs) {
+		// Preference for socket latency measurement if available.
+		// Socket latency can be any higher value up to 40ms.
+		auto latencyUs = latency.SocketLatencyUs != INT64_MAX ? std::max<int64_t>(latency.SocketLatencyUs - 20000, 1) : latency.PingLatencyUs;
+
+		// Additionally, obtain estimated latency for use as fallback.
+		const auto latencyEstimateUs = ((latency.RttMinUs + latency.RttMeanUs) / 2) - ((latency.RttDeviationUs + 25000) / 2);
+
+		// Replace latency with estimated latency under certain circumstances:
+		// - Failed to obtain measurement
+		// - Server RTT measurement is faster than actual latency
+		const auto latencyEstimated = latencyUs == INT64_MAX || rttUs < latencyUs;
+		if (latencyEstimated)
+			latencyUs = latencyEstimateUs;
+
+		auto bestLatencyUs = latencyUs;
+		int64_t delayUs = 0;
+		switch (mode) {
+			case MitigationMode::SubtractLatency:
+				delayUs = rttUs - latencyUs;
+				break;
+
+			case MitigationMode::SimulateRtt:
+				delayUs = expectedDelayUs;
+				break;
+
+			case MitigationMode::SimulateNormalizedRttAndLatency:
+				// Server-side focused mode. Attempts to guess the server delay from response time statistics.
+				// Handles fake-ping VPN usage by using estimated latency when necessary.
+				bestLatencyUs = std::max(latencyUs, latencyEstimateUs);
+
+				// Estimate server delay, using modulus to handle high ping rtt multipliers.
+				delayUs = bestLatencyUs > 0 ? ((rttUs % bestLatencyUs) + (rttUs - bestLatencyUs)) / 2 : rttUs;
+				break;
+		}
+
+		// Disallow negative delay values.
+		delayUs = std::max<int64_t>(delayUs, 0);
+
+		return {
+			.LatencyUs = latencyUs,
+			.LatencyEstimated = latencyEstimated,
+			.BestLatencyUs = bestLatencyUs,
+			.DelayUs = delayUs,
+
+			// The new animation lock time without server response time delay, but with artificial delay (safety/lag) value.
+			.AnimationLockEndsAtUs = nowUs + (originalWaitUs - rttUs) + delayUs,
+		};
+	}
+
+	/// \brief Pairs the action requests of a connection with what the server answers, and decides when each animation lock should end.
+	///
+	/// Does not touch any message by itself: the caller passes in what it has read from one, and writes back what it is told to.
+	/// Timestamps are given by the caller, so that it can run on a simulated clock.
+	class Tracker {
+	public:
+		static constexpr int64_t AutoAttackDelayUs = 100000;
+
+		struct PendingAction {
+			uint32_t ActionId{};
+			uint32_t Sequence{};
+			int64_t RequestUs{};
+			int64_t ResponseUs{};
+			int64_t OriginalWaitUs{};
+			int64_t WaitTimeUs{};
+			int64_t CastTimeUs{};
+		};
+
+		struct EffectResult {
+			// Animation lock duration sent by the server.
+			int64_t OriginalWaitUs;
+
+			// Time from the response until the animation lock should end; negative if it should have ended already.
+			int64_t ResolvedWaitUs;
+
+			// ResolvedWaitUs, but not negative.
+			int64_t WaitUs;
+
+			// Whether the response should be left as it is.
+			bool KeepOriginal;
+
+			// Whether the response should carry WaitUs instead of OriginalWaitUs.
+			bool Shortened;
+
+			// Time between the request and the response, if the response has been resolved against its request.
+			std::optional<int64_t> RttUs;
+			std::optional<Resolution> Resolved;
+		};
+
+		// The game will allow the user to use an action, if server does not respond in 500ms since last action usage.
+		// This will result in cancellation of following actions, so to prevent this, we keep track of outgoing action
+		// request timestamps, and stack up required animation lock time responses from server.
+		// The game will only process the latest animation lock duration information.
+		std::deque<PendingAction> PendingActions;
+		std::optional<PendingAction> LatestSuccessfulRequest;
+		std::optional<int64_t> LastAnimationLockEndsAtUs;
+
+		void OnActionRequest(uint32_t actionId, uint32_t sequence, int64_t nowUs) {
+			PendingActions.emplace_back(PendingAction{
+				.ActionId = actionId,
+				.Sequence = sequence,
+				.RequestUs = nowUs,
+			});
+
+			// If there was no action queued to begin with before the current one, update the base lock time to now.
+			if (PendingActions.size() == 1 && (!PendingActions.back().RequestUs || (!LastAnimationLockEndsAtUs || *LastAnimationLockEndsAtUs < PendingActions.back().RequestUs)))
+				LastAnimationLockEndsAtUs = PendingActions.back().RequestUs;
+		}
+
+		/// \param originalWaitUs Animation lock duration sent by the server.
+		/// \param preview Whether the response is only being looked at, and will not be modified.
+		/// \param resolve Called with the round trip time of an instant action; returns what Resolve returned for it.
+		/// \param onIgnored Called with each request that had no response, and is being dropped.
+		template<typename TResolve, typename TOnIgnored>
+		EffectResult OnActionEffect(uint32_t actionId, uint32_t sourceSequence, int64_t originalWaitUs, int64_t nowUs, bool preview, const TResolve& resolve, const TOnIgnored& onIgnored) {
+			EffectResult result{ .OriginalWaitUs = originalWaitUs };
+			auto waitUs = originalWaitUs;
+
+			if (sourceSequence == 0) {
+				// Process actions originating from server.
+				if (LatestSuccessfulRequest && !LatestSuccessfulRequest->CastTimeUs && LatestSuccessfulRequest->Sequence) {
+					LatestSuccessfulRequest->ActionId = actionId;
+					LatestSuccessfulRequest->Sequence = 0;
+					*LastAnimationLockEndsAtUs += (originalWaitUs + nowUs) - (LatestSuccessfulRequest->OriginalWaitUs + LatestSuccessfulRequest->ResponseUs);
+					LastAnimationLockEndsAtUs = (std::min)(nowUs + AutoAttackDelayUs + originalWaitUs, (std::max)(nowUs + AutoAttackDelayUs, *LastAnimationLockEndsAtUs));
+
+				} else {
+					LastAnimationLockEndsAtUs = nowUs + waitUs;
+				}
+
+			} else {
+				DropUntil([sourceSequence](const PendingAction& item) { return item.Sequence == sourceSequence; }, onIgnored);
+
+				if (!PendingActions.empty()) {
+					LatestSuccessfulRequest = PendingActions.front();
+					LatestSuccessfulRequest->ResponseUs = nowUs;
+					LatestSuccessfulRequest->OriginalWaitUs = originalWaitUs;
+
+					// 100ms animation lock after cast ends stays. Modify animation lock duration for instant actions only.
+					// Since no other action is in progress right before the cast ends, we can safely replace the animation lock with the latest after-cast lock.
+					if (!LatestSuccessfulRequest->CastTimeUs) {
+						result.RttUs = nowUs - LatestSuccessfulRequest->RequestUs;
+						result.Resolved = resolve(*result.RttUs);
+						LastAnimationLockEndsAtUs = result.Resolved->AnimationLockEndsAtUs;
+
+					} else {
+						LastAnimationLockEndsAtUs = LatestSuccessfulRequest->RequestUs + LatestSuccessfulRequest->CastTimeUs + waitUs;
+					}
+					PendingActions.pop_front();
+
+				} else {
+					LastAnimationLockEndsAtUs = nowUs + waitUs;
+				}
+			}
+
+			result.ResolvedWaitUs = waitUs = *LastAnimationLockEndsAtUs - nowUs;
+			result.KeepOriginal = waitUs == originalWaitUs || (LatestSuccessfulRequest && LatestSuccessfulRequest->CastTimeUs);
+			if (result.KeepOriginal) {
+				// pass
+			} else if (waitUs < 0) {
+				waitUs = 0;
+				result.Shortened = true;
+				if (!preview && LatestSuccessfulRequest)
+					LatestSuccessfulRequest->WaitTimeUs = -LatestSuccessfulRequest->OriginalWaitUs;
+
+			} else if (waitUs < originalWaitUs) {
+				result.Shortened = true;
+				if (!preview && LatestSuccessfulRequest)
+					LatestSuccessfulRequest->WaitTimeUs = waitUs - originalWaitUs;
+			}
+			result.WaitUs = waitUs;
+			return result;
+		}
+
+		// Oldest action request has been rejected from server.
+		template<typename TOnIgnored>
+		void OnActionRejected(uint32_t actionId, uint32_t sourceSequence, const TOnIgnored& onIgnored) {
+			// Sometimes SourceSequence is empty, in which case, we use ActionId to judge.
+			DropUntil([actionId, sourceSequence](const PendingAction& item) {
+				return sourceSequence != 0 ? item.Sequence == sourceSequence : item.ActionId == actionId;
+			}, onIgnored);
+
+			if (!PendingActions.empty())
+				PendingActions.pop_front();
+		}
+
+		// The server has cancelled an oldest action (which is a cast) in progress.
+		template<typename TOnIgnored>
+		void OnCastCancelled(uint32_t actionId, const TOnIgnored& onIgnored) {
+			DropUntil([actionId](const PendingAction& item) { return item.ActionId == actionId; }, onIgnored);
+
+			if (!PendingActions.empty())
+				PendingActions.pop_front();
+		}
+
+		// If the last request indeed is a cast, the game UI will block the user from generating additional requests,
+		// so first item is guaranteed to be the cast action.
+		void OnCast(int64_t castTimeUs) {
+			if (!PendingActions.empty())
+				PendingActions.front().CastTimeUs = castTimeUs;
+		}
+
+	private:
+		// Drops requests from the oldest, assuming action responses are always in order, until one matches.
+		template<typename TPredicate, typename TOnIgnored>
+		void DropUntil(const TPredicate& matches, const TOnIgnored& onIgnored) {
+			while (!PendingActions.empty() && !matches(PendingActions.front())) {
+				onIgnored(PendingActions.front());
+				PendingActions.pop_front();
+			}
+		}
+	};
+}
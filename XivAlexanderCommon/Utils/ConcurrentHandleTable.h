@@ -0,0 +1,206 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+
+namespace Utils {
+	/// \brief Fixed-capacity open-addressed map from handle-like keys to owned values.
+	///
+	/// Find is wait-free: it probes no further than the longest distance any key has been inserted from its hash, and never blocks.
+	/// Erase is lock-free against other Insert/Erase calls. It waits until every Lease on the erased value has been released, then deletes the value.
+	/// Key values 0 and UINTPTR_MAX are reserved.
+	template<typename TKey, typename TValue>
+	class ConcurrentHandleTable {
+		static constexpr uintptr_t EmptyKey = 0;
+		static constexpr uintptr_t TombstoneKey = UINTPTR_MAX;
+
+		struct Slot {
+			std::atomic<uintptr_t> Key = EmptyKey;
+			std::atomic<TValue*> Value = nullptr;
+			std::atomic<uint32_t> Readers = 0;
+		};
+
+		const size_t m_mask;
+		const int m_shift;
+		const std::unique_ptr<Slot[]> m_slots;
+
+		// Erased slots stay tombstones and never become empty again, so after enough churn a miss would otherwise probe the whole table.
+		std::atomic<size_t> m_longestProbe = 0;
+
+		static uintptr_t ToKey(TKey key) {
+			if constexpr (std::is_pointer_v<TKey>)
+				return reinterpret_cast<uintptr_t>(key);
+			else
+				return static_cast<uintptr_t>(key);
+		}
+
+		size_t Hash(uintptr_t key) const {
+			// Handles are multiples of 4, so discard the low bits and spread the rest with Fibonacci hashing.
+			return static_cast<size_t>(((static_cast<uint64_t>(key) >> 2) * 0x9E3779B97F4A7C15ULL) >> m_shift);
+		}
+
+		Slot* FindSlot(uintptr_t key) const {
+			const auto longestProbe = m_longestProbe.load(std::memory_order_acquire);
+			for (size_t i = 0, index = Hash(key); i <= longestProbe; ++i, index = (index + 1) & m_mask) {
+				const auto k = m_slots[index].Key.load(std::memory_order_acquire);
+				if (k == key)
+					return &m_slots[index];
+				if (k == EmptyKey)
+					return nullptr;
+			}
+			return nullptr;
+		}
+
+	public:
+		/// \brief Keeps a value alive until destructed.
+		class Lease {
+			friend class ConcurrentHandleTable;
+
+			Slot* m_slot = nullptr;
+			TValue* m_value = nullptr;
+
+			Lease(Slot* slot, TValue* value) noexcept
+				: m_slot(slot)
+				, m_value(value) {
+			}
+
+		public:
+			Lease() noexcept = default;
+			Lease(const Lease&) = delete;
+			Lease& operator=(const Lease&) = delete;
+
+			Lease(Lease&& r) noexcept
+				: m_slot(r.m_slot)
+				, m_value(r.m_value) {
+				r.m_slot = nullptr;
+				r.m_value = nullptr;
+			}
+
+			Lease& operator=(Lease&& r) noexcept {
+				if (this != &r) {
+					Release();
+					m_slot = r.m_slot;
+					m_value = r.m_value;
+					r.m_slot = nullptr;
+					r.m_value = nullptr;
+				}
+				return *this;
+			}
+
+			~Lease() {
+				Release();
+			}
+
+			void Release() noexcept {
+				if (m_slot)
+					m_slot->Readers.fetch_sub(1, std::memory_order_release);
+				m_slot = nullptr;
+				m_value = nullptr;
+			}
+
+			explicit operator bool() const noexcept {
+				return m_value;
+			}
+
+			TValue* get() const noexcept {
+				return m_value;
+			}
+
+			TValue& operator*() const noexcept {
+				return *m_value;
+			}
+
+			TValue* operator->() const noexcept {
+				return m_value;
+			}
+		};
+
+		/// \param capacity Number of slots; rounded up to a power of 2.
+		explicit ConcurrentHandleTable(size_t capacity)
+			: m_mask(std::bit_ceil(std::max<size_t>(capacity, 2)) - 1)
+			, m_shift(64 - std::countr_zero(static_cast<uint64_t>(m_mask + 1)))
+			, m_slots(std::make_unique<Slot[]>(m_mask + 1)) {
+		}
+
+		ConcurrentHandleTable(const ConcurrentHandleTable&) = delete;
+		ConcurrentHandleTable& operator=(const ConcurrentHandleTable&) = delete;
+
+		~ConcurrentHandleTable() {
+			for (size_t i = 0; i <= m_mask; ++i)
+				delete m_slots[i].Value.load(std::memory_order_relaxed);
+		}
+
+		[[nodiscard]] size_t Capacity() const {
+			return m_mask + 1;
+		}
+
+		/// \returns Number of slots past its hash that a lookup may have to look at.
+		[[nodiscard]] size_t LongestProbe() const {
+			return m_longestProbe.load(std::memory_order_relaxed);
+		}
+
+		/// \brief Takes ownership of value. Key must not be in the table already.
+		/// \throws std::runtime_error If the table is full.
+		void Insert(TKey key, std::unique_ptr<TValue> value) {
+			const auto k = ToKey(key);
+			if (k == EmptyKey || k == TombstoneKey)
+				throw std::invalid_argument("reserved key");
+
+			for (size_t i = 0, index = Hash(k); i <= m_mask; ++i, index = (index + 1) & m_mask) {
+				auto& slot = m_slots[index];
+				auto expected = slot.Key.load(std::memory_order_relaxed);
+				while (expected == EmptyKey || expected == TombstoneKey) {
+					if (slot.Key.compare_exchange_weak(expected, k, std::memory_order_acq_rel)) {
+						auto longestProbe = m_longestProbe.load(std::memory_order_relaxed);
+						while (longestProbe < i && !m_longestProbe.compare_exchange_weak(longestProbe, i, std::memory_order_acq_rel)) {
+						}
+						slot.Value.store(value.release(), std::memory_order_seq_cst);
+						return;
+					}
+				}
+			}
+			throw std::runtime_error("ConcurrentHandleTable is full");
+		}
+
+		/// \returns A lease on the value, or an empty lease if key was not found.
+		[[nodiscard]] Lease Find(TKey key) const {
+			const auto k = ToKey(key);
+			const auto slot = FindSlot(k);
+			if (!slot)
+				return {};
+
+			// Announce the reader before looking at the value; Erase clears the value before waiting for readers to leave.
+			slot->Readers.fetch_add(1, std::memory_order_seq_cst);
+			if (slot->Key.load(std::memory_order_seq_cst) == k) {
+				if (const auto value = slot->Value.load(std::memory_order_seq_cst))
+					return Lease(slot, value);
+			}
+			slot->Readers.fetch_sub(1, std::memory_order_release);
+			return {};
+		}
+
+		/// \brief Removes key, and deletes its value once no lease refers to it.
+		/// Must not be called while the calling thread holds a lease on the same key.
+		/// \returns Whether key was found.
+		bool Erase(TKey key) {
+			const auto k = ToKey(key);
+			const auto slot = FindSlot(k);
+			if (!slot)
+				return false;
+
+			const std::unique_ptr<TValue> value(slot->Value.exchange(nullptr, std::memory_order_seq_cst));
+			if (!value)
+				return false;
+
+			while (slot->Readers.load(std::memory_order_seq_cst))
+				std::this_thread::yield();
+
+			slot->Key.store(TombstoneKey, std::memory_order_release);
+			return true;
+		}
+	};
+}
@@ -23,71 +23,6 @@ static NTSTATUS CheckNtStatus(NTSTATUS status, const char* operation) {
 	throw std::runtime_error(msg);
 }
 
-Utils::Crypt::Sha1::Sha1()
-	: m_hAlg(nullptr)
-	, m_hHash(nullptr) {
-	CheckNtStatus(BCryptOpenAlgorithmProvider(&m_hAlg, BCRYPT_SHA1_ALGORITHM, nullptr, 0), "BCryptOpenAlgorithmProvider(SHA1)");
-	try {
-		DWORD hashObjectSize = 0, cbData = 0;
-		CheckNtStatus(BCryptGetProperty(m_hAlg, BCRYPT_OBJECT_LENGTH, reinterpret_cast<PUCHAR>(&hashObjectSize), sizeof(hashObjectSize), &cbData, 0), "BCryptGetProperty(BCRYPT_OBJECT_LENGTH)");
-
-		m_hashObject.resize(hashObjectSize);
-		CheckNtStatus(BCryptCreateHash(m_hAlg, &m_hHash, m_hashObject.data(), hashObjectSize, nullptr, 0, 0), "BCryptCreateHash(SHA1)");
-	} catch (...) {
-		BCryptCloseAlgorithmProvider(m_hAlg, 0);
-		throw;
-	}
-}
-
-Utils::Crypt::Sha1::~Sha1() {
-	if (m_hHash)
-		BCryptDestroyHash(m_hHash);
-	if (m_hAlg)
-		BCryptCloseAlgorithmProvider(m_hAlg, 0);
-}
-
-void Utils::Crypt::Sha1::Update(std::span<const uint8_t> data) {
-	CheckNtStatus(BCryptHashData(m_hHash, const_cast<PUCHAR>(data.data()), static_cast<ULONG>(data.size()), 0), "BCryptHashData");
-}
-
-void Utils::Crypt::Sha1::Final(std::span<uint8_t> digest) {
-	CheckNtStatus(BCryptFinishHash(m_hHash, digest.data(), DigestSize, 0), "BCryptFinishHash");
-}
-
-Utils::Crypt::HmacSha512::HmacSha512(std::span<const uint8_t> key)
-	: m_hAlg(nullptr)
-	, m_hHash(nullptr) {
-	CheckNtStatus(BCryptOpenAlgorithmProvider(&m_hAlg, BCRYPT_SHA512_ALGORITHM, nullptr, BCRYPT_ALG_HANDLE_HMAC_FLAG), "BCryptOpenAlgorithmProvider(SHA512/HMAC)");
-	try {
-		DWORD hashObjectSize = 0, cbData = 0;
-		CheckNtStatus(BCryptGetProperty(m_hAlg, BCRYPT_OBJECT_LENGTH, reinterpret_cast<PUCHAR>(&hashObjectSize), sizeof(hashObjectSize), &cbData, 0), "BCryptGetProperty(BCRYPT_OBJECT_LENGTH)");
-
-		m_hashObject.resize(hashObjectSize);
-		CheckNtStatus(BCryptCreateHash(m_hAlg, &m_hHash, m_hashObject.data(), hashObjectSize,
-			const_cast<PUCHAR>(key.data()), static_cast<ULONG>(key.size()), 0), "BCryptCreateHash(HMAC-SHA512)");
-	} catch (...) {
-		BCryptCloseAlgorithmProvider(m_hAlg, 0);
-		throw;
-	}
-}
-
-Utils::Crypt::HmacSha512::~HmacSha512() {
-	if (m_hHash)
-		BCryptDestroyHash(m_hHash);
-	if (m_hAlg)
-		BCryptCloseAlgorithmProvider(m_hAlg, 0);
-}
-
-void Utils::Crypt::HmacSha512::Update(std::span<const uint8_t> data) {
-	CheckNtStatus(BCryptHashData(m_hHash, const_cast<PUCHAR>(data.data()), static_cast<ULONG>(data.size()), 0), "BCryptHashData");
-}
-
-void Utils::Crypt::HmacSha512::Final(std::span<uint8_t> digest) {
-	if (digest.size() < DigestSize)
-		throw std::invalid_argument("Digest buffer is too small for HMAC-SHA512");
-	CheckNtStatus(BCryptFinishHash(m_hHash, digest.data(), DigestSize, 0), "BCryptFinishHash");
-}
-
 std::string Utils::Crypt::Base64Encode(std::span<const uint8_t> data) {
 	DWORD chars = 0;
 	if (!CryptBinaryToStringA(data.data(), static_cast<DWORD>(data.size()), CRYPT_STRING_BASE64 | CRYPT_STRING_NOCRLF, nullptr, &chars))
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstdint>
+#include <span>
 #include <string>
 #include <vector>
 
@@ -8,9 +9,18 @@ namespace Utils::Crypt {
 	class Sha1 {
 	public:
 		static constexpr size_t DigestSize = 20;
+		static constexpr size_t BlockSize = 64;
+
+		enum class Backend {
+			// Fastest one supported by the running processor.
+			Auto,
+			Scalar,
+			ShaNi,
+			// Single buffer hashing uses Scalar; DigestMany hashes 8 buffers at once.
+			Avx2,
+		};
 
 		Sha1();
-		~Sha1();
 		Sha1(const Sha1&) = delete;
 		Sha1& operator=(const Sha1&) = delete;
 
@@ -27,18 +37,27 @@ namespace Utils::Crypt {
 
 		void Final(std::span<uint8_t> digest);
 
+		// Hashes every item of inputs independently; digests receives DigestSize bytes per input, in order.
+		static void DigestMany(std::span<const std::span<const uint8_t>> inputs, std::span<uint8_t> digests);
+
+		// Applies to every Sha1 instance created afterwards; throws if the processor does not support it.
+		static void SetBackend(Backend backend);
+		[[nodiscard]] static Backend GetBackend();
+		[[nodiscard]] static bool IsBackendSupported(Backend backend);
+
 	private:
-		void* m_hAlg;
-		void* m_hHash;
-		std::vector<uint8_t> m_hashObject;
+		uint32_t m_state[5];
+		uint64_t m_totalSize;
+		uint8_t m_buffer[BlockSize];
+		void(*m_compress)(uint32_t* state, const uint8_t* blocks, size_t blockCount);
 	};
 
 	class HmacSha512 {
 	public:
 		static constexpr size_t DigestSize = 64;
+		static constexpr size_t BlockSize = 128;
 
 		HmacSha512(std::span<const uint8_t> key);
-		~HmacSha512();
 		HmacSha512(const HmacSha512&) = delete;
 		HmacSha512& operator=(const HmacSha512&) = delete;
 
@@ -56,9 +75,10 @@ namespace Utils::Crypt {
 		void Final(std::span<uint8_t> digest);
 
 	private:
-		void* m_hAlg;
-		void* m_hHash;
-		std::vector<uint8_t> m_hashObject;
+		uint64_t m_state[8];
+		uint64_t m_totalSize;
+		uint8_t m_buffer[BlockSize];
+		uint8_t m_outerKeyPad[BlockSize];
 	};
 
 	std::string Base64Encode(std::span<const uint8_t> data);
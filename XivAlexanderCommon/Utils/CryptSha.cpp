@@ -0,0 +1,586 @@
+#include "pch.h"
+#include "XivAlexanderCommon/Utils/Crypt.h"
+
+#include <atomic>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define XIVALEX_CRYPT_X86
+
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#define XIVALEX_CRYPT_TARGET(x)
+#else
+#define XIVALEX_CRYPT_TARGET(x) __attribute__((target(x)))
+#endif
+
+#endif
+
+namespace {
+	uint32_t LoadBe32(const uint8_t* p) {
+		return static_cast<uint32_t>(p[0]) << 24
+			| static_cast<uint32_t>(p[1]) << 16
+			| static_cast<uint32_t>(p[2]) << 8
+			| static_cast<uint32_t>(p[3]);
+	}
+
+	uint64_t LoadBe64(const uint8_t* p) {
+		return static_cast<uint64_t>(LoadBe32(p)) << 32 | LoadBe32(p + 4);
+	}
+
+	void StoreBe32(uint8_t* p, uint32_t v) {
+		p[0] = static_cast<uint8_t>(v >> 24);
+		p[1] = static_cast<uint8_t>(v >> 16);
+		p[2] = static_cast<uint8_t>(v >> 8);
+		p[3] = static_cast<uint8_t>(v);
+	}
+
+	void StoreBe64(uint8_t* p, uint64_t v) {
+		StoreBe32(p, static_cast<uint32_t>(v >> 32));
+		StoreBe32(p + 4, static_cast<uint32_t>(v));
+	}
+
+	constexpr uint32_t Rotl32(uint32_t v, int n) {
+		return v << n | v >> (32 - n);
+	}
+
+	constexpr uint64_t Rotr64(uint64_t v, int n) {
+		return v >> n | v << (64 - n);
+	}
+
+	constexpr uint32_t Sha1InitialState[5]{ 0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0 };
+	constexpr uint32_t Sha1RoundConstants[4]{ 0x5A827999, 0x6ED9EBA1, 0x8F1BBCDC, 0xCA62C1D6 };
+
+	void Sha1CompressScalar(uint32_t* state, const uint8_t* blocks, size_t blockCount) {
+		for (; blockCount; --blockCount, blocks += Utils::Crypt::Sha1::BlockSize) {
+			uint32_t w[16];
+			for (size_t i = 0; i < 16; ++i)
+				w[i] = LoadBe32(blocks + i * 4);
+
+			auto a = state[0], b = state[1], c = state[2], d = state[3], e = state[4];
+			for (size_t t = 0; t < 80; ++t) {
+				if (t >= 16)
+					w[t & 15] = Rotl32(w[(t - 3) & 15] ^ w[(t - 8) & 15] ^ w[(t - 14) & 15] ^ w[t & 15], 1);
+
+				uint32_t f;
+				if (t < 20)
+					f = d ^ (b & (c ^ d));
+				else if (t < 40 || t >= 60)
+					f = b ^ c ^ d;
+				else
+					f = (b & c) | (d & (b | c));
+
+				const auto temp = Rotl32(a, 5) + f + e + Sha1RoundConstants[t / 20] + w[t & 15];
+				e = d;
+				d = c;
+				c = Rotl32(b, 30);
+				b = a;
+				a = temp;
+			}
+
+			state[0] += a;
+			state[1] += b;
+			state[2] += c;
+			state[3] += d;
+			state[4] += e;
+		}
+	}
+
+#ifdef XIVALEX_CRYPT_X86
+	struct CpuFeatures {
+		bool ShaNi = false;
+		bool Avx2 = false;
+
+		CpuFeatures() {
+			int leaf1[4]{}, leaf7[4]{};
+			CpuId(leaf1, 0);
+			const auto maxLeaf = leaf1[0];
+			CpuId(leaf1, 1);
+			if (maxLeaf >= 7)
+				CpuId(leaf7, 7);
+
+			const auto ssse3 = !!(leaf1[2] & (1 << 9));
+			const auto sse41 = !!(leaf1[2] & (1 << 19));
+			const auto osxsave = !!(leaf1[2] & (1 << 27));
+			const auto avx = !!(leaf1[2] & (1 << 28));
+			ShaNi = ssse3 && sse41 && !!(leaf7[1] & (1 << 29));
+			Avx2 = osxsave && avx && !!(leaf7[1] & (1 << 5)) && (XGetBv0() & 6) == 6;
+		}
+
+	private:
+		static void CpuId(int out[4], int leaf) {
+#if defined(_MSC_VER)
+			__cpuidex(out, leaf, 0);
+#else
+			unsigned a, b, c, d;
+			__cpuid_count(leaf, 0, a, b, c, d);
+			out[0] = static_cast<int>(a);
+			out[1] = static_cast<int>(b);
+			out[2] = static_cast<int>(c);
+			out[3] = static_cast<int>(d);
+#endif
+		}
+
+		static uint64_t XGetBv0() {
+#if defined(_MSC_VER)
+			return _xgetbv(0);
+#else
+			uint32_t eax, edx;
+			__asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+			return static_cast<uint64_t>(edx) << 32 | eax;
+#endif
+		}
+	};
+
+	const CpuFeatures& GetCpuFeatures() {
+		static const CpuFeatures features;
+		return features;
+	}
+
+	// One group of 4 rounds; W[Group % 4] is replaced with the message schedule for this group.
+	template<int Group>
+	XIVALEX_CRYPT_TARGET("sha,sse4.1,ssse3")
+	inline void Sha1ShaNiGroup(__m128i& abcd, __m128i& e, __m128i(&w)[4], const uint8_t* block, __m128i byteSwapMask) {
+		if constexpr (Group < 4) {
+			w[Group] = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(block + Group * 16)), byteSwapMask);
+		} else {
+			w[Group % 4] = _mm_sha1msg2_epu32(
+				_mm_xor_si128(_mm_sha1msg1_epu32(w[Group % 4], w[(Group + 1) % 4]), w[(Group + 2) % 4]),
+				w[(Group + 3) % 4]);
+		}
+
+		const auto ew = Group == 0 ? _mm_add_epi32(e, w[0]) : _mm_sha1nexte_epu32(e, w[Group % 4]);
+		e = abcd;
+		abcd = _mm_sha1rnds4_epu32(abcd, ew, Group / 5);
+	}
+
+	template<int... Groups>
+	XIVALEX_CRYPT_TARGET("sha,sse4.1,ssse3")
+	inline void Sha1ShaNiGroups(std::integer_sequence<int, Groups...>, __m128i& abcd, __m128i& e, __m128i(&w)[4], const uint8_t* block, __m128i byteSwapMask) {
+		(Sha1ShaNiGroup<Groups>(abcd, e, w, block, byteSwapMask), ...);
+	}
+
+	XIVALEX_CRYPT_TARGET("sha,sse4.1,ssse3")
+	void Sha1CompressShaNi(uint32_t* state, const uint8_t* blocks, size_t blockCount) {
+		const auto byteSwapMask = _mm_set_epi64x(0x0001020304050607LL, 0x08090a0b0c0d0e0fLL);
+		auto abcd = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(state)), 0x1B);
+		auto e = _mm_set_epi32(static_cast<int>(state[4]), 0, 0, 0);
+
+		for (; blockCount; --blockCount, blocks += Utils::Crypt::Sha1::BlockSize) {
+			const auto abcdSaved = abcd;
+			const auto eSaved = e;
+			__m128i w[4];
+			Sha1ShaNiGroups(std::make_integer_sequence<int, 20>(), abcd, e, w, blocks, byteSwapMask);
+			e = _mm_sha1nexte_epu32(e, eSaved);
+			abcd = _mm_add_epi32(abcd, abcdSaved);
+		}
+
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(state), _mm_shuffle_epi32(abcd, 0x1B));
+		state[4] = static_cast<uint32_t>(_mm_extract_epi32(e, 3));
+	}
+
+	static constexpr size_t Sha1Avx2Lanes = 8;
+
+	template<int N>
+	XIVALEX_CRYPT_TARGET("avx2")
+	inline __m256i Rotl32x8(__m256i v) {
+		return _mm256_or_si256(_mm256_slli_epi32(v, N), _mm256_srli_epi32(v, 32 - N));
+	}
+
+	// Compresses one block for each of 8 independent states, stored transposed as state[word][lane].
+	XIVALEX_CRYPT_TARGET("avx2")
+	void Sha1CompressAvx2(uint32_t(&state)[5][Sha1Avx2Lanes], const uint8_t* const(&blocks)[Sha1Avx2Lanes]) {
+		const auto byteSwapMask = _mm256_set_epi8(
+			12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3,
+			12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3);
+
+		__m256i w[16];
+		for (size_t i = 0; i < 16; ++i) {
+			uint32_t words[Sha1Avx2Lanes];
+			for (size_t lane = 0; lane < Sha1Avx2Lanes; ++lane)
+				memcpy(&words[lane], blocks[lane] + i * 4, 4);
+			w[i] = _mm256_shuffle_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(words)), byteSwapMask);
+		}
+
+		__m256i v[5];
+		for (size_t i = 0; i < 5; ++i)
+			v[i] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(state[i]));
+
+		auto a = v[0], b = v[1], c = v[2], d = v[3], e = v[4];
+		for (size_t t = 0; t < 80; ++t) {
+			if (t >= 16)
+				w[t & 15] = Rotl32x8<1>(_mm256_xor_si256(_mm256_xor_si256(w[(t - 3) & 15], w[(t - 8) & 15]), _mm256_xor_si256(w[(t - 14) & 15], w[t & 15])));
+
+			__m256i f;
+			if (t < 20)
+				f = _mm256_xor_si256(d, _mm256_and_si256(b, _mm256_xor_si256(c, d)));
+			else if (t < 40 || t >= 60)
+				f = _mm256_xor_si256(_mm256_xor_si256(b, c), d);
+			else
+				f = _mm256_or_si256(_mm256_and_si256(b, c), _mm256_and_si256(d, _mm256_or_si256(b, c)));
+
+			const auto temp = _mm256_add_epi32(
+				_mm256_add_epi32(Rotl32x8<5>(a), f),
+				_mm256_add_epi32(_mm256_add_epi32(e, _mm256_set1_epi32(static_cast<int>(Sha1RoundConstants[t / 20]))), w[t & 15]));
+			e = d;
+			d = c;
+			c = Rotl32x8<30>(b);
+			b = a;
+			a = temp;
+		}
+
+		v[0] = _mm256_add_epi32(v[0], a);
+		v[1] = _mm256_add_epi32(v[1], b);
+		v[2] = _mm256_add_epi32(v[2], c);
+		v[3] = _mm256_add_epi32(v[3], d);
+		v[4] = _mm256_add_epi32(v[4], e);
+		for (size_t i = 0; i < 5; ++i)
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(state[i]), v[i]);
+	}
+#endif
+
+	using Sha1CompressFunction = void(*)(uint32_t* state, const uint8_t* blocks, size_t blockCount);
+
+	std::atomic<Utils::Crypt::Sha1::Backend> s_sha1Backend = Utils::Crypt::Sha1::Backend::Auto;
+
+	Utils::Crypt::Sha1::Backend ResolveSha1Backend() {
+		using Backend = Utils::Crypt::Sha1::Backend;
+		if (const auto backend = s_sha1Backend.load(); backend != Backend::Auto)
+			return backend;
+		if (Utils::Crypt::Sha1::IsBackendSupported(Backend::ShaNi))
+			return Backend::ShaNi;
+		if (Utils::Crypt::Sha1::IsBackendSupported(Backend::Avx2))
+			return Backend::Avx2;
+		return Backend::Scalar;
+	}
+
+	Sha1CompressFunction GetSha1CompressFunction(Utils::Crypt::Sha1::Backend backend) {
+#ifdef XIVALEX_CRYPT_X86
+		if (backend == Utils::Crypt::Sha1::Backend::ShaNi)
+			return &Sha1CompressShaNi;
+#endif
+		return &Sha1CompressScalar;
+	}
+
+	// Builds the final 1 or 2 blocks of a message: the trailing partial block, padding, and the length in bits.
+	size_t Sha1PadTail(uint8_t(&tail)[Utils::Crypt::Sha1::BlockSize * 2], std::span<const uint8_t> remaining, uint64_t totalSize) {
+		const auto blockCount = remaining.size() + 9 <= Utils::Crypt::Sha1::BlockSize ? 1 : 2;
+		std::fill_n(tail, sizeof tail, 0);
+		std::copy_n(remaining.begin(), remaining.size(), tail);
+		tail[remaining.size()] = 0x80;
+		StoreBe64(&tail[blockCount * Utils::Crypt::Sha1::BlockSize - 8], totalSize * 8);
+		return blockCount;
+	}
+
+	void Sha1StoreDigest(const uint32_t* state, uint8_t* digest) {
+		for (size_t i = 0; i < 5; ++i)
+			StoreBe32(digest + i * 4, state[i]);
+	}
+
+	void Sha1DigestOne(Sha1CompressFunction compress, std::span<const uint8_t> data, uint8_t* digest) {
+		uint32_t state[5];
+		std::copy_n(Sha1InitialState, 5, state);
+
+		const auto fullBlocks = data.size() / Utils::Crypt::Sha1::BlockSize;
+		compress(state, data.data(), fullBlocks);
+
+		uint8_t tail[Utils::Crypt::Sha1::BlockSize * 2];
+		compress(state, tail, Sha1PadTail(tail, data.subspan(fullBlocks * Utils::Crypt::Sha1::BlockSize), data.size()));
+		Sha1StoreDigest(state, digest);
+	}
+
+#ifdef XIVALEX_CRYPT_X86
+	void Sha1DigestManyAvx2(std::span<const std::span<const uint8_t>> inputs, std::span<uint8_t> digests) {
+		struct Lane {
+			size_t InputIndex = SIZE_MAX;
+			const uint8_t* Data = nullptr;
+			size_t FullBlocks = 0;
+			size_t TotalBlocks = 0;
+			size_t NextBlock = 0;
+			uint8_t Tail[Utils::Crypt::Sha1::BlockSize * 2]{};
+
+			[[nodiscard]] const uint8_t* Block(size_t index) const {
+				return index < FullBlocks ? Data + index * Utils::Crypt::Sha1::BlockSize : Tail + (index - FullBlocks) * Utils::Crypt::Sha1::BlockSize;
+			}
+		};
+
+		static constexpr uint8_t IdleBlock[Utils::Crypt::Sha1::BlockSize]{};
+
+		Lane lanes[Sha1Avx2Lanes];
+		uint32_t state[5][Sha1Avx2Lanes];
+		size_t nextInput = 0;
+
+		while (true) {
+			size_t activeLanes = 0;
+			for (size_t i = 0; i < Sha1Avx2Lanes; ++i) {
+				auto& lane = lanes[i];
+				if (lane.InputIndex == SIZE_MAX && nextInput < inputs.size()) {
+					const auto data = inputs[nextInput];
+					lane.InputIndex = nextInput++;
+					lane.Data = data.data();
+					lane.FullBlocks = data.size() / Utils::Crypt::Sha1::BlockSize;
+					lane.TotalBlocks = lane.FullBlocks + Sha1PadTail(lane.Tail, data.subspan(lane.FullBlocks * Utils::Crypt::Sha1::BlockSize), data.size());
+					lane.NextBlock = 0;
+					for (size_t j = 0; j < 5; ++j)
+						state[j][i] = Sha1InitialState[j];
+				}
+				if (lane.InputIndex != SIZE_MAX)
+					activeLanes++;
+			}
+
+			if (!activeLanes)
+				break;
+
+			// Running mostly idle lanes costs more than finishing the stragglers one at a time.
+			if (nextInput == inputs.size() && activeLanes < Sha1Avx2Lanes / 2) {
+				for (size_t i = 0; i < Sha1Avx2Lanes; ++i) {
+					auto& lane = lanes[i];
+					if (lane.InputIndex == SIZE_MAX)
+						continue;
+
+					uint32_t laneState[5];
+					for (size_t j = 0; j < 5; ++j)
+						laneState[j] = state[j][i];
+					for (; lane.NextBlock < lane.TotalBlocks; ++lane.NextBlock)
+						Sha1CompressScalar(laneState, lane.Block(lane.NextBlock), 1);
+					Sha1StoreDigest(laneState, &digests[lane.InputIndex * Utils::Crypt::Sha1::DigestSize]);
+					lane.InputIndex = SIZE_MAX;
+				}
+				break;
+			}
+
+			const uint8_t* blocks[Sha1Avx2Lanes];
+			for (size_t i = 0; i < Sha1Avx2Lanes; ++i)
+				blocks[i] = lanes[i].InputIndex == SIZE_MAX ? IdleBlock : lanes[i].Block(lanes[i].NextBlock);
+			Sha1CompressAvx2(state, blocks);
+
+			for (size_t i = 0; i < Sha1Avx2Lanes; ++i) {
+				auto& lane = lanes[i];
+				if (lane.InputIndex == SIZE_MAX || ++lane.NextBlock < lane.TotalBlocks)
+					continue;
+
+				uint32_t laneState[5];
+				for (size_t j = 0; j < 5; ++j)
+					laneState[j] = state[j][i];
+				Sha1StoreDigest(laneState, &digests[lane.InputIndex * Utils::Crypt::Sha1::DigestSize]);
+				lane.InputIndex = SIZE_MAX;
+			}
+		}
+	}
+#endif
+
+	constexpr uint64_t Sha512RoundConstants[80]{
+		0x428a2f98d728ae22ULL, 0x7137449123ef65cdULL, 0xb5c0fbcfec4d3b2fULL, 0xe9b5dba58189dbbcULL,
+		0x3956c25bf348b538ULL, 0x59f111f1b605d019ULL, 0x923f82a4af194f9bULL, 0xab1c5ed5da6d8118ULL,
+		0xd807aa98a3030242ULL, 0x12835b0145706fbeULL, 0x243185be4ee4b28cULL, 0x550c7dc3d5ffb4e2ULL,
+		0x72be5d74f27b896fULL, 0x80deb1fe3b1696b1ULL, 0x9bdc06a725c71235ULL, 0xc19bf174cf692694ULL,
+		0xe49b69c19ef14ad2ULL, 0xefbe4786384f25e3ULL, 0x0fc19dc68b8cd5b5ULL, 0x240ca1cc77ac9c65ULL,
+		0x2de92c6f592b0275ULL, 0x4a7484aa6ea6e483ULL, 0x5cb0a9dcbd41fbd4ULL, 0x76f988da831153b5ULL,
+		0x983e5152ee66dfabULL, 0xa831c66d2db43210ULL, 0xb00327c898fb213fULL, 0xbf597fc7beef0ee4ULL,
+		0xc6e00bf33da88fc2ULL, 0xd5a79147930aa725ULL, 0x06ca6351e003826fULL, 0x142929670a0e6e70ULL,
+		0x27b70a8546d22ffcULL, 0x2e1b21385c26c926ULL, 0x4d2c6dfc5ac42aedULL, 0x53380d139d95b3dfULL,
+		0x650a73548baf63deULL, 0x766a0abb3c77b2a8ULL, 0x81c2c92e47edaee6ULL, 0x92722c851482353bULL,
+		0xa2bfe8a14cf10364ULL, 0xa81a664bbc423001ULL, 0xc24b8b70d0f89791ULL, 0xc76c51a30654be30ULL,
+		0xd192e819d6ef5218ULL, 0xd69906245565a910ULL, 0xf40e35855771202aULL, 0x106aa07032bbd1b8ULL,
+		0x19a4c116b8d2d0c8ULL, 0x1e376c085141ab53ULL, 0x2748774cdf8eeb99ULL, 0x34b0bcb5e19b48a8ULL,
+		0x391c0cb3c5c95a63ULL, 0x4ed8aa4ae3418acbULL, 0x5b9cca4f7763e373ULL, 0x682e6ff3d6b2b8a3ULL,
+		0x748f82ee5defb2fcULL, 0x78a5636f43172f60ULL, 0x84c87814a1f0ab72ULL, 0x8cc702081a6439ecULL,
+		0x90befffa23631e28ULL, 0xa4506cebde82bde9ULL, 0xbef9a3f7b2c67915ULL, 0xc67178f2e372532bULL,
+		0xca273eceea26619cULL, 0xd186b8c721c0c207ULL, 0xeada7dd6cde0eb1eULL, 0xf57d4f7fee6ed178ULL,
+		0x06f067aa72176fbaULL, 0x0a637dc5a2c898a6ULL, 0x113f9804bef90daeULL, 0x1b710b35131c471bULL,
+		0x28db77f523047d84ULL, 0x32caab7b40c72493ULL, 0x3c9ebe0a15c9bebcULL, 0x431d67c49c100d4cULL,
+		0x4cc5d4becb3e42b6ULL, 0x597f299cfc657e2aULL, 0x5fcb6fab3ad6faecULL, 0x6c44198c4a475817ULL,
+	};
+
+	constexpr uint64_t Sha512InitialState[8]{
+		0x6a09e667f3bcc908ULL, 0xbb67ae8584caa73bULL, 0x3c6ef372fe94f82bULL, 0xa54ff53a5f1d36f1ULL,
+		0x510e527fade682d1ULL, 0x9b05688c2b3e6c1fULL, 0x1f83d9abfb41bd6bULL, 0x5be0cd19137e2179ULL,
+	};
+
+	void Sha512Compress(uint64_t* state, const uint8_t* blocks, size_t blockCount) {
+		for (; blockCount; --blockCount, blocks += Utils::Crypt::HmacSha512::BlockSize) {
+			uint64_t w[80];
+			for (size_t i = 0; i < 16; ++i)
+				w[i] = LoadBe64(blocks + i * 8);
+			for (size_t i = 16; i < 80; ++i) {
+				const auto s0 = Rotr64(w[i - 15], 1) ^ Rotr64(w[i - 15], 8) ^ (w[i - 15] >> 7);
+				const auto s1 = Rotr64(w[i - 2], 19) ^ Rotr64(w[i - 2], 61) ^ (w[i - 2] >> 6);
+				w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+			}
+
+			auto a = state[0], b = state[1], c = state[2], d = state[3], e = state[4], f = state[5], g = state[6], h = state[7];
+			for (size_t i = 0; i < 80; ++i) {
+				const auto s1 = Rotr64(e, 14) ^ Rotr64(e, 18) ^ Rotr64(e, 41);
+				const auto ch = (e & f) ^ (~e & g);
+				const auto temp1 = h + s1 + ch + Sha512RoundConstants[i] + w[i];
+				const auto s0 = Rotr64(a, 28) ^ Rotr64(a, 34) ^ Rotr64(a, 39);
+				const auto maj = (a & b) ^ (a & c) ^ (b & c);
+				const auto temp2 = s0 + maj;
+				h = g;
+				g = f;
+				f = e;
+				e = d + temp1;
+				d = c;
+				c = b;
+				b = a;
+				a = temp1 + temp2;
+			}
+
+			state[0] += a;
+			state[1] += b;
+			state[2] += c;
+			state[3] += d;
+			state[4] += e;
+			state[5] += f;
+			state[6] += g;
+			state[7] += h;
+		}
+	}
+
+	// Feeds data into a Merkle-Damgard hash state that keeps a partial block in buffer.
+	template<size_t BlockSize, typename TState, typename TCompress>
+	void HashUpdate(TState* state, uint64_t& totalSize, uint8_t(&buffer)[BlockSize], std::span<const uint8_t> data, TCompress compress) {
+		const auto buffered = static_cast<size_t>(totalSize % BlockSize);
+		totalSize += data.size();
+
+		if (buffered) {
+			const auto fill = std::min(BlockSize - buffered, data.size());
+			std::copy_n(data.begin(), fill, &buffer[buffered]);
+			data = data.subspan(fill);
+			if (buffered + fill < BlockSize)
+				return;
+			compress(state, buffer, 1);
+		}
+
+		const auto fullBlocks = data.size() / BlockSize;
+		compress(state, data.data(), fullBlocks);
+		data = data.subspan(fullBlocks * BlockSize);
+		std::copy_n(data.begin(), data.size(), buffer);
+	}
+
+	void Sha512Final(uint64_t* state, uint64_t totalSize, uint8_t(&buffer)[Utils::Crypt::HmacSha512::BlockSize], uint8_t* digest) {
+		static constexpr auto BlockSize = Utils::Crypt::HmacSha512::BlockSize;
+		const auto buffered = static_cast<size_t>(totalSize % BlockSize);
+		uint8_t tail[BlockSize * 2]{};
+		std::copy_n(buffer, buffered, tail);
+		tail[buffered] = 0x80;
+
+		// The length field is 128 bits wide; the upper half is always zero here.
+		const auto blockCount = buffered + 17 <= BlockSize ? 1 : 2;
+		StoreBe64(&tail[blockCount * BlockSize - 8], totalSize * 8);
+		Sha512Compress(state, tail, blockCount);
+
+		for (size_t i = 0; i < 8; ++i)
+			StoreBe64(digest + i * 8, state[i]);
+	}
+}
+
+Utils::Crypt::Sha1::Sha1()
+	: m_totalSize(0)
+	, m_buffer{}
+	, m_compress(GetSha1CompressFunction(ResolveSha1Backend())) {
+	std::copy_n(Sha1InitialState, 5, m_state);
+}
+
+void Utils::Crypt::Sha1::Update(std::span<const uint8_t> data) {
+	HashUpdate(m_state, m_totalSize, m_buffer, data, m_compress);
+}
+
+void Utils::Crypt::Sha1::Final(std::span<uint8_t> digest) {
+	if (digest.size() < DigestSize)
+		throw std::invalid_argument("Digest buffer is too small for SHA-1");
+
+	uint8_t tail[BlockSize * 2];
+	m_compress(m_state, tail, Sha1PadTail(tail, std::span(m_buffer).subspan(0, static_cast<size_t>(m_totalSize % BlockSize)), m_totalSize));
+	Sha1StoreDigest(m_state, digest.data());
+}
+
+void Utils::Crypt::Sha1::DigestMany(std::span<const std::span<const uint8_t>> inputs, std::span<uint8_t> digests) {
+	if (digests.size() < inputs.size() * DigestSize)
+		throw std::invalid_argument("Digest buffer is too small for SHA-1");
+
+	const auto backend = ResolveSha1Backend();
+#ifdef XIVALEX_CRYPT_X86
+	if (backend == Backend::Avx2) {
+		Sha1DigestManyAvx2(inputs, digests);
+		return;
+	}
+#endif
+
+	const auto compress = GetSha1CompressFunction(backend);
+	for (size_t i = 0; i < inputs.size(); ++i)
+		Sha1DigestOne(compress, inputs[i], &digests[i * DigestSize]);
+}
+
+void Utils::Crypt::Sha1::SetBackend(Backend backend) {
+	if (!IsBackendSupported(backend))
+		throw std::invalid_argument("SHA-1 backend is not supported by this processor");
+	s_sha1Backend = backend;
+}
+
+Utils::Crypt::Sha1::Backend Utils::Crypt::Sha1::GetBackend() {
+	return ResolveSha1Backend();
+}
+
+bool Utils::Crypt::Sha1::IsBackendSupported(Backend backend) {
+	switch (backend) {
+		case Backend::Auto:
+		case Backend::Scalar:
+			return true;
+#ifdef XIVALEX_CRYPT_X86
+		case Backend::ShaNi:
+			return GetCpuFeatures().ShaNi;
+		case Backend::Avx2:
+			return GetCpuFeatures().Avx2;
+#endif
+		default:
+			return false;
+	}
+}
+
+Utils::Crypt::HmacSha512::HmacSha512(std::span<const uint8_t> key)
+	: m_totalSize(0)
+	, m_buffer{}
+	, m_outerKeyPad{} {
+	uint8_t keyBlock[BlockSize]{};
+	if (key.size() > BlockSize) {
+		uint64_t keyState[8];
+		uint64_t keySize = 0;
+		std::copy_n(Sha512InitialState, 8, keyState);
+		HashUpdate(keyState, keySize, m_buffer, key, Sha512Compress);
+		Sha512Final(keyState, keySize, m_buffer, keyBlock);
+	} else
+		std::copy_n(key.begin(), key.size(), keyBlock);
+
+	uint8_t innerKeyPad[BlockSize];
+	for (size_t i = 0; i < BlockSize; ++i) {
+		innerKeyPad[i] = keyBlock[i] ^ 0x36;
+		m_outerKeyPad[i] = keyBlock[i] ^ 0x5c;
+	}
+
+	std::copy_n(Sha512InitialState, 8, m_state);
+	Update(std::span<const uint8_t>(innerKeyPad));
+}
+
+void Utils::Crypt::HmacSha512::Update(std::span<const uint8_t> data) {
+	HashUpdate(m_state, m_totalSize, m_buffer, data, Sha512Compress);
+}
+
+void Utils::Crypt::HmacSha512::Final(std::span<uint8_t> digest) {
+	if (digest.size() < DigestSize)
+		throw std::invalid_argument("Digest buffer is too small for HMAC-SHA512");
+
+	uint8_t innerDigest[DigestSize];
+	Sha512Final(m_state, m_totalSize, m_buffer, innerDigest);
+
+	m_totalSize = 0;
+	std::copy_n(Sha512InitialState, 8, m_state);
+	Update(std::span<const uint8_t>(m_outerKeyPad));
+	Update(std::span<const uint8_t>(innerDigest));
+	Sha512Final(m_state, m_totalSize, m_buffer, digest.data());
+}
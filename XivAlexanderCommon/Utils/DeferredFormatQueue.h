@@ -0,0 +1,172 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <filesystem>
+#include <format>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <variant>
+
+namespace Utils {
+	/// \brief Bounded lock-free multi-producer single-consumer queue of format calls whose formatting is deferred to the consumer.
+	///
+	/// Arguments are copied into a fixed-size slot at push time.
+	/// Only value types are captured: trivially copyable types, strings, and paths.
+	/// Character pointers and string views are copied into owned strings.
+	/// Anything else makes TryPush fail, and the caller should format eagerly instead.
+	///
+	/// The format string is not copied, and must have static storage duration.
+	template<typename TMeta, size_t StorageSize = 192>
+	class DeferredFormatQueue {
+	public:
+		using FormattedText = std::variant<std::string, std::wstring>;
+
+	private:
+		template<typename T>
+		struct CaptureType {
+			using Type = T;
+		};
+
+		template<typename T> requires std::is_same_v<T, char*> || std::is_same_v<T, const char*> || std::is_same_v<T, std::string_view>
+		struct CaptureType<T> {
+			using Type = std::string;
+		};
+
+		template<typename T> requires std::is_same_v<T, wchar_t*> || std::is_same_v<T, const wchar_t*> || std::is_same_v<T, std::wstring_view>
+		struct CaptureType<T> {
+			using Type = std::wstring;
+		};
+
+		template<typename T>
+		using Captured = typename CaptureType<std::decay_t<T>>::Type;
+
+		template<typename T>
+		static constexpr bool IsValueType = std::is_trivially_copyable_v<T>
+			|| std::is_same_v<T, std::string>
+			|| std::is_same_v<T, std::wstring>
+			|| std::is_same_v<T, std::filesystem::path>;
+
+		template<typename CharT, typename...Args>
+		struct Capture {
+			const CharT* Format;
+			std::tuple<Args...> Args_;
+		};
+
+		struct Slot {
+			std::atomic<uint64_t> Sequence;
+			TMeta Meta;
+
+			// Formats the captured arguments into the given text, and destroys them.
+			void(*Formatter)(void* storage, FormattedText& text);
+
+			alignas(std::max_align_t) std::byte Storage[StorageSize];
+		};
+
+		template<typename CharT, typename...Args>
+		static void FormatCapture(void* storage, FormattedText& text) {
+			struct Destroyer {
+				Capture<CharT, Args...>* p;
+				~Destroyer() { std::destroy_at(p); }
+			} const capture{ std::launder(static_cast<Capture<CharT, Args...>*>(storage)) };
+
+			try {
+				text = std::apply([format = capture.p->Format](auto&...args) {
+					if constexpr (std::is_same_v<CharT, char>)
+						return std::vformat(format, std::make_format_args(args...));
+					else
+						return std::vformat(format, std::make_wformat_args(args...));
+				}, capture.p->Args_);
+			} catch (const std::format_error& e) {
+				text = std::format("<format error: {}>", e.what());
+			}
+		}
+
+		const size_t m_mask;
+		const std::unique_ptr<Slot[]> m_slots;
+		alignas(64) std::atomic<uint64_t> m_enqueuePosition = 0;
+		alignas(64) uint64_t m_dequeuePosition = 0;
+
+	public:
+		template<typename CharT, typename...Args>
+		static constexpr bool IsDeferrable = sizeof(Capture<CharT, Captured<Args>...>) <= StorageSize
+			&& alignof(Capture<CharT, Captured<Args>...>) <= alignof(std::max_align_t)
+			&& (IsValueType<Captured<Args>> && ...);
+
+		/// \param capacity Number of slots; must be a power of 2.
+		explicit DeferredFormatQueue(size_t capacity)
+			: m_mask(capacity - 1)
+			, m_slots(std::make_unique<Slot[]>(capacity)) {
+			if (!capacity || (capacity & m_mask))
+				throw std::invalid_argument("capacity must be a power of 2");
+			for (size_t i = 0; i < capacity; ++i)
+				m_slots[i].Sequence.store(i, std::memory_order_relaxed);
+		}
+
+		DeferredFormatQueue(const DeferredFormatQueue&) = delete;
+		DeferredFormatQueue& operator=(const DeferredFormatQueue&) = delete;
+
+		~DeferredFormatQueue() {
+			Drain([](TMeta&, FormattedText&) {});
+		}
+
+		/// \returns false if the queue is full or the arguments cannot be captured.
+		template<typename CharT, typename...Args>
+		bool TryPush(const TMeta& meta, const CharT* format, Args&&...args) {
+			if constexpr (!IsDeferrable<CharT, Args...>) {
+				return false;
+			} else {
+				auto pos = m_enqueuePosition.load(std::memory_order_relaxed);
+				Slot* slot;
+				while (true) {
+					slot = &m_slots[pos & m_mask];
+					const auto seq = slot->Sequence.load(std::memory_order_acquire);
+					const auto diff = static_cast<int64_t>(seq - pos);
+					if (diff == 0) {
+						if (m_enqueuePosition.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+							break;
+					} else if (diff < 0)
+						return false;
+					else
+						pos = m_enqueuePosition.load(std::memory_order_relaxed);
+				}
+
+				using CaptureT = Capture<CharT, Captured<Args>...>;
+				slot->Meta = meta;
+				slot->Formatter = &FormatCapture<CharT, Captured<Args>...>;
+				new(slot->Storage) CaptureT{ format, std::tuple<Captured<Args>...>(std::forward<Args>(args)...) };
+				slot->Sequence.store(pos + 1, std::memory_order_release);
+				return true;
+			}
+		}
+
+		/// \brief Formats and removes every completed record. Only one thread may call this at a time.
+		/// \returns Number of records processed.
+		template<typename Fn>
+		size_t Drain(Fn&& cb) {
+			size_t count = 0;
+			FormattedText text;
+			while (true) {
+				auto& slot = m_slots[m_dequeuePosition & m_mask];
+				if (slot.Sequence.load(std::memory_order_acquire) != m_dequeuePosition + 1)
+					return count;
+
+				slot.Formatter(slot.Storage, text);
+				auto meta = std::move(slot.Meta);
+				slot.Sequence.store(m_dequeuePosition + m_mask + 1, std::memory_order_release);
+				m_dequeuePosition++;
+				count++;
+				cb(meta, text);
+			}
+		}
+
+		[[nodiscard]] bool Empty() const {
+			return m_slots[m_dequeuePosition & m_mask].Sequence.load(std::memory_order_acquire) != m_dequeuePosition + 1;
+		}
+	};
+}
@@ -0,0 +1,299 @@
+#include "pch.h"
+#include "XivAlexanderCommon/Utils/Deflater.h"
+
+#include <array>
+#include <bit>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define XIVALEX_DEFLATE_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace {
+	struct Code {
+		uint32_t Bits;
+		uint32_t Length;
+	};
+
+	// Huffman codes are packed starting from their most significant bit, unlike everything else in deflate.
+	constexpr uint32_t ReverseBits(uint32_t code, uint32_t length) {
+		uint32_t reversed = 0;
+		for (uint32_t i = 0; i < length; ++i)
+			reversed |= ((code >> i) & 1) << (length - 1 - i);
+		return reversed;
+	}
+
+	constexpr Code FixedLiteralLengthCode(uint32_t symbol) {
+		if (symbol < 144)
+			return { ReverseBits(0x30 + symbol, 8), 8 };
+		if (symbol < 256)
+			return { ReverseBits(0x190 + symbol - 144, 9), 9 };
+		if (symbol < 280)
+			return { ReverseBits(symbol - 256, 7), 7 };
+		return { ReverseBits(0xc0 + symbol - 280, 8), 8 };
+	}
+
+	constexpr auto LiteralCodes = [] {
+		std::array<Code, 256> codes{};
+		for (uint32_t i = 0; i < 256; ++i)
+			codes[i] = FixedLiteralLengthCode(i);
+		return codes;
+	}();
+
+	constexpr auto EndOfBlockCode = FixedLiteralLengthCode(256);
+
+	// Length symbol followed by its extra bits, indexed by match length.
+	constexpr auto LengthCodes = [] {
+		constexpr uint32_t Bases[]{ 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+		constexpr uint32_t ExtraBits[]{ 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+		std::array<Code, Utils::QuickDeflater::MaxMatch + 1> codes{};
+
+		// 258 could also be written as 227 with 31 extra, but it has its own symbol, which later entries overwrite it with.
+		for (uint32_t i = 0; i < std::size(Bases); ++i) {
+			const auto code = FixedLiteralLengthCode(257 + i);
+			for (uint32_t extra = 0; extra < 1u << ExtraBits[i] && Bases[i] + extra <= Utils::QuickDeflater::MaxMatch; ++extra)
+				codes[Bases[i] + extra] = { code.Bits | extra << code.Length, code.Length + ExtraBits[i] };
+		}
+		return codes;
+	}();
+
+	constexpr auto DistanceSymbolCodes = [] {
+		std::array<uint32_t, 30> codes{};
+		for (uint32_t i = 0; i < 30; ++i)
+			codes[i] = ReverseBits(i, 5);
+		return codes;
+	}();
+
+	// Distance symbol followed by its extra bits. Distances 1 to 4 have a symbol each, and then every symbol covers as many as the pair before it did, doubled.
+	Code DistanceCode(uint32_t distance) {
+		const auto x = distance - 1;
+		if (x < 4)
+			return { DistanceSymbolCodes[x], 5 };
+		const auto extraBits = static_cast<uint32_t>(std::bit_width(x)) - 2;
+		const auto symbol = 2 * extraBits + 2 + ((x >> extraBits) & 1);
+		return { DistanceSymbolCodes[symbol] | (x & ((1u << extraBits) - 1)) << 5, 5 + extraBits };
+	}
+
+	class BitWriter {
+		uint8_t* m_ptr;
+		uint64_t m_bits = 0;
+		uint32_t m_count = 0;
+
+	public:
+		explicit BitWriter(uint8_t* ptr)
+			: m_ptr(ptr) {
+		}
+
+		void Put(Code code) {
+			m_bits |= static_cast<uint64_t>(code.Bits) << m_count;
+			m_count += code.Length;
+			if (m_count >= 32) {
+				m_ptr[0] = static_cast<uint8_t>(m_bits);
+				m_ptr[1] = static_cast<uint8_t>(m_bits >> 8);
+				m_ptr[2] = static_cast<uint8_t>(m_bits >> 16);
+				m_ptr[3] = static_cast<uint8_t>(m_bits >> 24);
+				m_ptr += 4;
+				m_bits >>= 32;
+				m_count -= 32;
+			}
+		}
+
+		// Pads to a byte boundary, and returns where the next byte goes.
+		uint8_t* Finish() {
+			for (; m_count; m_count = m_count > 8 ? m_count - 8 : 0) {
+				*m_ptr++ = static_cast<uint8_t>(m_bits);
+				m_bits >>= 8;
+			}
+			return m_ptr;
+		}
+	};
+
+	uint32_t Load32(const uint8_t* p) {
+		uint32_t v;
+		memcpy(&v, p, sizeof v);
+		return v;
+	}
+
+	uint32_t Hash(uint32_t v) {
+		return (v * 0x9e3779b1u) >> (32 - Utils::QuickDeflater::HashBits);
+	}
+
+	size_t MatchLength(const uint8_t* a, const uint8_t* b, size_t maxLength) {
+		size_t length = 0;
+#ifdef XIVALEX_DEFLATE_SSE2
+		for (; length + 16 <= maxLength; length += 16) {
+			const auto equal = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a + length)), _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + length)));
+			if (const auto mask = static_cast<uint32_t>(_mm_movemask_epi8(equal)); mask != 0xffff)
+				return length + std::countr_one(mask);
+		}
+#else
+		if constexpr (std::endian::native == std::endian::little) {
+			for (; length + 8 <= maxLength; length += 8) {
+				uint64_t x, y;
+				memcpy(&x, a + length, sizeof x);
+				memcpy(&y, b + length, sizeof y);
+				if (x != y)
+					return length + std::countr_zero(x ^ y) / 8;
+			}
+		}
+#endif
+		while (length < maxLength && a[length] == b[length])
+			++length;
+		return length;
+	}
+
+	void WriteBigEndian32(uint8_t* p, uint32_t v) {
+		p[0] = static_cast<uint8_t>(v >> 24);
+		p[1] = static_cast<uint8_t>(v >> 16);
+		p[2] = static_cast<uint8_t>(v >> 8);
+		p[3] = static_cast<uint8_t>(v);
+	}
+}
+
+Utils::QuickDeflater::QuickDeflater()
+	: m_hashTable(size_t{ 1 } << HashBits) {
+}
+
+size_t Utils::QuickDeflater::Bound(size_t sourceSize) {
+	// Header, stored blocks of up to 65535 bytes with 5 bytes each of overhead, and checksum.
+	return 2 + sourceSize + 5 * (std::max<size_t>)(1, (sourceSize + 65534) / 65535) + 4;
+}
+
+uint32_t Utils::QuickDeflater::Adler32(std::span<const uint8_t> data, uint32_t adler) {
+	constexpr uint32_t Base = 65521;
+
+	// Largest n such that 255n(n+1)/2 + (n+1)(Base-1) fits in 32 bits, as in zlib; also a multiple of 16.
+	constexpr size_t BlockSize = 5552;
+
+	uint64_t s1 = adler & 0xffff, s2 = adler >> 16;
+	auto p = data.data();
+	for (auto remaining = data.size(); remaining;) {
+		auto blockSize = (std::min)(remaining, BlockSize);
+		remaining -= blockSize;
+
+#ifdef XIVALEX_DEFLATE_SSE2
+		// For each 16 bytes b[0..15]: s1 += sum(b[j]), and s2 += 16 * s1 + sum((16 - j) * b[j]), where s1 is as it was before those 16 bytes.
+		if (const auto chunks = blockSize / 16) {
+			const auto zero = _mm_setzero_si128();
+			const auto weightsLow = _mm_set_epi16(9, 10, 11, 12, 13, 14, 15, 16);
+			const auto weightsHigh = _mm_set_epi16(1, 2, 3, 4, 5, 6, 7, 8);
+			auto byteSums = zero, byteSumPrefixes = zero, weightedSums = zero;
+			for (size_t i = 0; i < chunks; ++i, p += 16) {
+				const auto bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+				byteSumPrefixes = _mm_add_epi32(byteSumPrefixes, byteSums);
+				byteSums = _mm_add_epi32(byteSums, _mm_sad_epu8(bytes, zero));
+				weightedSums = _mm_add_epi32(weightedSums, _mm_madd_epi16(_mm_unpacklo_epi8(bytes, zero), weightsLow));
+				weightedSums = _mm_add_epi32(weightedSums, _mm_madd_epi16(_mm_unpackhi_epi8(bytes, zero), weightsHigh));
+			}
+
+			const auto sum = [](__m128i v) {
+				alignas(16) uint32_t lanes[4];
+				_mm_store_si128(reinterpret_cast<__m128i*>(lanes), v);
+				return uint64_t{ lanes[0] } + lanes[1] + lanes[2] + lanes[3];
+			};
+			s2 += 16 * chunks * s1 + 16 * sum(byteSumPrefixes) + sum(weightedSums);
+			s1 += sum(byteSums);
+			blockSize -= chunks * 16;
+		}
+#endif
+
+		for (; blockSize; --blockSize) {
+			s1 += *p++;
+			s2 += s1;
+		}
+		s1 %= Base;
+		s2 %= Base;
+	}
+	return static_cast<uint32_t>(s2 << 16 | s1);
+}
+
+size_t Utils::QuickDeflater::WriteStored(std::span<const uint8_t> source, uint32_t adler) {
+	auto p = m_buffer.data() + 2;
+	do {
+		const auto length = (std::min<size_t>)(source.size(), 65535);
+		*p++ = length == source.size() ? 1 : 0;
+		p[0] = static_cast<uint8_t>(length);
+		p[1] = static_cast<uint8_t>(length >> 8);
+		p[2] = static_cast<uint8_t>(~length);
+		p[3] = static_cast<uint8_t>(~length >> 8);
+		p += 4;
+		if (length)
+			memcpy(p, source.data(), length);
+		p += length;
+		source = source.subspan(length);
+	} while (!source.empty());
+
+	WriteBigEndian32(p, adler);
+	return p + 4 - m_buffer.data();
+}
+
+std::span<uint8_t> Utils::QuickDeflater::Deflate(std::span<const uint8_t> source) {
+	const auto size = source.size();
+	if (size > UINT32_MAX / 2)
+		throw std::length_error("Input too large");
+
+	// Every byte takes at most 9 bits: a literal does, and a match takes at most 31 bits for at least 4 bytes.
+	// The block header and the end of block take 10 bits.
+	const auto capacity = (std::max)(2 + (10 + 9 * size + 7) / 8 + 4, Bound(size));
+	if (m_buffer.size() < capacity)
+		m_buffer.resize(capacity);
+
+	// Start over before positions wrap around.
+	if (m_base > UINT32_MAX - size) {
+		std::ranges::fill(m_hashTable, 0);
+		m_base = 1;
+	}
+
+	const auto adler = Adler32(source);
+
+	// CMF: deflate with 32K window; FLG: fastest, and check bits.
+	m_buffer[0] = 0x78;
+	m_buffer[1] = 0x01;
+
+	BitWriter writer(m_buffer.data() + 2);
+
+	// BFINAL, and BTYPE of fixed Huffman codes.
+	writer.Put({ 0b011, 3 });
+
+	const auto src = source.data();
+	size_t i = 0;
+	if (size >= MinMatch) {
+		const auto lastHashable = size - MinMatch;
+		while (i <= lastHashable) {
+			const auto v = Load32(&src[i]);
+			auto& slot = m_hashTable[Hash(v)];
+			const auto candidate = slot;
+			slot = m_base + static_cast<uint32_t>(i);
+
+			if (candidate >= m_base) {
+				const auto matchOffset = candidate - m_base;
+				const auto distance = i - matchOffset;
+				if (distance <= WindowSize && Load32(&src[matchOffset]) == v) {
+					const auto length = MinMatch + MatchLength(&src[i + MinMatch], &src[matchOffset + MinMatch], (std::min)(MaxMatch, size - i) - MinMatch);
+					writer.Put(LengthCodes[length]);
+					writer.Put(DistanceCode(static_cast<uint32_t>(distance)));
+
+					const auto matchEnd = i + length;
+					for (++i; i < matchEnd && i <= lastHashable; ++i)
+						m_hashTable[Hash(Load32(&src[i]))] = m_base + static_cast<uint32_t>(i);
+					i = matchEnd;
+					continue;
+				}
+			}
+
+			writer.Put(LiteralCodes[src[i++]]);
+		}
+	}
+	for (; i < size; ++i)
+		writer.Put(LiteralCodes[src[i]]);
+	writer.Put(EndOfBlockCode);
+
+	const auto end = writer.Finish();
+	WriteBigEndian32(end, adler);
+	auto length = static_cast<size_t>(end + 4 - m_buffer.data());
+	if (length > Bound(size))
+		length = WriteStored(source, adler);
+
+	m_base += static_cast<uint32_t>(size);
+	return std::span(m_buffer).subspan(0, length);
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace Utils {
+	/// \brief Compresses data into zlib streams, keeping its state and output buffer between calls.
+	class Deflater {
+	public:
+		virtual ~Deflater() = default;
+
+		// The result stays valid until the next call.
+		virtual std::span<uint8_t> Deflate(std::span<const uint8_t> source) = 0;
+
+		std::span<uint8_t> operator()(std::span<const uint8_t> source) {
+			return Deflate(source);
+		}
+	};
+
+	/// \brief Compresses into a single block of fixed Huffman codes with greedy matching, the way zlib-ng's deflate_quick does.
+	///
+	/// Output is larger than zlib's default level, but is a zlib stream that any inflater takes.
+	/// Nothing has to be reset between calls, which dominates the cost of deflating small inputs with zlib;
+	/// and match lengths and the Adler-32 checksum are computed 16 bytes at a time where SSE2 is available.
+	class QuickDeflater : public Deflater {
+	public:
+		static constexpr size_t HashBits = 14;
+		static constexpr size_t WindowSize = 32768;
+		static constexpr size_t MinMatch = 4;
+		static constexpr size_t MaxMatch = 258;
+
+	private:
+		// Where each hash was last seen, as m_base plus the offset into the input; anything below m_base is from an earlier call.
+		std::vector<uint32_t> m_hashTable;
+		uint32_t m_base = 1;
+
+		std::vector<uint8_t> m_buffer;
+
+		size_t WriteStored(std::span<const uint8_t> source, uint32_t adler);
+
+	public:
+		QuickDeflater();
+
+		std::span<uint8_t> Deflate(std::span<const uint8_t> source) override;
+
+		// Largest possible output for an input of the given size.
+		[[nodiscard]] static size_t Bound(size_t sourceSize);
+
+		[[nodiscard]] static uint32_t Adler32(std::span<const uint8_t> data, uint32_t adler = 1);
+	};
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+
+namespace Utils {
+
+	template<typename T, T DefaultValue = static_cast<T>(0)>
+	struct LE {
+	private:
+		T value;
+
+	public:
+		LE(T defaultValue = DefaultValue)
+			: value(defaultValue) {
+		}
+
+		operator T() const {
+			return Value();
+		}
+
+		LE<T, DefaultValue>& operator= (T newValue) {
+			Value(std::move(newValue));
+			return *this;
+		}
+
+		LE<T, DefaultValue>& operator+= (T newValue) {
+			Value(Value() + std::move(newValue));
+			return *this;
+		}
+
+		LE<T, DefaultValue>& operator-= (T newValue) {
+			Value(Value() - std::move(newValue));
+			return *this;
+		}
+
+		T Value() const {
+			return value;
+		}
+
+		void Value(T newValue) {
+			value = std::move(newValue);
+		}
+	};
+
+	template<typename T, T DefaultValue = static_cast<T>(0)>
+	struct BE {
+	private:
+		union {
+			T value;
+			char buf[sizeof(T)];
+		};
+
+	public:
+		BE(T defaultValue = DefaultValue)
+			: value(defaultValue) {
+			std::reverse(buf, buf + sizeof(T));
+		}
+
+		operator T() const {
+			return Value();
+		}
+
+		BE<T, DefaultValue>& operator= (T newValue) {
+			Value(std::move(newValue));
+			return *this;
+		}
+
+		BE<T, DefaultValue>& operator+= (T newValue) {
+			Value(Value() + std::move(newValue));
+			return *this;
+		}
+
+		BE<T, DefaultValue>& operator-= (T newValue) {
+			Value(Value() - std::move(newValue));
+			return *this;
+		}
+
+		T Value() const {
+			union {
+				char tmp[sizeof(T)];
+				T tval;
+			};
+			memcpy(tmp, buf, sizeof(T));
+			std::reverse(tmp, tmp + sizeof(T));
+			return tval;
+		}
+
+		void Value(T newValue) {
+			union {
+				char tmp[sizeof(T)];
+				T tval;
+			};
+			tval = newValue;
+			std::reverse(tmp, tmp + sizeof(T));
+			memcpy(buf, tmp, sizeof(T));
+		}
+	};
+}
@@ -0,0 +1,212 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <utility>
+
+namespace Utils {
+	/// \brief Open-addressed map from handle-like keys to values, stored inline in one flat array.
+	///
+	/// Not thread safe. Lookups probe linearly from the hashed slot, so a hit usually touches a single cache line.
+	/// Erasing leaves a tombstone and never moves other entries, so iterators stay valid across Erase; Emplace may rehash and invalidate them.
+	template<typename TKey, typename TValue>
+	class FlatHandleMap {
+		enum class SlotState : uint8_t {
+			Empty,
+			Used,
+			Tombstone,
+		};
+
+	public:
+		struct Entry {
+			TKey Key{};
+			TValue Value{};
+		};
+
+	private:
+		std::unique_ptr<SlotState[]> m_states;
+		std::unique_ptr<Entry[]> m_entries;
+		size_t m_mask = 0;
+		int m_shift = 0;
+		size_t m_size = 0;
+		size_t m_tombstones = 0;
+
+		static uint64_t ToInteger(TKey key) {
+			if constexpr (std::is_pointer_v<TKey>)
+				return static_cast<uint64_t>(reinterpret_cast<uintptr_t>(key));
+			else
+				return static_cast<uint64_t>(key);
+		}
+
+		size_t Hash(TKey key) const {
+			// Handles are multiples of 4, so discard the low bits and spread the rest with Fibonacci hashing.
+			return static_cast<size_t>(((ToInteger(key) >> 2) * 0x9E3779B97F4A7C15ULL) >> m_shift);
+		}
+
+		size_t FindIndex(TKey key) const {
+			if (!m_size)
+				return SIZE_MAX;
+			for (size_t i = 0, index = Hash(key); i <= m_mask; ++i, index = (index + 1) & m_mask) {
+				if (m_states[index] == SlotState::Empty)
+					return SIZE_MAX;
+				if (m_states[index] == SlotState::Used && m_entries[index].Key == key)
+					return index;
+			}
+			return SIZE_MAX;
+		}
+
+		void Rehash(size_t capacity) {
+			auto states = std::move(m_states);
+			auto entries = std::move(m_entries);
+			const auto oldCapacity = states ? m_mask + 1 : 0;
+
+			m_mask = capacity - 1;
+			m_shift = 64 - std::countr_zero(static_cast<uint64_t>(capacity));
+			m_states = std::make_unique<SlotState[]>(capacity);
+			m_entries = std::make_unique<Entry[]>(capacity);
+			m_tombstones = 0;
+
+			for (size_t i = 0; i < oldCapacity; ++i) {
+				if (states[i] != SlotState::Used)
+					continue;
+				auto index = Hash(entries[i].Key);
+				while (m_states[index] != SlotState::Empty)
+					index = (index + 1) & m_mask;
+				m_states[index] = SlotState::Used;
+				m_entries[index] = std::move(entries[i]);
+			}
+		}
+
+	public:
+		class Iterator {
+			friend class FlatHandleMap;
+
+			const FlatHandleMap* m_map = nullptr;
+			size_t m_index = 0;
+
+			Iterator(const FlatHandleMap* map, size_t index)
+				: m_map(map)
+				, m_index(index) {
+				SkipUnused();
+			}
+
+			void SkipUnused() {
+				while (m_index <= m_map->m_mask && m_map->m_states && m_map->m_states[m_index] != SlotState::Used)
+					++m_index;
+			}
+
+		public:
+			using iterator_category = std::forward_iterator_tag;
+			using value_type = Entry;
+			using difference_type = std::ptrdiff_t;
+			using pointer = Entry*;
+			using reference = Entry&;
+
+			Iterator() = default;
+
+			Entry& operator*() const {
+				return m_map->m_entries[m_index];
+			}
+
+			Entry* operator->() const {
+				return &m_map->m_entries[m_index];
+			}
+
+			Iterator& operator++() {
+				++m_index;
+				SkipUnused();
+				return *this;
+			}
+
+			Iterator operator++(int) {
+				auto prev = *this;
+				++*this;
+				return prev;
+			}
+
+			bool operator==(const Iterator& r) const {
+				return m_index == r.m_index;
+			}
+		};
+
+		/// \param capacity Initial number of slots; rounded up to a power of 2.
+		explicit FlatHandleMap(size_t capacity = 64) {
+			Rehash(std::bit_ceil(std::max<size_t>(capacity, 8)));
+		}
+
+		FlatHandleMap(const FlatHandleMap&) = delete;
+		FlatHandleMap& operator=(const FlatHandleMap&) = delete;
+		FlatHandleMap(FlatHandleMap&&) = default;
+		FlatHandleMap& operator=(FlatHandleMap&&) = default;
+
+		[[nodiscard]] size_t Size() const {
+			return m_size;
+		}
+
+		[[nodiscard]] bool Empty() const {
+			return !m_size;
+		}
+
+		/// \returns Pointer to the value, or nullptr if key was not found.
+		[[nodiscard]] TValue* Find(TKey key) const {
+			const auto index = FindIndex(key);
+			return index == SIZE_MAX ? nullptr : &m_entries[index].Value;
+		}
+
+		/// \brief Inserts a value constructed from args, unless key is already in the map.
+		/// \returns The value for key, and whether it has been inserted.
+		template<typename...TArgs>
+		std::pair<TValue*, bool> Emplace(TKey key, TArgs&&...args) {
+			if (const auto found = Find(key))
+				return { found, false };
+
+			// Keep at least a quarter of slots empty, so that misses stop early.
+			if ((m_size + m_tombstones + 1) * 4 > (m_mask + 1) * 3)
+				Rehash((m_size + 1) * 2 > m_mask + 1 ? (m_mask + 1) * 2 : m_mask + 1);
+
+			auto index = Hash(key);
+			while (m_states[index] == SlotState::Used)
+				index = (index + 1) & m_mask;
+			if (m_states[index] == SlotState::Tombstone)
+				m_tombstones--;
+			m_states[index] = SlotState::Used;
+			m_entries[index] = Entry{ key, TValue(std::forward<TArgs>(args)...) };
+			m_size++;
+			return { &m_entries[index].Value, true };
+		}
+
+		/// \returns Whether key was found.
+		bool Erase(TKey key) {
+			const auto index = FindIndex(key);
+			if (index == SIZE_MAX)
+				return false;
+
+			// Move the value out first, so that its destructor sees the map without it.
+			auto value = std::move(m_entries[index].Value);
+			m_entries[index] = Entry{};
+			m_states[index] = SlotState::Tombstone;
+			m_size--;
+			m_tombstones++;
+			return true;
+		}
+
+		void Clear() {
+			for (size_t i = 0; i <= m_mask; ++i) {
+				m_states[i] = SlotState::Empty;
+				m_entries[i] = Entry{};
+			}
+			m_size = m_tombstones = 0;
+		}
+
+		[[nodiscard]] Iterator begin() const {
+			return { this, 0 };
+		}
+
+		[[nodiscard]] Iterator end() const {
+			return { this, m_mask + 1 };
+		}
+	};
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <thread>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace Utils::FramePacing {
+	/// \brief Picks the render phase to use after the render interval changes.
+	///
+	/// Renders happen at timestamps t where t % intervalUs == driftUs, at the first one after nowUs.
+	/// The next render is kept at least intervalUs after the last render of the previous schedule,
+	/// at the earliest such timestamp after nowUs.
+	///
+	/// Every phase in [0, intervalUs) has exactly one render timestamp in (nowUs, nowUs + intervalUs],
+	/// and the wanted timestamp is in that range, so the phase is its remainder.
+	///
+	/// \param nowUs Current timestamp; must be at least prevIntervalUs.
+	/// \param prevIntervalUs Previous render interval; must be positive.
+	/// \param prevDriftUs Previous render phase, in [0, prevIntervalUs).
+	/// \param intervalUs New render interval; must be positive.
+	/// \returns Render phase for the new interval, in [0, intervalUs).
+	constexpr int64_t CalculateRenderDriftUs(int64_t nowUs, int64_t prevIntervalUs, int64_t prevDriftUs, int64_t intervalUs) {
+		const auto lastRenderTimestamp = (nowUs - prevDriftUs) / prevIntervalUs * prevIntervalUs + prevDriftUs;
+		const auto nextRenderTimestamp = std::max(lastRenderTimestamp + intervalUs, nowUs + 1);
+		return nextRenderTimestamp % intervalUs;
+	}
+
+	inline void CpuPause() {
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+		_mm_pause();
+#else
+		std::this_thread::yield();
+#endif
+	}
+
+	/// \brief Waits until a deadline by sleeping until a safety margin before it, and then spinning.
+	///
+	/// The margin follows the measured sleep overshoot: mean plus four mean absolute deviations,
+	/// or the recent worst overshoot if larger, which decays over time.
+	class HybridWaiter {
+	public:
+		static constexpr int64_t MinMarginUs = 50;
+		static constexpr int64_t MaxMarginUs = 4000;
+		static constexpr int64_t InitialMarginUs = 1000;
+
+		struct WaitResult {
+			int64_t SleptUs;
+			int64_t SpunUs;
+
+			// How late the wait returned past the deadline; 0 if it was on time.
+			int64_t LateUs;
+		};
+
+	private:
+		const std::function<int64_t()> m_nowUs;
+		const std::function<void(int64_t)> m_sleepUs;
+		const std::function<void()> m_pause;
+
+		double m_overshootMeanUs = 0;
+		double m_overshootDeviationUs = 0;
+		double m_overshootPeakUs = InitialMarginUs;
+		int64_t m_marginUs = InitialMarginUs;
+
+		void RecordOvershoot(int64_t overshootUs) {
+			const auto o = static_cast<double>(std::max<int64_t>(0, overshootUs));
+			m_overshootMeanUs += (o - m_overshootMeanUs) / 16;
+			m_overshootDeviationUs += (std::abs(o - m_overshootMeanUs) - m_overshootDeviationUs) / 16;
+			m_overshootPeakUs = std::max(o, m_overshootPeakUs - m_overshootPeakUs / 128);
+			m_marginUs = std::clamp(static_cast<int64_t>(std::max(m_overshootMeanUs + 4 * m_overshootDeviationUs, m_overshootPeakUs)), MinMarginUs, MaxMarginUs);
+		}
+
+	public:
+		/// \param nowUs Monotonic clock in microseconds.
+		/// \param sleepUs Sleeps for at least the given duration in microseconds; may overshoot.
+		/// \param pause Called on each spin iteration.
+		HybridWaiter(std::function<int64_t()> nowUs, std::function<void(int64_t)> sleepUs, std::function<void()> pause = CpuPause)
+			: m_nowUs(std::move(nowUs))
+			, m_sleepUs(std::move(sleepUs))
+			, m_pause(std::move(pause)) {
+		}
+
+		[[nodiscard]] int64_t MarginUs() const {
+			return m_marginUs;
+		}
+
+		WaitResult WaitUntil(int64_t deadlineUs) {
+			auto now = m_nowUs();
+			const auto start = now;
+
+			if (const auto sleepUntil = deadlineUs - m_marginUs; sleepUntil > now) {
+				m_sleepUs(sleepUntil - now);
+				now = m_nowUs();
+				RecordOvershoot(now - sleepUntil);
+			}
+			const auto slept = now - start;
+
+			while (now < deadlineUs) {
+				m_pause();
+				now = m_nowUs();
+			}
+
+			return {
+				.SleptUs = slept,
+				.SpunUs = now - start - slept,
+				.LateUs = std::max<int64_t>(0, now - deadlineUs),
+			};
+		}
+	};
+}
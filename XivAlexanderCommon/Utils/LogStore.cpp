@@ -0,0 +1,201 @@
+#include "pch.h"
+#include "XivAlexanderCommon/Utils/LogStore.h"
+
+Utils::LogStore::LogStore(size_t ringCapacity, size_t arenaSize, std::filesystem::path spillPath)
+	: m_arena(std::make_unique<char[]>(arenaSize))
+	, m_arenaSize(static_cast<uint32_t>(arenaSize))
+	, m_ring(ringCapacity)
+	, m_spillPath(std::move(spillPath)) {
+	if (!ringCapacity || !arenaSize)
+		throw std::invalid_argument("ringCapacity and arenaSize must not be zero");
+	if (arenaSize > UINT32_MAX)
+		throw std::invalid_argument("arenaSize too big");
+
+	if (!m_spillPath.empty()) {
+		m_spill.open(m_spillPath, std::ios::in | std::ios::out | std::ios::trunc | std::ios::binary);
+		if (!m_spill)
+			throw std::runtime_error("Failed to open log spill file");
+		m_spillWriteBuffer.reserve(SpillWriteBufferSize);
+	}
+}
+
+Utils::LogStore::~LogStore() {
+	if (!m_spillPath.empty()) {
+		m_spill.close();
+		std::error_code ec;
+		remove(m_spillPath, ec);
+	}
+}
+
+const Utils::LogStore::RingEntry& Utils::LogStore::RingAt(size_t i) const {
+	return m_ring[(m_ringHead + i) % m_ring.size()];
+}
+
+void Utils::LogStore::FlushSpill() const {
+	if (m_spillWriteBuffer.empty())
+		return;
+	m_spill.clear();
+	m_spill.seekp(0, std::ios::end);
+	m_spill.write(m_spillWriteBuffer.data(), static_cast<std::streamsize>(m_spillWriteBuffer.size()));
+	m_spill.flush();
+	m_spillWriteBuffer.clear();
+}
+
+void Utils::LogStore::Append(uint64_t id, int64_t timestamp, uint8_t category, uint8_t level, std::string_view text) {
+	if (IsSpilling()) {
+		if (m_spillCount % SpillIndexInterval == 0)
+			m_spillIndex.emplace_back(SpillIndexEntry{ id, m_spillSize });
+
+		const auto length = static_cast<uint32_t>(std::min<size_t>(text.size(), UINT32_MAX));
+		const SpillHeader header{
+			.Length = length,
+			.Category = category,
+			.Level = level,
+			.Id = id,
+			.Timestamp = timestamp,
+		};
+		const auto headerBytes = reinterpret_cast<const char*>(&header);
+		m_spillWriteBuffer.insert(m_spillWriteBuffer.end(), headerBytes, headerBytes + sizeof header);
+		m_spillWriteBuffer.insert(m_spillWriteBuffer.end(), text.data(), text.data() + length);
+		m_spillSize += sizeof header + length;
+		m_spillCount++;
+		if (m_spillWriteBuffer.size() >= SpillWriteBufferSize)
+			FlushSpill();
+	}
+
+	// Step. Find room in the arena; wrap around instead of splitting text.
+	const auto length = static_cast<uint32_t>(std::min<size_t>(text.size(), m_arenaSize));
+	auto offset = m_arenaWrite;
+	const auto wrapped = offset + length > m_arenaSize;
+	if (wrapped)
+		offset = 0;
+
+	// Step. Evict the oldest entries that are in the way.
+	// Entries are laid out in the arena in order, so the ones from the previous lap are right after the write position.
+	// Decide by where entries start rather than by overlap, so that empty entries do not stop the eviction early.
+	const auto evictOldest = [this] {
+		m_ringHead = (m_ringHead + 1) % m_ring.size();
+		m_ringCount--;
+		if (m_ringPreviousLapCount)
+			m_ringPreviousLapCount--;
+	};
+	if (wrapped) {
+		while (m_ringPreviousLapCount)
+			evictOldest();
+		m_ringPreviousLapCount = m_ringCount;
+	}
+	while (m_ringCount && (m_ringCount == m_ring.size() || (m_ringPreviousLapCount && m_ring[m_ringHead].Offset < offset + length)))
+		evictOldest();
+
+	// Step. Store.
+	std::copy_n(text.data(), length, &m_arena[offset]);
+	m_ring[(m_ringHead + m_ringCount) % m_ring.size()] = RingEntry{
+		.Id = id,
+		.Timestamp = timestamp,
+		.Offset = offset,
+		.Length = length,
+		.Category = category,
+		.Level = level,
+	};
+	m_ringCount++;
+	m_arenaWrite = offset + length;
+}
+
+void Utils::LogStore::Clear() {
+	m_ringHead = m_ringCount = m_ringPreviousLapCount = 0;
+	m_arenaWrite = 0;
+
+	if (IsSpilling()) {
+		m_spill.close();
+		m_spill.open(m_spillPath, std::ios::in | std::ios::out | std::ios::trunc | std::ios::binary);
+		if (!m_spill)
+			throw std::runtime_error("Failed to reopen log spill file");
+		m_spillWriteBuffer.clear();
+		m_spillSize = 0;
+		m_spillCount = 0;
+		m_spillIndex.clear();
+	}
+}
+
+bool Utils::LogStore::IsSpilling() const {
+	return !m_spillPath.empty();
+}
+
+size_t Utils::LogStore::Count() const {
+	return IsSpilling() ? m_spillCount : m_ringCount;
+}
+
+size_t Utils::LogStore::InMemoryCount() const {
+	return m_ringCount;
+}
+
+uint64_t Utils::LogStore::FirstId() const {
+	if (IsSpilling() && !m_spillIndex.empty())
+		return m_spillIndex.front().Id;
+	return FirstInMemoryId();
+}
+
+uint64_t Utils::LogStore::FirstInMemoryId() const {
+	return m_ringCount ? m_ring[m_ringHead].Id : UINT64_MAX;
+}
+
+size_t Utils::LogStore::ReadSpill(uint64_t fromId, uint64_t beforeId, size_t maxCount, const std::function<void(const RecordView&)>& cb) const {
+	FlushSpill();
+
+	auto it = std::upper_bound(m_spillIndex.begin(), m_spillIndex.end(), fromId, [](uint64_t id, const SpillIndexEntry& e) { return id < e.Id; });
+	if (it != m_spillIndex.begin())
+		--it;
+	if (it == m_spillIndex.end())
+		return 0;
+
+	m_spill.clear();
+	m_spill.seekg(static_cast<std::streamoff>(it->Offset));
+	auto offset = it->Offset;
+
+	size_t count = 0;
+	std::string text;
+	SpillHeader header{};
+	while (count < maxCount && offset < m_spillSize) {
+		if (!m_spill.read(reinterpret_cast<char*>(&header), sizeof header))
+			throw std::runtime_error("Failed to read log spill file");
+		offset += sizeof header + header.Length;
+		if (header.Id >= beforeId)
+			break;
+
+		if (header.Id < fromId) {
+			m_spill.seekg(header.Length, std::ios::cur);
+			continue;
+		}
+
+		text.resize(header.Length);
+		if (!m_spill.read(text.data(), header.Length))
+			throw std::runtime_error("Failed to read log spill file");
+		cb(RecordView{ header.Id, header.Timestamp, header.Category, header.Level, text });
+		count++;
+	}
+	return count;
+}
+
+size_t Utils::LogStore::Read(uint64_t fromId, size_t maxCount, const std::function<void(const RecordView&)>& cb) const {
+	size_t count = 0;
+	const auto firstInMemoryId = FirstInMemoryId();
+	if (IsSpilling() && fromId < firstInMemoryId) {
+		count = ReadSpill(fromId, firstInMemoryId, maxCount, cb);
+		fromId = firstInMemoryId;
+	}
+
+	size_t lo = 0, hi = m_ringCount;
+	while (lo < hi) {
+		const auto mid = (lo + hi) / 2;
+		if (RingAt(mid).Id < fromId)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	for (auto i = lo; i < m_ringCount && count < maxCount; ++i, ++count) {
+		const auto& e = RingAt(i);
+		cb(RecordView{ e.Id, e.Timestamp, e.Category, e.Level, std::string_view(&m_arena[e.Offset], e.Length) });
+	}
+	return count;
+}
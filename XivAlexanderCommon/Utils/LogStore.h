@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+namespace Utils {
+	/// \brief Log record storage with bounded memory use.
+	///
+	/// The most recent records are kept in a fixed-size in-memory ring; text goes into a single preallocated arena.
+	/// If a spill file is given, every record is also appended to it in a compact binary form,
+	/// so that records evicted from the ring can still be paged in from disk.
+	///
+	/// Not thread-safe; callers are expected to serialize access.
+	class LogStore {
+	public:
+		struct RecordView {
+			uint64_t Id;
+			int64_t Timestamp;
+			uint8_t Category;
+			uint8_t Level;
+			std::string_view Text;
+		};
+
+	private:
+		struct RingEntry {
+			uint64_t Id;
+			int64_t Timestamp;
+			uint32_t Offset;
+			uint32_t Length;
+			uint8_t Category;
+			uint8_t Level;
+		};
+
+		// On-disk record header, followed by Length bytes of text.
+		struct SpillHeader {
+			uint32_t Length;
+			uint8_t Category;
+			uint8_t Level;
+			uint16_t Reserved;
+			uint64_t Id;
+			int64_t Timestamp;
+		};
+		static_assert(sizeof(SpillHeader) == 24);
+
+		// One index entry is kept per this many records in the spill file.
+		static constexpr size_t SpillIndexInterval = 64;
+		static constexpr size_t SpillWriteBufferSize = 65536;
+
+		struct SpillIndexEntry {
+			uint64_t Id;
+			uint64_t Offset;
+		};
+
+		const std::unique_ptr<char[]> m_arena;
+		const uint32_t m_arenaSize;
+		uint32_t m_arenaWrite = 0;
+
+		std::vector<RingEntry> m_ring;
+		size_t m_ringHead = 0;
+		size_t m_ringCount = 0;
+		size_t m_ringPreviousLapCount = 0; // Number of oldest entries written before the arena last wrapped around.
+
+		std::filesystem::path m_spillPath;
+		mutable std::fstream m_spill;
+		mutable std::vector<char> m_spillWriteBuffer;
+		uint64_t m_spillSize = 0;
+		size_t m_spillCount = 0;
+		std::vector<SpillIndexEntry> m_spillIndex;
+
+		const RingEntry& RingAt(size_t i) const;
+		void FlushSpill() const;
+		size_t ReadSpill(uint64_t fromId, uint64_t beforeId, size_t maxCount, const std::function<void(const RecordView&)>& cb) const;
+
+	public:
+		/// \param ringCapacity Maximum number of records kept in memory.
+		/// \param arenaSize Maximum number of text bytes kept in memory. Longer records are truncated in memory, but not in the spill file.
+		/// \param spillPath File to append every record to. Truncated on open, and deleted on destruction. Empty path disables spilling.
+		LogStore(size_t ringCapacity, size_t arenaSize, std::filesystem::path spillPath = {});
+		LogStore(const LogStore&) = delete;
+		LogStore& operator=(const LogStore&) = delete;
+		~LogStore();
+
+		/// \brief Adds a record. Ids must be strictly increasing, but may have gaps.
+		void Append(uint64_t id, int64_t timestamp, uint8_t category, uint8_t level, std::string_view text);
+
+		void Clear();
+
+		[[nodiscard]] bool IsSpilling() const;
+		[[nodiscard]] size_t Count() const;
+		[[nodiscard]] size_t InMemoryCount() const;
+
+		/// \returns Id of the oldest available record, or UINT64_MAX if empty.
+		[[nodiscard]] uint64_t FirstId() const;
+
+		/// \returns Id of the oldest record in memory, or UINT64_MAX if empty.
+		[[nodiscard]] uint64_t FirstInMemoryId() const;
+
+		/// \brief Calls cb for up to maxCount records in order, starting from the first record whose id is fromId or later.
+		/// Text is valid only during the callback.
+		/// \returns Number of records visited.
+		size_t Read(uint64_t fromId, size_t maxCount, const std::function<void(const RecordView&)>& cb) const;
+	};
+}
@@ -2,36 +2,107 @@
 #include "XivAlexanderCommon/Utils/NumericStatisticsTracker.h"
 #include "XivAlexanderCommon/Utils/Utils.h"
 
-Utils::NumericStatisticsTracker::Entry::Entry(int64_t value, int64_t maxAgeUs)
-	: Value(value)
-	, TimestampUs(Utils::QpcUs())
-	, ExpiryUs(maxAgeUs == INT64_MAX ? INT64_MAX : TimestampUs + maxAgeUs) {
+#include <thread>
+
+class Utils::NumericStatisticsTracker::Snapshot {
+	const Slot* m_slots;
+	size_t m_trackCount;
+	uint64_t m_end;
+	size_t m_size;
+
+public:
+	Snapshot(const NumericStatisticsTracker& tracker, int64_t nowUs)
+		: m_slots(tracker.m_slots.get())
+		, m_trackCount(tracker.m_trackCount)
+		, m_end(tracker.m_end.load(std::memory_order_relaxed)) {
+		const auto begin = tracker.m_begin.load(std::memory_order_relaxed);
+		m_size = static_cast<size_t>(std::min<uint64_t>(m_end - std::min(begin, m_end), m_trackCount));
+
+		// Samples are added in order, so expired ones are all at the oldest end.
+		if (tracker.m_maxAgeUs != INT64_MAX) {
+			while (m_size && (*this)[m_size - 1].TimestampUs + tracker.m_maxAgeUs < nowUs)
+				m_size--;
+		}
+	}
+
+	[[nodiscard]] size_t size() const {
+		return m_size;
+	}
+
+	[[nodiscard]] bool empty() const {
+		return m_size == 0;
+	}
+
+	// 0 is the newest.
+	Entry operator[](size_t index) const {
+		const auto& slot = m_slots[(m_end - 1 - index) % m_trackCount];
+		return { slot.Value.load(std::memory_order_relaxed), slot.TimestampUs.load(std::memory_order_relaxed) };
+	}
+
+	// Number of samples taken at or after sinceUs.
+	[[nodiscard]] size_t CountSince(int64_t sinceUs) const {
+		size_t count = 0;
+		while (count < m_size && (*this)[count].TimestampUs >= sinceUs)
+			++count;
+		return count;
+	}
+};
+
+template<typename TFn>
+auto Utils::NumericStatisticsTracker::Read(const TFn& fn) const {
+	const auto nowUs = Utils::QpcUs();
+	while (true) {
+		const auto sequence = m_sequence.load(std::memory_order_acquire);
+		if (sequence & 1) {
+			std::this_thread::yield();
+			continue;
+		}
+
+		// Whatever fn computes from a sample being overwritten is thrown away below.
+		auto result = fn(Snapshot(*this, nowUs));
+
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (m_sequence.load(std::memory_order_relaxed) == sequence)
+			return result;
+	}
 }
 
 Utils::NumericStatisticsTracker::NumericStatisticsTracker(size_t trackCount, int64_t emptyValue, int64_t maxAgeUs)
 	: m_trackCount(trackCount)
 	, m_emptyValue(emptyValue)
-	, m_maxAgeUs(maxAgeUs) {
+	, m_maxAgeUs(maxAgeUs)
+	, m_slots(std::make_unique<Slot[]>(trackCount)) {
 }
 
 Utils::NumericStatisticsTracker::~NumericStatisticsTracker() = default;
 
 void Utils::NumericStatisticsTracker::AddValue(int64_t v) {
-	{
-		const auto lock = std::lock_guard(m_mtx);
-		m_values.emplace_back(v, m_maxAgeUs);
-	}
-	void(RemoveExpired(m_values.back().TimestampUs));
+	const auto nowUs = Utils::QpcUs();
+	const auto lock = std::lock_guard(m_writeMtx);
+
+	const auto sequence = m_sequence.load(std::memory_order_relaxed);
+	m_sequence.store(sequence + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	const auto end = m_end.load(std::memory_order_relaxed);
+	auto& slot = m_slots[end % m_trackCount];
+	slot.Value.store(v, std::memory_order_relaxed);
+	slot.TimestampUs.store(nowUs, std::memory_order_relaxed);
+	m_end.store(end + 1, std::memory_order_relaxed);
+
+	m_sequence.store(sequence + 2, std::memory_order_release);
 }
 
-const std::deque<Utils::NumericStatisticsTracker::Entry>& Utils::NumericStatisticsTracker::RemoveExpired(int64_t nowUs) const {
-	const auto lock = std::lock_guard(m_mtx);
-	while (!m_values.empty() && (
-		m_values.size() > m_trackCount || 
-		m_values.front().ExpiryUs < nowUs
-	))
-		m_values.pop_front();
-	return m_values;
+void Utils::NumericStatisticsTracker::Clear() {
+	const auto lock = std::lock_guard(m_writeMtx);
+
+	const auto sequence = m_sequence.load(std::memory_order_relaxed);
+	m_sequence.store(sequence + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	m_begin.store(m_end.load(std::memory_order_relaxed), std::memory_order_relaxed);
+
+	m_sequence.store(sequence + 2, std::memory_order_release);
 }
 
 int64_t Utils::NumericStatisticsTracker::InvalidValue() const {
@@ -39,102 +110,92 @@ int64_t Utils::NumericStatisticsTracker::InvalidValue() const {
 }
 
 int64_t Utils::NumericStatisticsTracker::Latest() const {
-	const auto vals = RemoveExpired();
-	if (vals.empty())
-		return m_emptyValue;
-	return vals.back().Value;
+	return Read([this](const Snapshot& vals) {
+		return vals.empty() ? m_emptyValue : vals[0].Value;
+	});
 }
 
 int64_t Utils::NumericStatisticsTracker::Min(int64_t sinceUs) const {
-	const auto vals = RemoveExpired();
-	auto found = false;
-	int64_t minValue{};
-	for (const auto& v : std::ranges::reverse_view(vals)) {
-		if (v.TimestampUs < sinceUs)
-			break;
-		if (!found || minValue > v.Value)
-			minValue = v.Value;
-		found = true;
-	}
-	return found ? minValue : m_emptyValue;
+	return Read([this, sinceUs](const Snapshot& vals) {
+		const auto count = vals.CountSince(sinceUs);
+		if (!count)
+			return m_emptyValue;
+
+		auto minValue = vals[0].Value;
+		for (size_t i = 1; i < count; ++i)
+			minValue = (std::min)(minValue, vals[i].Value);
+		return minValue;
+	});
 }
 
 int64_t Utils::NumericStatisticsTracker::Max(int64_t sinceUs) const {
-	const auto vals = RemoveExpired();
-	auto found = false;
-	int64_t maxValue{};
-	for (const auto& v : std::ranges::reverse_view(vals)) {
-		if (v.TimestampUs < sinceUs)
-			break;
-		if (!found || maxValue < v.Value)
-			maxValue = v.Value;
-		found = true;
-	}
-	return found ? maxValue : m_emptyValue;
+	return Read([this, sinceUs](const Snapshot& vals) {
+		const auto count = vals.CountSince(sinceUs);
+		if (!count)
+			return m_emptyValue;
+
+		auto maxValue = vals[0].Value;
+		for (size_t i = 1; i < count; ++i)
+			maxValue = (std::max)(maxValue, vals[i].Value);
+		return maxValue;
+	});
 }
 
 int64_t Utils::NumericStatisticsTracker::Median(int64_t sinceUs) const {
-	const auto vals = RemoveExpired();
-
 	std::vector<int64_t> sorted;
-	sorted.reserve(vals.size());
-	for (const auto& v : std::ranges::reverse_view(vals)) {
-		if (v.TimestampUs < sinceUs)
-			break;
-		sorted.emplace_back(v.Value);
-	}
+	sorted.reserve(m_trackCount);
+	Read([&sorted, sinceUs](const Snapshot& vals) {
+		sorted.clear();
+		for (size_t i = 0, count = vals.CountSince(sinceUs); i < count; ++i)
+			sorted.emplace_back(vals[i].Value);
+		return 0;
+	});
 	if (sorted.empty())
 		return m_emptyValue;
-	std::ranges::sort(sorted);
 
+	const auto middle = sorted.begin() + static_cast<ptrdiff_t>(sorted.size() / 2);
+	std::ranges::nth_element(sorted, middle);
 	if (sorted.size() % 2 == 0) {
 		// even
-		return (sorted[sorted.size() / 2] + sorted[sorted.size() / 2 - 1]) / 2;
+		return (*middle + *std::max_element(sorted.begin(), middle)) / 2;
 	} else {
 		// odd
-		return sorted[sorted.size() / 2];
+		return *middle;
 	}
 }
 
 int64_t Utils::NumericStatisticsTracker::Mean(int64_t sinceUs) const {
-	const auto vals = RemoveExpired();
-	int64_t count = 0;
-	int64_t acc{};
-	for (const auto& v : std::ranges::reverse_view(vals)) {
-		if (v.TimestampUs < sinceUs)
-			break;
-		acc += v.Value;
-		++count;
-	}
-	return count ? acc / count : m_emptyValue;
+	return Read([this, sinceUs](const Snapshot& vals) {
+		const auto count = vals.CountSince(sinceUs);
+		if (!count)
+			return m_emptyValue;
+
+		int64_t acc{};
+		for (size_t i = 0; i < count; ++i)
+			acc += vals[i].Value;
+		return acc / static_cast<int64_t>(count);
+	});
 }
 
 std::pair<int64_t, int64_t> Utils::NumericStatisticsTracker::MeanAndDeviation(int64_t sinceUs) const {
-	const auto vals = RemoveExpired();
-
-	int64_t count = 0;
-	int64_t acc{};
-	for (const auto& v : std::ranges::reverse_view(vals)) {
-		if (v.TimestampUs < sinceUs)
-			break;
-		acc += v.Value;
-		++count;
-	}
+	return Read([this, sinceUs](const Snapshot& vals) -> std::pair<int64_t, int64_t> {
+		const auto count = static_cast<int64_t>(vals.CountSince(sinceUs));
+		if (count == 0)
+			return {m_emptyValue, 0};
+		if (count == 1)
+			return {vals[0].Value, 0};
 
-	if (count == 0)
-		return {m_emptyValue, 0};
-	if (count == 1)
-		return {acc, 0};
-	const auto mean = acc / count;
-
-	int64_t diffSquaredSum = 0;
-	for (const auto& v : std::ranges::reverse_view(vals)) {
-		if (v.TimestampUs < sinceUs)
-			break;
-		diffSquaredSum += (v.Value - mean) * (v.Value - mean);
-	}
+		int64_t acc{};
+		for (int64_t i = 0; i < count; ++i)
+			acc += vals[i].Value;
+		const auto mean = acc / count;
+
+		int64_t diffSquaredSum = 0;
+		for (int64_t i = 0; i < count; ++i)
+			diffSquaredSum += (vals[i].Value - mean) * (vals[i].Value - mean);
 
-	return {mean, static_cast<int64_t>(std::sqrt(diffSquaredSum / count))};
+		return {mean, static_cast<int64_t>(std::sqrt(diffSquaredSum / count))};
+	});
 }
 
 int64_t Utils::NumericStatisticsTracker::Deviation(int64_t sinceUs) const {
@@ -142,45 +203,54 @@ int64_t Utils::NumericStatisticsTracker::Deviation(int64_t sinceUs) const {
 }
 
 size_t Utils::NumericStatisticsTracker::Count(int64_t sinceUs) const {
-	const auto vals = RemoveExpired();
-	if (!sinceUs)
-		return vals.size();
-
-	size_t count = 0;
-	for (const auto& v : std::ranges::reverse_view(vals)) {
-		if (v.TimestampUs < sinceUs)
-			break;
-		++count;
-	}
-	return count;
+	return Read([sinceUs](const Snapshot& vals) {
+		return sinceUs ? vals.CountSince(sinceUs) : vals.size();
+	});
+}
+
+Utils::NumericStatisticsTracker::Summary Utils::NumericStatisticsTracker::Summarize() const {
+	return Read([this](const Snapshot& vals) -> Summary {
+		if (vals.empty())
+			return { 0, m_emptyValue, m_emptyValue, m_emptyValue, 0 };
+
+		const auto count = static_cast<int64_t>(vals.size());
+		int64_t minValue = vals[0].Value;
+		int64_t acc{};
+		for (int64_t i = 0; i < count; ++i) {
+			minValue = (std::min)(minValue, vals[i].Value);
+			acc += vals[i].Value;
+		}
+		const auto mean = acc / count;
+
+		int64_t diffSquaredSum = 0;
+		for (int64_t i = 0; i < count; ++i)
+			diffSquaredSum += (vals[i].Value - mean) * (vals[i].Value - mean);
+
+		return { vals.size(), vals[0].Value, minValue, mean, static_cast<int64_t>(std::sqrt(diffSquaredSum / count)) };
+	});
 }
 
 int64_t Utils::NumericStatisticsTracker::NextBlankInUs() const {
-	const auto s = RemoveExpired();
-	if (s.size() < m_trackCount)
-		return 0;
-	return s.front().Value - Entry(0, 0).Value;
+	return Read([this](const Snapshot& vals) -> int64_t {
+		if (vals.size() < m_trackCount)
+			return 0;
+		return vals[vals.size() - 1].Value;
+	});
 }
 
 double Utils::NumericStatisticsTracker::CountFractional(int64_t sinceUs) const {
-	const auto vals = RemoveExpired();
-	if (!sinceUs)
-		return static_cast<double>(vals.size());
-
-	size_t count = 0;
-	int64_t lastTimestamp = INT64_MIN;
-	for (const auto& v : std::ranges::reverse_view(vals)) {
-		if (v.TimestampUs < sinceUs) {
-			if (lastTimestamp != INT64_MIN) {
-				const auto window = lastTimestamp - v.TimestampUs;
-				const auto elapsed = sinceUs - v.TimestampUs;
-				if (window > elapsed)
-					return static_cast<double>(count) + static_cast<double>(elapsed) / static_cast<double>(window);
-			}
-			break;
+	return Read([sinceUs](const Snapshot& vals) {
+		if (!sinceUs)
+			return static_cast<double>(vals.size());
+
+		const auto count = vals.CountSince(sinceUs);
+		if (count && count < vals.size()) {
+			// Count the part of the interval between the last sample before sinceUs and the first one after it.
+			const auto window = vals[count - 1].TimestampUs - vals[count].TimestampUs;
+			const auto elapsed = sinceUs - vals[count].TimestampUs;
+			if (window > elapsed)
+				return static_cast<double>(count) + static_cast<double>(elapsed) / static_cast<double>(window);
 		}
-		++count;
-		lastTimestamp = v.TimestampUs;
-	}
-	return static_cast<double>(count);
+		return static_cast<double>(count);
+	});
 }
@@ -1,38 +1,65 @@
 #pragma once
 
-#include <deque>
+#include <atomic>
+#include <memory>
 #include <mutex>
 #include "XivAlexanderCommon/Utils/Utils.h"
 
 namespace Utils {
+	/// \brief Keeps the last few samples of a value, and answers statistics about them.
+	///
+	/// Samples live in a ring guarded by a sequence lock: readers never take a lock nor block writers,
+	/// and retry if a sample was added while they were reading. Writers are only serialized among themselves.
 	class NumericStatisticsTracker {
 		const size_t m_trackCount;
 		const int64_t m_emptyValue;
 		const int64_t m_maxAgeUs;
 
-		struct Entry {
-			const int64_t Value;
-			const int64_t TimestampUs;
-			const int64_t ExpiryUs;
+		struct Slot {
+			std::atomic<int64_t> Value;
+			std::atomic<int64_t> TimestampUs;
+		};
 
-			Entry(int64_t value, int64_t maxAgeUs);
+		struct Entry {
+			int64_t Value;
+			int64_t TimestampUs;
 		};
 
-		mutable std::mutex m_mtx;
-		mutable std::deque<Entry> m_values;
+		// Unexpired samples as of when the read started, from the newest.
+		class Snapshot;
+
+		const std::unique_ptr<Slot[]> m_slots;
+
+		// Odd while a writer is changing anything below.
+		std::atomic<uint64_t> m_sequence = 0;
+
+		// Number of samples ever added, and where Clear was last called.
+		std::atomic<uint64_t> m_end = 0;
+		std::atomic<uint64_t> m_begin = 0;
+
+		std::mutex m_writeMtx;
 
 	public:
 		NumericStatisticsTracker(size_t trackCount, int64_t emptyValue, int64_t maxAgeUs = INT64_MAX);
 		~NumericStatisticsTracker();
 
 		void AddValue(int64_t);
-		void Clear() { m_values.clear(); };
-		bool Empty() const { return m_values.empty(); }
+		void Clear();
+		[[nodiscard]] bool Empty() const { return Count() == 0; }
 
 	private:
-		[[nodiscard]] const std::deque<Entry>& RemoveExpired(int64_t nowUs = Utils::QpcUs()) const;
+		template<typename TFn>
+		auto Read(const TFn& fn) const;
 
 	public:
+		struct Summary {
+			size_t Count;
+			int64_t Latest;
+			int64_t Min;
+			int64_t Mean;
+			int64_t Deviation;
+		};
+
 		[[nodiscard]] int64_t InvalidValue() const;
 		[[nodiscard]] int64_t Latest() const;
 		[[nodiscard]] int64_t Min(int64_t sinceUs = 0) const;
@@ -42,6 +69,9 @@ namespace Utils {
 		[[nodiscard]] int64_t Mean(int64_t sinceUs = 0) const;
 		[[nodiscard]] int64_t Deviation(int64_t sinceUs = 0) const;
 		[[nodiscard]] size_t Count(int64_t sinceUs = 0) const;
+
+		// Same as calling Latest, Min and MeanAndDeviation, but from a single read.
+		[[nodiscard]] Summary Summarize() const;
 		[[nodiscard]] int64_t NextBlankInUs() const;
 		[[nodiscard]] double CountFractional(int64_t sinceUs = 0) const;
 	};
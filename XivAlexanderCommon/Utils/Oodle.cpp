@@ -180,17 +180,21 @@ Utils::Oodle::Oodler::Oodler(const OodleModule& funcs, bool udp)
 Utils::Oodle::Oodler::~Oodler() = default;
 
 std::span<uint8_t> Utils::Oodle::Oodler::Decode(std::span<const uint8_t> source, size_t decodedLength) {
+	m_buffer.resize(decodedLength);
+	return Decode(source, std::span(m_buffer));
+}
+
+std::span<uint8_t> Utils::Oodle::Oodler::Decode(std::span<const uint8_t> source, std::span<uint8_t> target) {
 	if (!m_funcs.ErrorStep.empty())
 		throw std::runtime_error("Oodle not initialized");
-	m_buffer.resize(decodedLength);
 	if (m_udp) {
-		if (!m_funcs.UdpDecode(m_state.data(), m_shared.data(), source.data(), source.size(), m_buffer.data(), decodedLength))
+		if (!m_funcs.UdpDecode(m_state.data(), m_shared.data(), source.data(), source.size(), target.data(), target.size()))
 			throw std::runtime_error("OodleNetwork1UDP_Decode error");
 	} else {
-		if (!m_funcs.TcpDecode(m_state.data(), m_shared.data(), source.data(), source.size(), m_buffer.data(), decodedLength))
+		if (!m_funcs.TcpDecode(m_state.data(), m_shared.data(), source.data(), source.size(), target.data(), target.size()))
 			throw std::runtime_error("OodleNetwork1TCP_Decode error");
 	}
-	return { m_buffer };
+	return target;
 }
 
 std::span<uint8_t> Utils::Oodle::Oodler::Encode(std::span<const uint8_t> source) {
@@ -68,6 +68,9 @@ namespace Utils::Oodle {
 
 		std::span<uint8_t> Decode(std::span<const uint8_t> source, size_t decodedLength);
 
+		// Decodes exactly target.size() bytes into target.
+		std::span<uint8_t> Decode(std::span<const uint8_t> source, std::span<uint8_t> target);
+
 		std::span<uint8_t> Encode(std::span<const uint8_t> source);
 
 		static size_t MaxEncodedSize(size_t n) {
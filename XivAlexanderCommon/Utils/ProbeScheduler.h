@@ -0,0 +1,171 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <map>
+#include <optional>
+#include <random>
+#include <ranges>
+
+namespace Utils {
+	/// \brief Decides when to probe each of a set of targets, so that one thread can keep probes to all of them in flight.
+	///
+	/// Not thread safe, and does not send anything by itself: the caller sends whatever Poll asks for,
+	/// and reports back through Complete, once for every probe sent. Timestamps are given by the caller, so it can run on a fake clock.
+	template<typename TKey>
+	class ProbeScheduler {
+	public:
+		// Identifies one probe sent; never 0.
+		using ProbeId = uint64_t;
+
+		struct Options {
+			int64_t IntervalUs = 1000000;
+
+			// Each interval is lengthened or shortened by a random amount up to this, so that targets added together drift apart.
+			int64_t JitterUs = 0;
+
+			// Probe again right away if a latency differs from the previous one by this many percent or more, to confirm it.
+			int64_t ConfirmChangePercent = 10;
+
+			// Stop probing a target after this many failures in a row.
+			size_t MaxConsecutiveFailures = 10;
+		};
+
+		enum class Outcome {
+			Recorded,
+			Failed,
+
+			// The target has been removed.
+			GaveUp,
+		};
+
+	private:
+		struct Target {
+			int64_t DueUs;
+			ProbeId Probe = 0;  // 0 if no probe is in flight
+			int64_t SentUs = 0;
+			int64_t LastLatencyUs = -1;
+			size_t ConsecutiveFailures = 0;
+		};
+
+		Options m_options;
+		std::minstd_rand m_rng;
+		std::map<TKey, Target> m_targets;
+
+		// Includes probes to targets that have since been removed, as they are still out there until they complete.
+		std::map<ProbeId, TKey> m_inFlight;
+		ProbeId m_lastProbeId = 0;
+
+		int64_t NextIntervalUs(int64_t minIntervalUs) {
+			auto intervalUs = (std::max)(m_options.IntervalUs, minIntervalUs);
+			if (m_options.JitterUs > 0)
+				intervalUs += std::uniform_int_distribution<int64_t>(-m_options.JitterUs, m_options.JitterUs)(m_rng);
+			return (std::max<int64_t>)(0, intervalUs);
+		}
+
+	public:
+		explicit ProbeScheduler(const Options& options = {}, uint32_t seed = std::random_device()())
+			: m_options(options)
+			, m_rng(seed) {
+		}
+
+		[[nodiscard]] const Options& GetOptions() const {
+			return m_options;
+		}
+
+		// Takes effect from the next completed probe.
+		void SetOptions(const Options& options) {
+			m_options = options;
+		}
+
+		// A target added is due right away. Returns false if it already exists.
+		bool Add(const TKey& key, int64_t nowUs) {
+			return m_targets.emplace(key, Target{ nowUs }).second;
+		}
+
+		// A probe still in flight to the removed target keeps counting as in flight until it completes, and then gets ignored,
+		// even if the target has been added again by then.
+		bool Remove(const TKey& key) {
+			return m_targets.erase(key);
+		}
+
+		[[nodiscard]] bool Contains(const TKey& key) const {
+			return m_targets.contains(key);
+		}
+
+		[[nodiscard]] size_t Size() const {
+			return m_targets.size();
+		}
+
+		[[nodiscard]] size_t InFlight() const {
+			return m_inFlight.size();
+		}
+
+		/// \brief Calls send(key, probeId) for every target that is due and has nothing in flight, while fewer than maxInFlight probes are in flight.
+		///
+		/// Targets that have been due the longest go first, so that none starves when maxInFlight is not enough for all of them.
+		/// \returns When the earliest target not in flight becomes due, or INT64_MAX if there is none, or if what is due has to wait for a probe to complete.
+		template<typename TFn>
+		int64_t Poll(int64_t nowUs, size_t maxInFlight, const TFn& send) {
+			while (m_inFlight.size() < maxInFlight) {
+				auto next = m_targets.end();
+				for (auto it = m_targets.begin(); it != m_targets.end(); ++it) {
+					if (!it->second.Probe && it->second.DueUs <= nowUs && (next == m_targets.end() || it->second.DueUs < next->second.DueUs))
+						next = it;
+				}
+				if (next == m_targets.end())
+					break;
+
+				const auto probeId = ++m_lastProbeId;
+				next->second.Probe = probeId;
+				next->second.SentUs = nowUs;
+				m_inFlight.emplace(probeId, next->first);
+				send(next->first, probeId);
+			}
+
+			auto nextDueUs = INT64_MAX;
+			for (const auto& target : m_targets | std::views::values) {
+				if (!target.Probe && target.DueUs > nowUs)
+					nextDueUs = (std::min)(nextDueUs, target.DueUs);
+			}
+			return nextDueUs;
+		}
+
+		/// \brief Records how a probe went.
+		/// \param latencyUs Measured latency, or empty if the probe failed or timed out.
+		/// \param minIntervalUs Lower bound for the interval until the next probe, in addition to Options::IntervalUs.
+		/// \returns Empty if the probe was not in flight, or was sent to a target that has been removed since.
+		std::optional<Outcome> Complete(ProbeId probeId, int64_t nowUs, std::optional<int64_t> latencyUs, int64_t minIntervalUs = 0) {
+			const auto probeIt = m_inFlight.find(probeId);
+			if (probeIt == m_inFlight.end())
+				return std::nullopt;
+			const auto it = m_targets.find(probeIt->second);
+			m_inFlight.erase(probeIt);
+			if (it == m_targets.end() || it->second.Probe != probeId)
+				return std::nullopt;
+
+			auto& target = it->second;
+			const auto sentUs = target.SentUs;
+			target.Probe = 0;
+
+			if (!latencyUs) {
+				if (++target.ConsecutiveFailures >= m_options.MaxConsecutiveFailures) {
+					m_targets.erase(it);
+					return Outcome::GaveUp;
+				}
+				target.DueUs = (std::max)(nowUs, sentUs + NextIntervalUs(minIntervalUs));
+				return Outcome::Failed;
+			}
+
+			target.ConsecutiveFailures = 0;
+			const auto lastLatencyUs = target.LastLatencyUs;
+			target.LastLatencyUs = *latencyUs;
+			if (lastLatencyUs != -1 && *latencyUs > 0 && 100 * std::abs(lastLatencyUs - *latencyUs) / *latencyUs >= m_options.ConfirmChangePercent)
+				target.DueUs = nowUs;
+			else
+				target.DueUs = (std::max)(nowUs, sentUs + NextIntervalUs(minIntervalUs));
+			return Outcome::Recorded;
+		}
+	};
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <span>
+
+namespace Utils {
+	/// \brief Byte queue over a circular array with a power-of-2 capacity.
+	///
+	/// Not thread safe. Memory is only reallocated when a write does not fit, so a stream that always has a partial message pending keeps reusing it.
+	/// Free space and pending data can be made contiguous on request, for receiving into the buffer and for parsing in place.
+	class RingBuffer {
+		std::unique_ptr<uint8_t[]> m_data;
+		size_t m_mask;
+
+		// Offsets since the last reset; masked on access.
+		size_t m_head = 0;
+		size_t m_tail = 0;
+
+		// Moves pending data to the beginning of the array.
+		void Linearize() {
+			const auto size = Size();
+			const auto headIndex = m_head & m_mask;
+			if (headIndex + size > Capacity())
+				std::rotate(&m_data[0], &m_data[headIndex], &m_data[0] + Capacity());
+			else if (headIndex)
+				memmove(&m_data[0], &m_data[headIndex], size);
+			m_head = 0;
+			m_tail = size;
+		}
+
+		void Grow(size_t minCapacity) {
+			const auto capacity = std::bit_ceil(minCapacity);
+			auto data = std::make_unique_for_overwrite<uint8_t[]>(capacity);
+			const auto size = Read(std::span(&data[0], capacity));
+			m_data = std::move(data);
+			m_mask = capacity - 1;
+			m_head = 0;
+			m_tail = size;
+		}
+
+	public:
+		explicit RingBuffer(size_t capacity = 65536)
+			: m_data(std::make_unique_for_overwrite<uint8_t[]>(std::bit_ceil(capacity)))
+			, m_mask(std::bit_ceil(capacity) - 1) {
+		}
+
+		[[nodiscard]] size_t Capacity() const {
+			return m_mask + 1;
+		}
+
+		[[nodiscard]] size_t Size() const {
+			return m_tail - m_head;
+		}
+
+		[[nodiscard]] bool Empty() const {
+			return m_tail == m_head;
+		}
+
+		/// \brief Gets contiguous free space right after pending data, to be followed by CommitWrite.
+		/// \returns Free space of at least minSize bytes; the buffer grows if needed.
+		[[nodiscard]] std::span<uint8_t> PrepareWrite(size_t minSize = 1) {
+			if (Capacity() - Size() < minSize)
+				Grow(Size() + minSize);
+
+			auto tailIndex = m_tail & m_mask;
+			auto length = (std::min)(Capacity() - tailIndex, Capacity() - Size());
+			if (length < minSize) {
+				Linearize();
+				tailIndex = m_tail;
+				length = Capacity() - m_tail;
+			}
+			return { &m_data[tailIndex], length };
+		}
+
+		void CommitWrite(size_t length) {
+			m_tail += length;
+		}
+
+		void Write(std::span<const uint8_t> data) {
+			const auto target = PrepareWrite(data.size());
+			memcpy(target.data(), data.data(), data.size());
+			CommitWrite(data.size());
+		}
+
+		/// \brief Gets pending data from the beginning, without consuming it.
+		/// \param minContiguous Number of bytes that must be contiguous, or SIZE_MAX for all of them. Data is moved if needed.
+		/// \returns Pending data up to the end of the array, or further if it has been moved.
+		[[nodiscard]] std::span<const uint8_t> Peek(size_t minContiguous = 0) {
+			auto headIndex = m_head & m_mask;
+			auto length = (std::min)(Size(), Capacity() - headIndex);
+			if (length < (std::min)(minContiguous, Size())) {
+				Linearize();
+				headIndex = 0;
+				length = Size();
+			}
+			return { &m_data[headIndex], length };
+		}
+
+		/// \returns Number of bytes consumed, which is less than length if not that many were pending.
+		size_t Consume(size_t length) {
+			length = (std::min)(length, Size());
+			m_head += length;
+
+			// Start over from the beginning whenever drained, to keep free space contiguous.
+			if (m_head == m_tail)
+				m_head = m_tail = 0;
+			return length;
+		}
+
+		size_t Read(std::span<uint8_t> target) {
+			const auto length = (std::min)(target.size(), Size());
+			const auto headIndex = m_head & m_mask;
+			const auto first = (std::min)(length, Capacity() - headIndex);
+			memcpy(target.data(), &m_data[headIndex], first);
+			memcpy(target.data() + first, &m_data[0], length - first);
+			return Consume(length);
+		}
+	};
+}
@@ -1,4 +1,3 @@
-#include "ZlibWrapper.h"
 #include "pch.h"
 #include "XivAlexanderCommon/Utils/ZlibWrapper.h"
 
@@ -43,16 +42,20 @@ Utils::ZlibReusableInflater::~ZlibReusableInflater() {
 }
 
 std::span<uint8_t> Utils::ZlibReusableInflater::operator()(std::span<const uint8_t> source) {
+	return Inflate(source, m_buffer);
+}
+
+std::span<uint8_t> Utils::ZlibReusableInflater::Inflate(std::span<const uint8_t> source, std::vector<uint8_t>& buffer) {
 	Initialize();
 
 	m_zstream.next_in = &source[0];
 	m_zstream.avail_in = static_cast<uint32_t>(source.size());
 
-	if (m_buffer.size() < m_defaultBufferSize)
-		m_buffer.resize(m_defaultBufferSize);
+	if (buffer.size() < m_defaultBufferSize)
+		buffer.resize(m_defaultBufferSize);
 	while (true) {
-		m_zstream.next_out = &m_buffer[m_zstream.total_out];
-		m_zstream.avail_out = static_cast<uint32_t>(m_buffer.size() - m_zstream.total_out);
+		m_zstream.next_out = &buffer[m_zstream.total_out];
+		m_zstream.avail_out = static_cast<uint32_t>(buffer.size() - m_zstream.total_out);
 
 		if (const auto res = inflate(&m_zstream, Z_FINISH);
 			res != Z_OK && res != Z_BUF_ERROR && res != Z_STREAM_END) {
@@ -60,11 +63,11 @@ std::span<uint8_t> Utils::ZlibReusableInflater::operator()(std::span<const uint8
 		} else {
 			if (res == Z_STREAM_END)
 				break;
-			m_buffer.resize(m_buffer.size() + std::min<size_t>(m_buffer.size(), 65536));
+			buffer.resize(buffer.size() + std::min<size_t>(buffer.size(), 65536));
 		}
 	}
 
-	return std::span(m_buffer).subspan(0, m_zstream.total_out);
+	return std::span(buffer).subspan(0, m_zstream.total_out);
 }
 
 std::span<uint8_t> Utils::ZlibReusableInflater::operator()(std::span<const uint8_t> source, size_t maxSize) {
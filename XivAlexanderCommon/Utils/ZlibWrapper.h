@@ -4,6 +4,8 @@
 #include <vector>
 #include <zlib.h>
 
+#include "XivAlexanderCommon/Utils/Deflater.h"
+
 namespace Utils {
 	class ZlibError : public std::runtime_error {
 	public:
@@ -27,12 +29,15 @@ namespace Utils {
 
 		std::span<uint8_t> operator()(std::span<const uint8_t> source);
 
+		// Inflates into buffer, growing it as needed; buffer is never shrunk, so that it can be reused without reallocating.
+		std::span<uint8_t> Inflate(std::span<const uint8_t> source, std::vector<uint8_t>& buffer);
+
 		std::span<uint8_t> operator()(std::span<const uint8_t> source, size_t maxSize);
 
 		std::span<uint8_t> operator()(std::span<const uint8_t> source, std::span<uint8_t> target);
 	};
 
-	class ZlibReusableDeflater {
+	class ZlibReusableDeflater : public Deflater {
 		const int m_level;
 		const int m_method;
 		const int m_windowBits;
@@ -56,13 +61,9 @@ namespace Utils {
 			int strategy = Z_DEFAULT_STRATEGY,
 			size_t defaultBufferSize = 16384);
 
-		~ZlibReusableDeflater();
+		~ZlibReusableDeflater() override;
 
-		std::span<uint8_t> Deflate(std::span<const uint8_t> source);
-
-		std::span<uint8_t> operator()(std::span<const uint8_t> source) {
-			return Deflate(source);
-		}
+		std::span<uint8_t> Deflate(std::span<const uint8_t> source) override;
 
 		const std::span<uint8_t>& Result() const {
 			return m_latestResult;
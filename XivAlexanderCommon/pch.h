@@ -29,6 +29,7 @@
 #include <string>
 #include <vector>
 
+#ifdef _WIN32
 // Windows API, part 1
 #define NOMINMAX
 #define _WINSOCKAPI_   // Prevent <winsock.h> from being included
@@ -65,4 +66,10 @@
 #include "span_cast.h"
 #include "XivAlexanderCommon/Utils/StringUtils.h"
 
+#else
+// Only the portable parts, such as Sqex/ZiPatch, build outside Windows.
+#define ZLIB_CONST
+#include <zlib.h>
+#endif
+
 #endif //PCH_H